@@ -0,0 +1,214 @@
+// Blinn-Phong lighting shared by the sphere fragment shaders through #include
+// The including shader declares the FrameData block first
+
+#include "EnvironmentLighting.glsl"
+
+// Point light structure definition (std140, every member padded to a vec4)
+struct PointLight {
+    vec4 position;
+    vec4 color;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation; // Constant, linear and exponent factors, w is the range past which the light is dropped
+};
+
+// Directional light structure definition
+struct DirectionalLight {
+    vec4 direction;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+};
+
+// Spotlight structure definition
+struct Spotlight {
+    vec4 position;
+    vec4 direction;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 cutOff; // Inner and outer cosine
+};
+
+const int MAX_SPOT_LIGHTS = 10;// Maximum number of spotlights
+const int SHADOW_CASCADES = 3;// Directional shadow cascades, see ShadowCascadeCount
+
+// Every point light, written once by Light::InitializeLights, the first lightCounts.x are on
+layout (std430, binding = 10) readonly buffer PointLightData {
+    PointLight pointLights[];
+};
+
+// Every other light in the scene, written once per frame by Light::UploadLights
+layout (std140, binding = 1) uniform LightData {
+    DirectionalLight dirLight;
+    Spotlight spotLights[MAX_SPOT_LIGHTS]; // Array of spotlights
+    ivec4 lightEnable;// Toggles for point, directional, spot and rim lights
+    ivec4 lightCounts;// Number of point lights and spotlights
+    mat4 cascadeMatrices[SHADOW_CASCADES];// World to shadow atlas texture space
+    mat4 spotShadowMatrices[MAX_SPOT_LIGHTS];
+    ivec4 shadowCounts;// Directional cascades and spotlights with a shadow map, zero while shadows are off
+};
+
+// Every shadow map as a tile of one depth texture, see ShadowAtlas
+layout (binding = 4) uniform sampler2DShadow ShadowAtlas;
+const float ShadowNormalOffset = 0.05f;// World units the lookup moves off the surface
+const float ShadowBias = 0.0002f;
+const int SHADOW_TILES_PER_ROW = 4;// Tiles across the atlas, see ShadowAtlas::TilesPerRow
+
+// Uniform Inputs
+uniform float AmbientStrength = 0.1f;// The strength of the ambient light component, scales the sky irradiance
+uniform vec3 AmbientColor = vec3(1.0f, 1.0f, 1.0f);// Tint of the ambient light
+uniform vec3 LightColor = vec3(1.0f, 1.0f, 1.0f); // The color of the light (used for rim lighting here)
+uniform vec3 LightPos = vec3(5.0f, 10.0f, 3.0f);// The position of the light (not used in this shader)
+uniform float LightSpecularStrength = 1.2f;// The strength of the specular component
+uniform float Shininess = 100.0f;// The shininess factor for specular highlights, the deferred path reads it from the G-buffer
+
+// Function to calculate point light contribution
+vec3 CalculatePointLight(PointLight pointlight, vec3 position, vec3 normal, vec3 viewDir, float shininess) {
+    vec3 lightDir = normalize(position - pointlight.position.xyz);
+    float DiffuseStrength = max(dot(normal, -lightDir), 0.0);
+    vec3 reflectDir = reflect(lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 ambient = pointlight.ambient.rgb * pointlight.color.rgb;
+    vec3 diffuse = pointlight.diffuse.rgb * DiffuseStrength * pointlight.color.rgb;
+    vec3 specular = pointlight.specular.rgb * spec;
+
+    float distance = length(pointlight.position.xyz - position);
+    vec3  CombinedLight = vec3( diffuse + specular);
+ float Attenuation =( pointlight.attenuation.x + (pointlight.attenuation.y * distance) + (pointlight.attenuation.z * pow(distance, 2))); 
+            CombinedLight/=Attenuation;         
+    return vec3 (CombinedLight);
+}
+
+// Function to calculate directional light contribution, shadow scales all but the ambient part
+vec3 CalculateDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, float shininess, float shadow) {
+    vec3 lightDir = normalize(-light.direction.xyz);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 ambient = light.ambient.rgb;
+    vec3 diffuse = light.diffuse.rgb * diff;
+    vec3 specular = light.specular.rgb * spec;
+    return ambient + (diffuse + specular) * shadow;
+}
+
+// Function to calculate spotlight contribution
+vec3 CalculateSpotlight(Spotlight light, vec3 position, vec3 normal, vec3 viewDir, float shininess) {
+    vec3 lightDir = normalize(position - light.position.xyz );
+    float Theta = dot(lightDir, normalize(light.direction.xyz));
+    float Epsilon = light.cutOff.x - light.cutOff.y;
+    float Intensity = clamp((Theta - light.cutOff.y) / Epsilon, 0.0, 1.0);
+    
+    float DiffuseStrength = max(dot(normal, -lightDir), 0.0);
+    vec3 HalfwayVector = normalize(-lightDir + viewDir);
+    float spec = pow(max(dot(normal, HalfwayVector), 0.0), shininess);
+
+    vec3 diffuse = light.diffuse.rgb * DiffuseStrength * Intensity;
+    vec3 specular = light.specular.rgb * spec * Intensity;
+    return (diffuse + specular);
+}
+
+// Atlas position and depth of a surface point in one shadow map, false when the map does not cover it
+bool ProjectShadow(mat4 shadowMatrix, int tile, vec3 position, vec3 normal, out vec3 coord) {
+    vec4 projected = shadowMatrix * vec4(position + normal * ShadowNormalOffset, 1.0f);
+    if (projected.w <= 0.0f) {
+        return false;// Behind a spotlight, which does not light it anyway
+    }
+    coord = projected.xyz / projected.w;
+    if (coord.z >= 1.0f) {
+        return false;// Past the far plane of the map
+    }
+    // Inside the tile by the filter footprint, so no lookup reads a neighbouring tile
+    vec2 texel = 1.0f / vec2(textureSize(ShadowAtlas, 0));
+    float scale = 1.0f / float(SHADOW_TILES_PER_ROW);
+    vec2 tileMin = vec2(tile % SHADOW_TILES_PER_ROW, tile / SHADOW_TILES_PER_ROW) * scale;
+    return all(greaterThanEqual(coord.xy, tileMin + texel)) && all(lessThanEqual(coord.xy, tileMin + scale - texel));
+}
+
+// Share of the light reaching a projected point past the casters of its shadow map, 0 to 1
+float SampleShadow(vec3 coord) {
+    // Four filtered comparisons, a 3x3 texel footprint
+    vec2 texel = 1.0f / vec2(textureSize(ShadowAtlas, 0));
+    float lit = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        vec2 offset = (vec2(i & 1, i >> 1) - 0.5f) * texel;
+        lit += texture(ShadowAtlas, vec3(coord.xy + offset, coord.z - ShadowBias));
+    }
+    return lit * 0.25f;
+}
+
+// Directional shadow from the sharpest cascade that covers the point. The cascades are
+// picked by what they contain rather than by view depth, so probe faces get them right too
+float CalculateDirectionalShadow(vec3 position, vec3 normal) {
+    vec3 coord;
+    for (int i = 0; i < shadowCounts.x; i++) {
+        if (ProjectShadow(cascadeMatrices[i], i, position, normal, coord)) {
+            return SampleShadow(coord);
+        }
+    }
+    return 1.0f;
+}
+
+// Shadow of one spotlight, lit when it has no map. Spotlight tiles follow the cascades
+float CalculateSpotShadow(int light, vec3 position, vec3 normal) {
+    vec3 coord;
+    if (light >= shadowCounts.y || !ProjectShadow(spotShadowMatrices[light], SHADOW_CASCADES + light, position, normal, coord)) {
+        return 1.0f;
+    }
+    return SampleShadow(coord);
+}
+
+// Rim light settings
+uniform float RimStrength = 0.5f; // Adjust the strength of the rim light
+uniform float RimPower = 2.0f;   // Adjust the fall-off of the rim light
+
+// Rim Light Calculation
+vec3 CalculateRimLight(vec3 normal, vec3 viewDir) {
+    float rim = 1.0 - max(dot(viewDir, normal), 0.0);
+    rim = smoothstep(0.0, 1.0, pow(rim, RimPower)) * RimStrength;
+    return rim * LightColor; // The rim light color is usually the same as the main light color
+}
+// Sum of the enabled point lights at a surface point
+vec3 CalculatePointLights(vec3 position, vec3 Normal, vec3 viewDir, float shininess) {
+    vec3 pointLightContribution = vec3(0.0f);
+    if (lightEnable.x != 0) {
+        for (int i = 0; i < lightCounts.x; ++i) {
+            pointLightContribution += CalculatePointLight(pointLights[i], position, Normal, viewDir, shininess);
+        }
+    }
+    return pointLightContribution;
+}
+
+// Ambient, directional, spot and rim light at a surface point, everything but the point lights
+vec3 CalculateSceneLights(vec3 position, vec3 Normal, vec3 viewDir, float shininess) {
+   // Ambient light is the irradiance of the sky around the normal
+    vec3 Ambient = AmbientStrength * AmbientColor * SkyIrradiance(Normal);
+     // Calculate directional light contribution if enabled
+    vec3 dirLightContribution = vec3(0.0f);
+    if (lightEnable.y != 0) {
+        dirLightContribution = CalculateDirectionalLight(dirLight, Normal, viewDir, shininess, CalculateDirectionalShadow(position, Normal));
+    }
+   // Calculate spotlight contribution if enabled
+    vec3 spotlightContribution = vec3(0.0f);
+    if (lightEnable.z != 0) {
+        for (int i = 0; i < lightCounts.y; i++) {
+            spotlightContribution += CalculateSpotlight(spotLights[i], position, Normal, viewDir, shininess) * CalculateSpotShadow(i, position, Normal);
+        }
+    }
+     // Calculate rim light contribution if enabled
+    vec3 rimLight = vec3(0.0f);
+    if (lightEnable.w != 0) {
+        rimLight = CalculateRimLight(Normal, viewDir);
+    }
+
+    // Combine the lighting components
+    return Ambient + dirLightContribution + spotlightContribution + rimLight;
+}
+
+// Sum of every enabled light at a surface point, multiplied by the surface colour by the caller
+vec3 CalculateLighting(vec3 position, vec3 Normal) {
+ // Calculate the view direction
+    vec3 viewDir = normalize(cameraPosition.xyz - position);
+    return CalculateSceneLights(position, Normal, viewDir, Shininess) + CalculatePointLights(position, Normal, viewDir, Shininess);
+}
@@ -1,28 +1,48 @@
 #version 460 core
-// Define the layout of the incoming vertex attributes
-layout (location = 0) in vec3 Position;// Position of the vertex
-layout (location = 1) in vec2 TexCoord;// Texture coordinates of the vertex
-layout (location = 2) in vec3 Normal;// Normal vector of the vertex
+// The vertex attributes are pulled from the geometry pool
+#include "VertexPulling.glsl"
+// The depth pre-pass runs this shader too, GL_EQUAL needs the very same depths
+invariant gl_Position;
 
-uniform mat4 model; // Model matrix for transforming object space to world space
-uniform mat4  PVM;// Projection * View * Model matrix for transforming object space to clip space
+// Per-frame camera data, written once per frame into the stream buffer
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
+// Transforms of every instance in this draw, indexed by gl_InstanceID
+// Built on the CPU in batches, so no matrix is inverted per vertex
+struct InstanceTransform {
+    mat4 model;
+    mat4 normalMatrix;// Inverse transpose of the model matrix
+    mat4 pvm;// projection * view * model
+};
+layout (std430, binding = 2) readonly buffer InstanceData {
+    InstanceTransform instances[];
+};
 
 
 out vec2 FragTexCoords;// Pass through for texture coordinates
 out vec3 FragPos; // Pass through for fragment position
 out vec3 FragNormal; // Pass through for normal vector
+out vec3 FragTint; // Colour multiplier, white for these instances
 
 void main() {
+    Vertex vertex = PullVertex();
+    mat4 model = instances[gl_InstanceID].model; // Model matrix for transforming object space to world space
  // Transform the vertex position to clip space
-    gl_Position =  PVM * vec4(Position, 1.0);
+    gl_Position =  instances[gl_InstanceID].pvm * vec4(vertex.position, 1.0);
   // Pass the texture coordinates directly to the fragment shader
 
-    FragTexCoords = TexCoord;
+    FragTexCoords = vertex.texCoord;
+    FragTint = vec3(1.0f);
         // Transform the normal vector to world space and pass it to the fragment shader
     // The normal matrix is the transpose of the inverse of the model matrix
     // This is used to correctly transform normals in case of non-uniform scaling
 
-    FragNormal = mat3(transpose(inverse(model))) * Normal;
+    FragNormal = mat3(instances[gl_InstanceID].normalMatrix) * vertex.normal;
     // Transform the vertex position to world space and pass it to the fragment shader
-    FragPos = vec3(model * vec4(Position, 1.0f));
+    FragPos = vec3(model * vec4(vertex.position, 1.0f));
 }
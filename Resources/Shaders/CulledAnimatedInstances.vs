@@ -0,0 +1,36 @@
+#version 460 core
+// The vertex attributes are pulled from the geometry pool
+#include "VertexPulling.glsl"
+// The depth pre-pass runs this shader too, GL_EQUAL needs the very same depths
+invariant gl_Position;
+// The instances come from the meshlet culling pass
+#include "MeshletInstance.glsl"
+
+// Per-frame camera data, written once per frame into the stream buffer
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
+#include "InstanceAnimation.glsl"
+
+out vec2 FragTexCoords;// Pass through for texture coordinates
+out vec3 FragPos; // Pass through for fragment position
+out vec3 FragNormal; // Pass through for normal vector
+out vec3 FragTint; // Colour multiplier of the pulse
+
+void main() {
+    Vertex vertex = PullVertex();
+    vec3 center;
+    mat3 rotation;
+    float scale;
+    EvaluateAnimation(CulledInstance(), center, rotation, scale, FragTint);
+
+    // Scale is uniform, so the rotation also transforms the normal
+    FragPos = center + rotation * (vertex.position * scale);
+    gl_Position = projection * view * vec4(FragPos, 1.0f);
+    FragNormal = rotation * vertex.normal;
+    FragTexCoords = vertex.texCoord;
+}
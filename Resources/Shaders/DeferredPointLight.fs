@@ -0,0 +1,31 @@
+#version 460 core
+
+// Adds one point light to the pixels its volume covers. The volume is drawn
+// by its back faces where they lie behind the surface, so only surfaces in
+// front of the far side of the volume are shaded.
+
+out vec4 FinalColor; // Added to the light buffer
+
+flat in int LightIndex;
+
+// Per-frame camera data
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
+#include "BlinnPhongLighting.glsl"
+#include "GBuffer.glsl"
+
+void main() {
+    Surface surface = ReadSurface(ivec2(gl_FragCoord.xy));
+    PointLight light = pointLights[LightIndex];
+    // The cube corners reach past the light, the forward path would add less than a step of colour there
+    if (distance(light.position.xyz, surface.position) > light.attenuation.w) {
+        discard;
+    }
+    vec3 viewDir = normalize(cameraPosition.xyz - surface.position);
+    FinalColor = vec4(CalculatePointLight(light, surface.position, surface.normal, viewDir, surface.shininess) * surface.albedo, 1.0f);
+}
@@ -0,0 +1,8 @@
+#version 460 core
+
+// Fragment shader of the depth pre-pass, linked with the vertex shader of the
+// shading pass so the depths match. Nothing is written but depth.
+
+void main()
+{
+}
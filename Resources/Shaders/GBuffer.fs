@@ -0,0 +1,22 @@
+#version 460 core
+
+// Geometry pass of the deferred path, linked with the vertex shader of the
+// forward pass. The surface is stored for the lighting pass instead of lit.
+
+layout (location = 0) out vec4 AlbedoShininess;
+layout (location = 1) out vec2 PackedNormal;
+// Vertex Shader Inputs
+in vec2 FragTexCoords;// The texture coordinates passed from the vertex shader
+in vec3 FragNormal; // The normal vector passed from the vertex shader
+in vec3 FragTint; // Colour multiplier from the vertex shader
+
+#include "GBuffer.glsl"
+
+uniform sampler2D ImageTexture0;// The texture sampler
+uniform float Shininess = 100.0f;// Same default as BlinnPhongLighting.glsl
+
+void main() {
+    vec3 albedo = texture(ImageTexture0, FragTexCoords).rgb * FragTint;
+    AlbedoShininess = vec4(albedo, min(Shininess, MaxShininess) / MaxShininess);
+    PackedNormal = EncodeNormal(normalize(FragNormal));
+}
@@ -0,0 +1,57 @@
+// G-buffer of the deferred path, shared by GBuffer.fs and the lighting shaders through #include
+//   AlbedoShininess RGBA8: surface colour (texture times tint), shininess / MaxShininess in alpha
+//   PackedNormal RG16F: world normal folded onto the octahedron
+//   Depth 32F: the world position is rebuilt from it with InverseViewProjection
+
+const float MaxShininess = 256.0f;// Largest shininess the alpha channel can hold
+
+// Unit normal to a point of the [-1, 1] square, matches VertexEncoder::EncodeOctahedral
+vec2 EncodeNormal(vec3 normal) {
+    normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+    vec2 point = normal.xy;
+    if (normal.z < 0.0f) {
+        point = (1.0f - abs(normal.yx)) * vec2(normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return point;
+}
+
+// Inverse of EncodeNormal
+vec3 DecodeNormal(vec2 point) {
+    vec3 normal = vec3(point, 1.0f - abs(point.x) - abs(point.y));
+    float fold = max(-normal.z, 0.0f);
+    normal.x += (normal.x >= 0.0f) ? -fold : fold;
+    normal.y += (normal.y >= 0.0f) ? -fold : fold;
+    return normalize(normal);
+}
+
+// Targets bound by DeferredRenderer, unit 0 stays free for the material textures
+layout (binding = 1) uniform sampler2D GBufferAlbedo;
+layout (binding = 2) uniform sampler2D GBufferNormal;
+layout (binding = 3) uniform sampler2D GBufferDepth;
+uniform mat4 InverseViewProjection;// Set by DeferredRenderer every frame
+
+// What the geometry pass stored for one pixel
+struct Surface {
+    vec3 position;
+    vec3 normal;
+    vec3 albedo;
+    float shininess;
+    bool covered;// False where no opaque geometry was drawn
+};
+
+// Reads the surface under a pixel, texelFetch as every target matches the screen
+Surface ReadSurface(ivec2 pixel) {
+    Surface surface;
+    float depth = texelFetch(GBufferDepth, pixel, 0).r;
+    surface.covered = depth < 1.0f;
+
+    vec2 uv = (vec2(pixel) + 0.5f) / vec2(textureSize(GBufferDepth, 0));
+    vec4 world = InverseViewProjection * vec4(vec3(uv, depth) * 2.0f - 1.0f, 1.0f);
+    surface.position = world.xyz / world.w;
+
+    vec4 albedoShininess = texelFetch(GBufferAlbedo, pixel, 0);
+    surface.albedo = albedoShininess.rgb;
+    surface.shininess = albedoShininess.a * MaxShininess;
+    surface.normal = DecodeNormal(texelFetch(GBufferNormal, pixel, 0).rg);
+    return surface;
+}
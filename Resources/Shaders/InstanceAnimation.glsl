@@ -0,0 +1,49 @@
+// Per-instance animation shared by the animated vertex shaders through #include
+// The including shader declares the FrameData block first, for the time
+
+// How every instance moves, uploaded once when the spheres are created
+// Angles are in radians and speeds in radians per second
+struct InstanceAnimation {
+    vec4 basePosition;// xyz position, w uniform scale
+    vec4 baseRotation;// Quaternion (x, y, z, w)
+    vec4 spin;// xyz unit axis, w speed
+    vec4 bob;// x height, y speed, z phase
+    vec4 orbit;// x radius, y speed, z phase
+    vec4 pulse;// rgb tint at the peak of the pulse, w speed
+};
+layout (std430, binding = 4) readonly buffer InstanceAnimationData {
+    InstanceAnimation animations[];
+};
+
+// Hamilton product, b is applied first
+vec4 QuatMultiply(vec4 a, vec4 b) {
+    return vec4(a.w * b.xyz + b.w * a.xyz + cross(a.xyz, b.xyz), a.w * b.w - dot(a.xyz, b.xyz));
+}
+
+// Rotation matrix of a unit quaternion
+mat3 QuatToMat3(vec4 q) {
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    return mat3(
+        1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy),
+        2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx),
+        2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy));
+}
+
+// Where instance is at the frame time, and the colour multiplier of its pulse
+void EvaluateAnimation(int instance, out vec3 center, out mat3 rotation, out float scale, out vec3 tint) {
+    InstanceAnimation animation = animations[instance];
+
+    // Spin about the instance axis on top of its starting rotation
+    float spinAngle = animation.spin.w * time;
+    vec4 spin = vec4(animation.spin.xyz * sin(spinAngle * 0.5f), cos(spinAngle * 0.5f));
+    rotation = QuatToMat3(QuatMultiply(spin, animation.baseRotation));
+
+    // Circle around the starting position while bobbing up and down
+    float orbitAngle = animation.orbit.y * time + animation.orbit.z;
+    float bobAngle = animation.bob.y * time + animation.bob.z;
+    center = animation.basePosition.xyz + vec3(cos(orbitAngle) * animation.orbit.x, sin(bobAngle) * animation.bob.x, sin(orbitAngle) * animation.orbit.x);
+    scale = animation.basePosition.w;
+    tint = mix(vec3(1.0f), animation.pulse.rgb, 0.5f + 0.5f * sin(animation.pulse.w * time));
+}
@@ -0,0 +1,13 @@
+// Instance lookup for the draws written by the meshlet culling pass, shared through #include
+// Each indirect draw is one meshlet, gl_DrawID picks its list of surviving instances
+
+layout (std430, binding = 9) readonly buffer MeshletVisibleData {
+    uint visibleInstances[];
+};
+
+uniform uint meshletInstanceStride;// Entries per meshlet list, set once by the sphere
+
+// The instance this invocation draws, in place of gl_InstanceID
+int CulledInstance() {
+    return int(visibleInstances[uint(gl_DrawID) * meshletInstanceStride + uint(gl_InstanceID)]);
+}
@@ -1,20 +1,29 @@
 #version 460 core
 
-layout (location = 0) in vec3 aPos; // The Position variable has attribute Position 0
-layout (location = 1) in vec2 aTexCoord; // The texture coordinate variable has attribute Position 1
+// The vertex attributes are pulled from the geometry pool
+#include "VertexPulling.glsl"
 
 // Output to the fragment shader
 out vec2 TexCoord;
 
+// Camera matrices, written once per frame into the stream buffer
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
 // Uniforms
-uniform mat4 PVM;
+uniform mat4 model;
 
 
 void main()
 {
+    Vertex vertex = PullVertex();
     // Pass the texture coordinates to the fragment shader
-    TexCoord = aTexCoord;
+    TexCoord = vertex.texCoord;
 
     // Calculate the Position of the vertex
-    gl_Position = PVM * vec4(aPos, 1.0);
+    gl_Position = projection * view * model * vec4(vertex.position, 1.0);
 }
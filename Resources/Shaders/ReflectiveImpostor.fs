@@ -0,0 +1,34 @@
+#version 460 core
+
+out vec4 FragColor;
+
+// Per-frame camera data shared with every scene shader
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
+#include "ImpostorFragment.glsl"
+
+// Cube map of the reflection probe around this sphere, or SkySpecular until the probe is ready
+layout (binding = 0) uniform samplerCube ReflectionProbe;
+// The sky shows through wherever the probe saw nothing, alpha 0
+#include "EnvironmentLighting.glsl"
+uniform float Roughness = 0.1f;// Polished rather than a perfect mirror
+
+// Reflects the skybox off the exact sphere surface, as reflective.fs does for the mesh
+void main()
+{
+    vec3 position;
+    vec3 normal;
+    bool hit = TraceImpostor(position, normal);
+    vec3 viewDir = normalize(cameraPosition.xyz - position);
+    vec3 reflectDir = reflect(-viewDir, normal);
+    vec4 probe = texture(ReflectionProbe, reflectDir);
+    FragColor = vec4(mix(SkySpecularLight(reflectDir, Roughness), probe.rgb, probe.a), 1.0f);
+    if (!hit) {
+        discard;
+    }
+}
@@ -0,0 +1,21 @@
+#version 460 core
+// Shadow caster of the shadow atlas, linked with DepthOnly.fs
+// The vertex attributes are pulled from the geometry pool
+#include "VertexPulling.glsl"
+
+// The view and projection of the light whose tile is being drawn
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
+// One model matrix per caster, written into the stream buffer by the submitting object
+layout (std430, binding = 2) readonly buffer CasterData {
+    mat4 casterModels[];
+};
+
+void main() {
+    gl_Position = projection * view * casterModels[gl_InstanceID] * vec4(PullVertex().position, 1.0f);
+}
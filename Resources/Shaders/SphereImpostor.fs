@@ -0,0 +1,28 @@
+#version 460 core
+
+out vec4 FinalColor; // The output color of the pixel
+
+// Per-frame camera data
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
+#include "ImpostorFragment.glsl"
+#include "BlinnPhongLighting.glsl"
+
+uniform sampler2D ImageTexture0;// The texture sampler
+
+// Lights the exact sphere surface the same way as the sphere mesh
+void main() {
+    vec3 position;
+    vec3 normal;
+    bool hit = TraceImpostor(position, normal);
+    vec4 color = SampleImpostorTexture(ImageTexture0, normal);
+    if (!hit) {
+        discard;
+    }
+    FinalColor = vec4(CalculateLighting(position, normal), 1.0f) * color * vec4(FragTint, 1.0f);
+}
@@ -0,0 +1,581 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :AssetPack.cpp
+Description :  Implementation of the asset pack, its loose file fallback
+               and the packer.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "AssetPack.h"
+#include "MeshCache.h"
+#include "MeshImporter.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+const char* const AssetPack::DefaultPath = "Resources.pack";
+
+namespace
+{
+	const char PackMagic[4] = { 'P', 'A', 'C', 'K' };
+
+	// Swaps the rows of an image top to bottom
+	void FlipRows(unsigned char* pixels, int width, int height, int channels)
+	{
+		size_t rowSize = static_cast<size_t>(width) * channels;
+		std::vector<unsigned char> row(rowSize);
+		for (int top = 0, bottom = height - 1; top < bottom; top++, bottom--) {
+			unsigned char* topRow = pixels + top * rowSize;
+			unsigned char* bottomRow = pixels + bottom * rowSize;
+			std::memcpy(row.data(), topRow, rowSize);
+			std::memcpy(topRow, bottomRow, rowSize);
+			std::memcpy(bottomRow, row.data(), rowSize);
+		}
+	}
+
+	// Lower case extension of a path, without the dot
+	std::string GetExtension(const std::string& path)
+	{
+		size_t dot = path.find_last_of('.');
+		size_t slash = path.find_last_of('/');
+		if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+			return "";
+		}
+		return path.substr(dot + 1);
+	}
+
+	// One entry while a pack is built
+	struct PendingEntry
+	{
+		std::string name;
+		std::uint64_t nameHash;
+		GLuint type;
+		std::vector<unsigned char> data;
+	};
+}
+
+/***********************************************************************
+ * ~ImageAsset: Destructor for the ImageAsset class.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+ImageAsset::~ImageAsset()
+{
+	Release();
+}
+
+/***********************************************************************
+ * Load: Finds or decodes an image.
+ * Author: [Smirti Parajuli]
+ * Description: A packed image is used in place when its rows are already
+ *              in the wanted order and copied flipped otherwise. Without
+ *              a packed image the file is decoded with stb_image. Safe to
+ *              call from jobs.
+ *
+ * Parameters:
+ *   - path: Path of the image file.
+ *   - bottomUp: True for the bottom row first, as 2D textures want it,
+ *               false for the top row first, as cube map faces want it.
+ *
+ * Return: bool - True when the pixels are available.
+ ***********************************************************************/
+bool ImageAsset::Load(const std::string& path, bool bottomUp)
+{
+	Release();
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	if (AssetPack::Get().Find(path, AssetType::Image, data, size) && size >= sizeof(PackImageHeader)) {
+		PackImageHeader header;
+		std::memcpy(&header, data, sizeof(header));
+		// Checked row by row against the bytes after the header, so the product cannot wrap
+		size_t available = size - sizeof(header);
+		bool valid = header.width > 0 && header.height > 0 && header.channels > 0 && header.channels <= 4
+			&& header.width <= static_cast<GLuint>(INT_MAX) && header.height <= static_cast<GLuint>(INT_MAX)
+			&& header.width <= available / header.channels
+			&& header.height <= available / (static_cast<size_t>(header.width) * header.channels);
+		size_t pixelBytes = valid ? static_cast<size_t>(header.width) * header.channels * header.height : 0;
+		if (valid) {
+			width = static_cast<int>(header.width);
+			height = static_cast<int>(header.height);
+			channels = static_cast<int>(header.channels);
+			pixels = data + sizeof(header);
+			if ((header.bottomUp != 0) != bottomUp) {
+				flipped.assign(pixels, pixels + pixelBytes);
+				FlipRows(flipped.data(), width, height, channels);
+				pixels = flipped.data();
+			}
+			return true;
+		}
+	}
+
+	// stb_image's own flip switch is global, so the rows are flipped here
+	decoded = stbi_load(path.c_str(), &width, &height, &channels, 0);
+	if (!decoded) {
+		return false;
+	}
+	if (bottomUp) {
+		FlipRows(decoded, width, height, channels);
+	}
+	pixels = decoded;
+	return true;
+}
+
+/***********************************************************************
+ * Release: Frees the pixels.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void ImageAsset::Release()
+{
+	if (decoded) {
+		stbi_image_free(decoded);
+		decoded = nullptr;
+	}
+	std::vector<unsigned char>().swap(flipped);
+	pixels = nullptr;
+	width = 0;
+	height = 0;
+	channels = 0;
+}
+
+/***********************************************************************
+ * Get: Returns the asset pack of the application.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: AssetPack& - The pack, closed until Open succeeds.
+ ***********************************************************************/
+AssetPack& AssetPack::Get()
+{
+	static AssetPack pack;
+	return pack;
+}
+
+/***********************************************************************
+ * Open: Maps a pack.
+ * Author: [Smirti Parajuli]
+ * Description: Only the header, index and names are checked here, the
+ *              entries are used in place. Call Verify to check the data.
+ *
+ * Parameters:
+ *   - path: Path of the pack.
+ *
+ * Return: bool - True when the pack is mapped and its index is sound.
+ ***********************************************************************/
+bool AssetPack::Open(const std::string& path)
+{
+	file.Close();
+	entries = nullptr;
+	names = nullptr;
+	entryCount = 0;
+	if (!file.Open(path) || file.GetSize() < sizeof(Header)) {
+		file.Close();
+		return false;
+	}
+
+	Header header;
+	std::memcpy(&header, file.GetData(), sizeof(header));
+	size_t size = file.GetSize();
+	// Sums are compared against what is left of the file, so a damaged header cannot wrap them
+	std::uint64_t indexBytes = sizeof(Entry) * static_cast<std::uint64_t>(header.entryCount);
+	if (std::memcmp(header.magic, PackMagic, sizeof(header.magic)) != 0 || header.version != Version || header.fileSize != size
+		|| header.indexOffset % alignof(Entry) != 0 || header.indexOffset > size || indexBytes > size - header.indexOffset
+		|| header.nameOffset > size || header.nameBytes > size - header.nameOffset) {
+		std::cout << "Asset pack is damaged or from another version: " << path << std::endl;
+		file.Close();
+		return false;
+	}
+	const Entry* index = reinterpret_cast<const Entry*>(file.GetData() + header.indexOffset);
+	for (GLuint i = 0; i < header.entryCount; ++i) {
+		// Meshes are used in place, so their data must keep its alignment
+		if (index[i].offset % DataAlignment != 0 || index[i].offset > size || index[i].size > size - index[i].offset
+			|| index[i].nameOffset > header.nameBytes || index[i].nameLength > header.nameBytes - index[i].nameOffset) {
+			std::cout << "Asset pack is damaged: " << path << std::endl;
+			file.Close();
+			return false;
+		}
+	}
+	entries = index;
+	names = reinterpret_cast<const char*>(file.GetData() + header.nameOffset);
+	entryCount = header.entryCount;
+	return true;
+}
+
+/***********************************************************************
+ * Find: Looks up an entry.
+ * Author: [Smirti Parajuli]
+ * Description: Binary searches the index for the hash of the normalised
+ *              path, then compares the names to rule out collisions.
+ *
+ * Parameters:
+ *   - path: Path of the file as the application names it.
+ *   - type: Which form of the file is wanted.
+ *   - data: Set to the entry inside the mapping.
+ *   - size: Set to the size of the entry.
+ *
+ * Return: bool - True when the pack holds the entry.
+ ***********************************************************************/
+bool AssetPack::Find(const std::string& path, AssetType type, const unsigned char*& data, size_t& size) const
+{
+	if (entries == nullptr) {
+		return false;
+	}
+	std::string name = NormalizePath(path);
+	std::uint64_t nameHash = Hash(name.data(), name.size());
+	GLuint wantedType = static_cast<GLuint>(type);
+	const Entry* end = entries + entryCount;
+	const Entry* entry = std::lower_bound(entries, end, nameHash, [](const Entry& a, std::uint64_t hash) { return a.nameHash < hash; });
+	for (; entry != end && entry->nameHash == nameHash; ++entry) {
+		if (entry->type == wantedType && entry->nameLength == name.size() && std::memcmp(names + entry->nameOffset, name.data(), name.size()) == 0) {
+			data = file.GetData() + entry->offset;
+			size = static_cast<size_t>(entry->size);
+			return true;
+		}
+	}
+	return false;
+}
+
+/***********************************************************************
+ * Load: Gets the raw bytes of a file.
+ * Author: [Smirti Parajuli]
+ * Description: Points into the pack when it holds the file, otherwise the
+ *              loose file is read into the AssetData.
+ *
+ * Parameters:
+ *   - path: Path of the file.
+ *   - out: Filled with the bytes.
+ *
+ * Return: bool - True when the file was found in either place.
+ ***********************************************************************/
+bool AssetPack::Load(const std::string& path, AssetData& out)
+{
+	out.owned.clear();
+	if (Get().Find(path, AssetType::Raw, out.data, out.size)) {
+		return true;
+	}
+	return LoadLoose(path, out);
+}
+
+/***********************************************************************
+ * LoadLoose: Reads a file from disk, passing over the pack.
+ * Author: [Smirti Parajuli]
+ * Description: For files the pack may hold an older copy of.
+ *
+ * Parameters:
+ *   - path: Path of the file.
+ *   - out: Filled with the bytes.
+ *
+ * Return: bool - True when the file could be opened.
+ ***********************************************************************/
+bool AssetPack::LoadLoose(const std::string& path, AssetData& out)
+{
+	out.owned.clear();
+	std::ifstream loose(path, std::ios::in | std::ios::binary);
+	if (!loose.good()) {
+		out.data = nullptr;
+		out.size = 0;
+		return false;
+	}
+	loose.seekg(0, std::ios::end);
+	out.owned.resize(static_cast<size_t>(loose.tellg()) + 1);// One spare byte keeps the pointer valid for empty files
+	loose.seekg(0, std::ios::beg);
+	loose.read(reinterpret_cast<char*>(out.owned.data()), static_cast<std::streamsize>(out.owned.size() - 1));
+	out.data = out.owned.data();
+	out.size = out.owned.size() - 1;
+	return true;
+}
+
+/***********************************************************************
+ * Verify: Checks every entry against its content hash.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: bool - True when every entry is intact.
+ ***********************************************************************/
+bool AssetPack::Verify() const
+{
+	for (size_t i = 0; i < entryCount; ++i) {
+		if (Hash(file.GetData() + entries[i].offset, static_cast<size_t>(entries[i].size)) != entries[i].contentHash) {
+			std::cout << "Asset pack entry is damaged: " << std::string(names + entries[i].nameOffset, entries[i].nameLength) << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+/***********************************************************************
+ * Build: Writes a pack.
+ * Author: [Smirti Parajuli]
+ * Description: Every file below the roots becomes an entry. Images are
+ *              decoded, with the rows of cube map faces top first and of
+ *              every other image bottom first, the way they are uploaded.
+ *              OBJ and glTF files are cooked. Entries with the same bytes
+ *              share their data. Cooked .mesh files are skipped, the pack
+ *              cooks its own.
+ *
+ * Parameters:
+ *   - output: Path of the pack to write.
+ *   - roots: Folders to pack, named the way the application opens them.
+ *
+ * Return: bool - True when the pack was written.
+ ***********************************************************************/
+bool AssetPack::Build(const std::string& output, const std::vector<std::string>& roots)
+{
+	std::vector<std::string> paths;
+	for (const std::string& root : roots) {
+		ListFiles(root, paths);
+	}
+	std::sort(paths.begin(), paths.end());
+
+	std::vector<PendingEntry> pending;
+	for (const std::string& path : paths) {
+		PendingEntry entry;
+		entry.name = NormalizePath(path);
+		entry.nameHash = Hash(entry.name.data(), entry.name.size());
+		entry.type = static_cast<GLuint>(AssetType::Raw);
+		std::string extension = GetExtension(entry.name);
+		if (extension == "mesh" || extension == "tmp" || extension == "pack") {
+			continue;
+		}
+
+		if (extension == "jpg" || extension == "jpeg" || extension == "png" || extension == "bmp" || extension == "tga") {
+			int width = 0, height = 0, channels = 0;
+			unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
+			if (pixels) {
+				PackImageHeader header;
+				header.width = static_cast<GLuint>(width);
+				header.height = static_cast<GLuint>(height);
+				header.channels = static_cast<GLuint>(channels);
+				header.bottomUp = (entry.name.find("/cubemaps/") == std::string::npos) ? 1u : 0u;
+				if (header.bottomUp) {
+					FlipRows(pixels, width, height, channels);
+				}
+				size_t pixelBytes = static_cast<size_t>(width) * height * channels;
+				entry.type = static_cast<GLuint>(AssetType::Image);
+				entry.data.resize(sizeof(header) + pixelBytes);
+				std::memcpy(entry.data.data(), &header, sizeof(header));
+				std::memcpy(entry.data.data() + sizeof(header), pixels, pixelBytes);
+				stbi_image_free(pixels);
+				pending.push_back(std::move(entry));
+				continue;
+			}
+		}
+		else if (extension == "obj" || extension == "gltf" || extension == "glb") {
+			ImportedMesh imported;
+			if (MeshImporter::Import(path, imported)) {
+				CookedMesh cooked;
+				MeshImporter::Cook(imported, cooked);
+				entry.type = static_cast<GLuint>(AssetType::Mesh);
+				MeshCache::Serialize(cooked, MappedFile::GetStamp(path), entry.data);
+				pending.push_back(std::move(entry));
+			}
+			continue;
+		}
+
+		AssetData loose;
+		if (!Load(path, loose)) {
+			std::cout << "Cannot read asset: " << path << std::endl;
+			return false;
+		}
+		entry.data.assign(loose.GetData(), loose.GetData() + loose.GetSize());
+		pending.push_back(std::move(entry));
+	}
+
+	std::stable_sort(pending.begin(), pending.end(), [](const PendingEntry& a, const PendingEntry& b) {
+		return a.nameHash != b.nameHash ? a.nameHash < b.nameHash : a.type < b.type;
+	});
+
+	// Lay out the header, index and names, then the data on aligned offsets
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, PackMagic, sizeof(header.magic));
+	header.version = Version;
+	header.entryCount = static_cast<GLuint>(pending.size());
+	header.indexOffset = sizeof(Header);
+	header.nameOffset = header.indexOffset + sizeof(Entry) * pending.size();
+	std::string allNames;
+	std::vector<Entry> index(pending.size());
+	for (size_t i = 0; i < pending.size(); ++i) {
+		std::memset(&index[i], 0, sizeof(Entry));
+		index[i].nameHash = pending[i].nameHash;
+		index[i].type = pending[i].type;
+		index[i].nameOffset = static_cast<GLuint>(allNames.size());
+		index[i].nameLength = static_cast<GLuint>(pending[i].name.size());
+		allNames += pending[i].name;
+	}
+	header.nameBytes = static_cast<GLuint>(allNames.size());
+
+	std::vector<unsigned char> pack(static_cast<size_t>(header.nameOffset) + allNames.size());
+	std::memcpy(pack.data() + header.nameOffset, allNames.data(), allNames.size());
+	std::unordered_map<std::uint64_t, size_t> stored;// Content hash to the first entry holding it
+	size_t sharedEntries = 0;
+	for (size_t i = 0; i < pending.size(); ++i) {
+		const std::vector<unsigned char>& data = pending[i].data;
+		index[i].contentHash = Hash(data.data(), data.size());
+		index[i].size = data.size();
+		auto found = stored.find(index[i].contentHash);
+		if (found != stored.end() && index[found->second].size == data.size()
+			&& std::memcmp(pack.data() + index[found->second].offset, data.data(), data.size()) == 0) {
+			index[i].offset = index[found->second].offset;
+			sharedEntries++;
+			continue;
+		}
+		size_t offset = (pack.size() + DataAlignment - 1) / DataAlignment * DataAlignment;
+		pack.resize(offset + data.size());
+		if (!data.empty()) {
+			std::memcpy(pack.data() + offset, data.data(), data.size());
+		}
+		index[i].offset = offset;
+		stored.emplace(index[i].contentHash, i);
+	}
+	header.fileSize = pack.size();
+	std::memcpy(pack.data(), &header, sizeof(header));
+	if (!index.empty()) {
+		std::memcpy(pack.data() + header.indexOffset, index.data(), sizeof(Entry) * index.size());
+	}
+
+	// Written under a temporary name so a running application never maps half a pack
+	std::string temporaryPath = output + ".tmp";
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(pack.data()), static_cast<std::streamsize>(pack.size()));
+		if (!out.good()) {
+			std::cout << "Cannot write asset pack: " << temporaryPath << std::endl;
+			return false;
+		}
+	}
+	std::remove(output.c_str());
+	if (std::rename(temporaryPath.c_str(), output.c_str()) != 0) {
+		std::remove(temporaryPath.c_str());
+		std::cout << "Cannot write asset pack: " << output << std::endl;
+		return false;
+	}
+	std::cout << "Packed " << pending.size() << " entries (" << sharedEntries << " sharing data) into " << output
+		<< ", " << pack.size() << " bytes" << std::endl;
+	return true;
+}
+
+/***********************************************************************
+ * NormalizePath: Puts a path in the form the pack stores.
+ * Author: [Smirti Parajuli]
+ * Description: Lower case, forward slashes and no leading "./", since the
+ *              application and the file system do not agree on case.
+ *
+ * Parameters:
+ *   - path: The path.
+ *
+ * Return: std::string - The normalised path.
+ ***********************************************************************/
+std::string AssetPack::NormalizePath(const std::string& path)
+{
+	std::string name = path;
+	for (char& c : name) {
+		c = (c == '\\') ? '/' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	}
+	while (name.compare(0, 2, "./") == 0) {
+		name.erase(0, 2);
+	}
+	return name;
+}
+
+/***********************************************************************
+ * Hash: 64-bit FNV-1a hash.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - data: The bytes to hash.
+ *   - size: Number of bytes.
+ *   - seed: Starting value, the FNV offset basis by default.
+ *
+ * Return: std::uint64_t - The hash.
+ ***********************************************************************/
+std::uint64_t AssetPack::Hash(const void* data, size_t size, std::uint64_t seed)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	std::uint64_t hash = seed;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+/***********************************************************************
+ * ListFiles: Collects every file below a folder.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - directory: The folder, without a trailing separator.
+ *   - out: Paths of the files are appended, built from directory.
+ *
+ * Return: None
+ ***********************************************************************/
+void AssetPack::ListFiles(const std::string& directory, std::vector<std::string>& out)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	HANDLE search = FindFirstFileA((directory + "/*").c_str(), &found);
+	if (search == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	do {
+		std::string name = found.cFileName;
+		if (name == "." || name == "..") {
+			continue;
+		}
+		if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			ListFiles(directory + "/" + name, out);
+		}
+		else {
+			out.push_back(directory + "/" + name);
+		}
+	} while (FindNextFileA(search, &found));
+	FindClose(search);
+#else
+	DIR* folder = opendir(directory.c_str());
+	if (folder == nullptr) {
+		return;
+	}
+	while (dirent* found = readdir(folder)) {
+		std::string name = found->d_name;
+		if (name == "." || name == "..") {
+			continue;
+		}
+		std::string path = directory + "/" + name;
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0) {
+			continue;
+		}
+		if (S_ISDIR(info.st_mode)) {
+			ListFiles(path, out);
+		}
+		else {
+			out.push_back(path);
+		}
+	}
+	closedir(folder);
+#endif
+}
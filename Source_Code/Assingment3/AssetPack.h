@@ -0,0 +1,159 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :AssetPack.h
+Description :  The AssetPack is one archive holding every shader, texture
+               and mesh of the application. It is mapped once at start up
+               and its entries are handed out as spans into the mapping, so
+               nothing is opened, read or copied per file. Textures are
+               stored decoded and meshes cooked, so neither is parsed at
+               run time. Entries are found by a hash of their path through
+               a sorted index, their data starts on DataAlignment bytes and
+               carries a content hash, which also lets the packer store
+               identical files once.
+               When there is no pack, or it lacks an entry, the loose file
+               is read instead, so development needs no packing step.
+               Build writes a pack and is run with --pack-assets.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <glew.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// What an entry holds, one path may have an entry of each type
+enum class AssetType : GLuint
+{
+	Raw = 0,// The file as it is
+	Image = 1,// PackImageHeader followed by the decoded pixels
+	Mesh = 2// A cooked mesh, see MeshCache
+};
+
+// Start of every image entry
+struct PackImageHeader
+{
+	GLuint width;
+	GLuint height;
+	GLuint channels;
+	GLuint bottomUp;// 1 when the first row is the bottom of the image, as OpenGL expects for 2D textures
+};
+
+// Bytes of a file, inside the pack or owned when read from a loose file
+class AssetData
+{
+public:
+	const unsigned char* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+	bool IsValid() const { return data != nullptr; }
+	bool IsFromPack() const { return owned.empty() && data != nullptr; }
+
+private:
+	friend class AssetPack;
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	std::vector<unsigned char> owned;// Contents of a loose file
+};
+
+// Decoded pixels, inside the pack or decoded from a loose file
+class ImageAsset
+{
+public:
+	ImageAsset() {}
+	~ImageAsset();
+
+	// Finds or decodes an image with its rows in the given order
+	bool Load(const std::string& path, bool bottomUp);
+	void Release();
+
+	const unsigned char* GetPixels() const { return pixels; }
+	int GetWidth() const { return width; }
+	int GetHeight() const { return height; }
+	int GetChannels() const { return channels; }
+
+	// Copying and assignment not allowed for this class
+	ImageAsset(const ImageAsset&) = delete;
+	ImageAsset& operator=(const ImageAsset&) = delete;
+
+private:
+	const unsigned char* pixels = nullptr;
+	unsigned char* decoded = nullptr;// Owned by stb_image when read from a loose file
+	std::vector<unsigned char> flipped;// Used when the pack stores the other row order
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+};
+
+class AssetPack
+{
+public:
+	static const char* const DefaultPath;
+	static const GLuint DataAlignment = 64;
+
+	static AssetPack& Get();// The pack of the application, opened by Open before any job runs
+
+	bool Open(const std::string& path);// False when there is no valid pack, loose files are used then
+	bool IsOpen() const { return file.IsOpen(); }
+	size_t GetEntryCount() const { return entryCount; }
+
+	// Finds an entry in the pack, the data stays valid while the pack is open
+	bool Find(const std::string& path, AssetType type, const unsigned char*& data, size_t& size) const;
+	static bool Load(const std::string& path, AssetData& out);// Raw bytes from the pack or the loose file
+	static bool LoadLoose(const std::string& path, AssetData& out);// Raw bytes of the loose file only
+	bool Verify() const;// Checks the content hash of every entry
+
+	// Writes a pack of every file below the roots, images decoded and meshes cooked
+	static bool Build(const std::string& output, const std::vector<std::string>& roots);
+
+	static std::string NormalizePath(const std::string& path);// Lower case with forward slashes
+	static std::uint64_t Hash(const void* data, size_t size, std::uint64_t seed = 14695981039346656037ull);
+
+	// Copying and assignment not allowed for this class
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+
+private:
+	AssetPack() {}
+
+	struct Header
+	{
+		char magic[4];
+		GLuint version;
+		GLuint entryCount;
+		GLuint nameBytes;
+		std::uint64_t indexOffset;// Entries sorted by name hash and type
+		std::uint64_t nameOffset;// Normalised paths, not terminated
+		std::uint64_t fileSize;
+	};
+
+	struct Entry
+	{
+		std::uint64_t nameHash;
+		std::uint64_t contentHash;
+		std::uint64_t offset;// From the start of the pack, a multiple of DataAlignment
+		std::uint64_t size;
+		GLuint nameOffset;// From the start of the names
+		GLuint nameLength;
+		GLuint type;
+		GLuint padding;
+	};
+
+	static const GLuint Version = 1;
+
+	static void ListFiles(const std::string& directory, std::vector<std::string>& out);
+
+	MappedFile file;
+	const Entry* entries = nullptr;
+	const char* names = nullptr;
+	size_t entryCount = 0;
+};
+#endif // ASSETPACK_H
@@ -0,0 +1,163 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :BufferArena.cpp
+Description :  Implementation of the first fit range allocator.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "BufferArena.h"
+#include <algorithm>
+#include <iterator>
+
+/***********************************************************************
+ * BufferArena: Constructor for the BufferArena class.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - capacity: Size of the managed buffer, all of it free.
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+BufferArena::BufferArena(GLuint capacity)
+{
+	Reset(capacity);
+}
+
+/***********************************************************************
+ * Reset: Frees every range.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - capacity: New size of the managed buffer.
+ *
+ * Return: None
+ ***********************************************************************/
+void BufferArena::Reset(GLuint capacity)
+{
+	Reset(capacity, 0);
+}
+
+/***********************************************************************
+ * Reset: Starts over with one allocated block at the front.
+ * Author: [Smirti Parajuli]
+ * Description: Used after the owner has packed every live range to the
+ *              start of the buffer.
+ *
+ * Parameters:
+ *   - capacity: New size of the managed buffer.
+ *   - used: Size of the allocated front of the buffer.
+ *
+ * Return: None
+ ***********************************************************************/
+void BufferArena::Reset(GLuint capacity, GLuint used)
+{
+	this->capacity = capacity;
+	freeRanges.clear();
+	freeSize = (used < capacity) ? capacity - used : 0;
+	if (freeSize > 0) {
+		freeRanges[capacity - freeSize] = freeSize;
+	}
+}
+
+/***********************************************************************
+ * Allocate: Takes a range out of the free list.
+ * Author: [Smirti Parajuli]
+ * Description: The first free range that fits after aligning its start
+ *              is split, the padding in front and the remainder behind
+ *              stay free.
+ *
+ * Parameters:
+ *   - size: Units wanted.
+ *   - alignment: The offset is a multiple of this.
+ *
+ * Return: The offset, InvalidOffset when no free range fits.
+ ***********************************************************************/
+GLuint BufferArena::Allocate(GLuint size, GLuint alignment)
+{
+	if (size == 0) {
+		size = 1;
+	}
+	if (alignment == 0) {
+		alignment = 1;
+	}
+
+	for (auto range = freeRanges.begin(); range != freeRanges.end(); ++range) {
+		GLuint start = range->first;
+		GLuint end = range->first + range->second;
+		GLuint aligned = (start + alignment - 1) / alignment * alignment;
+		if (aligned >= end || end - aligned < size) {
+			continue;
+		}
+
+		freeRanges.erase(range);
+		if (aligned > start) {
+			freeRanges[start] = aligned - start;
+		}
+		if (aligned + size < end) {
+			freeRanges[aligned + size] = end - (aligned + size);
+		}
+		freeSize -= size;
+		return aligned;
+	}
+	return InvalidOffset;
+}
+
+/***********************************************************************
+ * Free: Returns a range to the free list.
+ * Author: [Smirti Parajuli]
+ * Description: The range is merged with a free range ending where it
+ *              starts and one starting where it ends.
+ *
+ * Parameters:
+ *   - offset: Offset returned by Allocate.
+ *   - size: The size given to Allocate.
+ *
+ * Return: None
+ ***********************************************************************/
+void BufferArena::Free(GLuint offset, GLuint size)
+{
+	if (offset == InvalidOffset) {
+		return;
+	}
+	if (size == 0) {
+		size = 1;
+	}
+	freeSize += size;
+
+	auto next = freeRanges.lower_bound(offset);
+	if (next != freeRanges.begin()) {
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == offset) {
+			offset = previous->first;
+			size += previous->second;
+			freeRanges.erase(previous);
+		}
+	}
+	if (next != freeRanges.end() && offset + size == next->first) {
+		size += next->second;
+		freeRanges.erase(next);
+	}
+	freeRanges[offset] = size;
+}
+
+/***********************************************************************
+ * GetLargestFree: Size of the largest free range.
+ * Author: [Smirti Parajuli]
+ * Description: Compared with GetFree it shows how fragmented the buffer
+ *              is.
+ *
+ * Parameters: None
+ *
+ * Return: The size, zero when the buffer is full.
+ ***********************************************************************/
+GLuint BufferArena::GetLargestFree() const
+{
+	GLuint largest = 0;
+	for (const auto& range : freeRanges) {
+		largest = std::max(largest, range.second);
+	}
+	return largest;
+}
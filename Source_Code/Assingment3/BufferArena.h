@@ -0,0 +1,46 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :BufferArena.h
+Description :  The BufferArena hands out ranges of one large buffer. It only
+               does the bookkeeping, the owner copies the data. Free ranges
+               are kept sorted by offset, allocation takes the first one
+               that fits and freeing merges a range with its neighbours.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef BUFFERARENA_H
+#define BUFFERARENA_H
+
+#include <glew.h>
+#include <map>
+
+class BufferArena
+{
+public:
+	static const GLuint InvalidOffset = 0xFFFFFFFFu;
+
+	explicit BufferArena(GLuint capacity = 0);
+
+	void Reset(GLuint capacity);// Frees everything
+	void Reset(GLuint capacity, GLuint used);// Everything below used is allocated, the rest is free
+
+	// Returns the offset of size units aligned to alignment, or InvalidOffset if no free range fits
+	GLuint Allocate(GLuint size, GLuint alignment = 1);
+	void Free(GLuint offset, GLuint size);
+
+	GLuint GetCapacity() const { return capacity; }
+	GLuint GetFree() const { return freeSize; }
+	GLuint GetLargestFree() const;
+
+private:
+	std::map<GLuint, GLuint> freeRanges;// Offset to size, never touching each other
+	GLuint capacity = 0;
+	GLuint freeSize = 0;
+};
+#endif // BUFFERARENA_H
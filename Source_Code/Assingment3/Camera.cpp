@@ -31,6 +31,8 @@ Camera::Camera(int windowWidth, int windowHeight, glm::vec3 position)
     Camera::windowWidth = windowWidth;// Set the width of the window for this camera
     Camera::windowHeight = windowHeight; // Set the height of the window for this camera
     Position = position;// Set the initial position for this camera
+    previousPosition = position;
+    renderPosition = position;
 
     // Initialize the cursors for the inside and outside of the  Window
       // Create a cursor that looks like a hand, to be used when the cursor is inside the window
@@ -65,6 +67,8 @@ Camera::~Camera() {
  *
  * Parameters: None
  *
+ * Uses the position interpolated between fixed simulation steps.
+ *
  * Return:
  *   - glm::mat4: The view matrix of the camera.
  ***********************************************/
@@ -72,7 +76,7 @@ Camera::~Camera() {
 glm::mat4 Camera::GetViewMatrix() const {
     // Return a view matrix using the glm::lookAt function 
     // This function creates a view matrix based on a position, target and up direction
-    return glm::lookAt(Position, Position + orientation, up);
+    return glm::lookAt(renderPosition, renderPosition + orientation, up);
 }
 
 /***********************************************
@@ -104,103 +108,116 @@ glm::mat4 Camera::GetProjectionMatrix(float fov, float aspectRat, float nearPlan
  * Inputs: Handles user input for camera movement and interaction.
  * Author: [Smirti Parajuli]
  * Processes mouse and keyboard inputs to update the camera's position and orientation.
- * Adjusts cursor visibility and camera's view based on user interaction.
+ * Called once per fixed simulation step on the simulation thread, so it only reads
+ * the sampled input state and never calls into GLFW.
  *
  * Parameters:
- *   - window: GLFWwindow pointer to the current window.
+ *   - input: Keyboard and mouse state sampled on the main thread.
+ *   - deltaTime: Length of the fixed simulation step in seconds.
  *
  * Return: None
  ***********************************************/
-void Camera::Inputs(GLFWwindow* Window) {
-    // Handles mouse position to adjust cursor visibility
-    double mouseX, mouseY;
-    glfwGetCursorPos(Window, &mouseX, &mouseY); // Get current cursor position in the window
-    float xoffset = static_cast<float>(mouseX - lastX);
-    float yoffset = static_cast<float>(lastY - mouseY); // Reversed since y-coordinates go from bottom to top
-    lastX = static_cast<float>(mouseX);
-    lastY = static_cast<float>(mouseY);
-    // If the cursor position is outside the window boundaries, set the cursor to 'outsideCursor'
-    if (mouseX < 0 || mouseX > windowWidth || mouseY < 0 || mouseY > windowHeight) {
-        // Cursor is outside window bounds
-        glfwSetCursor(Window, outsideCursor);
-    }
-    // If the cursor is inside the window, set the cursor to 'insideCursor'
-    else {
-        // Cursor is inside window bounds
-        glfwSetCursor(Window, insideCursor);
-    }
+void Camera::Inputs(const InputState& input, float deltaTime) {
+    previousPosition = Position;
 
-    // Handles left mouse button inputs for camera functionality
-    if (glfwGetMouseButton(Window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-        // Hide the cursor to allow free looking
-        glfwSetInputMode(Window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
+    float xoffset = static_cast<float>(input.mouseX - lastX);
+    float yoffset = static_cast<float>(lastY - input.mouseY); // Reversed since y-coordinates go from bottom to top
+    lastX = static_cast<float>(input.mouseX);
+    lastY = static_cast<float>(input.mouseY);
 
+    // Handles left mouse button inputs for camera functionality
+    if (input.leftMouseDown) {
         // Check if this is the first click to prevent the camera from jumping on first input
         if (firstClick) {
-            lastX = static_cast<float>(mouseX); // Cast double to float
-            lastY = static_cast<float>(mouseY); // Cast double to float
             firstClick = false;
         }
-
-
-        // Calculate the offset of the mouse position
-
-
         // Apply the camera pitch and yaw updates based on the mouse movement
-        MouseMovement(xoffset, yoffset);
-
+        else {
+            MouseMovement(xoffset, yoffset);
+        }
     }
-
     // If the left mouse button is released
-    else if (glfwGetMouseButton(Window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) {
-        // Unhides cursor since camera is not looking around anymore
-        glfwSetInputMode(Window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-        // Set the cursor back to normal mode
+    else {
         firstClick = true;
     }
-    currentFrameTime = static_cast<float>(glfwGetTime());
-    deltaTime = currentFrameTime - lastFrameTime;
-    lastFrameTime = currentFrameTime;
 
-    // Define a base speed factor
-    float baseSpeed = 1.0f;
+    // Zoom by however much the wheel moved since the last step
+    if (input.scrollTotal != lastScrollTotal) {
+        MouseScroll(input.scrollTotal - lastScrollTotal);
+        lastScrollTotal = input.scrollTotal;
+    }
+
+    // Define a base speed factor, increased while the left shift key is held
+    float baseSpeed = input.IsKeyDown(GLFW_KEY_LEFT_SHIFT) ? 2.0f : 1.0f;
 
     // Modify the base speed factor based on delta time
     float speed = baseSpeed * deltaTime;
 
     // Move forward when the 'W' key is pressed.
-    if (glfwGetKey(Window, GLFW_KEY_W) == GLFW_PRESS) {
+    if (input.IsKeyDown(GLFW_KEY_W)) {
         Position += speed * orientation; // Move the camera forward
     }
     // Move to the left when the 'A' key is pressed.
-    if (glfwGetKey(Window, GLFW_KEY_A) == GLFW_PRESS) {
+    if (input.IsKeyDown(GLFW_KEY_A)) {
         glm::vec3 leftMovement = glm::normalize(glm::cross(orientation, up));
         Position += speed * leftMovement;
     }
     // Move backward when the 'S' key is pressed.
-    if (glfwGetKey(Window, GLFW_KEY_S) == GLFW_PRESS) {
+    if (input.IsKeyDown(GLFW_KEY_S)) {
         Position -= speed * orientation; // Move the camera backward
     }
     // Move to the right when the 'D' key is pressed.
-    if (glfwGetKey(Window, GLFW_KEY_D) == GLFW_PRESS) {
+    if (input.IsKeyDown(GLFW_KEY_D)) {
         glm::vec3 rightMovement = glm::normalize(glm::cross(orientation, up));
         Position += speed * -rightMovement;
     }
     // Move up when the 'Q' key is pressed.
-    if (glfwGetKey(Window, GLFW_KEY_Q) == GLFW_PRESS) {
+    if (input.IsKeyDown(GLFW_KEY_Q)) {
         Position += speed * up;
     }
     // Move down when the 'E' key is pressed.
-    if (glfwGetKey(Window, GLFW_KEY_E) == GLFW_PRESS) {
+    if (input.IsKeyDown(GLFW_KEY_E)) {
         Position -= speed * up;
     }
-    // Increase the movement speed when the left shift key is pressed.
-    if (glfwGetKey(Window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) {
-        baseSpeed = 2.0f; // You can adjust this value as needed
+}
+/***********************************************
+ * UpdateCursor: Updates the cursor shape and visibility.
+ * Author: [Smirti Parajuli]
+ * Shows the 'inside' cursor over the window and hides it while the left mouse
+ * button is held for free looking. Must be called on the main thread.
+ *
+ * Parameters:
+ *   - window: GLFWwindow pointer to the current window.
+ *   - input: Keyboard and mouse state sampled this frame.
+ *
+ * Return: None
+ ***********************************************/
+void Camera::UpdateCursor(GLFWwindow* Window, const InputState& input) {
+    // If the cursor position is outside the window boundaries, set the cursor to 'outsideCursor'
+    if (input.mouseX < 0 || input.mouseX > windowWidth || input.mouseY < 0 || input.mouseY > windowHeight) {
+        glfwSetCursor(Window, outsideCursor);
     }
+    // If the cursor is inside the window, set the cursor to 'insideCursor'
     else {
-        baseSpeed = 1.0f; // Reset the speed to the default value
+        glfwSetCursor(Window, insideCursor);
     }
+
+    // Hide the cursor while looking around, show it again once the button is released
+    glfwSetInputMode(Window, GLFW_CURSOR, input.leftMouseDown ? GLFW_CURSOR_HIDDEN : GLFW_CURSOR_NORMAL);
+}
+/***********************************************
+ * Interpolate: Blends the camera position between fixed steps.
+ * Author: [Smirti Parajuli]
+ * Computes the position used by the view matrix from the previous and current
+ * simulated positions so movement stays smooth at any frame rate.
+ *
+ * Parameters:
+ *   - alpha: Interpolation factor from the frame clock, in the range [0, 1].
+ *
+ * Return: None
+ ***********************************************/
+void Camera::Interpolate(float alpha) {
+    renderPosition = glm::mix(previousPosition, Position, alpha);
 }
 /***********************************************
  * MouseMovement: Updates camera orientation based on mouse movement.
@@ -239,13 +256,11 @@ void Camera::MouseMovement(float xoffset, float yoffset) {
  * Zooms the camera in or out based on the scroll wheel's vertical offset.
  *
  * Parameters:
- *   - window: GLFWwindow pointer to the current window.
- *   - xOffset: The offset in the X direction of the scroll wheel.
  *   - yOffset: The offset in the Y direction of the scroll wheel.
  *
  * Return: None
  ***********************************************/
-void Camera::MouseScroll(GLFWwindow* window, double xoffset, double yoffset) {
+void Camera::MouseScroll(double yoffset) {
     std::cout << "MouseScroll called with yoffset: " << yoffset << std::endl;
 
     fov -= (float)yoffset * 2;
@@ -22,6 +22,7 @@ Mail : [smirti.parajuli]@mds.ac.nz
 #include<glm/gtc/type_ptr.hpp>
 
 #include"ShaderLoader.h"
+#include"InputState.h"
 class Camera
 {
 private:
@@ -33,6 +34,7 @@ private:
 	//float sensitivity = 0.1f; // Mouse sensitivity
 	float pitch = 0.0f; // Up/down rotation
 	float yaw = -90.0f; // Left/right rotation
+	double lastScrollTotal = 0.0; // Scroll total seen by the previous step
 
 public:
 	~Camera();
@@ -49,9 +51,8 @@ public:
 	// Stores the width and height of the window
 	int windowWidth;
 	int windowHeight;
-	float lastFrameTime = 0.0f;
-	float deltaTime = 0.0f;
-	float currentFrameTime = 0.0f;
+	glm::vec3 previousPosition;// Position at the start of the latest fixed step
+	glm::vec3 renderPosition;// Position interpolated between fixed steps, used for the view matrix
 	// Adjust the speed of the camera and it's sensitivity when looking around
 	//float speed = 0.1f;
 	float sensitivity = 0.1f;
@@ -65,14 +66,18 @@ public:
 	glm::mat4 GetProjectionMatrix(float fov, float aspectRat, float nearPlane, float farPlane) const;//returns the projection matrix
 
 
-	// Handles camera inputs
-	void Inputs(GLFWwindow* window);
+	// Handles camera inputs for one fixed simulation step (simulation thread)
+	void Inputs(const InputState& input, float deltaTime);
+	// Updates the cursor shape and visibility (main thread)
+	void UpdateCursor(GLFWwindow* window, const InputState& input);
+	// Blends the previous and current position for rendering
+	void Interpolate(float alpha);
 	//void KeyButtonCallback(GLFWwindow* window, int Key, int action, int mods);
 	void KeyButtonCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 	// New methods
 	void MouseMovement(float xoffset, float yoffset);
-	void MouseScroll(GLFWwindow* window, double xoffset, double yoffset);
+	void MouseScroll(double yoffset);
 
 
 };
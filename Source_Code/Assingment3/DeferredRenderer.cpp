@@ -0,0 +1,277 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :DeferredRenderer.cpp
+Description :  Implementation of the G-buffer and the deferred lighting
+               passes.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "DeferredRenderer.h"
+#include "GLState.h"
+#include "ShaderLoader.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <cstdint>
+#include <iostream>
+
+/***********************************************************************
+ * DeferredRenderer: Constructor for the DeferredRenderer class.
+ * Author: [Smirti Parajuli]
+ * Description: Loads the lighting programs and adds the light volume cube
+ *              to the geometry pool. The targets are made by the first
+ *              Resize, once the framebuffer size is known.
+ * Parameters: None
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+DeferredRenderer::DeferredRenderer()
+{
+	Program_Light = ShaderLoader::CreateProgram("Resources/Shaders/DeferredLight.vs", "Resources/Shaders/DeferredLight.fs");
+	Program_PointLight = ShaderLoader::CreateProgram("Resources/Shaders/DeferredPointLight.vs", "Resources/Shaders/DeferredPointLight.fs");
+	lightInverseLocation = glGetUniformLocation(Program_Light, "InverseViewProjection");
+	pointLightInverseLocation = glGetUniformLocation(Program_PointLight, "InverseViewProjection");
+	glGenVertexArrays(1, &emptyVertexArray);
+
+	// Corners of the unit cube, bit 0 picks x, bit 1 y and bit 2 z, in the 8 floats per vertex of the pool
+	GLfloat vertices[8 * 8] = {};
+	for (int i = 0; i < 8; i++) {
+		vertices[i * 8 + 0] = (i & 1) ? 0.5f : -0.5f;
+		vertices[i * 8 + 1] = (i & 2) ? 0.5f : -0.5f;
+		vertices[i * 8 + 2] = (i & 4) ? 0.5f : -0.5f;
+	}
+	// Counter clockwise seen from outside, the point light pass culls these front faces
+	GLuint indices[36] = {
+		0, 2, 1,  1, 2, 3,// -z
+		4, 5, 6,  5, 7, 6,// +z
+		0, 4, 2,  2, 4, 6,// -x
+		1, 3, 5,  3, 7, 5,// +x
+		0, 1, 4,  1, 5, 4,// -y
+		2, 6, 3,  3, 6, 7,// +y
+	};
+	volumeMesh = std::make_unique<Mesh>(vertices, indices, 8 * 8, 36);
+}
+
+/***********************************************************************
+ * ~DeferredRenderer: Destructor for the DeferredRenderer class.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None (destructor)
+ ***********************************************************************/
+DeferredRenderer::~DeferredRenderer()
+{
+	DeleteTargets();
+	GLState::Get().ForgetVertexArray(emptyVertexArray);
+	glDeleteVertexArrays(1, &emptyVertexArray);
+}
+
+/***********************************************************************
+ * Resize: Matches the targets to the framebuffer.
+ * Author: [Smirti Parajuli]
+ * Description: Called every frame, only does work when the size changed.
+ *              A minimised window keeps the old targets.
+ * Parameters:
+ *   - width: Framebuffer width in pixels.
+ *   - height: Framebuffer height in pixels.
+ *
+ * Return: None
+ ***********************************************************************/
+void DeferredRenderer::Resize(int width, int height)
+{
+	if (width <= 0 || height <= 0 || (width == this->width && height == this->height)) {
+		return;
+	}
+	this->width = width;
+	this->height = height;
+	DeleteTargets();
+	CreateTargets();
+}
+
+/***********************************************************************
+ * CreateTexture: Creates one screen sized target.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - format: The sized internal format.
+ *
+ * Return: GLuint - The texture, with one level and nearest filtering.
+ ***********************************************************************/
+GLuint DeferredRenderer::CreateTexture(GLenum format)
+{
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	GLState::Get().BindTexture(GL_TEXTURE_2D, texture, 0);
+	glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+/***********************************************************************
+ * CreateTargets: Creates the G-buffer and the light buffer.
+ * Author: [Smirti Parajuli]
+ * Description: Both framebuffers share the depth texture, so the forward
+ *              packets drawn after the lighting are tested against the
+ *              geometry of the G-buffer.
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void DeferredRenderer::CreateTargets()
+{
+	albedoTexture = CreateTexture(GL_RGBA8);
+	normalTexture = CreateTexture(GL_RG16F);
+	depthTexture = CreateTexture(GL_DEPTH_COMPONENT32F);
+	lightTexture = CreateTexture(GL_RGBA16F);
+
+	glGenFramebuffers(1, &gbuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, gbuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+	const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, drawBuffers);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "Deferred shading: the G-buffer is incomplete" << std::endl;
+	}
+
+	glGenFramebuffers(1, &lightBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, lightBuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, lightTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "Deferred shading: the light buffer is incomplete" << std::endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************************
+ * DeleteTargets: Deletes the framebuffers and their textures.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void DeferredRenderer::DeleteTargets()
+{
+	glDeleteFramebuffers(1, &gbuffer);
+	glDeleteFramebuffers(1, &lightBuffer);
+	gbuffer = 0;
+	lightBuffer = 0;
+	for (GLuint* texture : { &albedoTexture, &normalTexture, &depthTexture, &lightTexture }) {
+		if (*texture != 0) {
+			GLState::Get().ForgetTexture(*texture);
+			glDeleteTextures(1, texture);
+			*texture = 0;
+		}
+	}
+}
+
+/***********************************************************************
+ * BeginGeometry: Gets the G-buffer ready for the geometry pass.
+ * Author: [Smirti Parajuli]
+ * Description: Only depth is cleared. Pixels left at the far plane are
+ *              skipped by the lighting, so stale colours are never read.
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void DeferredRenderer::BeginGeometry()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, gbuffer);
+	GLState::Get().DepthMask(GL_TRUE);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+/***********************************************************************
+ * ExecuteLighting: Lights the G-buffer.
+ * Author: [Smirti Parajuli]
+ * Description: A fullscreen triangle adds the ambient, directional, spot
+ *              and rim light to every covered pixel. Then one cube per
+ *              point light is drawn by its back faces, with the depth test
+ *              reversed, so a light only shades the pixels whose surface
+ *              lies in front of the far side of its volume, and the
+ *              results are added up with blending. The depth texture is
+ *              read while the light buffer tests against it, which is
+ *              well defined after a texture barrier as long as nothing
+ *              writes depth.
+ * Parameters:
+ *   - frame: The snapshot holding the camera and the point light count.
+ *   - stats: Receives the fragments and GPU time of the lighting, or nullptr.
+ *
+ * Return: None
+ ***********************************************************************/
+void DeferredRenderer::ExecuteLighting(const FrameSnapshot& frame, OverdrawStats* stats)
+{
+	GLState& state = GLState::Get();
+	glTextureBarrier();
+	glBindFramebuffer(GL_FRAMEBUFFER, lightBuffer);
+	glClear(GL_COLOR_BUFFER_BIT);
+	state.BindTexture(GL_TEXTURE_2D, albedoTexture, 1);
+	state.BindTexture(GL_TEXTURE_2D, normalTexture, 2);
+	state.BindTexture(GL_TEXTURE_2D, depthTexture, 3);
+
+	glm::mat4 inverseViewProjection = glm::inverse(frame.projection * frame.view);
+	glProgramUniformMatrix4fv(Program_Light, lightInverseLocation, 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+	glProgramUniformMatrix4fv(Program_PointLight, pointLightInverseLocation, 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+
+	// The lights are drawn filled in wireframe mode too
+	GLint polygonMode[2] = { GL_FILL, GL_FILL };
+	glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	if (stats) {
+		stats->Begin(StatsPass::Lighting);
+	}
+	state.SetEnabled(GL_DEPTH_TEST, false);
+	state.DepthMask(GL_FALSE);
+	state.UseProgram(Program_Light);
+	state.BindVertexArray(emptyVertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	if (frame.pointLightsEnabled && frame.pointLightCount > 0) {
+		MeshRange range = volumeMesh->GetRange();
+		state.SetEnabled(GL_DEPTH_TEST, true);
+		state.DepthFunc(GL_GEQUAL);
+		state.SetEnabled(GL_CULL_FACE, true);
+		state.CullFace(GL_FRONT);
+		state.SetEnabled(GL_BLEND, true);
+		state.BlendFunc(GL_ONE, GL_ONE);
+		state.UseProgram(Program_PointLight);
+		state.BindVertexArray(volumeMesh->GetVAO());
+		const void* indexOffset = reinterpret_cast<const void*>(static_cast<std::uintptr_t>(range.indexOffset));
+		glDrawElementsInstancedBaseInstance(GL_TRIANGLES, range.indexCount, range.indexType, indexOffset, frame.pointLightCount, range.mesh);
+		state.SetEnabled(GL_BLEND, false);
+		state.CullFace(GL_BACK);
+		state.SetEnabled(GL_CULL_FACE, false);
+	}
+	if (stats) {
+		stats->End(StatsPass::Lighting);
+	}
+
+	state.SetEnabled(GL_DEPTH_TEST, true);
+	state.DepthMask(GL_TRUE);
+	glPolygonMode(GL_FRONT_AND_BACK, static_cast<GLenum>(polygonMode[0]));
+}
+
+/***********************************************************************
+ * Present: Shows the lit frame.
+ * Author: [Smirti Parajuli]
+ * Description: Copies the light buffer to the window framebuffer, which
+ *              stays bound for the rest of the frame.
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void DeferredRenderer::Present()
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, lightBuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,74 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :DeferredRenderer.h
+Description :  The DeferredRenderer lights the opaque geometry after it is
+               drawn instead of while it is drawn. The geometry pass stores
+               each visible surface in a G-buffer: albedo with the
+               shininess packed in its alpha, an octahedral normal and the
+               depth the position is rebuilt from. The lighting pass then
+               shades every covered pixel once with the lights that reach
+               everywhere, and adds each point light only inside its light
+               volume, a cube around the sphere the light reaches. Forward
+               shading costs fragments times lights, this costs fragments
+               plus the pixels covered by the light volumes.
+               The result is kept in a light buffer that shares the depth
+               of the G-buffer, so the sky, the impostors and everything
+               else the queue still shades forward is drawn into it before
+               it is copied to the window.
+               All access must happen on the thread that owns the GL context.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef DEFERREDRENDERER_H
+#define DEFERREDRENDERER_H
+
+#include <glew.h>
+#include <memory>
+#include "FrameSnapshot.h"
+#include "OverdrawStats.h"
+#include "Mesh.h"
+
+class DeferredRenderer
+{
+public:
+	DeferredRenderer();
+	~DeferredRenderer();
+
+	void Resize(int width, int height);// Recreates the targets when the framebuffer size changed
+	void BeginGeometry();// Binds and clears the G-buffer for RenderQueue::ExecuteGBuffer
+	// Lights the G-buffer into the light buffer and leaves it bound for the forward packets, stats is optional
+	void ExecuteLighting(const FrameSnapshot& frame, OverdrawStats* stats = nullptr);
+	void Present();// Copies the light buffer to the window and binds the window again
+
+	// Copying and assignment not allowed for this class
+	DeferredRenderer(const DeferredRenderer&) = delete;
+	DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+
+private:
+	void CreateTargets();
+	void DeleteTargets();
+	GLuint CreateTexture(GLenum format);// Screen sized, read with texelFetch
+
+	int width = 0;
+	int height = 0;
+	GLuint gbuffer = 0;// Framebuffer of albedoTexture, normalTexture and depthTexture
+	GLuint lightBuffer = 0;// Framebuffer of lightTexture and depthTexture
+	GLuint albedoTexture = 0;// RGBA8, shininess in alpha
+	GLuint normalTexture = 0;// RG16F octahedral normal
+	GLuint depthTexture = 0;// 32-bit float depth
+	GLuint lightTexture = 0;// RGBA16F, lit result
+
+	GLuint emptyVertexArray = 0;// The fullscreen triangle has no vertex data
+	std::unique_ptr<Mesh> volumeMesh;// Unit cube in the geometry pool, scaled per light
+	GLuint Program_Light;// Ambient, directional, spot and rim light over the whole screen
+	GLuint Program_PointLight;// One instance per point light volume
+	GLint lightInverseLocation = -1;// InverseViewProjection of each program
+	GLint pointLightInverseLocation = -1;
+};
+#endif // DEFERREDRENDERER_H
@@ -0,0 +1,341 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :EntityStore.cpp
+Description :  Implementation of the structure of arrays entity store.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "EntityStore.h"
+#include <cmath>
+
+/***********************************************************************
+ * EntityStore: Constructor for the EntityStore class.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+EntityStore::EntityStore()
+{
+}
+
+/***********************************************************************
+ * Reserve: Reserves room in every array.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - count: Number of entities expected.
+ *
+ * Return: None
+ ***********************************************************************/
+void EntityStore::Reserve(size_t count)
+{
+	positionX.reserve(count);
+	positionY.reserve(count);
+	positionZ.reserve(count);
+	rotationX.reserve(count);
+	rotationY.reserve(count);
+	rotationZ.reserve(count);
+	rotationW.reserve(count);
+	velocityX.reserve(count);
+	velocityY.reserve(count);
+	velocityZ.reserve(count);
+	scale.reserve(count);
+	material.reserve(count);
+	flags.reserve(count);
+	denseToSlot.reserve(count);
+	slots.reserve(count);
+}
+
+/***********************************************************************
+ * Create: Adds an entity at the end of the dense arrays.
+ * Author: [Smirti Parajuli]
+ * Description: Reuses a free slot when there is one so the slot table
+ *              does not grow when entities come and go.
+ *
+ * Parameters:
+ *   - position: World position.
+ *   - scale: Uniform scale.
+ *   - material: What the entity is drawn with.
+ *   - flags: EntityFlags bits.
+ *
+ * Return: Handle to the new entity.
+ ***********************************************************************/
+EntityHandle EntityStore::Create(const glm::vec3& position, float scale, MaterialId material, std::uint32_t flags)
+{
+	std::uint32_t dense = static_cast<std::uint32_t>(positionX.size());
+	positionX.push_back(position.x);
+	positionY.push_back(position.y);
+	positionZ.push_back(position.z);
+	rotationX.push_back(0.0f);
+	rotationY.push_back(0.0f);
+	rotationZ.push_back(0.0f);
+	rotationW.push_back(1.0f);
+	velocityX.push_back(0.0f);
+	velocityY.push_back(0.0f);
+	velocityZ.push_back(0.0f);
+	this->scale.push_back(scale);
+	this->material.push_back(material);
+	this->flags.push_back(flags);
+
+	std::uint32_t slot;
+	if (freeSlot != InvalidIndex) {
+		slot = freeSlot;
+		freeSlot = slots[slot].dense;
+	}
+	else {
+		slot = static_cast<std::uint32_t>(slots.size());
+		slots.push_back({ InvalidIndex, 0 });
+	}
+	slots[slot].dense = dense;
+	denseToSlot.push_back(slot);
+
+	EntityHandle handle;
+	handle.slot = slot;
+	handle.generation = slots[slot].generation;
+	return handle;
+}
+
+/***********************************************************************
+ * Destroy: Removes an entity.
+ * Author: [Smirti Parajuli]
+ * Description: The last entity is moved into the hole so the arrays stay
+ *              packed, and its slot is pointed at the new index.
+ *
+ * Parameters:
+ *   - handle: The entity to remove, ignored if already destroyed.
+ *
+ * Return: None
+ ***********************************************************************/
+void EntityStore::Destroy(EntityHandle handle)
+{
+	if (!IsAlive(handle)) {
+		return;
+	}
+	std::uint32_t dense = slots[handle.slot].dense;
+	std::uint32_t last = static_cast<std::uint32_t>(positionX.size() - 1);
+
+	if (dense != last) {
+		positionX[dense] = positionX[last];
+		positionY[dense] = positionY[last];
+		positionZ[dense] = positionZ[last];
+		rotationX[dense] = rotationX[last];
+		rotationY[dense] = rotationY[last];
+		rotationZ[dense] = rotationZ[last];
+		rotationW[dense] = rotationW[last];
+		velocityX[dense] = velocityX[last];
+		velocityY[dense] = velocityY[last];
+		velocityZ[dense] = velocityZ[last];
+		scale[dense] = scale[last];
+		material[dense] = material[last];
+		flags[dense] = flags[last];
+		denseToSlot[dense] = denseToSlot[last];
+		slots[denseToSlot[dense]].dense = dense;
+	}
+	positionX.pop_back();
+	positionY.pop_back();
+	positionZ.pop_back();
+	rotationX.pop_back();
+	rotationY.pop_back();
+	rotationZ.pop_back();
+	rotationW.pop_back();
+	velocityX.pop_back();
+	velocityY.pop_back();
+	velocityZ.pop_back();
+	scale.pop_back();
+	material.pop_back();
+	flags.pop_back();
+	denseToSlot.pop_back();
+
+	slots[handle.slot].generation++;
+	slots[handle.slot].dense = freeSlot;
+	freeSlot = handle.slot;
+}
+
+/***********************************************************************
+ * IsAlive: Checks a handle against its slot.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - handle: The handle to check.
+ *
+ * Return: True if the entity still exists.
+ ***********************************************************************/
+bool EntityStore::IsAlive(EntityHandle handle) const
+{
+	return handle.slot < slots.size() && slots[handle.slot].generation == handle.generation;
+}
+
+/***********************************************************************
+ * IndexOf: Resolves a handle to its dense index.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - handle: A live handle.
+ *
+ * Return: Index into the dense arrays.
+ ***********************************************************************/
+size_t EntityStore::IndexOf(EntityHandle handle) const
+{
+	return slots[handle.slot].dense;
+}
+
+/***********************************************************************
+ * GetPosition: Reads the position of an entity.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - handle: A live handle.
+ *
+ * Return: World position.
+ ***********************************************************************/
+glm::vec3 EntityStore::GetPosition(EntityHandle handle) const
+{
+	size_t i = IndexOf(handle);
+	return glm::vec3(positionX[i], positionY[i], positionZ[i]);
+}
+
+/***********************************************************************
+ * SetPosition: Moves an entity.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - handle: A live handle.
+ *   - position: New world position.
+ *
+ * Return: None
+ ***********************************************************************/
+void EntityStore::SetPosition(EntityHandle handle, const glm::vec3& position)
+{
+	size_t i = IndexOf(handle);
+	positionX[i] = position.x;
+	positionY[i] = position.y;
+	positionZ[i] = position.z;
+}
+
+/***********************************************************************
+ * Rotate: Applies one rotation to a set of entities.
+ * Author: [Smirti Parajuli]
+ * Description: Pre-multiplies the rotation of every entity whose flags
+ *              contain flagMask and renormalises it so repeated steps do
+ *              not drift. The loop has no branches and only touches the
+ *              flag and rotation arrays, so the compiler can vectorise it.
+ *
+ * Parameters:
+ *   - flagMask: Bits an entity must have to be rotated.
+ *   - rotation: Unit quaternion as (x, y, z, w).
+ *
+ * Return: None
+ ***********************************************************************/
+void EntityStore::Rotate(std::uint32_t flagMask, const glm::vec4& rotation)
+{
+	const float rx = rotation.x, ry = rotation.y, rz = rotation.z, rw = rotation.w;
+	const size_t count = positionX.size();
+	const std::uint32_t* entityFlags = flags.data();
+	float* qx = rotationX.data();
+	float* qy = rotationY.data();
+	float* qz = rotationZ.data();
+	float* qw = rotationW.data();
+
+	for (size_t i = 0; i < count; i++) {
+		float x = rw * qx[i] + rx * qw[i] + ry * qz[i] - rz * qy[i];
+		float y = rw * qy[i] - rx * qz[i] + ry * qw[i] + rz * qx[i];
+		float z = rw * qz[i] + rx * qy[i] - ry * qx[i] + rz * qw[i];
+		float w = rw * qw[i] - rx * qx[i] - ry * qy[i] - rz * qz[i];
+		float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+
+		bool selected = (entityFlags[i] & flagMask) == flagMask;
+		qx[i] = selected ? x * inverseLength : qx[i];
+		qy[i] = selected ? y * inverseLength : qy[i];
+		qz[i] = selected ? z * inverseLength : qz[i];
+		qw[i] = selected ? w * inverseLength : qw[i];
+	}
+}
+
+/***********************************************************************
+ * Cull: Collects the visible entities of one material.
+ * Author: [Smirti Parajuli]
+ * Description: Tests every entity's bounding sphere against all six planes
+ *              without early outs, reading only the position, scale,
+ *              material and flag arrays.
+ *
+ * Parameters:
+ *   - frustum: The camera frustum.
+ *   - material: Only entities with this material are reported.
+ *   - baseRadius: Bounding radius of the mesh at scale 1.
+ *   - visible: Receives the dense indices in dense order, room for Size().
+ *
+ * Return: size_t - Number of indices written.
+ ***********************************************************************/
+size_t EntityStore::Cull(const Frustum& frustum, MaterialId material, float baseRadius, std::uint32_t* visible) const
+{
+	return Cull(frustum, material, baseRadius, 0, positionX.size(), visible);
+}
+
+/***********************************************************************
+ * Cull: Collects the visible entities of one material in a range.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - frustum: The camera frustum.
+ *   - material: Only entities with this material are reported.
+ *   - baseRadius: Bounding radius of the mesh at scale 1.
+ *   - begin: First dense index tested.
+ *   - end: One past the last dense index tested.
+ *   - visible: Receives the dense indices in dense order, room for end - begin.
+ *
+ * Return: size_t - Number of indices written.
+ ***********************************************************************/
+size_t EntityStore::Cull(const Frustum& frustum, MaterialId material, float baseRadius, size_t begin, size_t end, std::uint32_t* visible) const
+{
+	size_t count = 0;
+	for (size_t i = begin; i < end; i++) {
+		if (this->material[i] != material || (flags[i] & EntityVisible) == 0) {
+			continue;
+		}
+		bool inside = true;
+		if (flags[i] & EntityCullable) {
+			float radius = baseRadius * scale[i];
+			for (int p = 0; p < 6; p++) {
+				const glm::vec4& plane = frustum.planes[p];
+				float distance = plane.x * positionX[i] + plane.y * positionY[i] + plane.z * positionZ[i] + plane.w;
+				inside &= (distance >= -radius);
+			}
+		}
+		if (inside) {
+			visible[count++] = static_cast<std::uint32_t>(i);
+		}
+	}
+	return count;
+}
+
+/***********************************************************************
+ * BuildModel: Builds the model matrix of an entity.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - index: Dense index of the entity.
+ *   - extraRotation: Unit quaternion (x, y, z, w) applied on top of the
+ *                    entity's rotation, e.g. for interpolation.
+ *
+ * Return: Translation * rotation * scale.
+ ***********************************************************************/
+glm::mat4 EntityStore::BuildModel(size_t index, const glm::vec4& extraRotation) const
+{
+	const float rx = extraRotation.x, ry = extraRotation.y, rz = extraRotation.z, rw = extraRotation.w;
+	const float ex = rotationX[index], ey = rotationY[index], ez = rotationZ[index], ew = rotationW[index];
+	float x = rw * ex + rx * ew + ry * ez - rz * ey;
+	float y = rw * ey - rx * ez + ry * ew + rz * ex;
+	float z = rw * ez + rx * ey - ry * ex + rz * ew;
+	float w = rw * ew - rx * ex - ry * ey - rz * ez;
+
+	float s = scale[index];
+	float xx = x * x, yy = y * y, zz = z * z;
+	float xy = x * y, xz = x * z, yz = y * z;
+	float wx = w * x, wy = w * y, wz = w * z;
+
+	glm::mat4 model;
+	model[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * s;
+	model[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * s;
+	model[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * s;
+	model[3] = glm::vec4(positionX[index], positionY[index], positionZ[index], 1.0f);
+	return model;
+}
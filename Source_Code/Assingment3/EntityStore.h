@@ -0,0 +1,102 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :EntityStore.h
+Description :  The EntityStore keeps every scene entity as a structure of
+               arrays: positions, rotations, scales, material ids and flags
+               each live in their own contiguous array, packed with no holes,
+               so updaters and culling walk memory linearly. Entities are
+               referred to by generational handles that stay valid while the
+               dense arrays are compacted underneath them.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef ENTITYSTORE_H
+#define ENTITYSTORE_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "Frustum.h"
+
+// What an entity is drawn with
+enum MaterialId : std::uint16_t
+{
+	MaterialSphere = 0,// Textured Blinn-Phong sphere
+	MaterialReflective = 1,// Sphere reflecting the skybox
+	MaterialLightMarker = 2,// Unlit cube showing a point light
+	MaterialCount
+};
+
+// Behaviour and state bits, tested with masks in the update loops
+enum EntityFlags : std::uint32_t
+{
+	EntityVisible = 1u << 0,// Taken into account by culling
+	EntitySpinning = 1u << 1,// Turned by the spin updater every step
+	EntityCullable = 1u << 2,// Frustum tested, otherwise always drawn when visible
+	EntityDynamic = 1u << 3// Moved and collided by the sphere physics
+};
+
+// Stable reference to an entity, survives other entities being destroyed
+struct EntityHandle
+{
+	std::uint32_t slot = 0xFFFFFFFFu;
+	std::uint32_t generation = 0;
+};
+
+class EntityStore
+{
+public:
+	EntityStore();
+
+	void Reserve(size_t count);
+	EntityHandle Create(const glm::vec3& position, float scale, MaterialId material, std::uint32_t flags);
+	void Destroy(EntityHandle handle);// Moves the last entity into the hole, handles stay valid
+	bool IsAlive(EntityHandle handle) const;
+	size_t IndexOf(EntityHandle handle) const;// Dense index, only valid until the next Destroy
+
+	size_t Size() const { return positionX.size(); }
+
+	// Per entity access through a handle
+	glm::vec3 GetPosition(EntityHandle handle) const;
+	void SetPosition(EntityHandle handle, const glm::vec3& position);
+
+	// Updater: rotates every entity with all bits of flagMask set by the same rotation
+	void Rotate(std::uint32_t flagMask, const glm::vec4& rotation);
+
+	// Culling: writes the dense index of every visible entity of a material inside the frustum and returns how many
+	// visible needs room for Size() indices, so it can come from a frame arena
+	size_t Cull(const Frustum& frustum, MaterialId material, float baseRadius, std::uint32_t* visible) const;
+	// Same over the dense range [begin, end) only, so culling can be split into jobs, visible needs end - begin
+	size_t Cull(const Frustum& frustum, MaterialId material, float baseRadius, size_t begin, size_t end, std::uint32_t* visible) const;
+
+	// Model matrix of a dense index, with an extra rotation applied before the entity's own
+	glm::mat4 BuildModel(size_t index, const glm::vec4& extraRotation) const;
+
+	// Dense arrays, index i of every array describes the same entity
+	std::vector<float> positionX, positionY, positionZ;
+	std::vector<float> rotationX, rotationY, rotationZ, rotationW;// Unit quaternion
+	std::vector<float> velocityX, velocityY, velocityZ;// World units per second
+	std::vector<float> scale;// Uniform scale
+	std::vector<std::uint16_t> material;
+	std::vector<std::uint32_t> flags;
+
+private:
+	struct Slot
+	{
+		std::uint32_t dense;// Index into the dense arrays while alive, next free slot otherwise
+		std::uint32_t generation;// Bumped on destroy so stale handles are rejected
+	};
+
+	static const std::uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+	std::vector<Slot> slots;
+	std::vector<std::uint32_t> denseToSlot;
+	std::uint32_t freeSlot = InvalidIndex;// Head of the free slot list
+};
+#endif // ENTITYSTORE_H
@@ -0,0 +1,662 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :EnvironmentLighting.cpp
+Description :  Implementation of the image-based lighting of the skybox:
+               the spherical harmonic projection, the GGX prefiltering and
+               the cache file.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "EnvironmentLighting.h"
+#include "ShaderBindings.h"
+#include "GLState.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <glm/glm.hpp>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define ENVIRONMENT_LIGHTING_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	const char CacheMagic[4] = { 'E', 'N', 'V', 'L' };
+	const float Pi = 3.14159265358979f;
+	const int PyramidCount = 8;// BaseSize down to one texel
+	static_assert((EnvironmentLighting::BaseSize >> (PyramidCount - 1)) == 1, "The pyramid ends at one texel");
+
+	// Direction through texel (s, t) of a face is major + s * sAxis + t * tAxis, as OpenGL looks cube maps up
+	struct FaceAxes
+	{
+		float major[3];
+		float sAxis[3];
+		float tAxis[3];
+	};
+	const FaceAxes Faces[EnvironmentLighting::FaceCount] = {
+		{ { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f } },
+		{ { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, -1.0f, 0.0f } },
+		{ { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+		{ { 0.0f, -1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } },
+		{ { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } },
+		{ { 0.0f, 0.0f, -1.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } }
+	};
+
+	// Constants of the spherical harmonic basis, in the order the shader evaluates it
+	const float BasisConstants[EnvironmentLighting::CoefficientCount] = {
+		0.282095f, 0.488603f, 0.488603f, 0.488603f, 1.092548f, 1.092548f, 0.315392f, 1.092548f, 0.546274f
+	};
+	// Cosine lobe convolution of each band divided by pi, so the shader gets irradiance / pi
+	const float BandScales[EnvironmentLighting::CoefficientCount] = {
+		1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f
+	};
+
+	// One texel per lane
+	struct Float1 {
+		static const int Width = 1;
+		float v;
+
+		static Float1 Set1(float value) { return { value }; }
+		static Float1 Ramp(float start, float) { return { start }; }
+		static Float1 InverseSqrt(Float1 a) { return { 1.0f / std::sqrt(a.v) }; }
+		static void LoadRgb(const float* texels, Float1& r, Float1& g, Float1& b) {
+			r.v = texels[0];
+			g.v = texels[1];
+			b.v = texels[2];
+		}
+		static float Sum(Float1 a) { return a.v; }
+	};
+	inline Float1 operator+(Float1 a, Float1 b) { return { a.v + b.v }; }
+	inline Float1 operator-(Float1 a, Float1 b) { return { a.v - b.v }; }
+	inline Float1 operator*(Float1 a, Float1 b) { return { a.v * b.v }; }
+
+#if defined(ENVIRONMENT_LIGHTING_SSE)
+	// Four texels of a row per register
+	struct Sse4 {
+		static const int Width = 4;
+		__m128 v;
+
+		static Sse4 Set1(float value) { return { _mm_set1_ps(value) }; }
+		static Sse4 Ramp(float start, float step) {
+			return { _mm_set_ps(start + 3.0f * step, start + 2.0f * step, start + step, start) };
+		}
+		static Sse4 InverseSqrt(Sse4 a) { return { _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(a.v)) }; }
+		// Four RGBA texels, transposed into a register per channel
+		static void LoadRgb(const float* texels, Sse4& r, Sse4& g, Sse4& b) {
+			__m128 row0 = _mm_loadu_ps(texels), row1 = _mm_loadu_ps(texels + 4);
+			__m128 row2 = _mm_loadu_ps(texels + 8), row3 = _mm_loadu_ps(texels + 12);
+			_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+			r.v = row0;
+			g.v = row1;
+			b.v = row2;
+		}
+		static float Sum(Sse4 a) {
+			float lanes[4];
+			_mm_storeu_ps(lanes, a.v);
+			return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+		}
+	};
+	inline Sse4 operator+(Sse4 a, Sse4 b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline Sse4 operator-(Sse4 a, Sse4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+	inline Sse4 operator*(Sse4 a, Sse4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+	typedef Sse4 ProjectionLanes;
+#else
+	typedef Float1 ProjectionLanes;
+#endif
+
+	// Floats in one face of a pyramid or specular level
+	size_t FaceFloats(int size)
+	{
+		return static_cast<size_t>(size) * size * 4;
+	}
+
+	/***********************************************************************
+	 * FaceDirection: The unnormalised direction through a texel centre.
+	 * Author: [Smirti Parajuli]
+	 * Parameters:
+	 *   - face: Cube map face, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face.
+	 *   - x, y: Texel, row 0 being the first row of the face image.
+	 *   - size: Texels along an edge of the face.
+	 *
+	 * Return: glm::vec3 - The direction, its major axis of length 1.
+	 ***********************************************************************/
+	glm::vec3 FaceDirection(int face, int x, int y, int size)
+	{
+		const FaceAxes& axes = Faces[face];
+		float s = (x + 0.5f) * 2.0f / size - 1.0f;
+		float t = (y + 0.5f) * 2.0f / size - 1.0f;
+		return glm::vec3(axes.major[0] + s * axes.sAxis[0] + t * axes.tAxis[0],
+			axes.major[1] + s * axes.sAxis[1] + t * axes.tAxis[1],
+			axes.major[2] + s * axes.sAxis[2] + t * axes.tAxis[2]);
+	}
+
+	/***********************************************************************
+	 * SampleFace: Bilinear sample of one pyramid level.
+	 * Author: [Smirti Parajuli]
+	 * Description: Finds the face the way OpenGL does and clamps at its
+	 *              edges, the other faces are not blended in.
+	 * Parameters:
+	 *   - level: RGBA texels of the six faces.
+	 *   - size: Texels along an edge of a face.
+	 *   - direction: Any length.
+	 *
+	 * Return: glm::vec3 - The filtered colour.
+	 ***********************************************************************/
+	glm::vec3 SampleFace(const std::vector<float>& level, int size, const glm::vec3& direction)
+	{
+		float ax = std::fabs(direction.x), ay = std::fabs(direction.y), az = std::fabs(direction.z);
+		int face = 0;
+		float s = 0.0f;
+		float t = 0.0f;
+		if (ax >= ay && ax >= az) {
+			face = direction.x > 0.0f ? 0 : 1;
+			s = (direction.x > 0.0f ? -direction.z : direction.z) / ax;
+			t = -direction.y / ax;
+		}
+		else if (ay >= az) {
+			face = direction.y > 0.0f ? 2 : 3;
+			s = direction.x / ay;
+			t = (direction.y > 0.0f ? direction.z : -direction.z) / ay;
+		}
+		else {
+			face = direction.z > 0.0f ? 4 : 5;
+			s = (direction.z > 0.0f ? direction.x : -direction.x) / az;
+			t = -direction.y / az;
+		}
+
+		float u = glm::clamp((s * 0.5f + 0.5f) * size - 0.5f, 0.0f, static_cast<float>(size - 1));
+		float v = glm::clamp((t * 0.5f + 0.5f) * size - 0.5f, 0.0f, static_cast<float>(size - 1));
+		int x0 = static_cast<int>(u);
+		int y0 = static_cast<int>(v);
+		int x1 = std::min(x0 + 1, size - 1);
+		int y1 = std::min(y0 + 1, size - 1);
+		float fx = u - x0;
+		float fy = v - y0;
+
+		const float* texels = level.data() + FaceFloats(size) * face;
+		auto texel = [&](int x, int y) {
+			const float* p = texels + (static_cast<size_t>(y) * size + x) * 4;
+			return glm::vec3(p[0], p[1], p[2]);
+		};
+		glm::vec3 top = texel(x0, y0) * (1.0f - fx) + texel(x1, y0) * fx;
+		glm::vec3 bottom = texel(x0, y1) * (1.0f - fx) + texel(x1, y1) * fx;
+		return top * (1.0f - fy) + bottom * fy;
+	}
+
+	/***********************************************************************
+	 * ProjectRow: Projects one row of texels onto the basis.
+	 * Author: [Smirti Parajuli]
+	 * Description: V holds V::Width texels of the row, one per lane. Each
+	 *              texel is weighted by its solid angle, which falls with
+	 *              the cube of the distance of the texel from the centre
+	 *              of the sphere.
+	 * Parameters:
+	 *   - texels: RGBA texels of the row.
+	 *   - size: Texels along an edge of the face.
+	 *   - face: Cube map face of the row.
+	 *   - y: Row within the face.
+	 *   - sums: Receives the 27 RGB sums and the total solid angle.
+	 *
+	 * Return: None
+	 ***********************************************************************/
+	template <class V>
+	void ProjectRow(const float* texels, int size, int face, int y, float* sums)
+	{
+		const FaceAxes& axes = Faces[face];
+		const float step = 2.0f / size;
+		const V t = V::Set1((y + 0.5f) * step - 1.0f);
+		const V one = V::Set1(1.0f);
+		const V three = V::Set1(3.0f);
+		const V texelArea = V::Set1(step * step);
+		const V zero = V::Set1(0.0f);
+
+		V totals[EnvironmentLighting::CoefficientCount * 3];
+		for (V& total : totals) {
+			total = zero;
+		}
+		V solidAngle = zero;
+
+		for (int x = 0; x + V::Width <= size; x += V::Width) {
+			V s = V::Ramp((x + 0.5f) * step - 1.0f, step);
+			V inverseLength = V::InverseSqrt(one + s * s + t * t);
+			V weight = texelArea * inverseLength * inverseLength * inverseLength;
+			V dx = (V::Set1(axes.major[0]) + s * V::Set1(axes.sAxis[0]) + t * V::Set1(axes.tAxis[0])) * inverseLength;
+			V dy = (V::Set1(axes.major[1]) + s * V::Set1(axes.sAxis[1]) + t * V::Set1(axes.tAxis[1])) * inverseLength;
+			V dz = (V::Set1(axes.major[2]) + s * V::Set1(axes.sAxis[2]) + t * V::Set1(axes.tAxis[2])) * inverseLength;
+
+			V basis[EnvironmentLighting::CoefficientCount] = {
+				one, dy, dz, dx, dx * dy, dy * dz, three * dz * dz - one, dx * dz, dx * dx - dy * dy
+			};
+			V r, g, b;
+			V::LoadRgb(texels + static_cast<size_t>(x) * 4, r, g, b);
+			for (int i = 0; i < EnvironmentLighting::CoefficientCount; i++) {
+				V weighted = basis[i] * V::Set1(BasisConstants[i]) * weight;
+				totals[i * 3 + 0] = totals[i * 3 + 0] + weighted * r;
+				totals[i * 3 + 1] = totals[i * 3 + 1] + weighted * g;
+				totals[i * 3 + 2] = totals[i * 3 + 2] + weighted * b;
+			}
+			solidAngle = solidAngle + weight;
+		}
+
+		for (int i = 0; i < EnvironmentLighting::CoefficientCount * 3; i++) {
+			sums[i] = V::Sum(totals[i]);
+		}
+		sums[EnvironmentLighting::CoefficientCount * 3] = V::Sum(solidAngle);
+	}
+
+	// A GGX sample around +z, the normal, for a view straight down the normal
+	struct LobeSample
+	{
+		glm::vec3 direction;
+		float level;// Pyramid level whose texels cover the solid angle of the sample
+	};
+
+	/***********************************************************************
+	 * BuildLobe: Importance samples the GGX lobe of one roughness.
+	 * Author: [Smirti Parajuli]
+	 * Description: Half vectors follow the GGX distribution over a
+	 *              Hammersley set. With the view along the normal the pdf
+	 *              of a reflected direction is D / 4. Each sample reads the
+	 *              pyramid level whose texels are about as big as the solid
+	 *              angle it stands for, which keeps the few samples free of
+	 *              bright speckles.
+	 * Parameters:
+	 *   - roughness: Perceptual roughness, alpha is its square.
+	 *   - out: Receives the samples above the surface.
+	 *
+	 * Return: None
+	 ***********************************************************************/
+	void BuildLobe(float roughness, std::vector<LobeSample>& out)
+	{
+		out.clear();
+		float alpha = roughness * roughness;
+		float alphaSquared = alpha * alpha;
+		float texelSolidAngle = 4.0f * Pi / (EnvironmentLighting::FaceCount * EnvironmentLighting::BaseSize * EnvironmentLighting::BaseSize);
+		for (unsigned int i = 0; i < static_cast<unsigned int>(EnvironmentLighting::SampleCount); i++) {
+			// Van der Corput radical inverse of i
+			unsigned int bits = i;
+			bits = (bits << 16u) | (bits >> 16u);
+			bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+			bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+			bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+			bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+			float u = static_cast<float>(i) / EnvironmentLighting::SampleCount;
+			float v = static_cast<float>(bits) * 2.3283064365386963e-10f;
+
+			float phi = 2.0f * Pi * u;
+			float cosTheta = std::sqrt((1.0f - v) / (1.0f + (alphaSquared - 1.0f) * v));
+			float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+			glm::vec3 half(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+			glm::vec3 direction = 2.0f * half.z * half - glm::vec3(0.0f, 0.0f, 1.0f);
+			if (direction.z <= 0.0f) {
+				continue;
+			}
+
+			float denominator = cosTheta * cosTheta * (alphaSquared - 1.0f) + 1.0f;
+			float distribution = alphaSquared / (Pi * denominator * denominator);
+			float sampleSolidAngle = 1.0f / (EnvironmentLighting::SampleCount * distribution * 0.25f + 1e-6f);
+			float level = 0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f;
+			out.push_back({ direction, glm::clamp(level, 0.0f, static_cast<float>(PyramidCount - 1)) });
+		}
+	}
+}
+
+/***********************************************************************
+ * ~EnvironmentLighting: Destructor for the EnvironmentLighting class.
+ * Author: [Smirti Parajuli]
+ * Description: Releases the specular cube map and the EnvironmentData
+ *              buffer.
+ * Parameters: None
+ *
+ * Return: None (destructor)
+ ***********************************************************************/
+EnvironmentLighting::~EnvironmentLighting()
+{
+	GLState::Get().ForgetTexture(specularTexture);
+	glDeleteTextures(1, &specularTexture);
+	glDeleteBuffers(1, &environmentBuffer);
+}
+
+/***********************************************************************
+ * GetLevelOffset: Finds a specular level in the cooked data.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - level: Specular level, 0 is the sharpest.
+ *
+ * Return: size_t - Floats from the start of the cooked data.
+ ***********************************************************************/
+size_t EnvironmentLighting::GetLevelOffset(int level)
+{
+	size_t offset = CoefficientCount * 4;
+	for (int i = 0; i < level; i++) {
+		offset += FaceFloats(BaseSize >> i) * FaceCount;
+	}
+	return offset;
+}
+
+/***********************************************************************
+ * GetCookedSize: Size of the cooked data.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: size_t - Floats of the coefficients and every level.
+ ***********************************************************************/
+size_t EnvironmentLighting::GetCookedSize()
+{
+	return GetLevelOffset(LevelCount);
+}
+
+/***********************************************************************
+ * Create: Makes the lighting of a skybox.
+ * Author: [Smirti Parajuli]
+ * Description: The key hashes the hashes of the six decoded faces, so
+ *              any change to an image computes the lighting again. A
+ *              fresh result is written to the cache for the next start.
+ *              The coefficients are bound to the EnvironmentData block
+ *              here, nothing else uses that binding.
+ * Parameters:
+ *   - faces: The decoded faces, in cube map face order.
+ *   - faceHashes: AssetPack::Hash of the pixels of each face.
+ *   - cachePath: File the results are read from and written to.
+ *   - jobs: The job system the computation is spread over.
+ *
+ * Return: None
+ ***********************************************************************/
+void EnvironmentLighting::Create(const ImageAsset faces[FaceCount], const std::uint64_t faceHashes[FaceCount], const std::string& cachePath, JobSystem& jobs)
+{
+	std::uint64_t key = AssetPack::Hash(faceHashes, sizeof(std::uint64_t) * FaceCount);
+	fromCache = ReadCache(cachePath, key);
+	if (!fromCache) {
+		Compute(faces, jobs);
+		WriteCache(cachePath, key);
+	}
+	Upload();
+}
+
+/***********************************************************************
+ * Compute: Projects and prefilters the sky.
+ * Author: [Smirti Parajuli]
+ * Description: The faces are first averaged down to BaseSize and then
+ *              halved down to one texel, all as linear floats. The bytes
+ *              are used as they are, the way the skybox shows them. The
+ *              coefficients come from the BaseSize level, each row
+ *              projected on its own and the row sums added in order, so
+ *              the result does not depend on the thread count. Specular
+ *              level 0 is the BaseSize level itself, each further level
+ *              averages the GGX lobe of its roughness over the pyramid.
+ * Parameters:
+ *   - faces: The decoded faces, in cube map face order.
+ *   - jobs: The job system the rows are spread over.
+ *
+ * Return: None
+ ***********************************************************************/
+void EnvironmentLighting::Compute(const ImageAsset faces[FaceCount], JobSystem& jobs)
+{
+	cooked.assign(GetCookedSize(), 0.0f);
+
+	// Area average of each face down to BaseSize
+	std::vector<float> pyramid[PyramidCount];
+	pyramid[0].assign(FaceFloats(BaseSize) * FaceCount, 0.0f);
+	jobs.ParallelFor(FaceCount * BaseSize, 16, [&](size_t begin, size_t end) {
+		for (size_t row = begin; row < end; row++) {
+			int face = static_cast<int>(row / BaseSize);
+			int y = static_cast<int>(row % BaseSize);
+			const ImageAsset& image = faces[face];
+			if (image.GetPixels() == nullptr) {
+				continue;// Black, Failed To load the Image was already reported
+			}
+			int width = image.GetWidth();
+			int height = image.GetHeight();
+			int channels = image.GetChannels();
+			int y0 = y * height / BaseSize;
+			int y1 = std::max((y + 1) * height / BaseSize, y0 + 1);
+			float* out = pyramid[0].data() + FaceFloats(BaseSize) * face + static_cast<size_t>(y) * BaseSize * 4;
+			for (int x = 0; x < BaseSize; x++) {
+				int x0 = x * width / BaseSize;
+				int x1 = std::max((x + 1) * width / BaseSize, x0 + 1);
+				float sum[3] = {};
+				for (int sy = y0; sy < y1; sy++) {
+					const unsigned char* pixel = image.GetPixels() + (static_cast<size_t>(sy) * width + x0) * channels;
+					for (int sx = x0; sx < x1; sx++, pixel += channels) {
+						sum[0] += pixel[0];
+						sum[1] += pixel[channels > 1 ? 1 : 0];
+						sum[2] += pixel[channels > 2 ? 2 : 0];
+					}
+				}
+				float scale = 1.0f / (255.0f * (x1 - x0) * (y1 - y0));
+				out[x * 4 + 0] = sum[0] * scale;
+				out[x * 4 + 1] = sum[1] * scale;
+				out[x * 4 + 2] = sum[2] * scale;
+			}
+		}
+	});
+	for (int level = 1; level < PyramidCount; level++) {
+		int size = BaseSize >> level;
+		const std::vector<float>& above = pyramid[level - 1];
+		pyramid[level].assign(FaceFloats(size) * FaceCount, 0.0f);
+		for (int face = 0; face < FaceCount; face++) {
+			const float* in = above.data() + FaceFloats(size * 2) * face;
+			float* out = pyramid[level].data() + FaceFloats(size) * face;
+			for (int y = 0; y < size; y++) {
+				for (int x = 0; x < size; x++) {
+					for (int channel = 0; channel < 3; channel++) {
+						const float* quad = in + (static_cast<size_t>(y) * 2 * size * 2 + x * 2) * 4 + channel;
+						out[(static_cast<size_t>(y) * size + x) * 4 + channel] = 0.25f * (quad[0] + quad[4] + quad[size * 2 * 4] + quad[size * 2 * 4 + 4]);
+					}
+				}
+			}
+		}
+	}
+
+	// Irradiance, one set of sums per row
+	const int SumCount = CoefficientCount * 3 + 1;
+	std::vector<float> rowSums(static_cast<size_t>(FaceCount) * BaseSize * SumCount, 0.0f);
+	jobs.ParallelFor(FaceCount * BaseSize, 32, [&](size_t begin, size_t end) {
+		for (size_t row = begin; row < end; row++) {
+			int face = static_cast<int>(row / BaseSize);
+			int y = static_cast<int>(row % BaseSize);
+			const float* texels = pyramid[0].data() + FaceFloats(BaseSize) * face + static_cast<size_t>(y) * BaseSize * 4;
+			ProjectRow<ProjectionLanes>(texels, BaseSize, face, y, rowSums.data() + row * SumCount);
+		}
+	});
+	double totals[SumCount] = {};
+	for (size_t row = 0; row < static_cast<size_t>(FaceCount) * BaseSize; row++) {
+		for (int i = 0; i < SumCount; i++) {
+			totals[i] += rowSums[row * SumCount + i];
+		}
+	}
+	// The texel weights miss the exact solid angles slightly, scaled so they cover the sphere
+	double normalise = totals[SumCount - 1] > 0.0 ? 4.0 * Pi / totals[SumCount - 1] : 0.0;
+	for (int i = 0; i < CoefficientCount; i++) {
+		for (int channel = 0; channel < 3; channel++) {
+			cooked[i * 4 + channel] = static_cast<float>(totals[i * 3 + channel] * normalise) * BandScales[i] * BasisConstants[i];
+		}
+	}
+
+	// Specular level 0 is the sky itself, alpha stays 0
+	std::copy(pyramid[0].begin(), pyramid[0].end(), cooked.begin() + GetLevelOffset(0));
+
+	// Each further level, the lobe turned to every texel's direction
+	std::vector<LobeSample> lobe;
+	for (int level = 1; level < LevelCount; level++) {
+		int size = BaseSize >> level;
+		BuildLobe(static_cast<float>(level) / (LevelCount - 1), lobe);
+		float* levelTexels = cooked.data() + GetLevelOffset(level);
+		jobs.ParallelFor(static_cast<size_t>(FaceCount) * size, 4, [&](size_t begin, size_t end) {
+			for (size_t row = begin; row < end; row++) {
+				int face = static_cast<int>(row / size);
+				int y = static_cast<int>(row % size);
+				float* out = levelTexels + FaceFloats(size) * face + static_cast<size_t>(y) * size * 4;
+				for (int x = 0; x < size; x++) {
+					glm::vec3 normal = glm::normalize(FaceDirection(face, x, y, size));
+					glm::vec3 up = std::fabs(normal.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+					glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
+					glm::vec3 bitangent = glm::cross(normal, tangent);
+
+					glm::vec3 colour(0.0f);
+					float weight = 0.0f;
+					for (const LobeSample& sample : lobe) {
+						glm::vec3 direction = tangent * sample.direction.x + bitangent * sample.direction.y + normal * sample.direction.z;
+						int lower = static_cast<int>(sample.level);
+						int upper = std::min(lower + 1, PyramidCount - 1);
+						float blend = sample.level - lower;
+						glm::vec3 texel = SampleFace(pyramid[lower], BaseSize >> lower, direction) * (1.0f - blend)
+							+ SampleFace(pyramid[upper], BaseSize >> upper, direction) * blend;
+						colour += texel * sample.direction.z;
+						weight += sample.direction.z;
+					}
+					colour /= std::max(weight, 1e-6f);
+					out[x * 4 + 0] = colour.r;
+					out[x * 4 + 1] = colour.g;
+					out[x * 4 + 2] = colour.b;
+				}
+			}
+		});
+	}
+}
+
+/***********************************************************************
+ * ReadCache: Loads the results of an earlier run.
+ * Author: [Smirti Parajuli]
+ * Description: The cache is looked for in the asset pack first, then as
+ *              a loose file. The loose file is also tried when the packed
+ *              copy is out of date, since WriteCache only updates it.
+ * Parameters:
+ *   - path: The cache file.
+ *   - key: Hash of the current faces.
+ *
+ * Return: bool - True when cooked was filled from the cache.
+ ***********************************************************************/
+bool EnvironmentLighting::ReadCache(const std::string& path, std::uint64_t key)
+{
+	const unsigned char* packed = nullptr;
+	size_t packedSize = 0;
+	if (AssetPack::Get().Find(path, AssetType::Raw, packed, packedSize) && ReadCacheData(packed, packedSize, key)) {
+		return true;
+	}
+	AssetData data;
+	return AssetPack::LoadLoose(path, data) && ReadCacheData(data.GetData(), data.GetSize(), key);
+}
+
+/***********************************************************************
+ * ReadCacheData: Loads the results of an earlier run from its bytes.
+ * Author: [Smirti Parajuli]
+ * Description: The bytes are only used when they were made from the same
+ *              faces with the same settings.
+ * Parameters:
+ *   - data: The cache file.
+ *   - size: Bytes of the cache file.
+ *   - key: Hash of the current faces.
+ *
+ * Return: bool - True when cooked was filled from the bytes.
+ ***********************************************************************/
+bool EnvironmentLighting::ReadCacheData(const unsigned char* data, size_t size, std::uint64_t key)
+{
+	if (size < sizeof(CacheHeader)) {
+		return false;
+	}
+	CacheHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	size_t expectedSize = sizeof(CacheHeader) + sizeof(float) * GetCookedSize();
+	if (std::memcmp(header.magic, CacheMagic, sizeof(header.magic)) != 0 || header.version != Version
+		|| header.sourceKey != key || header.baseSize != BaseSize || header.levelCount != LevelCount
+		|| header.sampleCount != SampleCount || header.fileSize != expectedSize || size != expectedSize) {
+		return false;
+	}
+	cooked.resize(GetCookedSize());
+	std::memcpy(cooked.data(), data + sizeof(CacheHeader), sizeof(float) * cooked.size());
+	return true;
+}
+
+/***********************************************************************
+ * WriteCache: Saves the results for the next run.
+ * Author: [Smirti Parajuli]
+ * Description: Written under a temporary name and renamed once complete,
+ *              like the cooked meshes. A cache that cannot be written
+ *              only costs the computation at the next start.
+ * Parameters:
+ *   - path: The cache file.
+ *   - key: Hash of the faces the results were computed from.
+ *
+ * Return: None
+ ***********************************************************************/
+void EnvironmentLighting::WriteCache(const std::string& path, std::uint64_t key) const
+{
+	CacheHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, CacheMagic, sizeof(header.magic));
+	header.version = Version;
+	header.sourceKey = key;
+	header.baseSize = BaseSize;
+	header.levelCount = LevelCount;
+	header.sampleCount = SampleCount;
+	header.fileSize = static_cast<GLuint>(sizeof(CacheHeader) + sizeof(float) * cooked.size());
+
+	std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(cooked.data()), static_cast<std::streamsize>(sizeof(float) * cooked.size()));
+		if (!out.good()) {
+			std::cout << "Cannot write environment lighting cache: " << temporaryPath << std::endl;
+			return;
+		}
+	}
+
+	// rename does not replace an existing file everywhere
+	std::remove(path.c_str());
+	if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+		std::remove(temporaryPath.c_str());
+	}
+}
+
+/***********************************************************************
+ * Upload: Creates the specular cube map and the EnvironmentData block.
+ * Author: [Smirti Parajuli]
+ * Description: The cooked data is released afterwards, the GPU copies
+ *              are all that is used from then on.
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void EnvironmentLighting::Upload()
+{
+	glGenTextures(1, &specularTexture);
+	GLState::Get().BindTexture(GL_TEXTURE_CUBE_MAP, specularTexture, 0);
+	glTexStorage2D(GL_TEXTURE_CUBE_MAP, LevelCount, GL_RGBA16F, BaseSize, BaseSize);
+	for (int level = 0; level < LevelCount; level++) {
+		int size = BaseSize >> level;
+		for (int face = 0; face < FaceCount; face++) {
+			const float* texels = cooked.data() + GetLevelOffset(level) + FaceFloats(size) * face;
+			glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, 0, 0, size, size, GL_RGBA, GL_FLOAT, texels);
+		}
+	}
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	EnvironmentUniforms uniforms;
+	for (int i = 0; i < CoefficientCount; i++) {
+		uniforms.irradiance[i] = glm::vec4(cooked[i * 4 + 0], cooked[i * 4 + 1], cooked[i * 4 + 2], 0.0f);
+	}
+	uniforms.specularLevels = glm::vec4(static_cast<float>(LevelCount - 1), 0.0f, 0.0f, 0.0f);
+	glGenBuffers(1, &environmentBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, environmentBuffer);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(EnvironmentUniforms), &uniforms, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, EnvironmentDataBinding, environmentBuffer);
+
+	cooked.clear();
+	cooked.shrink_to_fit();
+}
@@ -0,0 +1,88 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :EnvironmentLighting.h
+Description :  EnvironmentLighting turns the skybox into image-based
+               lighting, computed once on the CPU when the skybox is made.
+               The irradiance of the sky is projected onto nine spherical
+               harmonic coefficients, so a surface finds the light arriving
+               from the whole sky around its normal with a few multiply
+               adds. The specular part is a small cube map whose levels
+               hold the sky blurred by a GGX lobe of rising roughness, so a
+               rough reflection is one textureLod. Both are written to a
+               cache file keyed by a hash of the six face images, and read
+               back from it while the images stay the same.
+               The texture and the EnvironmentData block are created on the
+               thread that owns the GL context.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef ENVIRONMENTLIGHTING_H
+#define ENVIRONMENTLIGHTING_H
+
+#include <glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "JobSystem.h"
+
+class EnvironmentLighting
+{
+public:
+	static const int FaceCount = 6;
+	static const int BaseSize = 128;// Faces of the sharpest specular level, the size of the probe faces too
+	static const int LevelCount = 5;// Roughness 0, 0.25, 0.5, 0.75 and 1
+	static const int SampleCount = 64;// GGX samples per texel of the rough levels
+	static const int CoefficientCount = 9;// Spherical harmonics up to the second band
+	static_assert(BaseSize % 4 == 0, "Rows are projected four texels at a time");
+
+	EnvironmentLighting() {}
+	~EnvironmentLighting();
+
+	// Reads the cache or computes the lighting from the decoded faces, then uploads it
+	void Create(const ImageAsset faces[FaceCount], const std::uint64_t faceHashes[FaceCount], const std::string& cachePath, JobSystem& jobs);
+	GLuint GetSpecularTexture() const { return specularTexture; }// Alpha is 0 everywhere
+	bool IsFromCache() const { return fromCache; }
+
+	// Copying and assignment not allowed for this class
+	EnvironmentLighting(const EnvironmentLighting&) = delete;
+	EnvironmentLighting& operator=(const EnvironmentLighting&) = delete;
+
+private:
+	// The start of the cache file, followed by the coefficients and the levels, finest first
+	struct CacheHeader
+	{
+		char magic[4];
+		GLuint version;
+		std::uint64_t sourceKey;// Hash of the face hashes
+		GLuint baseSize;
+		GLuint levelCount;
+		GLuint sampleCount;
+		GLuint fileSize;
+	};
+
+	static const GLuint Version = 1;
+
+	static size_t GetLevelOffset(int level);// Floats from the start of the levels
+	static size_t GetCookedSize();// Floats of the coefficients and every level
+
+	void Compute(const ImageAsset faces[FaceCount], JobSystem& jobs);
+	bool ReadCache(const std::string& path, std::uint64_t key);
+	bool ReadCacheData(const unsigned char* data, size_t size, std::uint64_t key);
+	void WriteCache(const std::string& path, std::uint64_t key) const;
+	void Upload();
+
+	// Coefficients as vec4s, then RGBA texels of every level face by face
+	std::vector<float> cooked;
+	GLuint specularTexture = 0;
+	GLuint environmentBuffer = 0;
+	bool fromCache = false;
+};
+#endif // ENVIRONMENTLIGHTING_H
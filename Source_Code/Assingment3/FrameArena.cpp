@@ -0,0 +1,133 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :FrameArena.cpp
+Description :  Implementation of the per-frame linear allocator.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "FrameArena.h"
+#include <cstdint>
+
+namespace
+{
+	/***********************************************************************
+	 * AlignUp: Moves a pointer forward to the next arena alignment.
+	 * Author: [Smirti Parajuli]
+	 * Parameters:
+	 *   - pointer: Start of a heap block with Alignment spare bytes.
+	 *
+	 * Return: unsigned char* - The aligned pointer inside the block.
+	 ***********************************************************************/
+	unsigned char* AlignUp(unsigned char* pointer)
+	{
+		std::uintptr_t address = reinterpret_cast<std::uintptr_t>(pointer);
+		return pointer + ((FrameArena::Alignment - address % FrameArena::Alignment) % FrameArena::Alignment);
+	}
+}
+
+/***********************************************************************
+ * FrameArena: Constructor for the FrameArena class.
+ * Author: [Smirti Parajuli]
+ * Description: Only records the capacity, the memory is allocated by the
+ *              first Allocate so threads that never use their arena cost
+ *              nothing.
+ * Parameters:
+ *   - capacity: Bytes available to a frame before it spills to the heap.
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+FrameArena::FrameArena(size_t capacity)
+	: capacity((capacity + Alignment - 1) / Alignment * Alignment)
+{
+}
+
+/***********************************************************************
+ * ForThread: Gets the arena of the calling thread.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: FrameArena& - The arena, it lives as long as the thread.
+ ***********************************************************************/
+FrameArena& FrameArena::ForThread()
+{
+	thread_local FrameArena arena;
+	return arena;
+}
+
+/***********************************************************************
+ * Allocate: Reserves memory for the rest of the frame.
+ * Author: [Smirti Parajuli]
+ * Description: Bumps the used count. Anything that does not fit gets a
+ *              heap block of its own, kept until Reset or Rewind, so the
+ *              pointer is always valid.
+ * Parameters:
+ *   - size: Bytes needed, rounded up to Alignment.
+ *
+ * Return: void* - The memory, never nullptr.
+ ***********************************************************************/
+void* FrameArena::Allocate(size_t size)
+{
+	size = (size == 0) ? Alignment : (size + Alignment - 1) / Alignment * Alignment;
+	if (!storage) {
+		storage.reset(new unsigned char[capacity + Alignment]);
+		base = AlignUp(storage.get());
+	}
+
+	unsigned char* memory;
+	if (used + size <= capacity) {
+		memory = base + used;
+		used += size;
+	}
+	else {
+		overflow.emplace_back(new unsigned char[size + Alignment]);
+		overflowBytes += size;
+		memory = AlignUp(overflow.back().get());
+	}
+	if (used + overflowBytes > highWater) {
+		highWater = used + overflowBytes;
+	}
+	return memory;
+}
+
+/***********************************************************************
+ * Reset: Frees everything allocated this frame.
+ * Author: [Smirti Parajuli]
+ * Description: A frame that spilled to the heap grows the arena to its
+ *              size plus half, so the same frame fits next time. The new
+ *              memory is allocated by the next Allocate.
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void FrameArena::Reset()
+{
+	overflow.clear();
+	overflowBytes = 0;
+	used = 0;
+	if (highWater > capacity) {
+		capacity = (highWater + highWater / 2 + Alignment - 1) / Alignment * Alignment;
+		storage.reset();
+		base = nullptr;
+		growCount++;
+	}
+}
+
+/***********************************************************************
+ * Rewind: Frees everything allocated after a marker.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - marker: Taken by GetMarker earlier in the same frame.
+ *
+ * Return: None
+ ***********************************************************************/
+void FrameArena::Rewind(const Marker& marker)
+{
+	used = marker.used;
+	overflow.erase(overflow.begin() + marker.overflowCount, overflow.end());
+	overflowBytes = marker.overflowBytes;
+}
@@ -0,0 +1,97 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :FrameArena.h
+Description :  The FrameArena class is a linear allocator for CPU data that
+               only lives for one frame, like staging copies, sort buffers
+               and culling lists. Allocating moves a pointer forward and
+               Reset starts over at the next frame, so nothing is freed one
+               by one. A ScratchScope hands back everything allocated while
+               it was alive. Each thread has its own arena, so no locking
+               is needed. When a frame needs more than the arena holds the
+               rest comes from the heap, and the next Reset grows the arena
+               to fit, so a steady frame loop never touches the heap.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+class FrameArena
+{
+public:
+	static const size_t DefaultCapacity = 1024 * 1024;
+	static const size_t Alignment = 64;// Every allocation starts on its own cache line
+
+	// Position to roll back to, see ScratchScope
+	struct Marker
+	{
+		size_t used;
+		size_t overflowCount;
+		size_t overflowBytes;
+	};
+
+	explicit FrameArena(size_t capacity = DefaultCapacity);
+
+	static FrameArena& ForThread();// The arena of the calling thread, created on first use
+
+	// Returns uninitialised room for count objects, valid until Reset or the scope ends
+	void* Allocate(size_t size);
+	template <typename T>
+	T* Allocate(size_t count = 1) {
+		static_assert(std::is_trivially_destructible<T>::value, "Arena memory is never destroyed");
+		return static_cast<T*>(Allocate(sizeof(T) * count));
+	}
+
+	void Reset();// Frees everything, call once per frame when no scope is open
+	Marker GetMarker() const { return { used, overflow.size(), overflowBytes }; }
+	void Rewind(const Marker& marker);
+
+	size_t GetCapacity() const { return capacity; }
+	size_t GetHighWater() const { return highWater; }// Most bytes used by one frame so far
+	size_t GetGrowCount() const { return growCount; }
+
+	// Copying and assignment not allowed for this class
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+private:
+	std::unique_ptr<unsigned char[]> storage;// Allocated on first use, with room to align the start
+	unsigned char* base = nullptr;
+	size_t capacity;
+	size_t used = 0;
+	std::vector<std::unique_ptr<unsigned char[]>> overflow;// Heap blocks of a frame that did not fit
+	size_t overflowBytes = 0;
+	size_t highWater = 0;
+	size_t growCount = 0;
+};
+
+// Rolls the arena back to where it was when the scope started
+class ScratchScope
+{
+public:
+	explicit ScratchScope(FrameArena& arena = FrameArena::ForThread()) : arena(arena), marker(arena.GetMarker()) {}
+	~ScratchScope() { arena.Rewind(marker); }
+
+	template <typename T>
+	T* Allocate(size_t count = 1) { return arena.Allocate<T>(count); }
+
+	// Copying and assignment not allowed for this class
+	ScratchScope(const ScratchScope&) = delete;
+	ScratchScope& operator=(const ScratchScope&) = delete;
+
+private:
+	FrameArena& arena;
+	FrameArena::Marker marker;
+};
+#endif // FRAMEARENA_H
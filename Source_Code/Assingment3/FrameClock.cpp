@@ -0,0 +1,170 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :FrameClock.cpp
+Description :  Implementation of the fixed-timestep frame clock used to drive
+               the simulation independently of the rendering frame rate.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "FrameClock.h"
+#include <cmath>
+
+namespace
+{
+	const double MaxFrameTime = 0.25;// Longest frame we accept, e.g. after a breakpoint or window drag
+	const double StatsWindow = 1.0;// Length of the statistics reporting window in seconds
+}
+
+/***********************************************************************
+ * FrameClock: Constructor for the FrameClock class.
+ * Author: [Smirti Parajuli]
+ * Description: Sets the fixed simulation step and the catch-up cap.
+ *
+ * Parameters:
+ *   - fixedDelta: Length of one simulation step in seconds.
+ *   - maxStepsPerFrame: Maximum number of steps run in a single frame.
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+FrameClock::FrameClock(float fixedDelta, int maxStepsPerFrame)
+	: fixedDelta(fixedDelta), maxStepsPerFrame(maxStepsPerFrame)
+{
+}
+
+/***********************************************************************
+ * Reset: Restarts the clock.
+ * Author: [Smirti Parajuli]
+ * Description: Clears the accumulator and statistics so the first frame
+ *              after loading does not try to catch up on the load time.
+ *
+ * Parameters:
+ *   - now: Current time in seconds.
+ *
+ * Return: None
+ ***********************************************************************/
+void FrameClock::Reset(double now)
+{
+	lastFrameTime = now;
+	stepSampleTime = now;
+	windowStart = now;
+	simTime = 0.0;
+	accumulator = 0.0;
+	frameTime = 0.0f;
+	stepsThisFrame = 0;
+	windowFrames = windowSteps = windowDropped = 0;
+	windowFrameTime = windowLatency = 0.0;
+	statsReady = false;
+}
+
+/***********************************************************************
+ * BeginFrame: Starts a new frame.
+ * Author: [Smirti Parajuli]
+ * Description: Measures the real time since the previous frame and adds
+ *              it to the accumulator. If the accumulator holds more steps
+ *              than the catch-up cap allows, the surplus is dropped so a
+ *              hitch slows the simulation down instead of spiralling.
+ *
+ * Parameters:
+ *   - now: Current time in seconds.
+ *
+ * Return: None
+ ***********************************************************************/
+void FrameClock::BeginFrame(double now)
+{
+	double elapsed = now - lastFrameTime;
+	lastFrameTime = now;
+	if (elapsed > MaxFrameTime) {
+		elapsed = MaxFrameTime;
+	}
+	frameTime = static_cast<float>(elapsed);
+	accumulator += elapsed;
+	stepsThisFrame = 0;
+
+	// Drop whole steps that exceed the cap, keeping the fractional remainder for interpolation
+	double maxAccumulated = static_cast<double>(maxStepsPerFrame) * fixedDelta;
+	if (accumulator > maxAccumulated) {
+		double surplus = accumulator - maxAccumulated;
+		int dropped = static_cast<int>(surplus / fixedDelta);
+		accumulator -= dropped * static_cast<double>(fixedDelta);
+		windowDropped += dropped;
+	}
+
+	windowFrames++;
+	windowFrameTime += elapsed;
+}
+
+/***********************************************************************
+ * StepSimulation: Consumes one fixed step from the accumulator.
+ * Author: [Smirti Parajuli]
+ * Description: Intended to be used as the condition of a while loop that
+ *              runs the simulation updates with GetFixedDelta().
+ *
+ * Parameters: None
+ *
+ * Return: true if a fixed step should be simulated, false otherwise.
+ ***********************************************************************/
+bool FrameClock::StepSimulation()
+{
+	if (accumulator < fixedDelta || stepsThisFrame >= maxStepsPerFrame) {
+		return false;
+	}
+	accumulator -= fixedDelta;
+	simTime += fixedDelta;
+	stepsThisFrame++;
+	windowSteps++;
+	stepSampleTime = lastFrameTime;
+	return true;
+}
+
+/***********************************************************************
+ * GetAlpha: Returns the interpolation factor for rendering.
+ * Author: [Smirti Parajuli]
+ * Description: Fraction of a step left in the accumulator, used to blend
+ *              the previous and current simulation states.
+ *
+ * Parameters: None
+ *
+ * Return: float in the range [0, 1].
+ ***********************************************************************/
+float FrameClock::GetAlpha() const
+{
+	float alpha = static_cast<float>(accumulator / fixedDelta);
+	return (alpha > 1.0f) ? 1.0f : alpha;
+}
+
+/***********************************************************************
+ * EndFrame: Finishes the frame after it has been presented.
+ * Author: [Smirti Parajuli]
+ * Description: Records the time between the last input sample and the
+ *              buffer swap, and publishes averaged statistics once per
+ *              reporting window.
+ *
+ * Parameters:
+ *   - now: Time in seconds just after the buffers were swapped.
+ *
+ * Return: None
+ ***********************************************************************/
+void FrameClock::EndFrame(double now)
+{
+	windowLatency += now - stepSampleTime;
+	statsReady = false;
+
+	double windowLength = now - windowStart;
+	if (windowLength >= StatsWindow && windowFrames > 0) {
+		avgFrameMs = static_cast<float>(windowFrameTime / windowFrames * 1000.0);
+		framesPerSecond = static_cast<float>(windowFrames / windowLength);
+		stepsPerSecond = static_cast<float>(windowSteps / windowLength);
+		avgLatencyMs = static_cast<float>(windowLatency / windowFrames * 1000.0);
+		droppedSteps = windowDropped;
+		statsReady = true;
+
+		windowStart = now;
+		windowFrames = windowSteps = windowDropped = 0;
+		windowFrameTime = windowLatency = 0.0;
+	}
+}
@@ -0,0 +1,68 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :FrameClock.h
+Description :  The FrameClock class is the single time source for the main loop.
+               It runs the simulation at a fixed rate using an accumulator,
+               exposes the interpolation factor for rendering between steps
+               and keeps frame time, step rate and latency statistics.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef FRAMECLOCK_H
+#define FRAMECLOCK_H
+
+class FrameClock
+{
+public:
+	FrameClock(float fixedDelta = 1.0f / 60.0f, int maxStepsPerFrame = 5);
+
+	void Reset(double now);// Restarts the clock at the given time
+	void BeginFrame(double now);// Samples the frame time and feeds the accumulator
+	bool StepSimulation();// Returns true while another fixed step should run this frame
+	void EndFrame(double now);// Records the present time for latency statistics
+
+	float GetFixedDelta() const { return fixedDelta; }
+	float GetFrameTime() const { return frameTime; }// Real time since the previous frame (clamped)
+	float GetAlpha() const;// Interpolation factor between the previous and current simulation state
+	double GetSimTime() const { return simTime; }
+	int GetStepsThisFrame() const { return stepsThisFrame; }
+
+	// Statistics averaged over the last reporting window
+	bool HasNewStats() const { return statsReady; }
+	float GetAverageFrameMs() const { return avgFrameMs; }
+	float GetFramesPerSecond() const { return framesPerSecond; }
+	float GetStepsPerSecond() const { return stepsPerSecond; }
+	float GetAverageLatencyMs() const { return avgLatencyMs; }
+	int GetDroppedSteps() const { return droppedSteps; }
+
+private:
+	float fixedDelta;// Length of one simulation step in seconds
+	int maxStepsPerFrame;// Catch-up cap so a long hitch never spirals
+	double lastFrameTime = 0.0;
+	double stepSampleTime = 0.0;// Time at which the latest step sampled its inputs
+	double simTime = 0.0;
+	double accumulator = 0.0;
+	float frameTime = 0.0f;
+	int stepsThisFrame = 0;
+
+	// Reporting window accumulators
+	double windowStart = 0.0;
+	int windowFrames = 0;
+	int windowSteps = 0;
+	double windowFrameTime = 0.0;
+	double windowLatency = 0.0;
+	bool statsReady = false;
+	float avgFrameMs = 0.0f;
+	float framesPerSecond = 0.0f;
+	float stepsPerSecond = 0.0f;
+	float avgLatencyMs = 0.0f;
+	int droppedSteps = 0;
+	int windowDropped = 0;
+};
+#endif // FRAMECLOCK_H
@@ -0,0 +1,106 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :FrameSnapshot.h
+Description :  Everything the render thread needs to draw one frame. Built by
+               the simulation thread and handed over through a triple buffer,
+               then treated as read-only by the renderers.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef FRAMESNAPSHOT_H
+#define FRAMESNAPSHOT_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "ShaderBindings.h"
+
+// One shadow map, drawn into a tile of the shadow atlas
+struct ShadowView
+{
+	glm::mat4 view = glm::mat4(1.0f);// Light space, handed to the casters as FrameData
+	glm::mat4 projection = glm::mat4(1.0f);
+	std::uint64_t staticKey = 0;// Changes when the view or a static caster inside it changes
+	std::uint64_t dynamicKey = 0;// Changes when a dynamic caster inside it moves
+};
+
+// A cube map of the scene around a reflective sphere
+struct ReflectionProbeView
+{
+	glm::vec3 position = glm::vec3(0.0f);// Centre of the reflective sphere
+	float nearPlane = 0.1f;// Just outside the sphere, so it does not capture itself
+	std::uint64_t faceKeys[6] = {};// Change when the probe or a sphere inside the face moves
+};
+
+struct FrameSnapshot
+{
+	// Camera state, interpolated between fixed steps
+	glm::mat4 view = glm::mat4(1.0f);
+	glm::mat4 projection = glm::mat4(1.0f);// Scene projection, near 0.1 and far 1000
+	glm::vec3 cameraPosition = glm::vec3(0.0f);
+	float fov = 45.0f;
+	float aspect = 1.0f;
+	float nearPlane = 0.1f;
+	float farPlane = 1000.0f;
+
+	// Transforms of the spheres that survived frustum culling, nearest first
+	// Left empty while the spheres are animated on the GPU, which draws them all
+	std::vector<InstanceTransform> sphereInstances;
+	int totalSpheres = 0;
+	bool sphereAnimationOnGpu = false;
+	float animationTime = 0.0f;// Seconds since start, interpolated between fixed steps
+	bool sphereImpostors = false;// Spheres drawn as ray traced quads instead of the mesh
+	bool sphereMeshletCulling = false;// Sphere meshes drawn meshlet by meshlet after a GPU culling pass
+	std::vector<glm::mat4> reflectiveModels;
+
+	// Reflection probes, one per reflective sphere up to ReflectionProbes::MaxProbes
+	bool reflectionProbesEnabled = false;
+	std::vector<ReflectionProbeView> reflectionProbes;
+	std::vector<int> reflectiveProbeIndices;// Probe of each of the reflectiveModels, -1 reflects the skybox alone
+	// Spheres inside at least one probe face, without their spin, left empty while animated on the GPU
+	std::vector<glm::mat4> probeSphereModels;
+
+	// Sphere physics
+	bool physicsEnabled = false;
+	int physicsContacts = 0;
+	float physicsStepMs = 0.0f;
+
+	// Point light markers that survived frustum culling, with their light colors
+	std::vector<glm::mat4> lightMarkerModels;
+	std::vector<glm::vec3> lightMarkerColors;
+
+	// Render settings
+	bool depthPrepass = false;// Opaque geometry drawn depth only before it is shaded
+	bool deferredShading = false;// Opaque geometry lit from a G-buffer instead of while it is drawn
+
+	// Light toggles
+	bool pointLightsEnabled = true;
+	bool directionalLightEnabled = true;
+	bool spotLightsEnabled = true;
+	int pointLightCount = 0;// Point lights shading the scene, the first ones of Light
+
+	// Shadow maps, view i is drawn into tile i of the shadow atlas
+	bool shadowsEnabled = false;
+	bool shadowCaching = true;// Tiles are only drawn again when their keys change
+	int shadowCascadeCount = 0;// Directional cascades, the first views
+	int spotShadowCount = 0;// One view per spotlight after the cascades, zero while shadows are off
+	ShadowView shadowViews[MaxShadowViews];
+	// Casters inside at least one view, without their spin. The dynamic ones are left
+	// empty while the spheres are animated on the GPU, which draws them all.
+	std::vector<glm::mat4> staticShadowCasters;
+	std::vector<glm::mat4> dynamicShadowCasters;
+
+	// Timing
+	unsigned long long frameIndex = 0;
+	double inputSampleTime = 0.0;// When the input used for this frame was sampled
+	float simStepsPerSecond = 0.0f;
+	int droppedSteps = 0;
+	unsigned long long simHeapAllocations = 0;// Made on the simulation thread while producing this snapshot
+};
+#endif // FRAMESNAPSHOT_H
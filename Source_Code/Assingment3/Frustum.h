@@ -0,0 +1,58 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :Frustum.h
+Description :  View frustum planes extracted from a projection-view matrix,
+               with bounding sphere tests used for culling.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+struct Frustum
+{
+	glm::vec4 planes[6];// Left, right, bottom, top, near, far with normals pointing inwards
+
+	Frustum() {}
+
+	// Extracts the planes from a combined projection * view matrix (Gribb/Hartmann)
+	explicit Frustum(const glm::mat4& projectionView)
+	{
+		glm::vec4 row0(projectionView[0][0], projectionView[1][0], projectionView[2][0], projectionView[3][0]);
+		glm::vec4 row1(projectionView[0][1], projectionView[1][1], projectionView[2][1], projectionView[3][1]);
+		glm::vec4 row2(projectionView[0][2], projectionView[1][2], projectionView[2][2], projectionView[3][2]);
+		glm::vec4 row3(projectionView[0][3], projectionView[1][3], projectionView[2][3], projectionView[3][3]);
+
+		planes[0] = row3 + row0;
+		planes[1] = row3 - row0;
+		planes[2] = row3 + row1;
+		planes[3] = row3 - row1;
+		planes[4] = row3 + row2;
+		planes[5] = row3 - row2;
+
+		// Normalise so the plane distance is in world units
+		for (int i = 0; i < 6; i++) {
+			planes[i] /= glm::length(glm::vec3(planes[i]));
+		}
+	}
+
+	// Returns false only when the sphere lies completely outside one of the planes
+	bool IsSphereVisible(const glm::vec3& center, float radius) const
+	{
+		for (int i = 0; i < 6; i++) {
+			if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+#endif // FRUSTUM_H
@@ -0,0 +1,395 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :GLState.cpp
+Description :  Implementation of the shadowed OpenGL state cache.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "GLState.h"
+
+/***********************************************************************
+ * GLState: Constructor for the GLState class.
+ * Author: [Smirti Parajuli]
+ * Description: Starts with every value unknown so the first call of each
+ *              kind always reaches the driver.
+ *
+ * Parameters: None
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+GLState::GLState()
+{
+	Invalidate();
+}
+
+/***********************************************************************
+ * Get: Returns the state cache.
+ * Author: [Smirti Parajuli]
+ * Description: The application has a single GL context, so there is a
+ *              single cache shared by every renderer.
+ *
+ * Parameters: None
+ *
+ * Return: Reference to the cache.
+ ***********************************************************************/
+GLState& GLState::Get()
+{
+	static GLState instance;
+	return instance;
+}
+
+/***********************************************************************
+ * BeginFrame: Rolls the per-frame counters over.
+ * Author: [Smirti Parajuli]
+ * Description: Keeps the counts of the frame that just finished so they
+ *              can be reported, then resets them for the new frame.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::BeginFrame()
+{
+	lastIssued = issued;
+	lastFiltered = filtered;
+	issued = 0;
+	filtered = 0;
+}
+
+/***********************************************************************
+ * Invalidate: Marks all shadowed state as unknown.
+ * Author: [Smirti Parajuli]
+ * Description: The next call of every kind is forwarded to GL.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::Invalidate()
+{
+	program = Unknown;
+	vertexArray = Unknown;
+	activeUnit = Unknown;
+	for (int unit = 0; unit < MaxTextureUnits; unit++) {
+		for (int target = 0; target < TextureTargetCount; target++) {
+			textures[unit][target] = Unknown;
+		}
+	}
+	for (int i = 0; i < CapabilityCount; i++) {
+		capabilities[i] = Unknown;
+	}
+	depthFunc = Unknown;
+	depthMask = Unknown;
+	colorMask = Unknown;
+	blendSource = Unknown;
+	blendDestination = Unknown;
+	cullFace = Unknown;
+	frontFace = Unknown;
+}
+
+/***********************************************************************
+ * Changes: Compares a call against the shadowed value.
+ * Author: [Smirti Parajuli]
+ * Description: Stores the new value and counts the call as issued when it
+ *              differs, otherwise counts it as filtered.
+ *
+ * Parameters:
+ *   - cached: The shadow value for this piece of state.
+ *   - value: The value requested by the caller.
+ *
+ * Return: True when the call has to be forwarded to GL.
+ ***********************************************************************/
+bool GLState::Changes(GLuint& cached, GLuint value)
+{
+	if (cached == value) {
+		filtered++;
+		return false;
+	}
+	cached = value;
+	issued++;
+	return true;
+}
+
+/***********************************************************************
+ * UseProgram: Makes a program current.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - program: The shader program.
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::UseProgram(GLuint program)
+{
+	if (Changes(this->program, program)) {
+		glUseProgram(program);
+	}
+}
+
+/***********************************************************************
+ * BindVertexArray: Binds a vertex array object.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - vertexArray: The vertex array object.
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::BindVertexArray(GLuint vertexArray)
+{
+	if (Changes(this->vertexArray, vertexArray)) {
+		glBindVertexArray(vertexArray);
+	}
+}
+
+/***********************************************************************
+ * ActiveTexture: Selects the active texture unit.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - unit: Zero based texture unit.
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::ActiveTexture(GLuint unit)
+{
+	if (Changes(activeUnit, unit)) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+}
+
+/***********************************************************************
+ * BindTexture: Binds a texture to a texture unit.
+ * Author: [Smirti Parajuli]
+ * Description: The active unit is only switched when the binding itself
+ *              changes. Targets or units the cache does not track are
+ *              always forwarded.
+ *
+ * Parameters:
+ *   - target: GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, ...
+ *   - texture: The texture object.
+ *   - unit: Zero based texture unit.
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::BindTexture(GLenum target, GLuint texture, GLuint unit)
+{
+	int index = TargetIndex(target);
+	if (index < 0 || unit >= static_cast<GLuint>(MaxTextureUnits)) {
+		ActiveTexture(unit);
+		issued++;
+		glBindTexture(target, texture);
+		return;
+	}
+	if (textures[unit][index] == texture) {
+		filtered++;
+		return;
+	}
+	ActiveTexture(unit);
+	Changes(textures[unit][index], texture);
+	glBindTexture(target, texture);
+}
+
+/***********************************************************************
+ * ForgetVertexArray: Drops a vertex array that is about to be deleted.
+ * Author: [Smirti Parajuli]
+ * Description: GL reverts a deleted bound vertex array to zero, and the
+ *              name may be reused, so the shadow value must follow.
+ *
+ * Parameters:
+ *   - vertexArray: The vertex array object being deleted.
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::ForgetVertexArray(GLuint vertexArray)
+{
+	if (this->vertexArray == vertexArray) {
+		this->vertexArray = 0;
+	}
+}
+
+/***********************************************************************
+ * ForgetTexture: Drops a texture that is about to be deleted.
+ * Author: [Smirti Parajuli]
+ * Description: GL unbinds a deleted texture from every unit, so any unit
+ *              shadowing it goes back to zero.
+ *
+ * Parameters:
+ *   - texture: The texture object being deleted.
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::ForgetTexture(GLuint texture)
+{
+	for (int unit = 0; unit < MaxTextureUnits; unit++) {
+		for (int target = 0; target < TextureTargetCount; target++) {
+			if (textures[unit][target] == texture) {
+				textures[unit][target] = 0;
+			}
+		}
+	}
+}
+
+/***********************************************************************
+ * SetEnabled: glEnable / glDisable through the cache.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - capability: The capability, e.g. GL_DEPTH_TEST.
+ *   - enabled: Whether it should be enabled.
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::SetEnabled(GLenum capability, bool enabled)
+{
+	int index = CapabilityIndex(capability);
+	if (index >= 0 && !Changes(capabilities[index], enabled ? 1u : 0u)) {
+		return;
+	}
+	if (index < 0) {
+		issued++;
+	}
+	if (enabled) {
+		glEnable(capability);
+	}
+	else {
+		glDisable(capability);
+	}
+}
+
+/***********************************************************************
+ * DepthFunc: Sets the depth comparison function.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - func: GL_LESS, GL_LEQUAL, GL_EQUAL, ...
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::DepthFunc(GLenum func)
+{
+	if (Changes(depthFunc, func)) {
+		glDepthFunc(func);
+	}
+}
+
+/***********************************************************************
+ * DepthMask: Enables or disables depth writes.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - write: GL_TRUE to write depth.
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::DepthMask(GLboolean write)
+{
+	if (Changes(depthMask, write)) {
+		glDepthMask(write);
+	}
+}
+
+/***********************************************************************
+ * ColorMask: Enables or disables colour writes.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - write: GL_TRUE to write red, green, blue and alpha.
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::ColorMask(GLboolean write)
+{
+	if (Changes(colorMask, write)) {
+		glColorMask(write, write, write, write);
+	}
+}
+
+/***********************************************************************
+ * BlendFunc: Sets the source and destination blend factors.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - source: Source factor.
+ *   - destination: Destination factor.
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::BlendFunc(GLenum source, GLenum destination)
+{
+	if (blendSource == source && blendDestination == destination) {
+		filtered++;
+		return;
+	}
+	blendSource = source;
+	blendDestination = destination;
+	issued++;
+	glBlendFunc(source, destination);
+}
+
+/***********************************************************************
+ * CullFace: Selects which faces are culled.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - face: GL_BACK, GL_FRONT or GL_FRONT_AND_BACK.
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::CullFace(GLenum face)
+{
+	if (Changes(cullFace, face)) {
+		glCullFace(face);
+	}
+}
+
+/***********************************************************************
+ * FrontFace: Selects the front facing winding order.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - winding: GL_CCW or GL_CW.
+ *
+ * Return: None
+ ***********************************************************************/
+void GLState::FrontFace(GLenum winding)
+{
+	if (Changes(frontFace, winding)) {
+		glFrontFace(winding);
+	}
+}
+
+/***********************************************************************
+ * TargetIndex: Maps a texture target to its slot in the shadow table.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - target: The texture target.
+ *
+ * Return: The slot, or -1 for targets that are not tracked.
+ ***********************************************************************/
+int GLState::TargetIndex(GLenum target)
+{
+	switch (target) {
+	case GL_TEXTURE_2D: return 0;
+	case GL_TEXTURE_CUBE_MAP: return 1;
+	case GL_TEXTURE_2D_ARRAY: return 2;
+	default: return -1;
+	}
+}
+
+/***********************************************************************
+ * CapabilityIndex: Maps a capability to its slot in the shadow table.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - capability: The glEnable capability.
+ *
+ * Return: The slot, or -1 for capabilities that are not tracked.
+ ***********************************************************************/
+int GLState::CapabilityIndex(GLenum capability)
+{
+	switch (capability) {
+	case GL_DEPTH_TEST: return 0;
+	case GL_BLEND: return 1;
+	case GL_CULL_FACE: return 2;
+	case GL_TEXTURE_CUBE_MAP_SEAMLESS: return 3;
+	case GL_MULTISAMPLE: return 4;
+	case GL_POLYGON_OFFSET_FILL: return 5;
+	case GL_SCISSOR_TEST: return 6;
+	default: return -1;
+	}
+}
@@ -0,0 +1,89 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :GLState.h
+Description :  The GLState class shadows the OpenGL state the renderer touches
+               (program, vertex array, texture units, depth/blend/cull state)
+               and only forwards a call to the driver when it actually changes
+               something. It counts issued and filtered calls per frame.
+               All access must happen on the thread that owns the GL context.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <glew.h>
+
+class GLState
+{
+public:
+	static GLState& Get();// The cache for the one GL context of the application
+
+	void BeginFrame();// Stores the counters of the finished frame and starts new ones
+	void Invalidate();// Forgets everything, use after code that bypasses the cache
+
+	// Bindings
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vertexArray);
+	void BindTexture(GLenum target, GLuint texture, GLuint unit);
+	GLuint GetActiveTextureUnit() const { return activeUnit == Unknown ? 0 : activeUnit; }
+
+	// Objects being deleted are unbound by GL, so the cache must forget them too
+	void ForgetVertexArray(GLuint vertexArray);
+	void ForgetTexture(GLuint texture);
+
+	// Fixed function state
+	void SetEnabled(GLenum capability, bool enabled);
+	void DepthFunc(GLenum func);
+	void DepthMask(GLboolean write);
+	void ColorMask(GLboolean write);// All four channels at once
+	void BlendFunc(GLenum source, GLenum destination);
+	void CullFace(GLenum face);
+	void FrontFace(GLenum winding);
+
+	// Counters of the last completed frame
+	int GetIssuedCalls() const { return lastIssued; }
+	int GetFilteredCalls() const { return lastFiltered; }
+
+	// Copying and assignment not allowed for this class
+	GLState(const GLState&) = delete;
+	GLState& operator=(const GLState&) = delete;
+
+private:
+	GLState();
+
+	bool Changes(GLuint& cached, GLuint value);// Updates the shadow value, counts the call
+	void ActiveTexture(GLuint unit);
+	static int TargetIndex(GLenum target);
+	static int CapabilityIndex(GLenum capability);
+
+	static const GLuint Unknown = 0xFFFFFFFFu;// Shadow value that never matches a real one
+	static const int MaxTextureUnits = 16;
+	static const int TextureTargetCount = 3;// 2D, cube map, 2D array
+	static const int CapabilityCount = 7;
+
+	GLuint program;
+	GLuint vertexArray;
+	GLuint activeUnit;
+	GLuint textures[MaxTextureUnits][TextureTargetCount];
+	GLuint capabilities[CapabilityCount];// 0 or 1 once known
+	GLuint depthFunc;
+	GLuint depthMask;
+	GLuint colorMask;
+	GLuint blendSource;
+	GLuint blendDestination;
+	GLuint cullFace;
+	GLuint frontFace;
+
+	int issued = 0;
+	int filtered = 0;
+	int lastIssued = 0;
+	int lastFiltered = 0;
+};
+#endif // GLSTATE_H
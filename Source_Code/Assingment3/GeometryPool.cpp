@@ -0,0 +1,378 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :GeometryPool.cpp
+Description :  Implementation of the shared vertex and index buffers.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "GeometryPool.h"
+#include "GLState.h"
+#include "ShaderBindings.h"
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+/***********************************************************************
+ * GeometryPool: Constructor for the GeometryPool class.
+ * Author: [Smirti Parajuli]
+ * Description: Nothing is allocated until the first mesh is added, which
+ *              happens after the GL context is created.
+ *
+ * Parameters: None
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+GeometryPool::GeometryPool()
+{
+}
+
+/***********************************************************************
+ * Get: Returns the geometry pool.
+ * Author: [Smirti Parajuli]
+ * Description: The application has a single GL context, so there is a
+ *              single pool shared by every mesh.
+ *
+ * Parameters: None
+ *
+ * Return: The pool.
+ ***********************************************************************/
+GeometryPool& GeometryPool::Get()
+{
+	static GeometryPool instance;
+	return instance;
+}
+
+/***********************************************************************
+ * Add: Copies a mesh into the pool.
+ * Author: [Smirti Parajuli]
+ * Description: The vertices are encoded in the requested format and the
+ *              indices are narrowed to 16 bits when every index fits.
+ *              Indices stay relative to the mesh, the shaders add its
+ *              first word from the format buffer. If the free space is
+ *              split up the pool is defragmented, and if there is too
+ *              little it grows, see AddEncoded.
+ *
+ * Parameters:
+ *   - vertices: VertexEncoder::FloatsPerVertex floats for every vertex.
+ *   - vertexCount: Number of vertices.
+ *   - indices: Triangle indices, relative to the first vertex of the mesh.
+ *   - indexCount: Number of indices.
+ *   - format: How the vertices are stored.
+ *
+ * Return: Handle of the mesh, InvalidMesh if it did not fit.
+ ***********************************************************************/
+GLuint GeometryPool::Add(const GLfloat* vertices, GLuint vertexCount, const GLuint* indices, GLuint indexCount, VertexFormat format)
+{
+	EncodedVertices encoded;
+	VertexEncoder::Encode(vertices, vertexCount, format, encoded);
+
+	PoolMeshData data;
+	data.format = format;
+	data.vertexWords = encoded.words.data();
+	data.vertexCount = vertexCount;
+	data.stride = encoded.stride;
+	data.positionScale = encoded.positionScale;
+	data.positionOffset = encoded.positionOffset;
+	data.indices = indices;
+	data.indexType = GL_UNSIGNED_INT;
+	data.indexCount = indexCount;
+
+	std::vector<GLushort> narrow;
+	if (vertexCount <= 65536) {
+		narrow.assign(indices, indices + indexCount);
+		data.indices = narrow.data();
+		data.indexType = GL_UNSIGNED_SHORT;
+	}
+	return AddEncoded(data);
+}
+
+/***********************************************************************
+ * AddEncoded: Copies an already encoded mesh into the pool.
+ * Author: [Smirti Parajuli]
+ * Description: The words and indices are uploaded exactly as given, so a
+ *              mesh read from a mapped cooked file goes straight from the
+ *              mapping into the buffers. When the free space is split up
+ *              the meshes are packed together, and when there is not
+ *              enough of it they are packed into buffers doubled in size
+ *              until the mesh fits.
+ *
+ * Parameters:
+ *   - data: The encoded vertices and indices of the mesh.
+ *
+ * Return: Handle of the mesh, InvalidMesh if it is larger than MaxVertexWords or MaxIndexBytes allow.
+ ***********************************************************************/
+GLuint GeometryPool::AddEncoded(const PoolMeshData& data)
+{
+	if (vertexArray == 0) {
+		Create();
+	}
+
+	GLuint vertexCount = data.vertexCount;
+	bool shortIndices = (data.indexType == GL_UNSIGNED_SHORT);
+	if (shortIndices && vertexCount > 65536) {
+		std::cout << "A mesh of " << vertexCount << " vertices cannot use 16-bit indices, it was not added" << std::endl;
+		return InvalidMesh;
+	}
+	GLuint indexSize = shortIndices ? sizeof(GLushort) : sizeof(GLuint);
+	std::uint64_t wideVertexWords = static_cast<std::uint64_t>(vertexCount) * data.stride;
+	std::uint64_t wideIndexBytes = static_cast<std::uint64_t>(indexSize) * data.indexCount;
+	GLuint indexSlack = 4 * static_cast<GLuint>(entries.size() - freeHandles.size() + 1);// Every range starts on 4 bytes
+	if (freeHandles.empty() || wideVertexWords > MaxVertexWords - usedVertexWords || wideIndexBytes + indexSlack > MaxIndexBytes - usedIndexBytes) {
+		std::cout << "Geometry pool is full, a mesh of " << vertexCount << " vertices was not added" << std::endl;
+		return InvalidMesh;
+	}
+	GLuint vertexWords = static_cast<GLuint>(wideVertexWords);
+	GLuint indexBytes = static_cast<GLuint>(wideIndexBytes);
+
+	// Doubled until the live meshes and this one fit, one repack covers both buffers
+	GLuint newVertexWords = vertexCapacity;
+	GLuint newIndexBytes = indexCapacity;
+	while (usedVertexWords + vertexWords > newVertexWords) {
+		newVertexWords = (newVertexWords > MaxVertexWords / 2) ? MaxVertexWords : newVertexWords * 2;
+	}
+	while (usedIndexBytes + indexBytes + indexSlack > newIndexBytes) {
+		newIndexBytes = (newIndexBytes > MaxIndexBytes / 2) ? MaxIndexBytes : newIndexBytes * 2;
+	}
+	if (newVertexWords != vertexCapacity || newIndexBytes != indexCapacity) {
+		Repack(newVertexWords, newIndexBytes);
+	}
+
+	// Index ranges start on 4 bytes so either index size divides the offset
+	GLuint vertexWord = vertexArena.Allocate(vertexWords);
+	GLuint indexOffset = indexArena.Allocate(indexBytes, sizeof(GLuint));
+	if (vertexWord == BufferArena::InvalidOffset || indexOffset == BufferArena::InvalidOffset) {
+		vertexArena.Free(vertexWord, vertexWords);
+		indexArena.Free(indexOffset, indexBytes);
+		Defragment();
+		vertexWord = vertexArena.Allocate(vertexWords);
+		indexOffset = indexArena.Allocate(indexBytes, sizeof(GLuint));
+		if (vertexWord == BufferArena::InvalidOffset || indexOffset == BufferArena::InvalidOffset) {
+			vertexArena.Free(vertexWord, vertexWords);
+			indexArena.Free(indexOffset, indexBytes);
+			std::cout << "Geometry pool is full, a mesh of " << vertexCount << " vertices was not added" << std::endl;
+			return InvalidMesh;
+		}
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * vertexWord, sizeof(GLuint) * vertexWords, data.vertexWords);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, indexBytes, data.indices);
+
+	GLuint mesh = freeHandles.back();
+	freeHandles.pop_back();
+	Entry& entry = entries[mesh];
+	entry.live = true;
+	entry.format.layout = glm::uvec4(static_cast<GLuint>(data.format), vertexWord, data.stride, 0u);
+	entry.format.positionScale = glm::vec4(data.positionScale, 0.0f);
+	entry.format.positionOffset = glm::vec4(data.positionOffset, 0.0f);
+	entry.vertexCount = vertexCount;
+	entry.vertexWords = vertexWords;
+	entry.indexType = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	entry.indexOffset = indexOffset;
+	entry.indexBytes = indexBytes;
+	entry.indexCount = static_cast<GLsizei>(data.indexCount);
+	entry.floatBytes = sizeof(GLfloat) * VertexEncoder::FloatsPerVertex * vertexCount + sizeof(GLuint) * data.indexCount;
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, formatBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(MeshFormat) * mesh, sizeof(MeshFormat), &entry.format);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	usedVertices += vertexCount;
+	usedVertexWords += vertexWords;
+	usedIndexBytes += indexBytes;
+	floatBytes += entry.floatBytes;
+	return mesh;
+}
+
+/***********************************************************************
+ * Remove: Frees a mesh.
+ * Author: [Smirti Parajuli]
+ * Description: Only the bookkeeping changes, the old data stays in the
+ *              buffers until something else is placed over it. Draws
+ *              already queued with its range are still safe this frame.
+ *
+ * Parameters:
+ *   - mesh: Handle returned by Add, InvalidMesh is ignored.
+ *
+ * Return: None
+ ***********************************************************************/
+void GeometryPool::Remove(GLuint mesh)
+{
+	if (mesh >= entries.size() || !entries[mesh].live) {
+		return;
+	}
+
+	Entry& entry = entries[mesh];
+	vertexArena.Free(entry.format.layout.y, entry.vertexWords);
+	indexArena.Free(entry.indexOffset, entry.indexBytes);
+	usedVertices -= entry.vertexCount;
+	usedVertexWords -= entry.vertexWords;
+	usedIndexBytes -= entry.indexBytes;
+	floatBytes -= entry.floatBytes;
+	entry.live = false;
+	freeHandles.push_back(mesh);
+}
+
+/***********************************************************************
+ * Defragment: Packs the live meshes together.
+ * Author: [Smirti Parajuli]
+ * Description: Repacks into buffers of the current size.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void GeometryPool::Defragment()
+{
+	if (vertexArray == 0) {
+		return;
+	}
+	Repack(vertexCapacity, indexCapacity);
+}
+
+/***********************************************************************
+ * Repack: Copies the live meshes into new buffers.
+ * Author: [Smirti Parajuli]
+ * Description: The buffers are immutable, so the meshes are copied into
+ *              new ones in handle order, with no gaps between them, and
+ *              the old buffers are deleted. Handles stay the same, the
+ *              format entries get their new first word and the new
+ *              buffers take over the bindings of the old ones.
+ *
+ * Parameters:
+ *   - newVertexWords: Size of the new vertex buffer in words, at least
+ *                     the words in use.
+ *   - newIndexBytes: Size of the new index buffer in bytes, at least the
+ *                    bytes in use with their alignment.
+ *
+ * Return: None
+ ***********************************************************************/
+void GeometryPool::Repack(GLuint newVertexWords, GLuint newIndexBytes)
+{
+	GLuint newVertexBuffer = CreateBuffer(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * static_cast<GLsizeiptr>(newVertexWords));
+	GLuint newIndexBuffer = CreateBuffer(GL_COPY_WRITE_BUFFER, newIndexBytes);
+	GLuint vertexWord = 0;
+	GLuint indexOffset = 0;
+	for (GLuint mesh = 0; mesh < entries.size(); mesh++) {
+		Entry& entry = entries[mesh];
+		if (!entry.live) {
+			continue;
+		}
+
+		glBindBuffer(GL_COPY_READ_BUFFER, vertexBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, newVertexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sizeof(GLuint) * entry.format.layout.y, sizeof(GLuint) * vertexWord, sizeof(GLuint) * entry.vertexWords);
+		glBindBuffer(GL_COPY_READ_BUFFER, indexBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, newIndexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, entry.indexOffset, indexOffset, entry.indexBytes);
+
+		entry.format.layout.y = vertexWord;
+		entry.indexOffset = indexOffset;
+		glBindBuffer(GL_COPY_WRITE_BUFFER, formatBuffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(MeshFormat) * mesh, sizeof(MeshFormat), &entry.format);
+
+		vertexWord += entry.vertexWords;
+		indexOffset = (indexOffset + entry.indexBytes + 3u) & ~3u;
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glDeleteBuffers(1, &vertexBuffer);
+	glDeleteBuffers(1, &indexBuffer);
+	vertexBuffer = newVertexBuffer;
+	indexBuffer = newIndexBuffer;
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VertexDataBinding, vertexBuffer);
+	GLState::Get().BindVertexArray(vertexArray);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+	vertexCapacity = newVertexWords;
+	indexCapacity = newIndexBytes;
+	vertexArena.Reset(vertexCapacity, vertexWord);
+	indexArena.Reset(indexCapacity, indexOffset);
+	generation++;
+}
+
+/***********************************************************************
+ * GetRange: Where a mesh currently is.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - mesh: Handle returned by Add.
+ *
+ * Return: The range, with no indices for InvalidMesh or a removed mesh.
+ ***********************************************************************/
+MeshRange GeometryPool::GetRange(GLuint mesh) const
+{
+	MeshRange range;
+	if (mesh >= entries.size() || !entries[mesh].live) {
+		return range;
+	}
+
+	const Entry& entry = entries[mesh];
+	range.mesh = mesh;
+	range.indexType = entry.indexType;
+	range.indexOffset = entry.indexOffset;
+	range.indexCount = entry.indexCount;
+	return range;
+}
+
+/***********************************************************************
+ * Create: Allocates the shared buffers.
+ * Author: [Smirti Parajuli]
+ * Description: The vertex array has no attributes, only the element
+ *              buffer. The vertex and format buffers stay bound to their
+ *              storage block bindings for the rest of the application.
+ *              Handles are given out lowest first.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void GeometryPool::Create()
+{
+	vertexBuffer = CreateBuffer(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * static_cast<GLsizeiptr>(vertexCapacity));
+	formatBuffer = CreateBuffer(GL_COPY_WRITE_BUFFER, sizeof(MeshFormat) * MaxMeshes);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VertexDataBinding, vertexBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MeshFormatBinding, formatBuffer);
+
+	glGenVertexArrays(1, &vertexArray);
+	GLState::Get().BindVertexArray(vertexArray);
+	indexBuffer = CreateBuffer(GL_ELEMENT_ARRAY_BUFFER, indexCapacity);
+
+	vertexArena.Reset(vertexCapacity);
+	indexArena.Reset(indexCapacity);
+	entries.resize(MaxMeshes);
+	for (GLuint mesh = MaxMeshes; mesh > 0; mesh--) {
+		freeHandles.push_back(mesh - 1);
+	}
+}
+
+/***********************************************************************
+ * CreateBuffer: Creates one immutable pool buffer.
+ * Author: [Smirti Parajuli]
+ * Description: The data is written with glBufferSubData, so the storage
+ *              only needs the dynamic storage flag. The buffer is left
+ *              bound to target.
+ *
+ * Parameters:
+ *   - target: Binding used to create it.
+ *   - size: Size in bytes.
+ *
+ * Return: The buffer.
+ ***********************************************************************/
+GLuint GeometryPool::CreateBuffer(GLenum target, GLsizeiptr size)
+{
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(target, buffer);
+	glBufferStorage(target, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	if (target == GL_COPY_WRITE_BUFFER) {
+		glBindBuffer(target, 0);
+	}
+	return buffer;
+}
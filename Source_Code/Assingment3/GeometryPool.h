@@ -0,0 +1,128 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :GeometryPool.h
+Description :  The GeometryPool holds the vertices and indices of every mesh
+               in two shared buffers. Vertices sit in a shader storage buffer
+               and are pulled by the vertex shaders through gl_VertexID, so
+               one vertex array with no attributes serves every draw. The
+               indices stay in an element buffer so the post-transform
+               vertex cache keeps working.
+               Each mesh picks its own vertex format, described by a third
+               buffer the shaders index with the base instance of the draw,
+               and uses 16-bit indices whenever it has few enough vertices.
+               Meshes are suballocated from the buffers through free lists
+               and can be removed. When no free range is big enough the
+               live meshes are packed to the front of new buffers, doubled
+               in size when packing alone does not make room, so they are
+               referred to by handle and their ranges looked up per draw.
+               All access must happen on the thread that owns the GL context.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef GEOMETRYPOOL_H
+#define GEOMETRYPOOL_H
+
+#include <glew.h>
+#include "VertexEncoder.h"
+#include "BufferArena.h"
+#include "ShaderBindings.h"
+#include <vector>
+
+// Where one mesh lives inside the pool
+struct MeshRange
+{
+	GLuint mesh = 0;// Entry in the mesh format buffer, drawn as the base instance
+	GLenum indexType = GL_UNSIGNED_INT;
+	GLuint indexOffset = 0;// First index in the shared element buffer, in bytes
+	GLsizei indexCount = 0;
+};
+
+// A mesh already in the storage layout of the pool, as read from a cooked mesh file
+struct PoolMeshData
+{
+	VertexFormat format = VertexFormat::Float32;
+	const GLuint* vertexWords = nullptr;
+	GLuint vertexCount = 0;
+	GLuint stride = 0;// Words per vertex
+	glm::vec3 positionScale = glm::vec3(1.0f);
+	glm::vec3 positionOffset = glm::vec3(0.0f);
+	const void* indices = nullptr;
+	GLenum indexType = GL_UNSIGNED_INT;// GL_UNSIGNED_SHORT only when there are at most 65536 vertices
+	GLuint indexCount = 0;
+};
+
+class GeometryPool
+{
+public:
+	static GeometryPool& Get();// The pool for the one GL context of the application
+
+	static const GLuint InitialVertexWords = 65536 * VertexEncoder::FloatsPerVertex;// 65536 float vertices
+	static const GLuint InitialIndexBytes = 262144 * sizeof(GLuint);
+	static const GLuint MaxVertexWords = 0x10000000u;// The buffers grow up to 1 GiB each
+	static const GLuint MaxIndexBytes = 0x40000000u;
+	static const GLuint MaxMeshes = 256;
+	static const GLuint InvalidMesh = 0xFFFFFFFFu;
+
+	// Copies a mesh into the pool, vertexCount is in vertices. Returns InvalidMesh when it is too big for any pool.
+	GLuint Add(const GLfloat* vertices, GLuint vertexCount, const GLuint* indices, GLuint indexCount, VertexFormat format);
+	GLuint AddEncoded(const PoolMeshData& data);// Copies encoded data as it is, nothing is converted
+	void Remove(GLuint mesh);// Frees the ranges of a mesh, the handle may be given out again
+	void Defragment();// Packs every live mesh to the front of the buffers
+
+	MeshRange GetRange(GLuint mesh) const;// Empty for InvalidMesh, valid until the next Defragment
+	unsigned int GetGeneration() const { return generation; }// Changes whenever ranges move
+
+	GLuint GetVAO() const { return vertexArray; }
+	GLuint GetVertexCount() const { return usedVertices; }
+	GLuint GetVertexBytes() const { return usedVertexWords * sizeof(GLuint); }
+	GLuint GetIndexBytes() const { return usedIndexBytes; }
+	GLuint GetFloatBytes() const { return floatBytes; }// What the same meshes take with float vertices and 32-bit indices
+
+	// Copying and assignment not allowed for this class
+	GeometryPool(const GeometryPool&) = delete;
+	GeometryPool& operator=(const GeometryPool&) = delete;
+
+private:
+	GeometryPool();
+
+	// Bookkeeping of one mesh handle
+	struct Entry
+	{
+		bool live = false;
+		MeshFormat format;// Copy of the format buffer entry, layout.y is the first vertex word
+		GLuint vertexCount = 0;
+		GLuint vertexWords = 0;
+		GLenum indexType = GL_UNSIGNED_INT;
+		GLuint indexOffset = 0;// In bytes
+		GLuint indexBytes = 0;
+		GLsizei indexCount = 0;
+		GLuint floatBytes = 0;
+	};
+
+	void Create();// Allocates the buffers once a context exists
+	void Repack(GLuint newVertexWords, GLuint newIndexBytes);// Copies the live meshes to the front of buffers of the given size
+	GLuint CreateBuffer(GLenum target, GLsizeiptr size);
+
+	GLuint vertexArray = 0;
+	GLuint vertexBuffer = 0;// Shader storage, bound at VertexDataBinding
+	GLuint indexBuffer = 0;// Element array of vertexArray
+	GLuint formatBuffer = 0;// Shader storage, bound at MeshFormatBinding
+	BufferArena vertexArena;// In words
+	BufferArena indexArena;// In bytes
+	GLuint vertexCapacity = InitialVertexWords;
+	GLuint indexCapacity = InitialIndexBytes;
+	std::vector<Entry> entries;// Indexed by handle, which is also the format buffer entry
+	std::vector<GLuint> freeHandles;
+	unsigned int generation = 0;
+	GLuint usedVertices = 0;
+	GLuint usedVertexWords = 0;
+	GLuint usedIndexBytes = 0;
+	GLuint floatBytes = 0;
+};
+#endif // GEOMETRYPOOL_H
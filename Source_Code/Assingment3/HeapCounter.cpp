@@ -0,0 +1,137 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :HeapCounter.cpp
+Description :  Replacement of the global operator new and delete that
+               counts every allocation on the calling thread.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "HeapCounter.h"
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	// Plain integers, so they need no constructor and are ready before any allocation
+	thread_local std::uint64_t threadAllocations = 0;
+	thread_local std::uint64_t threadBytes = 0;
+
+	/***********************************************************************
+	 * CountedAllocate: Counts and performs one allocation.
+	 * Author: [Smirti Parajuli]
+	 * Description: Calls the new handler until the allocation succeeds, as
+	 *              the standard operator new does.
+	 * Parameters:
+	 *   - size: Bytes requested.
+	 *
+	 * Return: void* - The memory, or nullptr when there is no new handler.
+	 ***********************************************************************/
+	void* CountedAllocate(std::size_t size)
+	{
+		threadAllocations++;
+		threadBytes += size;
+		if (size == 0) {
+			size = 1;
+		}
+		for (;;) {
+			void* memory = std::malloc(size);
+			if (memory != nullptr) {
+				return memory;
+			}
+			std::new_handler handler = std::get_new_handler();
+			if (handler == nullptr) {
+				return nullptr;
+			}
+			handler();
+		}
+	}
+}
+
+/***********************************************************************
+ * GetThreadAllocations: Gets the allocation count of the calling thread.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: std::uint64_t - Calls to operator new since the thread started.
+ ***********************************************************************/
+std::uint64_t HeapCounter::GetThreadAllocations()
+{
+	return threadAllocations;
+}
+
+/***********************************************************************
+ * GetThreadBytes: Gets the bytes allocated by the calling thread.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: std::uint64_t - Bytes requested since the thread started.
+ ***********************************************************************/
+std::uint64_t HeapCounter::GetThreadBytes()
+{
+	return threadBytes;
+}
+
+// Every form of operator new ends up in CountedAllocate, delete frees what malloc returned
+void* operator new(std::size_t size)
+{
+	void* memory = CountedAllocate(size);
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	try {
+		return CountedAllocate(size);
+	}
+	catch (...) {
+		return nullptr;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
@@ -0,0 +1,31 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :HeapCounter.h
+Description :  HeapCounter counts the heap allocations made by each thread.
+               HeapCounter.cpp replaces the global operator new, so every
+               new, container growth and std::function of the program is
+               counted, while C allocations and the allocations of other
+               modules, like the GL driver, are not. Reading the count
+               before and after a frame shows whether the frame loop
+               allocated at all.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef HEAPCOUNTER_H
+#define HEAPCOUNTER_H
+
+#include <cstdint>
+
+class HeapCounter
+{
+public:
+	static std::uint64_t GetThreadAllocations();// Calls to operator new made by the calling thread so far
+	static std::uint64_t GetThreadBytes();// Bytes those calls asked for
+};
+#endif // HEAPCOUNTER_H
@@ -0,0 +1,50 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :InputState.h
+Description :  Plain copy of the keyboard and mouse state sampled on the main
+               thread, so the simulation thread never calls into GLFW.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef INPUTSTATE_H
+#define INPUTSTATE_H
+
+#include <glfw3.h>
+
+struct InputState
+{
+	bool keys[GLFW_KEY_LAST + 1] = {};// Pressed state for every tracked key
+	double mouseX = 0.0;// Cursor position in window coordinates
+	double mouseY = 0.0;
+	bool leftMouseDown = false;
+	double scrollTotal = 0.0;// Running sum of scroll offsets, consumers track the delta themselves
+	double sampleTime = 0.0;// Time at which this state was sampled
+
+	bool IsKeyDown(int key) const { return keys[key]; }
+
+	// Samples the tracked keys and mouse state, must be called on the main thread
+	void Sample(GLFWwindow* window, double scroll, double now)
+	{
+		// Keys the simulation reads; sampling only these keeps the per-frame poll short
+		static const int TrackedKeys[] = {
+			GLFW_KEY_W, GLFW_KEY_A, GLFW_KEY_S, GLFW_KEY_D, GLFW_KEY_Q, GLFW_KEY_E,
+			GLFW_KEY_LEFT_SHIFT, GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3, GLFW_KEY_P, GLFW_KEY_G, GLFW_KEY_I, GLFW_KEY_M, GLFW_KEY_Z,
+			GLFW_KEY_F, GLFW_KEY_MINUS, GLFW_KEY_EQUAL, GLFW_KEY_H, GLFW_KEY_J, GLFW_KEY_R,
+		};
+		for (int key : TrackedKeys) {
+			keys[key] = (glfwGetKey(window, key) == GLFW_PRESS);
+		}
+		glfwGetCursorPos(window, &mouseX, &mouseY);
+		leftMouseDown = (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
+		scrollTotal = scroll;
+		sampleTime = now;
+	}
+};
+
+#endif // INPUTSTATE_H
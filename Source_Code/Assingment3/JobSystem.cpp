@@ -0,0 +1,437 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :JobSystem.cpp
+Description :  Implementation of the work stealing job system.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "JobSystem.h"
+#include <chrono>
+
+namespace
+{
+	// Which job system and worker the calling thread belongs to
+	thread_local const JobSystem* currentSystem = nullptr;
+	thread_local int currentWorker = -1;
+	thread_local int executeDepth = 0;// Jobs run while waiting inside a job are nested
+}
+
+/***********************************************************************
+ * JobSystem: Constructor for the JobSystem class.
+ * Author: [Smirti Parajuli]
+ * Description: Starts the worker threads. Threads that wait on a counter
+ *              also run jobs, so by default one core is left for them.
+ *
+ * Parameters:
+ *   - threadCount: Number of worker threads, 0 to size from the hardware.
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+JobSystem::JobSystem(unsigned int threadCount)
+	: queuedJobs(0)
+{
+	if (threadCount == 0) {
+		unsigned int cores = std::thread::hardware_concurrency();
+		threadCount = (cores > 1) ? cores - 1 : 1;
+	}
+	// Every deque exists before any worker can try to steal from it
+	for (unsigned int i = 0; i < threadCount; i++) {
+		workers.emplace_back(new Worker());
+	}
+	for (unsigned int i = 0; i < threadCount; i++) {
+		workers[i]->thread = std::thread(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+/***********************************************************************
+ * ~JobSystem: Destructor for the JobSystem class.
+ * Author: [Smirti Parajuli]
+ * Description: Wakes every worker with the stop flag set and joins them.
+ *              Every counter must have been waited on before this.
+ *
+ * Parameters: None
+ *
+ * Return: None (destructor)
+ ***********************************************************************/
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	sleepCondition.notify_all();
+	for (std::unique_ptr<Worker>& worker : workers) {
+		worker->thread.join();
+	}
+}
+
+/***********************************************************************
+ * Run: Queues one job.
+ * Author: [Smirti Parajuli]
+ * Description: A worker pushes onto its own deque so the job stays on
+ *              the same core unless someone steals it, other threads push
+ *              onto the shared queue.
+ *
+ * Parameters:
+ *   - counter: Raised now, lowered once the job has run.
+ *   - task: The work to run.
+ *
+ * Return: None
+ ***********************************************************************/
+void JobSystem::Run(JobCounter& counter, std::function<void()> task)
+{
+	counter.pending.fetch_add(1, std::memory_order_relaxed);
+	Push(Job{ std::move(task), &counter }, true);
+}
+
+/***********************************************************************
+ * Wait: Blocks until every job of a counter has run.
+ * Author: [Smirti Parajuli]
+ * Description: Rather than sleeping the calling thread runs any job it
+ *              can find, its own first, so a job can wait on jobs it
+ *              started without tying up a worker.
+ *
+ * Parameters:
+ *   - counter: The group to wait for.
+ *
+ * Return: None
+ ***********************************************************************/
+void JobSystem::Wait(JobCounter& counter)
+{
+	while (!counter.IsDone()) {
+		if (!RunOne()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************************
+ * ParallelFor: Runs a loop body over a range on all threads.
+ * Author: [Smirti Parajuli]
+ * Description: Chunk boundaries depend only on count and grainSize, so a
+ *              task that writes only inside its own range gives the same
+ *              result whatever the number of threads. The caller helps
+ *              until the last chunk is done.
+ *
+ * Parameters:
+ *   - count: Number of items.
+ *   - grainSize: Items per chunk.
+ *   - task: Called with [begin, end) for every chunk.
+ *
+ * Return: None
+ ***********************************************************************/
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& task)
+{
+	if (count == 0) {
+		return;
+	}
+	if (grainSize == 0) {
+		grainSize = 1;
+	}
+	// Not worth queueing a single chunk
+	if (count <= grainSize || workers.empty()) {
+		task(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	size_t chunkCount = (count + grainSize - 1) / grainSize;
+	counter.pending.fetch_add(static_cast<int>(chunkCount), std::memory_order_relaxed);
+	for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+		size_t begin = chunk * grainSize;
+		size_t end = (begin + grainSize < count) ? begin + grainSize : count;
+		Push(Job{ [&task, begin, end] { task(begin, end); }, &counter }, false);
+	}
+	WakeWorkers(true);
+	Wait(counter);
+}
+
+/***********************************************************************
+ * GetWorkerStats: Reads the profiling counters of one worker.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - worker: Worker index, below GetThreadCount.
+ *
+ * Return: The counters since the last ResetStats.
+ ***********************************************************************/
+JobStats JobSystem::GetWorkerStats(unsigned int worker) const
+{
+	const Counters& counters = workers[worker]->counters;
+	JobStats stats;
+	stats.busyNanoseconds = counters.busyNanoseconds.load(std::memory_order_relaxed);
+	stats.jobsRun = counters.jobsRun.load(std::memory_order_relaxed);
+	stats.steals = counters.steals.load(std::memory_order_relaxed);
+	return stats;
+}
+
+/***********************************************************************
+ * GetHelperStats: Reads the counters of the non worker threads.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: The counters since the last ResetStats, all helpers combined.
+ ***********************************************************************/
+JobStats JobSystem::GetHelperStats() const
+{
+	JobStats stats;
+	stats.busyNanoseconds = helperCounters.busyNanoseconds.load(std::memory_order_relaxed);
+	stats.jobsRun = helperCounters.jobsRun.load(std::memory_order_relaxed);
+	stats.steals = helperCounters.steals.load(std::memory_order_relaxed);
+	return stats;
+}
+
+/***********************************************************************
+ * ResetStats: Starts a new profiling window.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void JobSystem::ResetStats()
+{
+	for (std::unique_ptr<Worker>& worker : workers) {
+		worker->counters.busyNanoseconds.store(0, std::memory_order_relaxed);
+		worker->counters.jobsRun.store(0, std::memory_order_relaxed);
+		worker->counters.steals.store(0, std::memory_order_relaxed);
+	}
+	helperCounters.busyNanoseconds.store(0, std::memory_order_relaxed);
+	helperCounters.jobsRun.store(0, std::memory_order_relaxed);
+	helperCounters.steals.store(0, std::memory_order_relaxed);
+}
+
+/***********************************************************************
+ * WorkerLoop: Body of every worker thread.
+ * Author: [Smirti Parajuli]
+ * Description: Runs jobs while any can be found and sleeps when every
+ *              queue is empty.
+ *
+ * Parameters:
+ *   - index: This worker's slot in workers.
+ *
+ * Return: None
+ ***********************************************************************/
+void JobSystem::WorkerLoop(unsigned int index)
+{
+	currentSystem = this;
+	currentWorker = static_cast<int>(index);
+	while (true)
+	{
+		if (RunOne()) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepCondition.wait(lock, [this] { return stopping || queuedJobs.load() > 0; });
+		if (stopping) {
+			return;
+		}
+	}
+}
+
+/***********************************************************************
+ * Push: Puts a job on the right queue.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - job: The job to queue.
+ *   - notify: Wake a sleeping worker now, false when the caller queues a
+ *             batch and wakes everyone once at the end.
+ *
+ * Return: None
+ ***********************************************************************/
+void JobSystem::Push(Job job, bool notify)
+{
+	int worker = CurrentWorker();
+	if (worker >= 0) {
+		std::lock_guard<std::mutex> lock(workers[worker]->mutex);
+		workers[worker]->jobs.push_back(std::move(job));
+	}
+	else {
+		std::lock_guard<std::mutex> lock(sharedMutex);
+		sharedJobs.push_back(std::move(job));
+	}
+	queuedJobs.fetch_add(1);
+	if (notify) {
+		WakeWorkers(false);
+	}
+}
+
+/***********************************************************************
+ * WakeWorkers: Wakes sleeping workers after jobs were queued.
+ * Author: [Smirti Parajuli]
+ * Description: The sleep mutex is taken first so a worker that has just
+ *              seen an empty queue cannot miss the notification.
+ *
+ * Parameters:
+ *   - all: Wake every worker instead of one.
+ *
+ * Return: None
+ ***********************************************************************/
+void JobSystem::WakeWorkers(bool all)
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	if (all) {
+		sleepCondition.notify_all();
+	}
+	else {
+		sleepCondition.notify_one();
+	}
+}
+
+/***********************************************************************
+ * RunOne: Finds one job and runs it.
+ * Author: [Smirti Parajuli]
+ * Description: A worker looks at its own deque, then the shared queue,
+ *              then steals. Other threads look at the shared queue and
+ *              then steal.
+ *
+ * Parameters: None
+ *
+ * Return: True if a job was run.
+ ***********************************************************************/
+bool JobSystem::RunOne()
+{
+	Job job;
+	int worker = CurrentWorker();
+	if (worker >= 0) {
+		Counters& counters = workers[worker]->counters;
+		if (PopLocal(worker, job) || PopShared(job)) {
+			Execute(job, counters);
+			return true;
+		}
+		if (Steal(worker, job)) {
+			counters.steals.fetch_add(1, std::memory_order_relaxed);
+			Execute(job, counters);
+			return true;
+		}
+		return false;
+	}
+
+	if (PopShared(job)) {
+		Execute(job, helperCounters);
+		return true;
+	}
+	if (Steal(static_cast<unsigned int>(workers.size()), job)) {
+		helperCounters.steals.fetch_add(1, std::memory_order_relaxed);
+		Execute(job, helperCounters);
+		return true;
+	}
+	return false;
+}
+
+/***********************************************************************
+ * PopLocal: Takes the newest job from a worker's own deque.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - index: The worker.
+ *   - job: Receives the job.
+ *
+ * Return: True if there was one.
+ ***********************************************************************/
+bool JobSystem::PopLocal(unsigned int index, Job& job)
+{
+	Worker& worker = *workers[index];
+	std::lock_guard<std::mutex> lock(worker.mutex);
+	if (worker.jobs.empty()) {
+		return false;
+	}
+	job = std::move(worker.jobs.back());
+	worker.jobs.pop_back();
+	queuedJobs.fetch_sub(1);
+	return true;
+}
+
+/***********************************************************************
+ * PopShared: Takes the oldest job from the shared queue.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - job: Receives the job.
+ *
+ * Return: True if there was one.
+ ***********************************************************************/
+bool JobSystem::PopShared(Job& job)
+{
+	std::lock_guard<std::mutex> lock(sharedMutex);
+	if (sharedJobs.empty()) {
+		return false;
+	}
+	job = std::move(sharedJobs.front());
+	sharedJobs.pop_front();
+	queuedJobs.fetch_sub(1);
+	return true;
+}
+
+/***********************************************************************
+ * Steal: Takes the oldest job from another worker's deque.
+ * Author: [Smirti Parajuli]
+ * Description: Victims are tried in order starting after the thief so
+ *              thieves spread over the workers. The oldest job is usually
+ *              the biggest piece of work left in that deque.
+ *
+ * Parameters:
+ *   - thief: Index of the stealing worker, GetThreadCount for others.
+ *   - job: Receives the job.
+ *
+ * Return: True if a job was stolen.
+ ***********************************************************************/
+bool JobSystem::Steal(unsigned int thief, Job& job)
+{
+	size_t count = workers.size();
+	for (size_t offset = 1; offset <= count; offset++) {
+		size_t victim = (thief + offset) % count;
+		if (victim == thief) {
+			continue;
+		}
+		Worker& worker = *workers[victim];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (!worker.jobs.empty()) {
+			job = std::move(worker.jobs.front());
+			worker.jobs.pop_front();
+			queuedJobs.fetch_sub(1);
+			return true;
+		}
+	}
+	return false;
+}
+
+/***********************************************************************
+ * Execute: Runs a job and signals its counter.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - job: The job to run.
+ *   - counters: Profiling counters of the running thread.
+ *
+ * Return: None
+ ***********************************************************************/
+void JobSystem::Execute(Job& job, Counters& counters)
+{
+	// Only the outermost job is timed so nested jobs are not counted twice
+	bool timed = (executeDepth == 0);
+	auto start = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+	executeDepth++;
+	job.task();
+	executeDepth--;
+	if (timed) {
+		auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+		counters.busyNanoseconds.fetch_add(static_cast<std::uint64_t>(elapsed.count()), std::memory_order_relaxed);
+	}
+	counters.jobsRun.fetch_add(1, std::memory_order_relaxed);
+	job.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+/***********************************************************************
+ * CurrentWorker: Identifies the calling thread.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: The worker index, or -1 for threads this system did not start.
+ ***********************************************************************/
+int JobSystem::CurrentWorker() const
+{
+	return (currentSystem == this) ? currentWorker : -1;
+}
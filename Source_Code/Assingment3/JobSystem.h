@@ -0,0 +1,119 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :JobSystem.h
+Description :  The JobSystem is the engine wide thread pool. Every worker
+               owns a deque: it pushes and pops its own jobs at the back
+               and steals from the front of the other deques when it runs
+               dry. Threads that are not workers, like the render and
+               simulation threads, submit through a shared queue and help
+               run jobs while they wait on a JobCounter.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts the unfinished jobs of a group, Wait returns once it reaches zero
+class JobCounter
+{
+public:
+	JobCounter() : pending(0) {}
+
+	bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+	// Copying and assignment not allowed for this class
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+private:
+	friend class JobSystem;
+	std::atomic<int> pending;
+};
+
+// Profiling counters of one thread since the last ResetStats
+struct JobStats {
+	std::uint64_t busyNanoseconds = 0;// Time spent inside jobs
+	std::uint64_t jobsRun = 0;
+	std::uint64_t steals = 0;// Jobs taken from another worker's deque
+};
+
+class JobSystem
+{
+public:
+	explicit JobSystem(unsigned int threadCount = 0);// 0 uses one thread per extra hardware core
+	~JobSystem();
+
+	// Queues a job, counter is raised now and lowered when the job has run
+	void Run(JobCounter& counter, std::function<void()> task);
+
+	// Runs jobs until the counter reaches zero, so waiting never idles a thread
+	void Wait(JobCounter& counter);
+
+	// Runs task(begin, end) over [0, count) in chunks of grainSize and returns when all are done
+	void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& task);
+
+	unsigned int GetThreadCount() const { return static_cast<unsigned int>(workers.size()); }
+	JobStats GetWorkerStats(unsigned int worker) const;
+	JobStats GetHelperStats() const;// Jobs run by waiting threads that are not workers
+	void ResetStats();
+
+	// Copying and assignment not allowed for this class
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+private:
+	struct Job {
+		std::function<void()> task;
+		JobCounter* counter;
+	};
+
+	struct Counters {
+		std::atomic<std::uint64_t> busyNanoseconds{ 0 };
+		std::atomic<std::uint64_t> jobsRun{ 0 };
+		std::atomic<std::uint64_t> steals{ 0 };
+	};
+
+	struct Worker {
+		std::mutex mutex;
+		std::deque<Job> jobs;// Owner works at the back, thieves take the front
+		Counters counters;
+		std::thread thread;
+	};
+
+	void WorkerLoop(unsigned int index);
+	void Push(Job job, bool notify);
+	bool RunOne();// Runs one job if any can be found, false otherwise
+	bool PopLocal(unsigned int index, Job& job);
+	bool PopShared(Job& job);
+	bool Steal(unsigned int thief, Job& job);
+	void Execute(Job& job, Counters& counters);
+	void WakeWorkers(bool all);
+	int CurrentWorker() const;// Index of the calling thread, -1 if it is not one of ours
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::mutex sharedMutex;
+	std::deque<Job> sharedJobs;// Jobs submitted by threads that are not workers
+	Counters helperCounters;
+
+	std::atomic<int> queuedJobs;// Jobs sitting in any queue, workers sleep while it is zero
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	bool stopping = false;
+};
+#endif // JOBSYSTEM_H
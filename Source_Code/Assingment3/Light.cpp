@@ -13,6 +13,11 @@
 #include "Light.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "ShaderBindings.h"
+#include "FrameArena.h"
+#include "ShadowAtlas.h"
+#include <cmath>
+#include <random>
 #include <string>
 /***********************************************
  * Light: Default Constructor for the Light class.
@@ -20,17 +25,15 @@
  * Initializes a default Light object with no specific properties set.
  * This calls the InitializeLights function to set up default lighting.
  *
- * Parameters: None
+ * Parameters:
+ *   - entities: The entity store the point light markers are added to.
  *
  * Return: None (constructor)
  ***********************************************/
  
-Light::Light()
-    :lightObj(glm::vec3(1.0f), glm::vec3(0.0))
+Light::Light(EntityStore& entities)
+    :entities(entities)
 {
-    isPointLightsEnable ;
-    isDirectionalLightEnable;
-    isSpotLightsEnable ;
     InitializeLights();
 }
 /***********************************************
@@ -44,13 +47,14 @@ Light::Light()
  ***********************************************/
 Light::~Light() {
     // Cleanup code...
-
+    glDeleteBuffers(1, &pointLightBuffer);
 }
 /***********************************************
  * InitializeLights: Sets up the properties for various light sources.
  * Author: [Smirti.parajuli]
  * This function initializes point lights, directional lights, and spotlights
- * with predefined positions, colors, and attenuation factors.
+ * with predefined positions, colors, and attenuation factors. The point
+ * lights are topped up with generated ones and written to their buffer.
  *
  * Parameters: None
  *
@@ -67,9 +71,9 @@ void Light::InitializeLights() {
     light1.attenuationConstant = 2.0f;
     light1.attenuationLinear = 0.09f;
     light1.attenuationExponent = 0.032f;
+    light1.range = CalculateRange(light1);
     pointLights.push_back(light1);
-    LightObj* lightObject1 = new LightObj(light1.position, light1.color);
-    lightObjects.push_back(lightObject1);
+    markerEntities.push_back(entities.Create(light1.position, 0.2f, MaterialLightMarker, EntityVisible | EntityCullable));
 
     PointLight light2{};
 
@@ -81,9 +85,9 @@ void Light::InitializeLights() {
     light2.attenuationConstant = 2.0f;
     light2.attenuationLinear = 0.09f;
     light2.attenuationExponent = 0.037f;
+    light2.range = CalculateRange(light2);
     pointLights.push_back(light2);
-    LightObj* lightObject2 = new LightObj(light2.position, light2.color);
-    lightObjects.push_back(lightObject2);
+    markerEntities.push_back(entities.Create(light2.position, 0.2f, MaterialLightMarker, EntityVisible | EntityCullable));
 
     // Initialize Directional Light
     dirLight.direction = glm::vec3(2.0f, 1.0f, 0.0f);
@@ -110,155 +114,243 @@ void Light::InitializeLights() {
     RimLight rimLight{};
     rimLight.position = glm::vec3(0.0f, -10.0f, 0.0f);
     rimLight.color = glm::vec3(0.0f, 0.0f, 1.0f); // Blue color
-  
-
-   
 
+    AddGeneratedLights();
+    CreatePointLightBuffer();
 }
 /***********************************************
- * RenderLightObjects: Renders the light objects in the scene.
+ * CalculateRange: Finds how far a point light reaches.
  * Author: [Smirti.parajuli]
- * Calls the Render function on each Pointlight light to display them in the scene,
- * with the respective colors.
+ * Solves constant + linear * d + exponent * d^2 = 256 * brightest, where
+ * brightest is the most the light adds to a white surface facing it, so
+ * past the range it adds less than one step of an 8-bit colour. The
+ * deferred path sizes the light volumes with it.
  *
  * Parameters:
- *   - camera: The camera object to use for rendering the light objects.
+ *   - light: The light, with its attenuation factors set.
  *
- * Return: None
+ * Return:
+ *   - float: The range in world units, zero for a light too dim to see.
  ***********************************************/
-void Light::RenderLightObjects(const Camera& camera) {
-    for (size_t i = 0; i < lightObjects.size(); ++i) {
-        lightObjects[i]->Render(pointLights[i].color, camera);
-
-
+float Light::CalculateRange(const PointLight& light) {
+    glm::vec3 diffuse = light.diffuse * light.color;
+    float brightest = glm::max(diffuse.x, glm::max(diffuse.y, diffuse.z))
+        + glm::max(light.specular.x, glm::max(light.specular.y, light.specular.z));
+    float constant = light.attenuationConstant - brightest * 256.0f;
+    if (constant >= 0.0f) {
+        return 0.0f;
+    }
+    if (light.attenuationExponent > 0.0f) {
+        float linear = light.attenuationLinear;
+        float range = (-linear + std::sqrt(linear * linear - 4.0f * light.attenuationExponent * constant)) / (2.0f * light.attenuationExponent);
+        return glm::min(range, MaxRange);
     }
+    if (light.attenuationLinear > 0.0f) {
+        return glm::min(-constant / light.attenuationLinear, MaxRange);
+    }
+    return MaxRange;
 }
 /***********************************************
- * IsPointLightsEnabled: Checks if point lights are enabled.
+ * AddGeneratedLights: Adds small point lights around the spheres.
  * Author: [Smirti.parajuli]
- * Returns a boolean value indicating whether point lights are currently enabled.
+ * Fills pointLights up to MaxPointLights with coloured lights that fall off
+ * quickly, so the cost of shading with many lights can be compared between
+ * the forward and deferred paths. They have no markers.
  *
  * Parameters: None
  *
- * Return:
- *   - bool: True if point lights are enabled, false otherwise.
+ * Return: None
  ***********************************************/
-
-bool Light::IsPointLightsEnabled() const {
-    return isPointLightsEnable;
+void Light::AddGeneratedLights() {
+    // Fixed seed, so every run measures the same lights
+    std::mt19937 random(2023);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> channel(0.05f, 1.0f);
+    while (pointLights.size() < static_cast<size_t>(MaxPointLights)) {
+        PointLight light{};
+        light.position = glm::vec3(position(random), position(random), position(random));
+        glm::vec3 color(channel(random), channel(random), channel(random));
+        light.color = color / glm::max(color.x, glm::max(color.y, color.z));// Brightest channel at full
+        light.ambient = glm::vec3(0.0f);
+        light.diffuse = glm::vec3(1.0f);
+        light.specular = glm::vec3(0.5f);
+        light.attenuationConstant = 1.0f;
+        light.attenuationLinear = 0.7f;
+        light.attenuationExponent = 10.0f;
+        light.range = CalculateRange(light);
+        pointLights.push_back(light);
+    }
 }
-
 /***********************************************
- * RenderPointLights: Applies point light effects to the shader.
+ * CreatePointLightBuffer: Uploads every point light once.
  * Author: [Smirti.parajuli]
- * Sets uniform values for point light properties in the given shader program,
- * enabling the effects of point lighting in the rendered scene.
+ * The lights never move, so they are written to a storage buffer at start
+ * up and the count in the LightData block picks how many are used.
  *
- * Parameters:
- *   - shaderProgram: The OpenGL shader program ID where the light properties will be set.
+ * Parameters: None
  *
  * Return: None
  ***********************************************/
-void Light::RenderPointLights(GLuint shaderProgram) {
-    if (isPointLightsEnable) {
-        glUseProgram(shaderProgram);
-
-        // Set point light properties
-        for (size_t i = 0; i < pointLights.size(); ++i) {
-            std::string pointLightStr = "pointLights[" + std::to_string(i) + "]";
-
-            glUniform3fv(glGetUniformLocation(shaderProgram, (pointLightStr + ".position").c_str()), 1, glm::value_ptr(pointLights[i].position));
-            glUniform3fv(glGetUniformLocation(shaderProgram, (pointLightStr + ".color").c_str()), 1, glm::value_ptr(pointLights[i].color));
-            glUniform3fv(glGetUniformLocation(shaderProgram, (pointLightStr + ".ambient").c_str()), 1, glm::value_ptr(pointLights[i].ambient));
-            glUniform3fv(glGetUniformLocation(shaderProgram, (pointLightStr + ".diffuse").c_str()), 1, glm::value_ptr(pointLights[i].diffuse));
-             glUniform3fv(glGetUniformLocation(shaderProgram, (pointLightStr + ".specular").c_str()), 1, glm::value_ptr(pointLights[i].specular));
-            glUniform1f(glGetUniformLocation(shaderProgram, (pointLightStr + ".AttenuationConstant").c_str()), pointLights[i].attenuationConstant);
-            glUniform1f(glGetUniformLocation(shaderProgram, (pointLightStr + ".AttenuationLinear").c_str()), pointLights[i].attenuationLinear);
-            glUniform1f(glGetUniformLocation(shaderProgram, (pointLightStr + ".AttenuationExponent").c_str()), pointLights[i].attenuationExponent);
-        }
-
-        // Set point light count (optional, if needed in shader)
-        glUniform1i(glGetUniformLocation(shaderProgram, "pointLightCount"), static_cast<int>(pointLights.size()));
-        glUniform1i(glGetUniformLocation(shaderProgram, "isPointLightsEnable"), isPointLightsEnable);
+void Light::CreatePointLightBuffer() {
+    ScratchScope scratch;
+    PointLightBlock* blocks = scratch.Allocate<PointLightBlock>(pointLights.size());
+    for (size_t i = 0; i < pointLights.size(); ++i) {
+        const PointLight& light = pointLights[i];
+        blocks[i].position = glm::vec4(light.position, 1.0f);
+        blocks[i].color = glm::vec4(light.color, 1.0f);
+        blocks[i].ambient = glm::vec4(light.ambient, 0.0f);
+        blocks[i].diffuse = glm::vec4(light.diffuse, 0.0f);
+        blocks[i].specular = glm::vec4(light.specular, 0.0f);
+        blocks[i].attenuation = glm::vec4(light.attenuationConstant, light.attenuationLinear, light.attenuationExponent, light.range);
     }
-   
-
 
+    // Never written again, so the storage does not need any access flags
+    glGenBuffers(1, &pointLightBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pointLightBuffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(PointLightBlock) * pointLights.size(), blocks, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 }
 /***********************************************
- * DisablePointLights: Disables point light effects in the shader.
+ * BuildMarkers: Collects the visible point light markers.
  * Author: [Smirti.parajuli]
- * Sets point light colors to zero in the shader program, effectively disabling them.
+ * Culls the marker entities against the frustum and records their model
+ * matrices and light colors in the snapshot. Runs on the simulation thread.
  *
  * Parameters:
- *   - shaderProgram: The OpenGL shader program ID where the light properties will be reset.
+ *   - frustum: The camera frustum for this frame.
+ *   - frame: The snapshot whose marker lists are refilled.
  *
  * Return: None
  ***********************************************/
-void Light::DisablePointLights(GLuint shaderProgram) {
-    glUseProgram(shaderProgram);
-    for (size_t i = 0; i < pointLights.size(); ++i) {
-        std::string pointLightStr = "pointLights[" + std::to_string(i) + "]";
-        glUniform3f(glGetUniformLocation(shaderProgram, (pointLightStr + ".ambient").c_str()), 0.0f, 0.0f, 0.0f);
-        glUniform3f(glGetUniformLocation(shaderProgram, (pointLightStr + ".diffuse").c_str()), 0.0f, 0.0f, 0.0f);
-        glUniform3f(glGetUniformLocation(shaderProgram, (pointLightStr + ".specular").c_str()), 0.0f, 0.0f, 0.0f);
+void Light::BuildMarkers(const Frustum& frustum, FrameSnapshot& frame) const {
+    frame.lightMarkerModels.clear();
+    frame.lightMarkerColors.clear();
+    for (size_t i = 0; i < markerEntities.size(); ++i) {
+        size_t index = entities.IndexOf(markerEntities[i]);
+        if (!frustum.IsSphereVisible(entities.GetPosition(markerEntities[i]), LightObj::BoundingRadius * entities.scale[index])) {
+            continue;
+        }
+        frame.lightMarkerModels.push_back(entities.BuildModel(index, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+        frame.lightMarkerColors.push_back(pointLights[i].color);
     }
 }
 /***********************************************
- * IsDirectionalLightEnabled: Checks the enable state of the directional light.
+ * SubmitLightObjects: Queues the light objects in the scene.
  * Author: [Smirti.parajuli]
- * Queries the current state of the directional light, returning whether it is enabled.
+ * Queues one marker per visible point light, with the respective colors.
  *
- * Parameters: None
+ * Parameters:
+ *   - queue: The render queue for this frame.
+ *   - frame: The snapshot holding the markers for this frame.
  *
- * Return:
- *   - bool: True if the directional light is enabled, false otherwise.
+ * Return: None
  ***********************************************/
-bool Light::IsDirectionalLightEnabled() const {
-    return isDirectionalLightEnable;
+void Light::SubmitLightObjects(RenderQueue& queue, const FrameSnapshot& frame) const {
+    for (size_t i = 0; i < frame.lightMarkerModels.size(); ++i) {
+        lightObj.Submit(queue, frame.lightMarkerModels[i], frame.lightMarkerColors[i], frame);
+    }
 }
 /***********************************************
- * RenderDirectionalLight: Renders the directional light in the scene.
+ * BuildShadowViews: Places the shadow maps for this frame.
  * Author: [Smirti.parajuli]
- * Passes the directional light's properties such as direction, ambient, diffuse,
- * and specular components to the shader program if the light is enabled.
+ * The directional light gets one orthographic cascade per slice of the camera
+ * frustum, sized to the bounding sphere of the slice so turning the camera never
+ * resizes it, and moved in whole texels so a still camera gives the same matrix
+ * every frame. Each spotlight gets a perspective map covering its outer cone.
+ * The cache keys are filled in by Sphere::BuildShadowCasters. Runs on the
+ * simulation thread.
  *
  * Parameters:
- *   - shaderProgram: The OpenGL shader program ID where the directional light properties will be set.
+ *   - frame: The snapshot holding the camera, whose shadow views are refilled.
  *
  * Return: None
  ***********************************************/
-void Light::RenderDirectionalLight(GLuint shaderProgram) {
-    if (isDirectionalLightEnable) {
-        glUseProgram(shaderProgram);
-        glUniform1i(glGetUniformLocation(shaderProgram, "isDirectionalLightEnable"), isDirectionalLightEnable);
-        glUniform3fv(glGetUniformLocation(shaderProgram, "dirLight.direction"), 1, glm::value_ptr(dirLight.direction));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "dirLight.ambient"), 1, glm::value_ptr(dirLight.ambient));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "dirLight.diffuse"), 1, glm::value_ptr(dirLight.diffuse));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "dirLight.specular"), 1, glm::value_ptr(dirLight.specular));
+void Light::BuildShadowViews(FrameSnapshot& frame) const {
+    frame.shadowsEnabled = isShadowsEnable;
+    frame.shadowCaching = isShadowCachingEnable;
+    frame.shadowCascadeCount = 0;
+    frame.spotShadowCount = 0;
+    if (!isShadowsEnable) {
+        return;
     }
 
-   
+    // Rotation into light space, where the cascade centres are snapped
+    glm::vec3 lightDirection = glm::normalize(dirLight.direction);
+    glm::vec3 lightUp = std::fabs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), lightDirection, lightUp);
+    glm::mat4 inverseLightRotation = glm::transpose(lightRotation);
+    glm::mat4 inverseView = glm::inverse(frame.view);
+
+    // Squared distance from the view axis to a frustum corner, per unit of depth
+    float tanHalfFov = std::tan(glm::radians(frame.fov) * 0.5f);
+    float cornerSpread = tanHalfFov * tanHalfFov * (1.0f + frame.aspect * frame.aspect);
+
+    float splitStart = frame.nearPlane;
+    for (int i = 0; i < ShadowCascadeCount; ++i) {
+        float fraction = static_cast<float>(i + 1) / ShadowCascadeCount;
+        float evenSplit = frame.nearPlane + (ShadowDistance - frame.nearPlane) * fraction;
+        float logSplit = frame.nearPlane * std::pow(ShadowDistance / frame.nearPlane, fraction);
+        float splitEnd = glm::mix(evenSplit, logSplit, CascadeSplitBlend);
+
+        // Smallest sphere around the slice, its centre lies on the view axis where the
+        // near and far corners are equally far away
+        float centreDepth = glm::min(0.5f * (splitStart + splitEnd) * (1.0f + cornerSpread), splitEnd);
+        float radius = std::sqrt((splitEnd - centreDepth) * (splitEnd - centreDepth) + splitEnd * splitEnd * cornerSpread);
+        radius = std::ceil(radius * 16.0f) / 16.0f;// Rounding noise must not change the size
+        glm::vec3 centre = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, -centreDepth, 1.0f));
+
+        float texel = 2.0f * radius / ShadowAtlas::TileSize;
+        glm::vec3 lightCentre = glm::vec3(lightRotation * glm::vec4(centre, 1.0f));
+        lightCentre = glm::floor(lightCentre / texel) * texel;
+        centre = glm::vec3(inverseLightRotation * glm::vec4(lightCentre, 1.0f));
+
+        // Starts CasterReach before the sphere, so casters between the light and the slice are drawn
+        ShadowView& view = frame.shadowViews[i];
+        view.view = glm::lookAt(centre - lightDirection * (radius + CasterReach), centre, lightUp);
+        view.projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + CasterReach);
+        splitStart = splitEnd;
+    }
+    frame.shadowCascadeCount = ShadowCascadeCount;
+
+    int spotCount = static_cast<int>(spotLights.size() < MaxSpotLights ? spotLights.size() : MaxSpotLights);
+    for (int i = 0; i < spotCount; ++i) {
+        const SpotLight& light = spotLights[i];
+        glm::vec3 direction = glm::normalize(light.direction);
+        glm::vec3 up = std::fabs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        ShadowView& view = frame.shadowViews[ShadowCascadeCount + i];
+        view.view = glm::lookAt(light.position, light.position + direction, up);
+        view.projection = glm::perspective(2.0f * std::acos(light.outerCutOff), 1.0f, SpotShadowNear, SpotShadowFar);
+    }
+    frame.spotShadowCount = spotCount;
 }
 /***********************************************
- * DisableDirectionalLight: Disables the directional light effects in the shader.
+ * IsPointLightsEnabled: Checks if point lights are enabled.
  * Author: [Smirti.parajuli]
- * Sets the ambient, diffuse, and specular components of the directional light to zero
- * in the shader program, effectively disabling it.
+ * Returns a boolean value indicating whether point lights are currently enabled.
  *
- * Parameters:
- *   - shaderProgram: The OpenGL shader program ID where the directional light properties will be reset.
+ * Parameters: None
  *
- * Return: None
+ * Return:
+ *   - bool: True if point lights are enabled, false otherwise.
  ***********************************************/
 
-void Light::DisableDirectionalLight(GLuint shaderProgram) {
-    glUseProgram(shaderProgram);
-    glUniform3f(glGetUniformLocation(shaderProgram, "dirLight.ambient"), 0.0f, 0.0f, 0.0f);
-    glUniform3f(glGetUniformLocation(shaderProgram, "dirLight.diffuse"), 0.0f, 0.0f, 0.0f);
-    glUniform3f(glGetUniformLocation(shaderProgram, "dirLight.specular"), 0.0f, 0.0f, 0.0f);
+bool Light::IsPointLightsEnabled() const {
+    return isPointLightsEnable;
 }
 
+/***********************************************
+ * IsDirectionalLightEnabled: Checks the enable state of the directional light.
+ * Author: [Smirti.parajuli]
+ * Queries the current state of the directional light, returning whether it is enabled.
+ *
+ * Parameters: None
+ *
+ * Return:
+ *   - bool: True if the directional light is enabled, false otherwise.
+ ***********************************************/
+bool Light::IsDirectionalLightEnabled() const {
+    return isDirectionalLightEnable;
+}
 /***********************************************
  * IsSpotlightsEnabled: Checks the enable state of all spotlights.
  * Author: [Smirti.parajuli]
@@ -275,151 +367,118 @@ bool Light::IsSpotlightsEnabled() const {
 }
 
 /***********************************************
- * RenderSpotlights: Renders the spotlights in the scene.
+ * UploadLights: Writes every light into the LightData uniform block.
  * Author: [Smirti.parajuli]
- * Passes each spotlight's properties such as position, direction, cutOff angles, ambient, diffuse,
- * and specular components to the shader program if spotlights are enabled.
+ * Fills the block directly in the mapped stream buffer and binds it, replacing
+ * the per-uniform glUniform calls. Disabled light types are switched off through
+ * the enable flags instead of zeroing their colours. The point lights are already
+ * in their buffer, only their count changes. The shadow matrices take a world
+ * position straight to the atlas tile of its shadow view.
  *
  * Parameters:
- *   - shaderProgram: The OpenGL shader program ID where the spotlight properties will be set.
+ *   - stream: The per-frame stream buffer to write into.
+ *   - frame: The snapshot holding the light toggles for this frame.
  *
  * Return: None
  ***********************************************/
-void Light::RenderSpotlights(GLuint shaderProgram)
-{
+void Light::UploadLights(StreamBuffer& stream, const FrameSnapshot& frame) {
+    GLintptr offset = 0;
+    LightBlock* block = stream.Allocate<LightBlock>(offset);
+    if (!block) {
+        return;
+    }
 
-    if (isSpotLightsEnable) {
-        glUseProgram(shaderProgram);
-
-        GLint spotLightCountLoc = glGetUniformLocation(shaderProgram, "spotLightCount");
-        glUniform1i(spotLightCountLoc, static_cast<int>(spotLights.size()));
-
-        for (size_t i = 0; i < spotLights.size(); ++i) {
-            std::string spotLightStr = "spotLights[" + std::to_string(i) + "]";
-            glUniform1i(glGetUniformLocation(shaderProgram, "isSpotLightsEnable"), isSpotLightsEnable);
-            GLint SpotPositionLoc = glGetUniformLocation(shaderProgram, (spotLightStr + ".position").c_str());
-            GLint SpotDirectionLoc = glGetUniformLocation(shaderProgram, (spotLightStr + ".direction").c_str());
-            GLint SpotAmbientLoc = glGetUniformLocation(shaderProgram, (spotLightStr + ".ambient").c_str());
-            GLint SpotDiffuseLoc = glGetUniformLocation(shaderProgram, (spotLightStr + ".diffuse").c_str());
-            GLint SpotSpecularLoc = glGetUniformLocation(shaderProgram, (spotLightStr + ".specular").c_str());
-            GLint SpotInnerAngleLoc = glGetUniformLocation(shaderProgram, (spotLightStr + ".cutOff").c_str());
-            GLint SpotOuterAngleLoc = glGetUniformLocation(shaderProgram, (spotLightStr + ".outerCutOff").c_str());
-
-            // Set light position, direction, colors and angles
-            if (SpotPositionLoc != -1) {
-                glUniform3fv(SpotPositionLoc, 1, glm::value_ptr(spotLights[i].position));
-            }
-            if (SpotDirectionLoc != -1) {
-                glUniform3fv(SpotDirectionLoc, 1, glm::value_ptr(spotLights[i].direction));
-            }
-            if (SpotAmbientLoc != -1) {
-                glUniform3fv(SpotAmbientLoc, 1, glm::value_ptr(spotLights[i].ambient));
-            }
-            if (SpotDiffuseLoc != -1) {
-                glUniform3fv(SpotDiffuseLoc, 1, glm::value_ptr(spotLights[i].diffuse));
-            }
-            if (SpotSpecularLoc != -1) {
-                glUniform3fv(SpotSpecularLoc, 1, glm::value_ptr(spotLights[i].specular));
-            }
-            if (SpotInnerAngleLoc != -1) {
-                glUniform1f(SpotInnerAngleLoc, spotLights[i].cutOff);
-            }
-            if (SpotOuterAngleLoc != -1) {
-                glUniform1f(SpotOuterAngleLoc, spotLights[i].outerCutOff);
-            }
-        }
+    int pointCount = glm::min(frame.pointLightCount, static_cast<int>(pointLights.size()));
+
+    block->dirLight.direction = glm::vec4(dirLight.direction, 0.0f);
+    block->dirLight.ambient = glm::vec4(dirLight.ambient, 0.0f);
+    block->dirLight.diffuse = glm::vec4(dirLight.diffuse, 0.0f);
+    block->dirLight.specular = glm::vec4(dirLight.specular, 0.0f);
+
+    int spotCount = static_cast<int>(spotLights.size() < MaxSpotLights ? spotLights.size() : MaxSpotLights);
+    for (int i = 0; i < spotCount; ++i) {
+        const SpotLight& light = spotLights[i];
+        block->spotLights[i].position = glm::vec4(light.position, 1.0f);
+        block->spotLights[i].direction = glm::vec4(light.direction, 0.0f);
+        block->spotLights[i].ambient = glm::vec4(light.ambient, 0.0f);
+        block->spotLights[i].diffuse = glm::vec4(light.diffuse, 0.0f);
+        block->spotLights[i].specular = glm::vec4(light.specular, 0.0f);
+        block->spotLights[i].cutOff = glm::vec4(light.cutOff, light.outerCutOff, 0.0f, 0.0f);
     }
-}
-/***********************************************
- * RenderRimLight: Renders the rim light in the scene.
- * Author: [Smirti.parajuli]
- * Passes the rim light's properties such as strength and power to the shader program
- * if the rim light is enabled.
- *
- * Parameters:
- *   - shaderProgram: The OpenGL shader program ID where the rim light properties will be set.
- *
- * Return: None
- ***********************************************/
-void Light::DisableSpotlights(GLuint shaderProgram)  {  // Disable all spotlights
-    glUniform1i(glGetUniformLocation(shaderProgram, "spotLightCount"), 0);
-       
-
-        // Optionally, loop through and explicitly set colors to zero
-        for (size_t i = 0; i < spotLights.size(); ++i) {
-            std::string spotLightStr = "spotLights[" + std::to_string(i) + "]";
-            glUniform3f(glGetUniformLocation(shaderProgram, (spotLightStr + ".diffuse").c_str()), 0.0f, 0.0f, 0.0f);
-            glUniform3f(glGetUniformLocation(shaderProgram, (spotLightStr + ".specular").c_str()), 0.0f, 0.0f, 0.0f);
-        }
-}
 
-/***********************************************
-* RenderRimLight: Renders the rim light in the scene.
-* Author: [Smirti.parajuli]
-* Passes the rim light's properties such as strength and power to the shader program
-* if the rim light is enabled.
-*
-* Parameters:
-*   - shaderProgram: The OpenGL shader program ID where the rim light properties will be set.
-*
-* Return: None
-***********************************************/
-
-void Light::RenderRimLight(GLuint shaderProgram) {
-    glUseProgram(shaderProgram);
-    glUniform1i(glGetUniformLocation(shaderProgram, "isRimLightEnable"), isRimLightEnable);
-
-    // Set the uniform values for RimStrength, RimPower, and RimLightColor
-    GLint rimStrengthLoc = glGetUniformLocation(shaderProgram, "RimStrength");
-    GLint rimPowerLoc = glGetUniformLocation(shaderProgram, "RimPower");
-    GLint rimLightColorLoc = glGetUniformLocation(shaderProgram, "RimLightColor");
-
-    // Check if the uniform locations are found
-    
+    block->enable = glm::ivec4(frame.pointLightsEnabled, frame.directionalLightEnabled, frame.spotLightsEnabled, isRimLightEnable);
+    block->counts = glm::ivec4(pointCount, spotCount, 0, 0);
+
+    int spotShadowCount = glm::min(frame.spotShadowCount, spotCount);
+    for (int i = 0; i < frame.shadowCascadeCount; ++i) {
+        const ShadowView& view = frame.shadowViews[i];
+        block->cascadeMatrices[i] = ShadowAtlas::GetTileMatrix(i) * view.projection * view.view;
+    }
+    for (int i = 0; i < spotShadowCount; ++i) {
+        const ShadowView& view = frame.shadowViews[ShadowCascadeCount + i];
+        block->spotShadowMatrices[i] = ShadowAtlas::GetTileMatrix(ShadowCascadeCount + i) * view.projection * view.view;
+    }
+    block->shadowCounts = glm::ivec4(frame.shadowCascadeCount, spotShadowCount, 0, 0);
+
+    stream.BindRange(GL_UNIFORM_BUFFER, LightDataBinding, offset, sizeof(LightBlock));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PointLightDataBinding, pointLightBuffer);
 }
 
 /***********************************************
  * HandleKeyPress: Handles key press events to toggle lights.
  * Author: [Smirti.parajuli]
  * Listens for specific key presses to toggle the state of point, directional, and spotlights.
+ * '-' and '=' halve and double the number of point lights, the scene lights always stay.
+ * 'H' toggles the shadow maps and 'J' whether they are kept until something in them moves.
  * The state is changed only on key press, not on key hold, to prevent rapid toggling.
+ * Runs on the simulation thread using the input sampled by the main thread.
  *
  * Parameters:
- *   - window: The GLFWwindow* representing the window that receives the key press.
+ *   - input: The keyboard state sampled for this step.
  *
  * Return:void
  ***********************************************/
-void Light::HandleKeyPress(GLFWwindow* window) {
-
-    // Static variables to keep track of the key states for different lights
-    static bool isDirectionalKeyPressed = false; // Should initially be false
-    static bool isPointKeyPressed = false; // Should initially be false
-    static bool isSpotKeyPressed = false; // Should initially be false
+void Light::HandleKeyPress(const InputState& input) {
 
     // Toggling Point Lights with key '1'
-    if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS && !isPointKeyPressed) {
+    if (input.IsKeyDown(GLFW_KEY_1) && !isPointKeyPressed) {
         isPointLightsEnable = !isPointLightsEnable; // Toggle the state
-        isPointKeyPressed = true; // Mark as pressed
-    }
-    else if (glfwGetKey(window, GLFW_KEY_1) == GLFW_RELEASE && isPointKeyPressed) {
-        isPointKeyPressed = false; // Mark as released
     }
+    isPointKeyPressed = input.IsKeyDown(GLFW_KEY_1);
 
     // Toggling Directional Lights with key '2'
-    if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS && !isDirectionalKeyPressed) {
+    if (input.IsKeyDown(GLFW_KEY_2) && !isDirectionalKeyPressed) {
         isDirectionalLightEnable = !isDirectionalLightEnable; // Toggle the state
-        isDirectionalKeyPressed = true; // Mark as pressed
-    }
-    else if (glfwGetKey(window, GLFW_KEY_2) == GLFW_RELEASE && isDirectionalKeyPressed) {
-        isDirectionalKeyPressed = false; // Mark as released
     }
+    isDirectionalKeyPressed = input.IsKeyDown(GLFW_KEY_2);
 
     // Toggling Spotlights with key '3'
-    if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS && !isSpotKeyPressed) {
+    if (input.IsKeyDown(GLFW_KEY_3) && !isSpotKeyPressed) {
         isSpotLightsEnable = !isSpotLightsEnable; // Toggle the state
-        isSpotKeyPressed = true; // Mark as pressed
     }
-    else if (glfwGetKey(window, GLFW_KEY_3) == GLFW_RELEASE && isSpotKeyPressed) {
-        isSpotKeyPressed = false; // Mark as released
+    isSpotKeyPressed = input.IsKeyDown(GLFW_KEY_3);
+
+    // Fewer point lights with key '-'
+    if (input.IsKeyDown(GLFW_KEY_MINUS) && !isFewerLightsKeyPressed) {
+        pointLightCount = glm::max(pointLightCount / 2, static_cast<int>(SceneLights));
+    }
+    isFewerLightsKeyPressed = input.IsKeyDown(GLFW_KEY_MINUS);
+
+    // More point lights with key '='
+    if (input.IsKeyDown(GLFW_KEY_EQUAL) && !isMoreLightsKeyPressed) {
+        pointLightCount = glm::min(pointLightCount * 2, static_cast<int>(pointLights.size()));
+    }
+    isMoreLightsKeyPressed = input.IsKeyDown(GLFW_KEY_EQUAL);
+
+    // Toggling shadows with key 'H'
+    if (input.IsKeyDown(GLFW_KEY_H) && !isShadowKeyPressed) {
+        isShadowsEnable = !isShadowsEnable; // Toggle the state
+    }
+    isShadowKeyPressed = input.IsKeyDown(GLFW_KEY_H);
+
+    // Toggling shadow caching with key 'J', off draws every shadow map every frame
+    if (input.IsKeyDown(GLFW_KEY_J) && !isShadowCacheKeyPressed) {
+        isShadowCachingEnable = !isShadowCachingEnable; // Toggle the state
     }
+    isShadowCacheKeyPressed = input.IsKeyDown(GLFW_KEY_J);
 }
@@ -23,6 +23,12 @@ Mail : [smirtiparajuli]@mds.ac.nz
 #include "LightObj.h"
 #include <glm/glm.hpp>
 #include "ShaderLoader.h"
+#include "InputState.h"
+#include "FrameSnapshot.h"
+#include "StreamBuffer.h"
+#include "RenderQueue.h"
+#include "EntityStore.h"
+#include "Frustum.h"
 #include <vector>
 // The Light class encapsulates different lighting models and their properties.
 class Light {
@@ -37,6 +43,7 @@ public:
         float attenuationConstant; // Constant factor for light attenuation
         float attenuationLinear;// Linear factor for light attenuation
         float attenuationExponent;// Exponential factor for light attenuation
+        float range;// Distance past which the light adds less than one step of an 8-bit colour
     };
     // Defines the attributes of a Directional Light, similar to sunlight.
     struct DirectionalLight {
@@ -60,43 +67,87 @@ public:
         glm::vec3 position; // Position in world space
         glm::vec3 color;// Color of the rim light
     };
+
+    // The two scene lights come first, the rest are small generated lights to measure shading cost per light
+    static const int SceneLights = 2;
+    static const int MaxPointLights = 1024;
+    // Array size of the LightData uniform block in BlinnPhongLighting.glsl
+    static const int MaxSpotLights = 10;
+    static_assert(MaxSpotLights == MaxSpotShadows, "Every spotlight needs room for its shadow map");
+
+    // std430 mirror of one entry of the PointLightData storage block, every member padded to a vec4
+    struct PointLightBlock {
+        glm::vec4 position, color, ambient, diffuse, specular;
+        glm::vec4 attenuation;// Constant, linear, exponent and range
+    };
+
+    // std140 mirror of the LightData uniform block, every member padded to a vec4
+    struct LightBlock {
+        struct {
+            glm::vec4 direction, ambient, diffuse, specular;
+        } dirLight;
+        struct {
+            glm::vec4 position, direction, ambient, diffuse, specular;
+            glm::vec4 cutOff;// Inner and outer cosine
+        } spotLights[MaxSpotLights];
+        glm::ivec4 enable;// Point, directional, spot and rim light toggles
+        glm::ivec4 counts;// Number of point lights and spotlights
+        glm::mat4 cascadeMatrices[ShadowCascadeCount];// World to shadow atlas texture space
+        glm::mat4 spotShadowMatrices[MaxSpotLights];
+        glm::ivec4 shadowCounts;// Directional cascades and spotlights with a shadow map, zero while shadows are off
+    };
  
 
-    Light();// Constructor
+    Light(EntityStore& entities);// Constructor
     ~Light();// Destructor
     void InitializeLights();// Initializes the lights in the scene
-    void RenderLightObjects(const Camera& camera); // Renders light objects
-    void RenderPointLights(GLuint shaderProgram);// Renders point lights
-    void RenderDirectionalLight(GLuint shaderProgram);// Renders directional light
-    void RenderSpotlights(GLuint shaderProgram);// Renders spotlights
-    void HandleKeyPress(GLFWwindow* Window);// Handles key press for toggling lights
+    void BuildMarkers(const Frustum& frustum, FrameSnapshot& frame) const;// Culls the point light markers (simulation thread)
+    void SubmitLightObjects(RenderQueue& queue, const FrameSnapshot& frame) const; // Queues the light objects
+    void BuildShadowViews(FrameSnapshot& frame) const;// Fits the cascades to the camera and aims a map down every spotlight (simulation thread)
+    void UploadLights(StreamBuffer& stream, const FrameSnapshot& frame);// Writes the LightData block for this frame
+    void HandleKeyPress(const InputState& input);// Handles key press for toggling lights
     bool IsPointLightsEnabled() const;// Checks if point lights are enabled
+    int GetPointLightCount() const { return pointLightCount; }// Point lights switched on with '-' and '='
     bool IsDirectionalLightEnabled() const;// Checks if directional light is enabled
     bool IsSpotlightsEnabled() const;  // Checks if spotlights are enabled
-    void DisablePointLights(GLuint shaderProgram);// Disables point lights
-    void DisableDirectionalLight(GLuint shaderProgram);// Disables directional light
-    void DisableSpotlights(GLuint shaderProgram);// Disables spotlights
-    void RenderRimLight(GLuint shaderProgram); // Renders rim light
 private:
+    static constexpr float MaxRange = 1000.0f;// The far plane, given to lights that never fade
+    static constexpr float ShadowDistance = 50.0f;// The cascades end here, further away nothing is shadowed
+    static constexpr float CascadeSplitBlend = 0.7f;// 0 splits the distance evenly, 1 logarithmically
+    static constexpr float CasterReach = 50.0f;// How far towards the sun casters outside a cascade still cast into it
+    static constexpr float SpotShadowNear = 0.1f;
+    static constexpr float SpotShadowFar = 50.0f;
+    static float CalculateRange(const PointLight& light);// Where the attenuated light fades below one colour step
+    void AddGeneratedLights();// Fills pointLights up to MaxPointLights
+    void CreatePointLightBuffer();// Writes every point light into pointLightBuffer
   
     std::vector<PointLight> pointLights;// Collection of point lights
+    GLuint pointLightBuffer = 0;// PointLightBlock per point light, never rewritten
+    int pointLightCount = SceneLights;// The first pointLightCount lights shade the scene
 
-    std::vector<LightObj*> lightObjects;// Collection of light objects for rendering
+    EntityStore& entities;// Holds the marker transforms
+    std::vector<EntityHandle> markerEntities;// One marker entity per point light, same order as pointLights
     std::vector<RimLight> rimLights; // Create a vector of RimLight objects
    DirectionalLight dirLight; // Directional light properties
    std::vector<SpotLight> spotLights;// Collection of spotlights
    RimLight rimLight;  // Rim light properties
     SpotLight spotlight; // Spotlight properties
    
-   LightObj lightObj;// Generic light object
-    bool isPointLightsEnable;// Flag for point light enable state
-    bool isDirectionalLightEnable ;// Flag for directional light enable state
-    bool isSpotLightsEnable; // Flag for spotlights enable state
+   LightObj lightObj;// Draws every point light marker
+    bool isPointLightsEnable = true;// Flag for point light enable state
+    bool isDirectionalLightEnable = true;// Flag for directional light enable state
+    bool isSpotLightsEnable = true; // Flag for spotlights enable state
     bool isRimLightEnable = true ; // Flag for rim light enable state
     
-    bool isKeyPressed1 = false;
-    bool isKeyPressed2 = false;
-    bool isKeyPressed3 = false;
+    bool isPointKeyPressed = false; // Key '1' held during the previous step
+    bool isDirectionalKeyPressed = false; // Key '2' held during the previous step
+    bool isSpotKeyPressed = false; // Key '3' held during the previous step
+    bool isFewerLightsKeyPressed = false; // Key '-' held during the previous step
+    bool isMoreLightsKeyPressed = false; // Key '=' held during the previous step
+    bool isShadowsEnable = true; // Flag for the directional and spot shadow maps
+    bool isShadowCachingEnable = true; // Flag for keeping shadow maps until something in them moves
+    bool isShadowKeyPressed = false; // Key 'H' held during the previous step
+    bool isShadowCacheKeyPressed = false; // Key 'J' held during the previous step
     GLuint Program_Object;
    // Sphere sphere;
 };
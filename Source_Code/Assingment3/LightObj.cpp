@@ -18,17 +18,17 @@
 /***********************************************
  * LightObj: Constructor for the LightObj class.
  * Author: [Smirti Parajuli]
- * Initializes a LightObj object with its position, color, and sets up the object.
+ * Creates the shared marker program and cube mesh. One LightObj draws every
+ * point light marker, their transforms come from the entity store.
  *
- * Parameters:
- *   - Position: The initial position of the light object.
- *   - color: The color of the light object.
+ * Parameters: None
  *
  * Return: None (constructor)
  ***********************************************/
-LightObj::LightObj(glm::vec3 Position, glm::vec3 color)
-	: position(Position), color(color), orientation(glm::vec3(0.0f)) {
-	Program_Object = ShaderLoader::CreateProgram("Resources/Shaders/Object_only.vs", "Resources/Shaders/VertexColor.fs"),
+LightObj::LightObj() {
+	Program_Object = ShaderLoader::CreateProgram("Resources/Shaders/Object_only.vs", "Resources/Shaders/VertexColor.fs");
+	modelLocation = glGetUniformLocation(Program_Object, "model");
+	colorLocation = glGetUniformLocation(Program_Object, "color");
 		
 	SetupLightObj();
 }
@@ -36,7 +36,7 @@ LightObj::LightObj(glm::vec3 Position, glm::vec3 color)
 /***********************************************
  * ~LightObj: Destructor for the LightObj class.
  * Author: [Smirti Parajuli]
- * Cleans up the resources used by the LightObj, such as the associated mesh.
+ * The mesh frees itself, nothing else is owned.
  *
  * Parameters: None
  *
@@ -44,10 +44,6 @@ LightObj::LightObj(glm::vec3 Position, glm::vec3 color)
  ***********************************************/
 
 LightObj::~LightObj() {
-	if (mesh) {
-		delete mesh;
-		mesh = nullptr;
-	}
 }
 
 
@@ -118,43 +114,33 @@ void LightObj::SetupLightObj() {
 	};
 
 	// Initialize the mesh using the provided vertices and indices.
-	mesh = new Mesh(Vertices_Cube, Indices_Cube, sizeof(Vertices_Cube) / sizeof(GLfloat), sizeof(Indices_Cube) / sizeof(GLuint));
+	mesh = std::make_unique<Mesh>(Vertices_Cube, Indices_Cube, sizeof(Vertices_Cube) / sizeof(GLfloat), sizeof(Indices_Cube) / sizeof(GLuint));
 }
 
 /***********************************************
- * Render: Renders the light object using the given camera and shader program.
+ * Submit: Queues one light marker for rendering.
  * Author: [Smirti Parajuli]
- * Sets up the transformation and projection matrices, and draws the light object mesh.
+ * Queues the light object mesh in the opaque pass with the given transform.
  *
  * Parameters:
+ *   - queue: The render queue for this frame.
+ *   - model: The marker's model matrix, built on the simulation thread.
  *   - lightColor: The color used to render the light object.
- *   - camera: The camera used to view the light object.
+ *   - frame: The snapshot holding the camera position for this frame.
  *
  * Return: None
  ***********************************************/
 
-void LightObj::Render(const glm::vec3& lightColor, const Camera& camera) {
-	// Define the scaling factor
-	glm::vec3 scale = glm::vec3(0.2f);  // Scale down to half the size as an example
-
-	// Apply translation
-	glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
-
-	// Apply scaling
-	model = glm::scale(model, scale);
-
-	glm::mat4 view = camera.GetViewMatrix();
-	glm::mat4 projection = camera.GetProjectionMatrix((float)camera.fov, (float)camera.windowWidth / camera.windowHeight, 0.1f, 100.0f);
-
-	glUseProgram(Program_Object);
-	// Set matrices
-
-	glm::mat4 PVM = projection * view * model;
-	glUniformMatrix4fv(glGetUniformLocation(Program_Object, "PVM"), 1, GL_FALSE, glm::value_ptr(PVM));
-
-	// Bind the cube map texture
-	glUniform3fv(glGetUniformLocation(Program_Object, "color"), 1, glm::value_ptr(lightColor));
-
-	mesh->Draw();
+void LightObj::Submit(RenderQueue& queue, const glm::mat4& model, const glm::vec3& lightColor, const FrameSnapshot& frame) const {
+	DrawPacket packet;
+	packet.program = Program_Object;
+	mesh->SetGeometry(packet);
+	packet.modelLocation = modelLocation;
+	packet.model = model;
+	packet.colorLocation = colorLocation;
+	packet.color = lightColor;
+
+	float distance = glm::length(glm::vec3(model[3]) - frame.cameraPosition);
+	packet.key = RenderQueue::MakeKey(RenderPass::Opaque, packet.program, packet.texture, packet.vertexArray, distance / frame.farPlane);
+	queue.Submit(packet);
 }
-
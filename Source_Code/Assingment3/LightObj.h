@@ -21,29 +21,37 @@ Mail : smirti.parajuli@mds.ac.nz
 #include "ShaderLoader.h"
 #include <glm/glm.hpp>
 #include "Sphere.h"
+#include "FrameSnapshot.h"
+#include "RenderQueue.h"
+#include <memory>
 
 class LightObj {
 public:
  
-    LightObj(glm::vec3 position, glm::vec3 color);  // Parameterized constructor
+    LightObj();  // Constructor
     ~LightObj();  // Destructor
     // void Draw();
-    void Render(const glm::vec3& lightColor, const Camera& camera);
+    void Submit(RenderQueue& queue, const glm::mat4& model, const glm::vec3& lightColor, const FrameSnapshot& frame) const;
+
+    static constexpr float BoundingRadius = 1.7321f;// The cube spans -1..1, so its corners are sqrt(3) away
 
     GLuint textureID;  // Store the texture ID here
     //GLuint TextureID;
+
+    // Copying and assignment not allowed for this class
+    LightObj(const LightObj&) = delete;
+    LightObj& operator=(const LightObj&) = delete;
    
 private:
     glm::mat4 PVM;
     GLuint VAO;
     GLuint IndexCount;
-    Mesh* mesh;  // A pointer to a Mesh object representing the object
+    std::unique_ptr<Mesh> mesh;  // The cube drawn for every marker
     void SetupLightObj();  // Private utility method to set up the object's geometry and buffers
   
-    glm::vec3 position;  // Represents the position of the object in the world
-    glm::vec3 color;  // Represents the color of the light
-    glm::vec3 orientation;  // Represents the forward direction/orientation of the object
     GLuint Program_Object;  // GLSL Program Object
+    GLint modelLocation;  // "model" uniform of Program_Object
+    GLint colorLocation;  // "color" uniform of Program_Object
     Sphere* sphere;
     GLuint Program_BlinnPhongLight;
 };
@@ -5,7 +5,25 @@
 #include "LightObj.h"
 #include "Sphere.h"
 #include "SkyBox.h"
+#include "Simulation.h"
+#include "EntityStore.h"
+#include "JobSystem.h"
+#include "TransformKernel.h"
+#include "StreamBuffer.h"
+#include "ShaderBindings.h"
+#include "GLState.h"
+#include "RenderQueue.h"
+#include "GeometryPool.h"
+#include "Model.h"
+#include "AssetPack.h"
+#include "FrameArena.h"
+#include "HeapCounter.h"
+#include "OverdrawStats.h"
+#include "DeferredRenderer.h"
+#include "ShadowAtlas.h"
+#include "ReflectionProbes.h"
 #include <iostream>
+#include <cstdio>
 #include <glew.h>
 #include <glfw3.h>
 #include <glm/glm.hpp>
@@ -23,8 +41,11 @@ GLuint Program_Object;
 GLuint Texture_Rayman;
 GLuint Program_TextShader;
 GLuint Program_BlinnPhongLight;
+GLuint Program_BlinnPhongDepth;// Depth pre-pass with the Blinn-Phong vertex shader
+GLuint Program_BlinnPhongGBuffer;// Deferred G-buffer pass with the Blinn-Phong vertex shader
 GLuint Program_DifferentLight;
 Camera* globalCameraInstance;// Camera pointer
+double scrollTotal = 0.0;// Sum of all scroll offsets, read by the simulation through the input state
 
 // Function prototypes
 void InitialSetup();
@@ -43,10 +64,8 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-    if (globalCameraInstance) {
-        globalCameraInstance->MouseScroll(window, xoffset, yoffset);
-        // No need to pass xoffset to MouseScroll if it's not used.
-    }
+    // The camera lives on the simulation thread, so only accumulate the offset here
+    scrollTotal += yoffset;
 
 }
 // Current color index
@@ -57,10 +76,39 @@ bool isAltBPressed = false;
 
 
 
-int main()
+int main(int argc, char** argv)
 {
-    glm::vec3 lightPosition = glm::vec3(0.0f, 0.0f, 0.0f); // Example position
-    glm::vec3 lightColor = glm::vec3(1.0f, 0.0f, 0.0f); // White light
+    // "--benchmark-transforms [count]" times the transform kernel against the per-object path and exits
+    if (argc > 1 && std::string(argv[1]) == "--benchmark-transforms")
+    {
+        JobSystem benchmarkJobs;
+        size_t instanceCount = (argc > 2) ? static_cast<size_t>(std::stoul(argv[2])) : 100000;
+        TransformKernel::Benchmark(benchmarkJobs, instanceCount);
+        return 0;
+    }
+    // "--pack-assets [output]" bundles the shaders, textures and models into one pack and exits
+    if (argc > 1 && std::string(argv[1]) == "--pack-assets")
+    {
+        std::string packPath = (argc > 2) ? argv[2] : AssetPack::DefaultPath;
+        return AssetPack::Build(packPath, { "Resources/Shaders", "Resources/Textures", "Resources/Models" }) ? 0 : 1;
+    }
+    std::cout << "Transform kernel: " << TransformKernel::GetPathName(TransformKernel::GetPath()) << std::endl;
+
+    // Everything is read from the pack when there is one, otherwise from the loose files
+    if (AssetPack::Get().Open(AssetPack::DefaultPath)) {
+        std::cout << "Asset pack: " << AssetPack::Get().GetEntryCount() << " entries mapped from " << AssetPack::DefaultPath << std::endl;
+    }
+    else {
+        std::cout << "Asset pack: none, reading loose files" << std::endl;
+    }
+
+    // "--model path" loads an OBJ or glTF model into the middle of the scene
+    std::string modelPath;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--model") {
+            modelPath = argv[i + 1];
+        }
+    }
 
     // Initialize GLFW and setting up version 4.6 with only core functionality
     if (!glfwInit())
@@ -90,93 +138,285 @@ int main()
         return -1;
     }
     // Enable depth testing for 3D objects
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
+    GLState& glState = GLState::Get();
+    glState.SetEnabled(GL_DEPTH_TEST, true);
+    glState.DepthFunc(GL_LESS);
+    glState.SetEnabled(GL_TEXTURE_CUBE_MAP_SEAMLESS, true); // Helps with cube map seams
     glfwSetScrollCallback(Window, scroll_callback);
     // Initial setup
     InitialSetup();
-    glEnable(GL_MULTISAMPLE);
+    glState.SetEnabled(GL_MULTISAMPLE, true);
     // Creates a camera object
     Camera camera(windowlength, windowheight, glm::vec3(0.0f, 0.0f, 5.0f));
     glfwSetWindowUserPointer(Window, &camera);
 
     globalCameraInstance = &camera;
-    SkyBox skybox(&camera);
+    // Shared worker threads for loading, simulation and culling work
+    JobSystem jobs;
+    // The model is imported or mapped as a job while the rest of the scene is set up
+    Model model(modelPath, "Resources/Textures/Rayman.jpg", jobs);
+    SkyBox skybox(&camera, jobs);
     // glfwSetWindowUserPointer(Window, &camera);
     // glfwSetCursorPosCallback(Window, Camera::MouseMovementCallback);
 
-    float lastFrameTime = 0.0f;
-    Sphere sphere;
-    Light light;
-    LightObj myLightObj(lightPosition, lightColor);
+    // Every scene entity lives in one structure of arrays store
+    EntityStore entities;
+    Sphere sphere(entities, jobs);
+    Light light(entities);
+    model.FinishLoad();
 
+    GeometryPool& geometry = GeometryPool::Get();
+    std::cout << "Geometry pool: " << geometry.GetVertexCount() << " vertices, "
+        << geometry.GetVertexBytes() + geometry.GetIndexBytes() << " bytes ("
+        << geometry.GetFloatBytes() << " as float vertices and 32-bit indices)" << std::endl;
 
     glfwSetKeyCallback(Window, keyCallback);
 
+    // Simulation runs on its own thread and hands frames over through triple buffers
+    TripleBuffer<InputState> inputBuffer;
+    TripleBuffer<FrameSnapshot> snapshotBuffer;
+    Simulation simulation(camera, sphere, light, inputBuffer, snapshotBuffer);
+    simulation.Start(glfwGetTime());
+
+    // Wait for the first snapshot so the first frame is never drawn from default matrices
+    while (!snapshotBuffer.Consume()) {
+        std::this_thread::yield();
+    }
+    simulation.NotifyFrameConsumed();
+
+    // Per-frame uniforms and instance data are written straight into this persistently mapped ring
+    StreamBuffer streamBuffer(4 * 1024 * 1024, 3);
+    // Every object queues its draws, the queue sorts them to minimise state changes
+    RenderQueue renderQueue;
+    // Fragments shaded by the opaque passes, to see whether the depth pre-pass pays off
+    OverdrawStats overdrawStats;
+    // G-buffer and light volumes of the deferred path, switched with 'F'
+    DeferredRenderer deferredRenderer;
+    // Directional and spot shadow maps, each tile drawn again only when something in it moved
+    ShadowAtlas shadowAtlas;
+    // Cube maps around the reflective spheres, a few faces drawn per frame when their contents moved
+    ReflectionProbes reflectionProbes;
+
+    // Present statistics measured on this thread
+    double statsWindowStart = glfwGetTime();
+    int statsFrames = 0;
+    double statsLatency = 0.0;
+    unsigned long long statsAllocations = 0;// Heap allocations of this thread inside the loop
+    unsigned long long statsSimAllocations = 0;
+    int statsSnapshots = 0;
+    int statsStaticShadowTiles = 0;
+    int statsDynamicShadowTiles = 0;
+    int statsProbeFaces = 0;
+
+    // Transient CPU data of a frame comes from this thread's arena, emptied at the top of the loop
+    FrameArena& frameArena = FrameArena::ForThread();
+
     // Program Main Loop
     while (!glfwWindowShouldClose(Window))
     {
-        camera.Inputs(Window);
+        frameArena.Reset();
+        std::uint64_t allocationsBefore = HeapCounter::GetThreadAllocations();
+
+        // Sample input for the simulation thread, it never touches GLFW itself
+        InputState& input = inputBuffer.BeginWrite();
+        input.Sample(Window, scrollTotal, glfwGetTime());
+        camera.UpdateCursor(Window, input);
+        inputBuffer.Publish();
+
+        // Pick up the newest snapshot, or redraw the previous one if none is ready
+        if (snapshotBuffer.Consume()) {
+            simulation.NotifyFrameConsumed();
+            statsSimAllocations += snapshotBuffer.Read().simHeapAllocations;
+            statsSnapshots++;
+        }
+        const FrameSnapshot& frame = snapshotBuffer.Read();
+
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);// Clear the screen
         // Set the camera's projection and view matrices
        // camera.Matrix(camera.fov, 0.1f, 100.0f, Program_PositionOnly, "camMatrix");
-
-        // Compute delta time
-        float currentFrameTime = static_cast<float>(glfwGetTime());
-        float deltaTime = currentFrameTime - lastFrameTime;
-        lastFrameTime = currentFrameTime;
-
-        sphere.Update(deltaTime);
-        sphere.Render(camera, Program_BlinnPhongLight);
-
-        //lightobj.Render(camera, Program_Object);
-        skybox.Update(&camera, deltaTime);
-        skybox.Render();
-        sphere.RenderReflectiveSphere(camera, skybox);
-
-        // Handle key inputs to toggle light states
-
-
-        light.HandleKeyPress(Window);
-
-        // Render lights based on their current states
-        if (light.IsPointLightsEnabled()) {
-            light.RenderPointLights(Program_BlinnPhongLight);
-            light.RenderLightObjects(camera);
+        glState.BeginFrame();
+        streamBuffer.BeginFrame();
+        overdrawStats.BeginFrame();
+
+        // Shadow tiles are brought up to date first, they bind FrameData of their own
+        shadowAtlas.BeginFrame(frame);
+        sphere.SubmitShadowCasters(shadowAtlas, frame, streamBuffer);
+        model.SubmitShadowCaster(shadowAtlas, streamBuffer);
+        shadowAtlas.Render(frame, streamBuffer);
+        statsStaticShadowTiles += shadowAtlas.GetStaticTilesDrawn();
+        statsDynamicShadowTiles += shadowAtlas.GetDynamicTilesDrawn();
+
+        // Lights are uploaded before anything that shades with them is drawn
+        light.UploadLights(streamBuffer, frame);
+
+        // Probe faces are lit like the scene and bind FrameData of their own too
+        reflectionProbes.BeginFrame(frame);
+        sphere.SubmitProbeScene(reflectionProbes, frame, streamBuffer);
+        model.SubmitToProbes(reflectionProbes, streamBuffer);
+        reflectionProbes.Render(frame, streamBuffer, skybox.getEnvironment().GetSpecularTexture());
+        statsProbeFaces += reflectionProbes.GetFacesDrawn();
+
+        // Camera data shared by every program through the FrameData block
+        GLintptr frameOffset = 0;
+        FrameUniforms* frameUniforms = streamBuffer.Allocate<FrameUniforms>(frameOffset);
+        if (frameUniforms) {
+            frameUniforms->view = frame.view;
+            frameUniforms->projection = frame.projection;
+            frameUniforms->cameraPosition = glm::vec4(frame.cameraPosition, 1.0f);
+            frameUniforms->time = frame.animationTime;
+            streamBuffer.BindRange(GL_UNIFORM_BUFFER, FrameDataBinding, frameOffset, sizeof(FrameUniforms));
         }
-        else {
-            // If point lights are disabled, set their contribution to zero or handle appropriately.
-            // Assuming you have a function in your Light class to disable point lights in the shader
-            light.DisablePointLights(Program_BlinnPhongLight);
-        }
-        if (light.IsDirectionalLightEnabled()) {
-            light.RenderDirectionalLight(Program_BlinnPhongLight);
-        }
-        else {
-            light.DisableDirectionalLight(Program_BlinnPhongLight);
+
+        // Queue everything, submission order does not matter
+        renderQueue.Clear();
+        sphere.Submit(renderQueue, frame, Program_BlinnPhongLight, Program_BlinnPhongDepth, Program_BlinnPhongGBuffer, streamBuffer);
+        model.Submit(renderQueue, frame, Program_BlinnPhongLight, Program_BlinnPhongDepth, Program_BlinnPhongGBuffer, streamBuffer);
+        skybox.Update(frame, streamBuffer);
+        skybox.Submit(renderQueue, streamBuffer);
+        sphere.SubmitReflectiveSphere(renderQueue, frame, skybox, reflectionProbes, streamBuffer);
+
+        // Queue the point light markers when point lights are on
+        if (frame.pointLightsEnabled) {
+            light.SubmitLightObjects(renderQueue, frame);
         }
-        if (light.IsSpotlightsEnabled()) {
-            light.RenderSpotlights(Program_BlinnPhongLight);
+
+        // Opaque front to back grouped by state, then the sky
+        // With the pre-pass on, opaque geometry lays down depth first and is shaded with GL_EQUAL
+        renderQueue.Sort();
+        renderQueue.SetDepthPrepass(frame.depthPrepass);
+        renderQueue.SetDeferred(frame.deferredShading);
+        if (frame.deferredShading) {
+            // Deferred: opaque surfaces go to the G-buffer and are lit once per pixel and per light volume,
+            // then the sky and whatever is still shaded forward are drawn on top
+            int framebufferWidth = 0;
+            int framebufferHeight = 0;
+            glfwGetFramebufferSize(Window, &framebufferWidth, &framebufferHeight);
+            deferredRenderer.Resize(framebufferWidth, framebufferHeight);
+            deferredRenderer.BeginGeometry();
+            renderQueue.ExecuteGBuffer(streamBuffer, &overdrawStats);
+            deferredRenderer.ExecuteLighting(frame, &overdrawStats);
+            renderQueue.Execute(streamBuffer);
+            deferredRenderer.Present();
         }
         else {
-            light.DisableSpotlights(Program_BlinnPhongLight);
+            renderQueue.Execute(streamBuffer, &overdrawStats);
         }
-        light. RenderRimLight( Program_BlinnPhongLight);
         //Sphere mySphere(20, 20); // You can adjust the stacks and sectors as required.
 
-         // Enable blending just before text rendering
-         // Render text objects with blending enabled
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-       
-        glDisable(GL_BLEND);  // Optionally, disable blending if not needed after
+        // Fence this frame's region before presenting
+        streamBuffer.EndFrame();
 
         // Call render and update functions
         Render();
+        double presentTime = glfwGetTime();
+        statsFrames++;
+        statsLatency += presentTime - frame.inputSampleTime;
         Update();
 
+        // Report frame rate, simulation rate and input-to-present latency once per second
+        if (presentTime - statsWindowStart >= 1.0)
+        {
+            double windowLength = presentTime - statsWindowStart;
+
+            // Share of the window the workers spent running jobs
+            double busyNanoseconds = 0.0;
+            unsigned long long steals = 0;
+            for (unsigned int worker = 0; worker < jobs.GetThreadCount(); worker++) {
+                JobStats stats = jobs.GetWorkerStats(worker);
+                busyNanoseconds += static_cast<double>(stats.busyNanoseconds);
+                steals += stats.steals;
+            }
+            int utilization = static_cast<int>(busyNanoseconds / (windowLength * 1e9 * jobs.GetThreadCount()) * 100.0);
+            jobs.ResetStats();
+
+            // Formatted in scratch memory, so reporting does not allocate either
+            ScratchScope scratch;
+            const size_t PartSize = 64;
+            const size_t TitleSize = 640;
+            char* spheres = scratch.Allocate<char>(PartSize);
+            char* physics = scratch.Allocate<char>(PartSize);
+            char* shadows = scratch.Allocate<char>(PartSize);
+            char* probes = scratch.Allocate<char>(PartSize);
+            char* overdraw = scratch.Allocate<char>(PartSize * 2);
+            char* title = scratch.Allocate<char>(TitleSize);
+            if (frame.sphereAnimationOnGpu) {
+                std::snprintf(spheres, PartSize, "%d animated on gpu", frame.totalSpheres);
+            }
+            else {
+                std::snprintf(spheres, PartSize, "%d/%d", static_cast<int>(frame.sphereInstances.size()), frame.totalSpheres);
+            }
+            physics[0] = '\0';
+            if (frame.physicsEnabled) {
+                std::snprintf(physics, PartSize, " | physics %.2f ms, %d contacts", frame.physicsStepMs, frame.physicsContacts);
+            }
+
+            // Tiles drawn per frame, zero in a still frame while caching is on
+            if (frame.shadowsEnabled) {
+                std::snprintf(shadows, PartSize, " | shadow tiles %.1f static, %.1f moving%s",
+                    static_cast<double>(statsStaticShadowTiles) / statsFrames, static_cast<double>(statsDynamicShadowTiles) / statsFrames,
+                    frame.shadowCaching ? "" : " uncached");
+            }
+            else {
+                std::snprintf(shadows, PartSize, " | shadows off");
+            }
+
+            // Faces drawn per frame, zero once the probes caught up with a still scene
+            if (frame.reflectionProbesEnabled) {
+                std::snprintf(probes, PartSize, " | probe faces %.1f, %d waiting",
+                    static_cast<double>(statsProbeFaces) / statsFrames, reflectionProbes.GetDirtyFaces() - reflectionProbes.GetFacesDrawn());
+            }
+            else {
+                std::snprintf(probes, PartSize, " | probes off");
+            }
+
+            // Fragments per pixel above 1 is overdraw, the pre-pass brings it down to the covered share of the screen
+            int framebufferWidth = 0;
+            int framebufferHeight = 0;
+            glfwGetFramebufferSize(Window, &framebufferWidth, &framebufferHeight);
+            double pixels = (framebufferWidth * framebufferHeight > 0) ? static_cast<double>(framebufferWidth) * framebufferHeight : 1.0;
+            PassStats opaque = overdrawStats.GetAverage(StatsPass::Opaque);
+            PassStats prepass = overdrawStats.GetAverage(StatsPass::DepthPrepass);
+            PassStats lighting = overdrawStats.GetAverage(StatsPass::Lighting);
+            if (frame.deferredShading) {
+                std::snprintf(overdraw, PartSize * 2, " | deferred, %d point lights: g-buffer %.2f ms, lighting %.2f ms, %.2f lit fragments per pixel",
+                    frame.pointLightCount, opaque.gpuMilliseconds, lighting.gpuMilliseconds, lighting.fragments / pixels);
+            }
+            else if (frame.depthPrepass) {
+                std::snprintf(overdraw, PartSize * 2, " | forward, %d point lights: pre-pass %.2f ms, opaque %.2f ms, %.2f fragments per pixel",
+                    frame.pointLightCount, prepass.gpuMilliseconds, opaque.gpuMilliseconds, opaque.fragments / pixels);
+            }
+            else {
+                std::snprintf(overdraw, PartSize * 2, " | forward, %d point lights: opaque %.2f ms, %.2f fragments per pixel",
+                    frame.pointLightCount, opaque.gpuMilliseconds, opaque.fragments / pixels);
+            }
+            overdrawStats.ResetStats();
+            std::snprintf(title, TitleSize, "OpenGL window! | %d fps | %.2f ms | sim %d Hz | latency %.2f ms | dropped %d | spheres %s%s"
+                " | stalls %d | gl calls %d issued / %d filtered | draws %d in %d calls | workers %d%% busy, %llu steals"
+                "%s%s%s | heap allocs %.1f per frame, sim %.1f%s",
+                static_cast<int>(statsFrames / windowLength), windowLength / statsFrames * 1000.0,
+                static_cast<int>(frame.simStepsPerSecond), statsLatency / statsFrames * 1000.0, frame.droppedSteps,
+                spheres, frame.sphereImpostors ? " impostors" : "",
+                streamBuffer.GetStallCount(), glState.GetIssuedCalls(), glState.GetFilteredCalls(),
+                renderQueue.GetPacketCount(), renderQueue.GetDrawCallCount(), utilization, steals, overdraw, shadows, probes,
+                static_cast<double>(statsAllocations) / statsFrames,
+                statsSnapshots > 0 ? static_cast<double>(statsSimAllocations) / statsSnapshots : 0.0, physics);
+            glfwSetWindowTitle(Window, title);
+            statsWindowStart = presentTime;
+            statsFrames = 0;
+            statsLatency = 0.0;
+            statsAllocations = 0;
+            statsSimAllocations = 0;
+            statsSnapshots = 0;
+            statsStaticShadowTiles = 0;
+            statsDynamicShadowTiles = 0;
+            statsProbeFaces = 0;
+        }
+
+        // Counted after the report, so a frame that allocates anywhere shows up in the next one
+        statsAllocations += HeapCounter::GetThreadAllocations() - allocationsBefore;
     }
 
+    simulation.Stop();
     glfwTerminate();    //Ensure proper shutdown
 
     return 0;
@@ -194,15 +434,17 @@ void InitialSetup()
     Program_PositionOnly = ShaderLoader::CreateProgram("Resources/Shaders/PositionOnly.vs", "Resources/Shaders/PositionOnly.fs");
     Program_Object = ShaderLoader::CreateProgram("Resources/Shaders/Object_only.vs", "Resources/Shaders/VertexColor.fs");
     Program_BlinnPhongLight = ShaderLoader::CreateProgram("Resources/Shaders/Blinn_PhongLight.vs", "Resources/Shaders/Blinn_PhongLight.fs");
+    Program_BlinnPhongDepth = ShaderLoader::CreateProgram("Resources/Shaders/Blinn_PhongLight.vs", "Resources/Shaders/DepthOnly.fs");
+    Program_BlinnPhongGBuffer = ShaderLoader::CreateProgram("Resources/Shaders/Blinn_PhongLight.vs", "Resources/Shaders/GBuffer.fs");
    
 
     glClearColor(1.0f, 1.0f, 1.f, 1.0f); // Set clear color
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     //enabling culling
-   // glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK); // Cull back-facing polygons
-    glFrontFace(GL_CCW); // Set  counter clockwise winding order as front-facing
+   // GLState::Get().SetEnabled(GL_CULL_FACE, true);
+    GLState::Get().CullFace(GL_BACK); // Cull back-facing polygons
+    GLState::Get().FrontFace(GL_CCW); // Set  counter clockwise winding order as front-facing
 
 
     // Maps window to NDC(-1 to 1)
@@ -0,0 +1,183 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :MappedFile.cpp
+Description :  Implementation of the read-only file mapping, through
+               MapViewOfFile on Windows and mmap everywhere else.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "MappedFile.h"
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/***********************************************************************
+ * ~MappedFile: Destructor for the MappedFile class.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/***********************************************************************
+ * Open: Maps a file into memory.
+ * Author: [Smirti Parajuli]
+ * Description: Any earlier mapping is closed first. The file handle is
+ *              closed again right away, the mapping keeps the file alive.
+ *
+ * Parameters:
+ *   - path: Path of the file to map.
+ *
+ * Return: bool - True when the whole file is mapped.
+ ***********************************************************************/
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (fileMapping == nullptr) {
+		return false;
+	}
+	void* view = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr) {
+		CloseHandle(fileMapping);
+		return false;
+	}
+	mapping = fileMapping;
+	data = static_cast<const unsigned char*>(view);
+	size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0) {
+		close(file);
+		return false;
+	}
+	void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	data = static_cast<const unsigned char*>(view);
+	size = static_cast<size_t>(info.st_size);
+#endif
+	return true;
+}
+
+/***********************************************************************
+ * Close: Releases the mapping.
+ * Author: [Smirti Parajuli]
+ * Description: Pointers into the data are no longer valid afterwards.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void MappedFile::Close()
+{
+	if (data == nullptr) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(static_cast<HANDLE>(mapping));
+#else
+	munmap(const_cast<unsigned char*>(data), size);
+#endif
+	data = nullptr;
+	size = 0;
+	mapping = nullptr;
+}
+
+/***********************************************************************
+ * GetStamp: Looks up the size and modification time of a file.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - path: Path of the file.
+ *
+ * Return: FileStamp - Both fields zero when the file does not exist.
+ ***********************************************************************/
+FileStamp MappedFile::GetStamp(const std::string& path)
+{
+	FileStamp stamp;
+#ifdef _WIN32
+	struct _stat64 info;
+	if (_stat64(path.c_str(), &info) == 0) {
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) == 0) {
+#endif
+		stamp.size = static_cast<std::uint64_t>(info.st_size);
+		stamp.modified = static_cast<std::int64_t>(info.st_mtime);
+	}
+	return stamp;
+}
+
+/***********************************************************************
+ * MappedFile: Move constructor, takes over the mapping of another file.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - other: The file to take the mapping from, left closed.
+ *
+ * Return: None
+ ***********************************************************************/
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: data(other.data), size(other.size), mapping(other.mapping)
+{
+	other.data = nullptr;
+	other.size = 0;
+	other.mapping = nullptr;
+}
+
+/***********************************************************************
+ * operator=: Move assignment, closes this mapping and takes another.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - other: The file to take the mapping from, left closed.
+ *
+ * Return: MappedFile& - This file.
+ ***********************************************************************/
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other) {
+		Close();
+		data = other.data;
+		size = other.size;
+		mapping = other.mapping;
+		other.data = nullptr;
+		other.size = 0;
+		other.mapping = nullptr;
+	}
+	return *this;
+}
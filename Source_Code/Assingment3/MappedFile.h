@@ -0,0 +1,62 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :MappedFile.h
+Description :  The MappedFile maps a whole file read-only into memory, so
+               cooked assets can be read in place without copying or
+               parsing. The mapping is released when the object goes away.
+               It also reports the size and modification time of files, which
+               the asset caches use to notice when a source has changed.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Size and modification time of a file, both zero when it does not exist
+struct FileStamp
+{
+	std::uint64_t size = 0;
+	std::int64_t modified = 0;// Seconds since the epoch
+
+	bool operator==(const FileStamp& other) const { return size == other.size && modified == other.modified; }
+	bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile();
+
+	bool Open(const std::string& path);// Maps the file, false if it cannot be opened or is empty
+	void Close();
+
+	bool IsOpen() const { return data != nullptr; }
+	const unsigned char* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+	static FileStamp GetStamp(const std::string& path);
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	// Copying and assignment not allowed for this class
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	void* mapping = nullptr;// Mapping handle on Windows, unused elsewhere
+};
+#endif // MAPPEDFILE_H
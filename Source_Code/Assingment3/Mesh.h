@@ -7,6 +7,7 @@ New Zealand
 (c) [2023] Media Design School
 File Name :Mesh.h
 Description :  Implementation of the Mesh class for rendering geometry using OpenGL.
+               The vertices and indices are kept in the shared GeometryPool.
 Author : Smirti Parajuli
 Mail : smirti.parajuli@mds.ac.nz
 **************************************************************************/
@@ -17,60 +18,90 @@ Mail : smirti.parajuli@mds.ac.nz
 #define MESH_H
  // Include the glad header file to get all the required OpenGL headers
 #include <glew.h> 
+#include "GLState.h"
+#include "GeometryPool.h"
+#include "RenderQueue.h"
+#include "VertexEncoder.h"
+#include "MeshOptimizer.h"
+#include "MeshletBuilder.h"
+#include "MeshCache.h"
+#include <vector>
 class Mesh {
 public:
-    GLuint VAO, VBO, EBO; // Handles for vertex array, vertex buffer, and element buffer
+    GLuint handle; // The mesh in the geometry pool, its range is looked up per draw as the pool may move it
     unsigned int vertexCount, indexCount; // Count of vertices and indices
+    std::vector<MeshletBounds> meshlets; // Clusters of triangles for culling, empty unless asked for
+    std::vector<MeshLod> lods; // Levels of detail of a cooked mesh, finest first, empty for the others
     GLuint GetVAO() const {
-        return VAO;
+        return GeometryPool::Get().GetVAO();
     }
 
-    // Constructor
-    Mesh(GLfloat* vertices, GLuint* indices, unsigned int vertexCount, unsigned int indexCount) {
+    // Constructor, vertexCount is the number of floats, 8 per vertex
+    // The vertices are converted to format, the indices to 16 bits when the mesh is small enough
+    // Meshes whose shaders rely on the vertex numbers (the impostor quad) turn the optimizer off
+    // Meshes drawn through the MeshletCuller give the vertices per meshlet, zero builds none
+    Mesh(GLfloat* vertices, GLuint* indices, unsigned int vertexCount, unsigned int indexCount, VertexFormat format = VertexFormat::HalfOctahedral, bool optimize = true, unsigned int meshletVertices = 0) {
         this->vertexCount = vertexCount;
         this->indexCount = indexCount;
+        GLuint meshVertices = vertexCount / VertexEncoder::FloatsPerVertex;
 
-        // Create buffers/arrays
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        // Reorder a copy for the vertex cache, overdraw and vertex fetch, the caller's arrays are left alone
+        std::vector<GLfloat> orderedVertices(vertices, vertices + vertexCount);
+        std::vector<GLuint> orderedIndices(indices, indices + indexCount);
+        if (optimize) {
+            MeshOptimizer::Optimize(orderedVertices.data(), VertexEncoder::FloatsPerVertex, meshVertices, orderedIndices.data(), indexCount);
+        }
+        if (meshletVertices > 0) {
+            // Meshlets regroup the triangles, so the vertices are put back in order of first use
+            MeshletBuilder::Build(orderedVertices.data(), VertexEncoder::FloatsPerVertex, meshVertices, orderedIndices.data(), indexCount, meshlets, meshletVertices);
+            MeshOptimizer::OptimizeVertexFetch(orderedVertices.data(), VertexEncoder::FloatsPerVertex, meshVertices, orderedIndices.data(), indexCount);
+        }
 
-        glBindVertexArray(VAO);
-        // Load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(GLfloat), vertices, GL_STATIC_DRAW);
+        // Copy the data into the shared buffers, the shaders pull the vertices by gl_VertexID
+        handle = GeometryPool::Get().Add(orderedVertices.data(), meshVertices, orderedIndices.data(), indexCount, format);
+    }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLuint), indices, GL_STATIC_DRAW);
+    // Constructor for a cooked mesh, the data goes into the pool exactly as it is stored
+    explicit Mesh(const CookedMeshView& cooked)
+        : lods(cooked.lods, cooked.lods + cooked.lodCount) {
+        this->vertexCount = cooked.data.vertexCount * VertexEncoder::FloatsPerVertex;
+        this->indexCount = cooked.data.indexCount;
+        handle = GeometryPool::Get().AddEncoded(cooked.data);
+    }
 
-        // Set the vertex attribute pointers
-        // Vertex Positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)0);
-        // Vertex Texture Coords
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-        // Vertex Normals
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(5 * sizeof(GLfloat)));
+    // Where the vertices and indices are now
+    MeshRange GetRange() const {
+        return GeometryPool::Get().GetRange(handle);
+    }
 
-        glBindVertexArray(0); // Unbind VAO
+    // Points a draw packet at this mesh, or at one level of detail of a cooked mesh
+    void SetGeometry(DrawPacket& packet, unsigned int lod = 0) const {
+        MeshRange range = GetRange();
+        packet.vertexArray = GetVAO();
+        packet.indexCount = range.indexCount;
+        packet.indexType = range.indexType;
+        packet.indexOffset = range.indexOffset;
+        packet.baseInstance = range.mesh;
+        if (!lods.empty() && range.indexCount > 0) {
+            const MeshLod& level = lods[lod < lods.size() ? lod : lods.size() - 1];
+            GLuint indexSize = (range.indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+            packet.indexCount = static_cast<GLsizei>(level.indexCount);
+            packet.indexOffset = range.indexOffset + level.firstIndex * indexSize;
+        }
     }
 
     // Render the mesh
     void Draw() {
         // Draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        MeshRange range = GetRange();
+        GLState::Get().BindVertexArray(GetVAO());
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, range.indexCount, range.indexType, (void*)(static_cast<std::uintptr_t>(range.indexOffset)), 1, range.mesh);
     }
 
     // Deconstructor
     ~Mesh() {
-        // Properly deallocate all resources once they've outlived their purpose
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
+        // Give the ranges back to the pool
+        GeometryPool::Get().Remove(handle);
     }
 
     // Copying and assignment not allowed for this class
@@ -0,0 +1,260 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :MeshCache.cpp
+Description :  Implementation of the cooked mesh files.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "MeshCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	const char CookedMagic[4] = { 'M', 'E', 'S', 'H' };
+
+	// Rounds a byte offset up to the next multiple of four
+	GLuint AlignFour(size_t offset)
+	{
+		return static_cast<GLuint>((offset + 3) / 4 * 4);
+	}
+}
+
+/***********************************************************************
+ * GetCookedPath: Names the cooked file of a source mesh.
+ * Author: [Smirti Parajuli]
+ * Description: Cooked files sit next to their source, so a model folder
+ *              carries its own cache.
+ *
+ * Parameters:
+ *   - sourcePath: Path of the glTF or OBJ file.
+ *
+ * Return: std::string - Path of the cooked file.
+ ***********************************************************************/
+std::string MeshCache::GetCookedPath(const std::string& sourcePath)
+{
+	return sourcePath + ".mesh";
+}
+
+/***********************************************************************
+ * Serialize: Lays a cooked mesh out as it is stored.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - mesh: The cooked mesh.
+ *   - source: Stamp of the source file the mesh was cooked from.
+ *   - out: Filled with the bytes of the cooked file.
+ *
+ * Return: None
+ ***********************************************************************/
+void MeshCache::Serialize(const CookedMesh& mesh, const FileStamp& source, std::vector<unsigned char>& out)
+{
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, CookedMagic, sizeof(header.magic));
+	header.version = Version;
+	header.sourceSize = source.size;
+	header.sourceModified = source.modified;
+	header.format = static_cast<GLuint>(mesh.format);
+	header.vertexCount = mesh.vertexCount;
+	header.stride = mesh.vertices.stride;
+	header.indexType = mesh.indexType;
+	header.indexCount = static_cast<GLuint>(mesh.indices.size() / (mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint)));
+	header.lodCount = static_cast<GLuint>(mesh.lods.size());
+	for (int axis = 0; axis < 3; ++axis) {
+		header.positionScale[axis] = mesh.vertices.positionScale[axis];
+		header.positionOffset[axis] = mesh.vertices.positionOffset[axis];
+	}
+	for (int i = 0; i < 4; ++i) {
+		header.bounds[i] = mesh.bounds[i];
+	}
+	header.lodOffset = AlignFour(sizeof(Header));
+	header.vertexOffset = AlignFour(header.lodOffset + sizeof(MeshLod) * mesh.lods.size());
+	header.indexOffset = AlignFour(header.vertexOffset + sizeof(GLuint) * mesh.vertices.words.size());
+	header.fileSize = AlignFour(header.indexOffset + mesh.indices.size());
+
+	out.assign(header.fileSize, 0);
+	std::memcpy(out.data(), &header, sizeof(header));
+	if (!mesh.lods.empty()) {
+		std::memcpy(out.data() + header.lodOffset, mesh.lods.data(), sizeof(MeshLod) * mesh.lods.size());
+	}
+	if (!mesh.vertices.words.empty()) {
+		std::memcpy(out.data() + header.vertexOffset, mesh.vertices.words.data(), sizeof(GLuint) * mesh.vertices.words.size());
+	}
+	if (!mesh.indices.empty()) {
+		std::memcpy(out.data() + header.indexOffset, mesh.indices.data(), mesh.indices.size());
+	}
+}
+
+/***********************************************************************
+ * Write: Saves a cooked mesh.
+ * Author: [Smirti Parajuli]
+ * Description: The file is written under a temporary name and renamed
+ *              once complete, so a reader never maps half a file.
+ *
+ * Parameters:
+ *   - path: Path of the cooked file.
+ *   - mesh: The cooked mesh.
+ *   - source: Stamp of the source file the mesh was cooked from.
+ *
+ * Return: bool - True when the file was written.
+ ***********************************************************************/
+bool MeshCache::Write(const std::string& path, const CookedMesh& mesh, const FileStamp& source)
+{
+	std::vector<unsigned char> file;
+	Serialize(mesh, source, file);
+	std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!out.good()) {
+			std::cout << "Cannot write cooked mesh: " << temporaryPath << std::endl;
+			return false;
+		}
+		out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+		if (!out.good()) {
+			std::cout << "Cannot write cooked mesh: " << temporaryPath << std::endl;
+			return false;
+		}
+	}
+
+	// rename does not replace an existing file everywhere
+	std::remove(path.c_str());
+	if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+		std::remove(temporaryPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+/***********************************************************************
+ * Read: Points a view at a mapped cooked file.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - file: The mapped cooked file.
+ *   - source: Stamp of the source file now, zero to accept any.
+ *   - view: Filled with pointers into the mapping.
+ *
+ * Return: bool - True when the file is a current, complete cooked mesh.
+ ***********************************************************************/
+bool MeshCache::Read(const MappedFile& file, const FileStamp& source, CookedMeshView& view)
+{
+	return file.IsOpen() && Read(file.GetData(), file.GetSize(), source, view);
+}
+
+/***********************************************************************
+ * Read: Points a view at cooked mesh bytes.
+ * Author: [Smirti Parajuli]
+ * Description: The vertex words and indices are used in place. Every
+ *              offset and count is checked against the size, and every
+ *              index against the vertex count, so a damaged file is
+ *              rejected rather than read past its mesh by the shaders.
+ *              The data must start on four bytes.
+ *
+ * Parameters:
+ *   - data: The bytes of a cooked file, in a mapping or the asset pack.
+ *   - size: Number of bytes.
+ *   - source: Stamp of the source file now, zero to accept any.
+ *   - view: Filled with pointers into the data.
+ *
+ * Return: bool - True when the data is a current, complete cooked mesh.
+ ***********************************************************************/
+bool MeshCache::Read(const unsigned char* data, size_t size, const FileStamp& source, CookedMeshView& view)
+{
+	if (data == nullptr || size < sizeof(Header)) {
+		return false;
+	}
+	Header header;
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, CookedMagic, sizeof(header.magic)) != 0 || header.version != Version
+		|| header.fileSize != size) {
+		return false;
+	}
+	if (source.size != 0 && (header.sourceSize != source.size || header.sourceModified != source.modified)) {
+		return false;
+	}
+	if (header.format > static_cast<GLuint>(VertexFormat::SnormOctahedral) || header.stride != VertexEncoder::GetStride(static_cast<VertexFormat>(header.format))
+		|| (header.indexType != GL_UNSIGNED_SHORT && header.indexType != GL_UNSIGNED_INT)
+		|| header.lodCount == 0 || header.lodCount > MaxLods) {
+		return false;
+	}
+
+	size_t indexSize = (header.indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+	size_t fileSize = size;
+	if (header.lodOffset % 4 != 0 || header.vertexOffset % 4 != 0 || header.indexOffset % 4 != 0
+		|| header.lodOffset + sizeof(MeshLod) * static_cast<size_t>(header.lodCount) > fileSize
+		|| header.vertexOffset + sizeof(GLuint) * static_cast<size_t>(header.vertexCount) * header.stride > fileSize
+		|| header.indexOffset + indexSize * static_cast<size_t>(header.indexCount) > fileSize) {
+		return false;
+	}
+	const MeshLod* lods = reinterpret_cast<const MeshLod*>(data + header.lodOffset);
+	for (GLuint i = 0; i < header.lodCount; ++i) {
+		if (static_cast<size_t>(lods[i].firstIndex) + lods[i].indexCount > header.indexCount) {
+			return false;
+		}
+	}
+	if (header.indexType == GL_UNSIGNED_SHORT) {
+		const GLushort* indices = reinterpret_cast<const GLushort*>(data + header.indexOffset);
+		for (GLuint i = 0; i < header.indexCount; ++i) {
+			if (indices[i] >= header.vertexCount) {
+				return false;
+			}
+		}
+	}
+	else {
+		const GLuint* indices = reinterpret_cast<const GLuint*>(data + header.indexOffset);
+		for (GLuint i = 0; i < header.indexCount; ++i) {
+			if (indices[i] >= header.vertexCount) {
+				return false;
+			}
+		}
+	}
+
+	view.data.format = static_cast<VertexFormat>(header.format);
+	view.data.vertexWords = reinterpret_cast<const GLuint*>(data + header.vertexOffset);
+	view.data.vertexCount = header.vertexCount;
+	view.data.stride = header.stride;
+	view.data.positionScale = glm::vec3(header.positionScale[0], header.positionScale[1], header.positionScale[2]);
+	view.data.positionOffset = glm::vec3(header.positionOffset[0], header.positionOffset[1], header.positionOffset[2]);
+	view.data.indices = data + header.indexOffset;
+	view.data.indexType = header.indexType;
+	view.data.indexCount = header.indexCount;
+	view.lods = lods;
+	view.lodCount = header.lodCount;
+	view.bounds = glm::vec4(header.bounds[0], header.bounds[1], header.bounds[2], header.bounds[3]);
+	return true;
+}
+
+/***********************************************************************
+ * View: Points a view at a cooked mesh in memory.
+ * Author: [Smirti Parajuli]
+ * Description: Used when the cooked file could not be written, so the
+ *              mesh is still drawn this run.
+ *
+ * Parameters:
+ *   - mesh: The cooked mesh, must outlive the view.
+ *
+ * Return: CookedMeshView - The view.
+ ***********************************************************************/
+CookedMeshView MeshCache::View(const CookedMesh& mesh)
+{
+	CookedMeshView view;
+	view.data.format = mesh.format;
+	view.data.vertexWords = mesh.vertices.words.data();
+	view.data.vertexCount = mesh.vertexCount;
+	view.data.stride = mesh.vertices.stride;
+	view.data.positionScale = mesh.vertices.positionScale;
+	view.data.positionOffset = mesh.vertices.positionOffset;
+	view.data.indices = mesh.indices.data();
+	view.data.indexType = mesh.indexType;
+	view.data.indexCount = static_cast<GLuint>(mesh.indices.size() / (mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint)));
+	view.lods = mesh.lods.data();
+	view.lodCount = static_cast<GLuint>(mesh.lods.size());
+	view.bounds = mesh.bounds;
+	return view;
+}
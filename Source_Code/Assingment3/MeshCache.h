@@ -0,0 +1,102 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :MeshCache.h
+Description :  The MeshCache reads and writes cooked meshes: binary files
+               that hold a mesh exactly as the geometry pool stores it,
+               encoded vertex words followed by the indices of every level
+               of detail. A cooked file is mapped and handed to the pool
+               without any parsing or conversion. The header records the
+               size and time of the source file, so a changed source makes
+               the cooked file stale. Files are in the byte order of the
+               machine that wrote them. Cooked meshes can also be read
+               from the asset pack, which stores the same bytes.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "VertexEncoder.h"
+#include "GeometryPool.h"
+
+// One level of detail, a range of the shared index list
+struct MeshLod
+{
+	GLuint firstIndex = 0;
+	GLuint indexCount = 0;
+	float error = 0.0f;// Largest distance a vertex moved, in object space units
+	float padding = 0.0f;
+};
+
+// A cooked mesh held in memory, filled by the importer
+struct CookedMesh
+{
+	VertexFormat format = VertexFormat::HalfOctahedral;
+	EncodedVertices vertices;
+	GLuint vertexCount = 0;
+	GLenum indexType = GL_UNSIGNED_INT;
+	std::vector<unsigned char> indices;// Every level of detail, finest first
+	std::vector<MeshLod> lods;
+	glm::vec4 bounds = glm::vec4(0.0f);// Object space sphere, xyz centre, w radius
+};
+
+// A cooked mesh in place, inside a mapped file or a CookedMesh, valid as long as they are
+struct CookedMeshView
+{
+	PoolMeshData data;// Every level of detail, ready for GeometryPool::AddEncoded
+	const MeshLod* lods = nullptr;
+	GLuint lodCount = 0;
+	glm::vec4 bounds = glm::vec4(0.0f);
+};
+
+class MeshCache
+{
+public:
+	static const GLuint MaxLods = 4;
+
+	static std::string GetCookedPath(const std::string& sourcePath);// Where the cooked file of a source lives
+	static void Serialize(const CookedMesh& mesh, const FileStamp& source, std::vector<unsigned char>& out);
+	static bool Write(const std::string& path, const CookedMesh& mesh, const FileStamp& source);
+	static bool Read(const unsigned char* data, size_t size, const FileStamp& source, CookedMeshView& view);// False when missing, stale or damaged
+	static bool Read(const MappedFile& file, const FileStamp& source, CookedMeshView& view);
+	static CookedMeshView View(const CookedMesh& mesh);
+
+private:
+	MeshCache();
+
+	// The start of every cooked file, followed by the lods, the vertex words and the indices
+	struct Header
+	{
+		char magic[4];
+		GLuint version;
+		std::uint64_t sourceSize;
+		std::int64_t sourceModified;
+		GLuint format;
+		GLuint vertexCount;
+		GLuint stride;
+		GLuint indexType;
+		GLuint indexCount;
+		GLuint lodCount;
+		float positionScale[3];
+		float positionOffset[3];
+		float bounds[4];
+		GLuint lodOffset;// Byte offsets from the start of the file, all multiples of four
+		GLuint vertexOffset;
+		GLuint indexOffset;
+		GLuint fileSize;
+	};
+
+	static const GLuint Version = 2;// 2: imported meshes no longer use half float positions
+};
+#endif // MESHCACHE_H
@@ -0,0 +1,1140 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :MeshImporter.cpp
+Description :  Implementation of the OBJ and glTF importers and the mesh
+               cooking. The glTF side reads triangle primitives of the
+               default scene with their node transforms, positions, normals
+               and the first texture coordinates. Materials, skins, morph
+               targets and sparse accessors are not read.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "MeshImporter.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace
+{
+	const int MaxJsonDepth = 64;// Stops runaway nesting in damaged files
+	const int MaxNodeDepth = 64;// Keeps the recursion over deep node trees off the end of the stack
+
+	// A parsed JSON value, objects keep their keys in file order
+	struct JsonValue
+	{
+		enum class Type { Null, Bool, Number, String, Array, Object };
+
+		Type type = Type::Null;
+		bool boolean = false;
+		double number = 0.0;
+		std::string text;
+		std::vector<JsonValue> items;// Array elements, or object values
+		std::vector<std::string> keys;// Object keys, parallel to items
+
+		const JsonValue* Find(const char* key) const {
+			if (type != Type::Object) {
+				return nullptr;
+			}
+			for (size_t i = 0; i < keys.size(); ++i) {
+				if (keys[i] == key) {
+					return &items[i];
+				}
+			}
+			return nullptr;
+		}
+
+		const JsonValue* At(size_t index) const {
+			return (type == Type::Array && index < items.size()) ? &items[index] : nullptr;
+		}
+
+		double NumberOr(const char* key, double fallback) const {
+			const JsonValue* value = Find(key);
+			return (value && value->type == Type::Number) ? value->number : fallback;
+		}
+
+		// Numbers that are not whole or do not fit an int give the fallback
+		int IntOr(const char* key, int fallback) const {
+			double number = NumberOr(key, fallback);
+			if (!(number >= -2147483648.0 && number <= 2147483647.0) || std::floor(number) != number) {
+				return fallback;
+			}
+			return static_cast<int>(number);
+		}
+
+		// An array element used as an index, false when it is not a whole number that fits an int
+		bool AsIndex(size_t& out) const {
+			if (type != Type::Number || !(number >= 0.0 && number <= 2147483647.0) || std::floor(number) != number) {
+				return false;
+			}
+			out = static_cast<size_t>(number);
+			return true;
+		}
+
+		// A byte count or offset, false when the number is not whole, negative or above 32 bits
+		bool SizeOr(const char* key, size_t fallback, size_t& out) const {
+			const JsonValue* value = Find(key);
+			if (!value || value->type != Type::Number) {
+				out = fallback;
+				return true;
+			}
+			double number = value->number;
+			if (!(number >= 0.0 && number <= 4294967295.0) || std::floor(number) != number) {
+				return false;
+			}
+			out = static_cast<size_t>(number);
+			return true;
+		}
+	};
+
+	// Recursive descent JSON parser over a block of memory
+	class JsonParser
+	{
+	public:
+		JsonParser(const char* begin, const char* end) : cursor(begin), end(end) {}
+
+		bool Parse(JsonValue& out) {
+			return ParseValue(out, 0);
+		}
+
+	private:
+		const char* cursor;
+		const char* end;
+
+		void SkipSpace() {
+			while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')) {
+				++cursor;
+			}
+		}
+
+		bool Match(const char* word) {
+			size_t length = std::strlen(word);
+			if (static_cast<size_t>(end - cursor) < length || std::strncmp(cursor, word, length) != 0) {
+				return false;
+			}
+			cursor += length;
+			return true;
+		}
+
+		bool ParseValue(JsonValue& out, int depth) {
+			SkipSpace();
+			if (cursor >= end || depth > MaxJsonDepth) {
+				return false;
+			}
+			switch (*cursor) {
+			case '{':
+				return ParseObject(out, depth);
+			case '[':
+				return ParseArray(out, depth);
+			case '"':
+				out.type = JsonValue::Type::String;
+				return ParseString(out.text);
+			case 't':
+				out.type = JsonValue::Type::Bool;
+				out.boolean = true;
+				return Match("true");
+			case 'f':
+				out.type = JsonValue::Type::Bool;
+				return Match("false");
+			case 'n':
+				return Match("null");
+			default:
+				return ParseNumber(out);
+			}
+		}
+
+		bool ParseObject(JsonValue& out, int depth) {
+			out.type = JsonValue::Type::Object;
+			++cursor;
+			SkipSpace();
+			if (cursor < end && *cursor == '}') {
+				++cursor;
+				return true;
+			}
+			while (cursor < end) {
+				SkipSpace();
+				std::string key;
+				if (cursor >= end || *cursor != '"' || !ParseString(key)) {
+					return false;
+				}
+				SkipSpace();
+				if (cursor >= end || *cursor != ':') {
+					return false;
+				}
+				++cursor;
+				out.keys.push_back(key);
+				out.items.push_back(JsonValue());
+				if (!ParseValue(out.items.back(), depth + 1)) {
+					return false;
+				}
+				SkipSpace();
+				if (cursor < end && *cursor == ',') {
+					++cursor;
+					continue;
+				}
+				if (cursor < end && *cursor == '}') {
+					++cursor;
+					return true;
+				}
+				return false;
+			}
+			return false;
+		}
+
+		bool ParseArray(JsonValue& out, int depth) {
+			out.type = JsonValue::Type::Array;
+			++cursor;
+			SkipSpace();
+			if (cursor < end && *cursor == ']') {
+				++cursor;
+				return true;
+			}
+			while (cursor < end) {
+				out.items.push_back(JsonValue());
+				if (!ParseValue(out.items.back(), depth + 1)) {
+					return false;
+				}
+				SkipSpace();
+				if (cursor < end && *cursor == ',') {
+					++cursor;
+					continue;
+				}
+				if (cursor < end && *cursor == ']') {
+					++cursor;
+					return true;
+				}
+				return false;
+			}
+			return false;
+		}
+
+		bool ParseString(std::string& out) {
+			++cursor;
+			while (cursor < end && *cursor != '"') {
+				char c = *cursor++;
+				if (c != '\\') {
+					out += c;
+					continue;
+				}
+				if (cursor >= end) {
+					return false;
+				}
+				char escape = *cursor++;
+				switch (escape) {
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				case 'n': out += '\n'; break;
+				case 'r': out += '\r'; break;
+				case 't': out += '\t'; break;
+				case 'u': {
+					if (end - cursor < 4) {
+						return false;
+					}
+					unsigned int code = static_cast<unsigned int>(std::strtoul(std::string(cursor, 4).c_str(), nullptr, 16));
+					cursor += 4;
+					// Written as UTF-8, surrogate pairs are kept as two code points
+					if (code < 0x80) {
+						out += static_cast<char>(code);
+					}
+					else if (code < 0x800) {
+						out += static_cast<char>(0xC0 | (code >> 6));
+						out += static_cast<char>(0x80 | (code & 0x3F));
+					}
+					else {
+						out += static_cast<char>(0xE0 | (code >> 12));
+						out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+						out += static_cast<char>(0x80 | (code & 0x3F));
+					}
+					break;
+				}
+				default: out += escape; break;
+				}
+			}
+			if (cursor >= end) {
+				return false;
+			}
+			++cursor;
+			return true;
+		}
+
+		bool ParseNumber(JsonValue& out) {
+			const char* start = cursor;
+			while (cursor < end && *cursor != '\0' && (std::strchr("+-.eE", *cursor) != nullptr || (*cursor >= '0' && *cursor <= '9'))) {
+				++cursor;
+			}
+			if (cursor == start) {
+				return false;
+			}
+			out.type = JsonValue::Type::Number;
+			out.number = std::strtod(std::string(start, cursor).c_str(), nullptr);
+			return true;
+		}
+	};
+
+	// Copies a whole file into memory
+	bool ReadWholeFile(const std::string& path, std::vector<unsigned char>& out)
+	{
+		MappedFile file;
+		if (!file.Open(path)) {
+			return false;
+		}
+		out.assign(file.GetData(), file.GetData() + file.GetSize());
+		return true;
+	}
+
+	// Decodes base64 text, characters outside the alphabet are skipped
+	std::vector<unsigned char> DecodeBase64(const std::string& text, size_t start)
+	{
+		std::vector<unsigned char> out;
+		out.reserve((text.size() - start) * 3 / 4);
+		unsigned int bits = 0;
+		int bitCount = 0;
+		for (size_t i = start; i < text.size(); ++i) {
+			char c = text[i];
+			int value = -1;
+			if (c >= 'A' && c <= 'Z') value = c - 'A';
+			else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+			else if (c >= '0' && c <= '9') value = c - '0' + 52;
+			else if (c == '+') value = 62;
+			else if (c == '/') value = 63;
+			else if (c == '=') break;
+			if (value < 0) {
+				continue;
+			}
+			bits = (bits << 6) | static_cast<unsigned int>(value);
+			bitCount += 6;
+			if (bitCount >= 8) {
+				bitCount -= 8;
+				out.push_back(static_cast<unsigned char>((bits >> bitCount) & 0xFF));
+			}
+		}
+		return out;
+	}
+
+	// Folder part of a path, including the trailing separator
+	std::string GetDirectory(const std::string& path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		return (slash == std::string::npos) ? "" : path.substr(0, slash + 1);
+	}
+
+	// Lower case extension of a path, without the dot
+	std::string GetExtension(const std::string& path)
+	{
+		size_t dot = path.find_last_of('.');
+		if (dot == std::string::npos) {
+			return "";
+		}
+		std::string extension = path.substr(dot + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+		return extension;
+	}
+
+	// Appends one vertex to an imported mesh
+	void PushVertex(ImportedMesh& mesh, const glm::vec3& position, const glm::vec2& texCoord, const glm::vec3& normal)
+	{
+		const GLfloat vertex[VertexEncoder::FloatsPerVertex] = {
+			position.x, position.y, position.z, texCoord.x, texCoord.y, normal.x, normal.y, normal.z };
+		mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + VertexEncoder::FloatsPerVertex);
+	}
+
+	// One corner of an OBJ face, zero based, -1 where the face gives none
+	struct ObjCorner
+	{
+		int position;
+		int texCoord;
+		int normal;
+
+		bool operator==(const ObjCorner& other) const {
+			return position == other.position && texCoord == other.texCoord && normal == other.normal;
+		}
+	};
+
+	struct ObjCornerHash
+	{
+		size_t operator()(const ObjCorner& corner) const {
+			size_t hash = static_cast<size_t>(corner.position) * 73856093u;
+			hash ^= static_cast<size_t>(corner.texCoord) * 19349663u;
+			hash ^= static_cast<size_t>(corner.normal) * 83492791u;
+			return hash;
+		}
+	};
+
+	// Turns a one based, possibly negative OBJ index into a zero based one, -1 if out of range
+	int ResolveObjIndex(long index, size_t count)
+	{
+		long resolved = (index < 0) ? static_cast<long>(count) + index : index - 1;
+		return (resolved >= 0 && resolved < static_cast<long>(count)) ? static_cast<int>(resolved) : -1;
+	}
+
+	// A glTF accessor resolved to memory
+	struct GltfAccessor
+	{
+		const unsigned char* data = nullptr;
+		size_t count = 0;
+		size_t stride = 0;
+		int componentType = 0;
+		int components = 0;
+		bool normalized = false;
+	};
+
+	size_t GetComponentSize(int componentType)
+	{
+		switch (componentType) {
+		case 5120: case 5121: return 1;// BYTE, UNSIGNED_BYTE
+		case 5122: case 5123: return 2;// SHORT, UNSIGNED_SHORT
+		case 5125: case 5126: return 4;// UNSIGNED_INT, FLOAT
+		default: return 0;
+		}
+	}
+
+	int GetComponentCount(const std::string& type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		return 0;
+	}
+
+	bool ResolveAccessor(const JsonValue& document, const std::vector<std::vector<unsigned char>>& buffers, int index, GltfAccessor& out)
+	{
+		const JsonValue* accessors = document.Find("accessors");
+		const JsonValue* accessor = accessors ? accessors->At(static_cast<size_t>(index)) : nullptr;
+		const JsonValue* views = document.Find("bufferViews");
+		if (!accessor || !views) {
+			return false;
+		}
+		const JsonValue* view = views->At(static_cast<size_t>(accessor->IntOr("bufferView", -1)));
+		const JsonValue* type = accessor->Find("type");
+		if (!view || !type || accessor->Find("sparse")) {
+			return false;
+		}
+		int buffer = view->IntOr("buffer", -1);
+		if (buffer < 0 || static_cast<size_t>(buffer) >= buffers.size()) {
+			return false;
+		}
+
+		out.componentType = accessor->IntOr("componentType", 0);
+		out.components = GetComponentCount(type->text);
+		const JsonValue* normalized = accessor->Find("normalized");
+		out.normalized = normalized && normalized->boolean;
+		size_t elementSize = GetComponentSize(out.componentType) * static_cast<size_t>(out.components);
+		if (elementSize == 0) {
+			return false;
+		}
+
+		// Every number is checked before use and every sum against what is left, so nothing can wrap
+		size_t viewOffset = 0;
+		size_t viewLength = 0;
+		size_t accessorOffset = 0;
+		if (!accessor->SizeOr("count", 0, out.count) || !view->SizeOr("byteStride", elementSize, out.stride)
+			|| !view->SizeOr("byteOffset", 0, viewOffset) || !view->SizeOr("byteLength", 0, viewLength)
+			|| !accessor->SizeOr("byteOffset", 0, accessorOffset) || out.stride < elementSize) {
+			return false;
+		}
+		size_t bufferSize = buffers[buffer].size();
+		if (viewOffset > bufferSize || viewLength > bufferSize - viewOffset) {
+			return false;
+		}
+		size_t viewEnd = viewOffset + viewLength;
+		if (accessorOffset > viewLength) {
+			return false;
+		}
+		size_t offset = viewOffset + accessorOffset;
+		if (out.count > 0 && (elementSize > viewEnd - offset || out.count - 1 > (viewEnd - offset - elementSize) / out.stride)) {
+			return false;
+		}
+		out.data = buffers[buffer].data() + offset;
+		return true;
+	}
+
+	// Reads one component as a float, normalised integers are scaled to 0..1 or -1..1
+	float ReadComponent(const GltfAccessor& accessor, size_t element, int component)
+	{
+		const unsigned char* at = accessor.data + accessor.stride * element + GetComponentSize(accessor.componentType) * component;
+		switch (accessor.componentType) {
+		case 5126: { float value; std::memcpy(&value, at, sizeof(value)); return value; }
+		case 5121: return accessor.normalized ? *at / 255.0f : *at;
+		case 5120: { signed char value = static_cast<signed char>(*at); return accessor.normalized ? std::max(value / 127.0f, -1.0f) : value; }
+		case 5123: { std::uint16_t value; std::memcpy(&value, at, sizeof(value)); return accessor.normalized ? value / 65535.0f : value; }
+		case 5122: { std::int16_t value; std::memcpy(&value, at, sizeof(value)); return accessor.normalized ? std::max(value / 32767.0f, -1.0f) : value; }
+		case 5125: { std::uint32_t value; std::memcpy(&value, at, sizeof(value)); return static_cast<float>(value); }
+		default: return 0.0f;
+		}
+	}
+
+	GLuint ReadIndex(const GltfAccessor& accessor, size_t element)
+	{
+		const unsigned char* at = accessor.data + accessor.stride * element;
+		switch (accessor.componentType) {
+		case 5121: return *at;
+		case 5123: { std::uint16_t value; std::memcpy(&value, at, sizeof(value)); return value; }
+		case 5125: { std::uint32_t value; std::memcpy(&value, at, sizeof(value)); return value; }
+		default: return 0;
+		}
+	}
+
+	// Local transform of a node, from its matrix or its translation, rotation and scale
+	glm::mat4 GetNodeMatrix(const JsonValue& node)
+	{
+		const JsonValue* matrix = node.Find("matrix");
+		if (matrix && matrix->items.size() == 16) {
+			glm::mat4 result(1.0f);
+			for (int column = 0; column < 4; ++column) {
+				result[column] = glm::vec4(
+					static_cast<float>(matrix->items[column * 4].number), static_cast<float>(matrix->items[column * 4 + 1].number),
+					static_cast<float>(matrix->items[column * 4 + 2].number), static_cast<float>(matrix->items[column * 4 + 3].number));
+			}
+			return result;
+		}
+
+		glm::mat4 result(1.0f);
+		const JsonValue* rotation = node.Find("rotation");
+		if (rotation && rotation->items.size() == 4) {
+			// glTF stores x, y, z, w
+			glm::quat q(static_cast<float>(rotation->items[3].number), static_cast<float>(rotation->items[0].number),
+				static_cast<float>(rotation->items[1].number), static_cast<float>(rotation->items[2].number));
+			result = glm::mat4_cast(q);
+		}
+		const JsonValue* scale = node.Find("scale");
+		if (scale && scale->items.size() == 3) {
+			for (int axis = 0; axis < 3; ++axis) {
+				result[axis] = result[axis] * static_cast<float>(scale->items[axis].number);
+			}
+		}
+		const JsonValue* translation = node.Find("translation");
+		if (translation && translation->items.size() == 3) {
+			result[3] = glm::vec4(static_cast<float>(translation->items[0].number), static_cast<float>(translation->items[1].number),
+				static_cast<float>(translation->items[2].number), 1.0f);
+		}
+		return result;
+	}
+
+	// Appends the triangles of one mesh, transformed to scene space
+	bool AppendGltfMesh(const JsonValue& document, const std::vector<std::vector<unsigned char>>& buffers, const JsonValue& mesh,
+		const glm::mat4& transform, ImportedMesh& out, std::vector<bool>& hasNormal)
+	{
+		const JsonValue* primitives = mesh.Find("primitives");
+		if (!primitives) {
+			return true;
+		}
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+		for (const JsonValue& primitive : primitives->items) {
+			const JsonValue* attributes = primitive.Find("attributes");
+			if (primitive.IntOr("mode", 4) != 4 || !attributes) {
+				continue;// Only triangle lists
+			}
+			GltfAccessor positions, normals, texCoords, indices;
+			if (!ResolveAccessor(document, buffers, attributes->IntOr("POSITION", -1), positions) || positions.components != 3) {
+				return false;
+			}
+			bool readNormals = ResolveAccessor(document, buffers, attributes->IntOr("NORMAL", -1), normals) && normals.components == 3 && normals.count == positions.count;
+			bool readTexCoords = ResolveAccessor(document, buffers, attributes->IntOr("TEXCOORD_0", -1), texCoords) && texCoords.components == 2 && texCoords.count == positions.count;
+
+			GLuint base = out.GetVertexCount();
+			for (size_t i = 0; i < positions.count; ++i) {
+				glm::vec3 position(ReadComponent(positions, i, 0), ReadComponent(positions, i, 1), ReadComponent(positions, i, 2));
+				glm::vec3 normal(0.0f);
+				glm::vec2 texCoord(0.0f);
+				if (readNormals) {
+					normal = glm::vec3(ReadComponent(normals, i, 0), ReadComponent(normals, i, 1), ReadComponent(normals, i, 2));
+					float length = glm::length(normalMatrix * normal);
+					normal = (length > 0.0f) ? (normalMatrix * normal) / length : glm::vec3(0.0f, 1.0f, 0.0f);
+				}
+				if (readTexCoords) {
+					// glTF puts the image origin top left, the textures here are flipped to bottom left
+					texCoord = glm::vec2(ReadComponent(texCoords, i, 0), 1.0f - ReadComponent(texCoords, i, 1));
+				}
+				PushVertex(out, glm::vec3(transform * glm::vec4(position, 1.0f)), texCoord, normal);
+				hasNormal.push_back(readNormals);
+			}
+
+			if (primitive.Find("indices")) {
+				if (!ResolveAccessor(document, buffers, primitive.IntOr("indices", -1), indices) || indices.components != 1) {
+					return false;
+				}
+				for (size_t i = 0; i + 2 < indices.count; i += 3) {
+					GLuint a = ReadIndex(indices, i), b = ReadIndex(indices, i + 1), c = ReadIndex(indices, i + 2);
+					if (a >= positions.count || b >= positions.count || c >= positions.count) {
+						return false;
+					}
+					out.indices.push_back(base + a);
+					out.indices.push_back(base + b);
+					out.indices.push_back(base + c);
+				}
+			}
+			else {
+				for (GLuint i = 0; i + 2 < positions.count; i += 3) {
+					out.indices.push_back(base + i);
+					out.indices.push_back(base + i + 1);
+					out.indices.push_back(base + i + 2);
+				}
+			}
+		}
+		return true;
+	}
+
+	// Appends a node and its children. The nodes form trees, so a node reached twice means a cycle
+	// or a shared child, and is refused rather than appended again
+	bool AppendGltfNode(const JsonValue& document, const std::vector<std::vector<unsigned char>>& buffers, const JsonValue& index,
+		const glm::mat4& parent, int depth, std::vector<bool>& visited, ImportedMesh& out, std::vector<bool>& hasNormal)
+	{
+		const JsonValue* nodes = document.Find("nodes");
+		size_t nodeIndex = 0;
+		const JsonValue* node = (nodes && index.AsIndex(nodeIndex)) ? nodes->At(nodeIndex) : nullptr;
+		if (!node || depth > MaxNodeDepth || visited[nodeIndex]) {
+			return false;
+		}
+		visited[nodeIndex] = true;
+		glm::mat4 transform = parent * GetNodeMatrix(*node);
+		const JsonValue* meshes = document.Find("meshes");
+		const JsonValue* mesh = (meshes && node->Find("mesh")) ? meshes->At(static_cast<size_t>(node->IntOr("mesh", -1))) : nullptr;
+		if (mesh && !AppendGltfMesh(document, buffers, *mesh, transform, out, hasNormal)) {
+			return false;
+		}
+		const JsonValue* children = node->Find("children");
+		if (children) {
+			for (const JsonValue& child : children->items) {
+				if (!AppendGltfNode(document, buffers, child, transform, depth + 1, visited, out, hasNormal)) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+/***********************************************************************
+ * Import: Reads a mesh file.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - path: An .obj, .gltf or .glb file.
+ *   - out: Filled with the mesh.
+ *
+ * Return: bool - True when the file was read and holds triangles.
+ ***********************************************************************/
+bool MeshImporter::Import(const std::string& path, ImportedMesh& out)
+{
+	std::string extension = GetExtension(path);
+	bool imported = false;
+	if (extension == "obj") {
+		imported = ImportObj(path, out);
+	}
+	else if (extension == "gltf" || extension == "glb") {
+		imported = ImportGltf(path, out);
+	}
+	else {
+		std::cout << "Unknown mesh file type: " << path << std::endl;
+		return false;
+	}
+	if (imported && out.indices.empty()) {
+		std::cout << "No triangles in mesh file: " << path << std::endl;
+		return false;
+	}
+	return imported;
+}
+
+/***********************************************************************
+ * ImportObj: Reads a Wavefront OBJ file.
+ * Author: [Smirti Parajuli]
+ * Description: The file is mapped and read line by line. Faces with more
+ *              than three corners are split into fans, corners sharing
+ *              position, texture coordinates and normal become one
+ *              vertex, and vertices without a normal get the average of
+ *              the faces around them. Groups and materials are ignored.
+ *
+ * Parameters:
+ *   - path: Path of the file.
+ *   - out: Filled with the mesh.
+ *
+ * Return: bool - True when the file could be read.
+ ***********************************************************************/
+bool MeshImporter::ImportObj(const std::string& path, ImportedMesh& out)
+{
+	MappedFile file;
+	if (!file.Open(path)) {
+		std::cout << "Cannot read mesh file: " << path << std::endl;
+		return false;
+	}
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> texCoords;
+	std::vector<glm::vec3> normals;
+	std::vector<bool> hasNormal;
+	std::unordered_map<ObjCorner, GLuint, ObjCornerHash> corners;
+	std::vector<GLuint> face;
+	size_t skippedFaces = 0;
+
+	const char* cursor = reinterpret_cast<const char*>(file.GetData());
+	const char* end = cursor + file.GetSize();
+	std::string line;
+	while (cursor < end) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+		if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+		line.assign(cursor, lineEnd);
+		cursor = lineEnd + 1;
+
+		const char* at = line.c_str();
+		while (*at == ' ' || *at == '\t') {
+			++at;
+		}
+		char* next = nullptr;
+		if (at[0] == 'v' && (at[1] == ' ' || at[1] == '\t')) {
+			glm::vec3 position;
+			position.x = std::strtof(at + 2, &next);
+			position.y = std::strtof(next, &next);
+			position.z = std::strtof(next, &next);
+			positions.push_back(position);
+		}
+		else if (at[0] == 'v' && at[1] == 't') {
+			glm::vec2 texCoord;
+			texCoord.x = std::strtof(at + 2, &next);
+			texCoord.y = std::strtof(next, &next);
+			texCoords.push_back(texCoord);
+		}
+		else if (at[0] == 'v' && at[1] == 'n') {
+			glm::vec3 normal;
+			normal.x = std::strtof(at + 2, &next);
+			normal.y = std::strtof(next, &next);
+			normal.z = std::strtof(next, &next);
+			normals.push_back(normal);
+		}
+		else if (at[0] == 'f' && (at[1] == ' ' || at[1] == '\t')) {
+			face.clear();
+			bool valid = true;
+			const char* token = at + 2;
+			while (*token != '\0') {
+				while (*token == ' ' || *token == '\t' || *token == '\r') {
+					++token;
+				}
+				if (*token == '\0') {
+					break;
+				}
+				ObjCorner corner = { -1, -1, -1 };
+				corner.position = ResolveObjIndex(std::strtol(token, &next, 10), positions.size());
+				if (next == token) {
+					valid = false;
+					break;
+				}
+				token = next;
+				if (*token == '/') {
+					++token;
+					if (*token != '/') {
+						corner.texCoord = ResolveObjIndex(std::strtol(token, &next, 10), texCoords.size());
+						token = next;
+					}
+					if (*token == '/') {
+						++token;
+						corner.normal = ResolveObjIndex(std::strtol(token, &next, 10), normals.size());
+						token = next;
+					}
+				}
+				while (*token != '\0' && *token != ' ' && *token != '\t' && *token != '\r') {
+					++token;
+				}
+				if (corner.position < 0) {
+					valid = false;
+					break;
+				}
+
+				auto found = corners.find(corner);
+				if (found == corners.end()) {
+					GLuint vertex = out.GetVertexCount();
+					PushVertex(out, positions[corner.position],
+						corner.texCoord >= 0 ? texCoords[corner.texCoord] : glm::vec2(0.0f),
+						corner.normal >= 0 ? normals[corner.normal] : glm::vec3(0.0f));
+					hasNormal.push_back(corner.normal >= 0);
+					found = corners.emplace(corner, vertex).first;
+				}
+				face.push_back(found->second);
+			}
+			if (!valid || face.size() < 3) {
+				skippedFaces++;
+				continue;
+			}
+			for (size_t i = 1; i + 1 < face.size(); ++i) {
+				out.indices.push_back(face[0]);
+				out.indices.push_back(face[i]);
+				out.indices.push_back(face[i + 1]);
+			}
+		}
+	}
+
+	if (skippedFaces > 0) {
+		std::cout << "Skipped " << skippedFaces << " faces with bad indices in: " << path << std::endl;
+	}
+	ComputeMissingNormals(out, hasNormal);
+	return true;
+}
+
+/***********************************************************************
+ * ImportGltf: Reads a glTF 2.0 file.
+ * Author: [Smirti Parajuli]
+ * Description: Reads both the JSON form, with its buffers in separate
+ *              files or data URIs, and the binary .glb form. Every mesh of
+ *              the default scene is flattened into one mesh with its node
+ *              transforms applied.
+ *
+ * Parameters:
+ *   - path: Path of the file.
+ *   - out: Filled with the mesh.
+ *
+ * Return: bool - True when the file could be read.
+ ***********************************************************************/
+bool MeshImporter::ImportGltf(const std::string& path, ImportedMesh& out)
+{
+	std::vector<unsigned char> file;
+	if (!ReadWholeFile(path, file)) {
+		std::cout << "Cannot read mesh file: " << path << std::endl;
+		return false;
+	}
+
+	// A .glb is a 12 byte header and chunks of JSON and binary data
+	const char* jsonBegin = reinterpret_cast<const char*>(file.data());
+	const char* jsonEnd = jsonBegin + file.size();
+	std::vector<unsigned char> binaryChunk;
+	std::uint32_t magic = 0;
+	if (file.size() >= 12) {
+		std::memcpy(&magic, file.data(), sizeof(magic));
+	}
+	if (magic == 0x46546C67) {// "glTF"
+		size_t offset = 12;
+		bool foundJson = false;
+		while (offset + 8 <= file.size()) {
+			std::uint32_t chunkLength, chunkType;
+			std::memcpy(&chunkLength, file.data() + offset, sizeof(chunkLength));
+			std::memcpy(&chunkType, file.data() + offset + 4, sizeof(chunkType));
+			offset += 8;
+			if (chunkLength > file.size() - offset) {
+				break;
+			}
+			if (chunkType == 0x4E4F534A && !foundJson) {// "JSON"
+				jsonBegin = reinterpret_cast<const char*>(file.data() + offset);
+				jsonEnd = jsonBegin + chunkLength;
+				foundJson = true;
+			}
+			else if (chunkType == 0x004E4942 && binaryChunk.empty()) {// "BIN"
+				binaryChunk.assign(file.data() + offset, file.data() + offset + chunkLength);
+			}
+			offset += chunkLength;
+		}
+		if (!foundJson) {
+			std::cout << "No JSON chunk in: " << path << std::endl;
+			return false;
+		}
+	}
+
+	JsonValue document;
+	JsonParser parser(jsonBegin, jsonEnd);
+	if (!parser.Parse(document) || document.type != JsonValue::Type::Object) {
+		std::cout << "Cannot parse glTF file: " << path << std::endl;
+		return false;
+	}
+
+	// Load every buffer, the first one without a URI is the binary chunk
+	std::vector<std::vector<unsigned char>> buffers;
+	const JsonValue* bufferList = document.Find("buffers");
+	if (bufferList) {
+		for (const JsonValue& buffer : bufferList->items) {
+			const JsonValue* uri = buffer.Find("uri");
+			buffers.push_back(std::vector<unsigned char>());
+			if (!uri) {
+				buffers.back().swap(binaryChunk);
+			}
+			else if (uri->text.compare(0, 5, "data:") == 0) {
+				size_t comma = uri->text.find(',');
+				if (comma != std::string::npos) {
+					buffers.back() = DecodeBase64(uri->text, comma + 1);
+				}
+			}
+			else if (!ReadWholeFile(GetDirectory(path) + uri->text, buffers.back())) {
+				std::cout << "Cannot read glTF buffer: " << uri->text << std::endl;
+				return false;
+			}
+		}
+	}
+
+	std::vector<bool> hasNormal;
+	bool appended = true;
+	const JsonValue* scenes = document.Find("scenes");
+	const JsonValue* scene = scenes ? scenes->At(static_cast<size_t>(document.IntOr("scene", 0))) : nullptr;
+	const JsonValue* roots = scene ? scene->Find("nodes") : nullptr;
+	if (roots) {
+		const JsonValue* nodes = document.Find("nodes");
+		std::vector<bool> visited(nodes ? nodes->items.size() : 0, false);
+		for (const JsonValue& root : roots->items) {
+			appended = appended && AppendGltfNode(document, buffers, root, glm::mat4(1.0f), 0, visited, out, hasNormal);
+		}
+	}
+	else if (document.Find("meshes")) {
+		// Without a scene every mesh is taken as it is
+		for (const JsonValue& mesh : document.Find("meshes")->items) {
+			appended = appended && AppendGltfMesh(document, buffers, mesh, glm::mat4(1.0f), out, hasNormal);
+		}
+	}
+	if (!appended) {
+		std::cout << "Bad accessor or node in glTF file: " << path << std::endl;
+		return false;
+	}
+	ComputeMissingNormals(out, hasNormal);
+	return true;
+}
+
+/***********************************************************************
+ * ComputeMissingNormals: Fills in normals the file did not give.
+ * Author: [Smirti Parajuli]
+ * Description: Each such vertex gets the area weighted average of the
+ *              faces that use it.
+ *
+ * Parameters:
+ *   - mesh: The mesh to update.
+ *   - hasNormal: For every vertex, whether its normal came from the file.
+ *
+ * Return: None
+ ***********************************************************************/
+void MeshImporter::ComputeMissingNormals(ImportedMesh& mesh, const std::vector<bool>& hasNormal)
+{
+	if (std::find(hasNormal.begin(), hasNormal.end(), false) == hasNormal.end()) {
+		return;
+	}
+	const GLuint stride = VertexEncoder::FloatsPerVertex;
+	std::vector<glm::vec3> sums(mesh.GetVertexCount(), glm::vec3(0.0f));
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+		const GLfloat* a = &mesh.vertices[mesh.indices[i] * stride];
+		const GLfloat* b = &mesh.vertices[mesh.indices[i + 1] * stride];
+		const GLfloat* c = &mesh.vertices[mesh.indices[i + 2] * stride];
+		glm::vec3 edgeB = glm::vec3(b[0], b[1], b[2]) - glm::vec3(a[0], a[1], a[2]);
+		glm::vec3 edgeC = glm::vec3(c[0], c[1], c[2]) - glm::vec3(a[0], a[1], a[2]);
+		glm::vec3 faceNormal = glm::cross(edgeB, edgeC);// Length is twice the area
+		for (int corner = 0; corner < 3; ++corner) {
+			sums[mesh.indices[i + corner]] += faceNormal;
+		}
+	}
+	for (GLuint vertex = 0; vertex < mesh.GetVertexCount(); ++vertex) {
+		if (hasNormal[vertex]) {
+			continue;
+		}
+		float length = glm::length(sums[vertex]);
+		glm::vec3 normal = (length > 0.0f) ? sums[vertex] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+		mesh.vertices[vertex * stride + 5] = normal.x;
+		mesh.vertices[vertex * stride + 6] = normal.y;
+		mesh.vertices[vertex * stride + 7] = normal.z;
+	}
+}
+
+/***********************************************************************
+ * Cook: Turns an imported mesh into its cooked form.
+ * Author: [Smirti Parajuli]
+ * Description: The mesh is optimised like every other mesh, then coarser
+ *              levels are clustered on grids of halving resolution. A
+ *              level that saves too little is skipped. All levels share
+ *              the vertices, so they only add indices. Last the vertices
+ *              are encoded in the format ChooseFormat picks and the
+ *              indices narrowed as the pool wants them.
+ *
+ * Parameters:
+ *   - mesh: The imported mesh, reordered in place.
+ *   - out: Filled with the cooked mesh.
+ *
+ * Return: None
+ ***********************************************************************/
+void MeshImporter::Cook(ImportedMesh& mesh, CookedMesh& out)
+{
+	GLuint vertexCount = mesh.GetVertexCount();
+	GLuint indexCount = static_cast<GLuint>(mesh.indices.size());
+	MeshOptimizer::Optimize(mesh.vertices.data(), VertexEncoder::FloatsPerVertex, vertexCount, mesh.indices.data(), indexCount);
+
+	std::vector<GLuint> indices(mesh.indices);
+	out.lods.clear();
+	MeshLod finest;
+	finest.indexCount = indexCount;
+	out.lods.push_back(finest);
+	std::vector<GLuint> simplified;
+	for (GLuint cells = LodBaseCells; cells >= 2 && out.lods.size() < MeshCache::MaxLods; cells /= 2) {
+		float error = SimplifyClusters(mesh, cells, simplified);
+		if (simplified.empty()) {
+			break;
+		}
+		if (simplified.size() > LodMinReduction * out.lods.back().indexCount) {
+			continue;
+		}
+		MeshOptimizer::OptimizeVertexCache(simplified.data(), static_cast<GLuint>(simplified.size()), vertexCount);
+		MeshLod lod;
+		lod.firstIndex = static_cast<GLuint>(indices.size());
+		lod.indexCount = static_cast<GLuint>(simplified.size());
+		lod.error = error;
+		out.lods.push_back(lod);
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+	}
+
+	out.format = ChooseFormat(mesh);
+	out.vertexCount = vertexCount;
+	VertexEncoder::Encode(mesh.vertices.data(), vertexCount, out.format, out.vertices);
+	if (vertexCount <= 65536) {
+		out.indexType = GL_UNSIGNED_SHORT;
+		out.indices.resize(indices.size() * sizeof(GLushort));
+		GLushort* narrow = reinterpret_cast<GLushort*>(out.indices.data());
+		for (size_t i = 0; i < indices.size(); ++i) {
+			narrow[i] = static_cast<GLushort>(indices[i]);
+		}
+	}
+	else {
+		out.indexType = GL_UNSIGNED_INT;
+		out.indices.resize(indices.size() * sizeof(GLuint));
+		std::memcpy(out.indices.data(), indices.data(), out.indices.size());
+	}
+
+	// Bounding sphere around the centre of the box, for culling and picking a level
+	glm::vec3 low(mesh.vertices[0], mesh.vertices[1], mesh.vertices[2]);
+	glm::vec3 high = low;
+	for (GLuint vertex = 0; vertex < vertexCount; ++vertex) {
+		glm::vec3 position(mesh.vertices[vertex * VertexEncoder::FloatsPerVertex], mesh.vertices[vertex * VertexEncoder::FloatsPerVertex + 1], mesh.vertices[vertex * VertexEncoder::FloatsPerVertex + 2]);
+		low = glm::min(low, position);
+		high = glm::max(high, position);
+	}
+	glm::vec3 centre = (low + high) * 0.5f;
+	float radius = 0.0f;
+	for (GLuint vertex = 0; vertex < vertexCount; ++vertex) {
+		glm::vec3 position(mesh.vertices[vertex * VertexEncoder::FloatsPerVertex], mesh.vertices[vertex * VertexEncoder::FloatsPerVertex + 1], mesh.vertices[vertex * VertexEncoder::FloatsPerVertex + 2]);
+		radius = std::max(radius, glm::length(position - centre));
+	}
+	out.bounds = glm::vec4(centre, radius);
+}
+
+/***********************************************************************
+ * ChooseFormat: Picks how the vertices of a mesh are stored.
+ * Author: [Smirti Parajuli]
+ * Description: The compact formats keep texture coordinates as unorm16,
+ *              which clamps them to 0..1, so a mesh that tiles or wraps
+ *              its texture keeps floats. Every other mesh gets snorm
+ *              positions, which are relative to its bounds and so keep
+ *              their precision however large or far from the origin the
+ *              mesh is. Half float positions are left to the small meshes
+ *              made around the origin in code.
+ *
+ * Parameters:
+ *   - mesh: The imported mesh.
+ *
+ * Return: VertexFormat - The format to cook the mesh in.
+ ***********************************************************************/
+VertexFormat MeshImporter::ChooseFormat(const ImportedMesh& mesh)
+{
+	const GLuint stride = VertexEncoder::FloatsPerVertex;
+	for (GLuint vertex = 0; vertex < mesh.GetVertexCount(); ++vertex) {
+		for (GLuint component = 3; component < 5; ++component) {
+			GLfloat value = mesh.vertices[vertex * stride + component];
+			if (!(value >= 0.0f && value <= 1.0f)) {
+				return VertexFormat::Float32;
+			}
+		}
+	}
+	return VertexFormat::SnormOctahedral;
+}
+
+/***********************************************************************
+ * SimplifyClusters: Builds a coarser level by vertex clustering.
+ * Author: [Smirti Parajuli]
+ * Description: The bounding box is cut into cubes, cells along its longest
+ *              side. Every vertex moves to the vertex of its cube closest
+ *              to the cube's average, and triangles that lose a corner
+ *              are dropped. The vertices are not changed, so the level
+ *              only needs new indices.
+ *
+ * Parameters:
+ *   - mesh: The mesh to simplify.
+ *   - cells: Cubes along the longest side of the bounding box.
+ *   - out: Filled with the triangles of the coarser level.
+ *
+ * Return: float - The largest distance a vertex moved.
+ ***********************************************************************/
+float MeshImporter::SimplifyClusters(const ImportedMesh& mesh, GLuint cells, std::vector<GLuint>& out)
+{
+	out.clear();
+	const GLuint stride = VertexEncoder::FloatsPerVertex;
+	GLuint vertexCount = mesh.GetVertexCount();
+	if (vertexCount == 0 || cells == 0) {
+		return 0.0f;
+	}
+	auto positionOf = [&](GLuint vertex) {
+		return glm::vec3(mesh.vertices[vertex * stride], mesh.vertices[vertex * stride + 1], mesh.vertices[vertex * stride + 2]);
+	};
+
+	glm::vec3 low = positionOf(0);
+	glm::vec3 high = low;
+	for (GLuint vertex = 1; vertex < vertexCount; ++vertex) {
+		low = glm::min(low, positionOf(vertex));
+		high = glm::max(high, positionOf(vertex));
+	}
+	glm::vec3 size = high - low;
+	float cellSize = std::max(size.x, std::max(size.y, size.z)) / cells;
+	if (cellSize <= 0.0f) {
+		return 0.0f;
+	}
+
+	// Cube of every vertex, and the running average of every cube
+	std::vector<GLuint> cellOf(vertexCount);
+	std::unordered_map<GLuint, GLuint> cellSlots;
+	std::vector<glm::vec3> averages;
+	std::vector<GLuint> counts;
+	for (GLuint vertex = 0; vertex < vertexCount; ++vertex) {
+		glm::vec3 local = (positionOf(vertex) - low) / cellSize;
+		GLuint x = std::min(static_cast<GLuint>(local.x), cells - 1);
+		GLuint y = std::min(static_cast<GLuint>(local.y), cells - 1);
+		GLuint z = std::min(static_cast<GLuint>(local.z), cells - 1);
+		GLuint cell = x + cells * (y + cells * z);
+		auto found = cellSlots.find(cell);
+		if (found == cellSlots.end()) {
+			found = cellSlots.emplace(cell, static_cast<GLuint>(averages.size())).first;
+			averages.push_back(glm::vec3(0.0f));
+			counts.push_back(0);
+		}
+		cellOf[vertex] = found->second;
+		averages[found->second] += positionOf(vertex);
+		counts[found->second]++;
+	}
+	for (size_t slot = 0; slot < averages.size(); ++slot) {
+		averages[slot] /= static_cast<float>(counts[slot]);
+	}
+
+	// The vertex nearest the average stands in for the whole cube
+	std::vector<GLuint> representative(averages.size(), vertexCount);
+	std::vector<float> nearest(averages.size(), 0.0f);
+	for (GLuint vertex = 0; vertex < vertexCount; ++vertex) {
+		GLuint slot = cellOf[vertex];
+		float distance = glm::length(positionOf(vertex) - averages[slot]);
+		if (representative[slot] == vertexCount || distance < nearest[slot]) {
+			representative[slot] = vertex;
+			nearest[slot] = distance;
+		}
+	}
+
+	float error = 0.0f;
+	for (GLuint vertex = 0; vertex < vertexCount; ++vertex) {
+		error = std::max(error, glm::length(positionOf(vertex) - positionOf(representative[cellOf[vertex]])));
+	}
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+		GLuint a = representative[cellOf[mesh.indices[i]]];
+		GLuint b = representative[cellOf[mesh.indices[i + 1]]];
+		GLuint c = representative[cellOf[mesh.indices[i + 2]]];
+		if (a != b && b != c && a != c) {
+			out.push_back(a);
+			out.push_back(b);
+			out.push_back(c);
+		}
+	}
+	return error;
+}
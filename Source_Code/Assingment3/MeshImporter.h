@@ -0,0 +1,59 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :MeshImporter.h
+Description :  The MeshImporter reads OBJ and glTF 2.0 (.gltf and .glb)
+               files into the interleaved float vertices the rest of the
+               engine builds meshes from, and cooks them into the layout of
+               the geometry pool: optimised for the vertex cache, encoded,
+               with coarser levels of detail made by vertex clustering.
+               Everything here is free of GL calls so it can run as a job.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef MESHIMPORTER_H
+#define MESHIMPORTER_H
+
+#include <glew.h>
+#include <string>
+#include <vector>
+#include "MeshCache.h"
+#include "VertexEncoder.h"
+
+// A parsed mesh, position, texture coordinates and normal for every vertex
+struct ImportedMesh
+{
+	std::vector<GLfloat> vertices;// VertexEncoder::FloatsPerVertex floats per vertex
+	std::vector<GLuint> indices;// Triangle list
+
+	GLuint GetVertexCount() const { return static_cast<GLuint>(vertices.size() / VertexEncoder::FloatsPerVertex); }
+};
+
+class MeshImporter
+{
+public:
+	static const GLuint LodBaseCells = 64;// Clustering cells along the longest side for the first coarse level
+	static constexpr float LodMinReduction = 0.8f;// A level must keep fewer indices than this share of the previous one
+
+	static bool Import(const std::string& path, ImportedMesh& out);// Picks the parser from the extension
+	static bool ImportObj(const std::string& path, ImportedMesh& out);
+	static bool ImportGltf(const std::string& path, ImportedMesh& out);
+
+	// Optimises the mesh in place and fills out with every level of detail
+	static void Cook(ImportedMesh& mesh, CookedMesh& out);
+	static VertexFormat ChooseFormat(const ImportedMesh& mesh);// The most compact format that stores the mesh unchanged
+
+	// Clusters the vertices on a grid and keeps the triangles that stay whole, returns the largest vertex move
+	static float SimplifyClusters(const ImportedMesh& mesh, GLuint cells, std::vector<GLuint>& out);
+
+private:
+	MeshImporter();
+
+	static void ComputeMissingNormals(ImportedMesh& mesh, const std::vector<bool>& hasNormal);
+};
+#endif // MESHIMPORTER_H
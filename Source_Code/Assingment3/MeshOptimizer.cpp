@@ -0,0 +1,398 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :MeshOptimizer.cpp
+Description :  Implementation of the mesh reordering stages and the vertex
+               cache simulation.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "MeshOptimizer.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+/***********************************************************************
+ * Optimize: Runs every stage on a mesh.
+ * Author: [Smirti Parajuli]
+ * Description: The cache order comes first, the overdraw stage only
+ *              moves whole clusters of it and the vertex order follows
+ *              the final triangle order.
+ *
+ * Parameters:
+ *   - vertices: floatsPerVertex floats for every vertex, position first.
+ *   - floatsPerVertex: Size of one vertex.
+ *   - vertexCount: Number of vertices.
+ *   - indices: Triangle list indices.
+ *   - indexCount: Number of indices.
+ *
+ * Return: None
+ ***********************************************************************/
+void MeshOptimizer::Optimize(GLfloat* vertices, GLuint floatsPerVertex, GLuint vertexCount, GLuint* indices, GLuint indexCount)
+{
+	VertexCacheStats before = AnalyzeVertexCache(indices, indexCount, vertexCount);
+
+	OptimizeVertexCache(indices, indexCount, vertexCount);
+	OptimizeOverdraw(vertices, floatsPerVertex, vertexCount, indices, indexCount);
+	OptimizeVertexFetch(vertices, floatsPerVertex, vertexCount, indices, indexCount);
+
+	VertexCacheStats after = AnalyzeVertexCache(indices, indexCount, vertexCount);
+	// Formatted apart and written in one call, this runs on job threads and std::cout keeps its settings
+	std::ostringstream line;
+	line << std::fixed << std::setprecision(3)
+		<< "Mesh optimized, " << indexCount / 3 << " triangles: ACMR " << before.acmr << " -> " << after.acmr
+		<< ", ATVR " << before.atvr << " -> " << after.atvr
+		<< " (" << SimulatedCacheSize << " entry FIFO)\n";
+	std::cout << line.str() << std::flush;
+}
+
+/***********************************************************************
+ * ScoreVertex: Forsyth score of one vertex.
+ * Author: [Smirti Parajuli]
+ * Description: Vertices of the last triangle score a fixed amount, the
+ *              rest of the cache scores less the older they are, and
+ *              vertices with few triangles left get a boost so they are
+ *              finished off instead of left for a later cache miss.
+ *
+ * Parameters:
+ *   - cachePosition: Position in the simulated LRU cache, -1 if not in it.
+ *   - remainingTriangles: Triangles still to be emitted using the vertex.
+ *
+ * Return: The score, -1 once the vertex is no longer needed.
+ ***********************************************************************/
+float MeshOptimizer::ScoreVertex(int cachePosition, GLuint remainingTriangles)
+{
+	if (remainingTriangles == 0) {
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+	if (cachePosition >= 0) {
+		if (cachePosition < 3) {
+			score = 0.75f;
+		}
+		else {
+			float scaler = 1.0f / (ScoringCacheSize - 3);
+			score = std::pow(1.0f - (cachePosition - 3) * scaler, 1.5f);
+		}
+	}
+	return score + 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+}
+
+/***********************************************************************
+ * OptimizeVertexCache: Reorders the triangles for the vertex cache.
+ * Author: [Smirti Parajuli]
+ * Description: Forsyth's linear-speed greedy method. The next triangle is
+ *              always the best scoring one around the vertices in the
+ *              simulated cache, only falling back to the first triangle
+ *              not yet emitted when none of them has any left.
+ *
+ * Parameters:
+ *   - indices: Triangle list indices, rewritten in the new order.
+ *   - indexCount: Number of indices.
+ *   - vertexCount: Number of vertices.
+ *
+ * Return: None
+ ***********************************************************************/
+void MeshOptimizer::OptimizeVertexCache(GLuint* indices, GLuint indexCount, GLuint vertexCount)
+{
+	GLuint triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// Triangles of every vertex, the first remaining[v] entries are the ones not yet emitted
+	std::vector<GLuint> remaining(vertexCount, 0);
+	for (GLuint i = 0; i < triangleCount * 3; i++) {
+		remaining[indices[i]]++;
+	}
+	std::vector<GLuint> offsets(vertexCount + 1, 0);
+	for (GLuint v = 0; v < vertexCount; v++) {
+		offsets[v + 1] = offsets[v] + remaining[v];
+	}
+	std::vector<GLuint> adjacency(triangleCount * 3);
+	std::vector<GLuint> cursor(offsets.begin(), offsets.end() - 1);
+	for (GLuint i = 0; i < triangleCount * 3; i++) {
+		adjacency[cursor[indices[i]]++] = i / 3;
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (GLuint v = 0; v < vertexCount; v++) {
+		vertexScore[v] = ScoreVertex(-1, remaining[v]);
+	}
+	std::vector<float> triangleScore(triangleCount);
+	for (GLuint t = 0; t < triangleCount; t++) {
+		const GLuint* triangle = indices + t * 3;
+		triangleScore[t] = vertexScore[triangle[0]] + vertexScore[triangle[1]] + vertexScore[triangle[2]];
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<GLuint> output;
+	output.reserve(triangleCount * 3);
+	std::vector<GLuint> cache;
+	std::vector<GLuint> nextCache;
+	GLuint firstUnemitted = 0;
+	GLuint best = 0;
+	bool haveBest = false;
+
+	while (output.size() < triangleCount * 3) {
+		if (!haveBest) {
+			while (emitted[firstUnemitted]) {
+				firstUnemitted++;
+			}
+			best = firstUnemitted;
+		}
+
+		const GLuint* triangle = indices + best * 3;
+		emitted[best] = true;
+		nextCache.clear();
+		for (int corner = 0; corner < 3; corner++) {
+			GLuint v = triangle[corner];
+			output.push_back(v);
+
+			// Swap the triangle out of the remaining part of the list
+			GLuint* list = adjacency.data() + offsets[v];
+			GLuint* found = std::find(list, list + remaining[v], best);
+			std::swap(*found, list[remaining[v] - 1]);
+			remaining[v]--;
+
+			if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end()) {
+				nextCache.push_back(v);
+			}
+		}
+
+		// The triangle moves to the front of the cache, the oldest entries drop off the end
+		for (GLuint v : cache) {
+			if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end()) {
+				nextCache.push_back(v);
+			}
+		}
+		for (size_t i = 0; i < nextCache.size(); i++) {
+			cachePosition[nextCache[i]] = (i < ScoringCacheSize) ? static_cast<int>(i) : -1;
+		}
+
+		// Rescore everything that moved and pick the best triangle around the cache
+		haveBest = false;
+		float bestScore = -1.0f;
+		for (GLuint v : nextCache) {
+			float score = ScoreVertex(cachePosition[v], remaining[v]);
+			float change = score - vertexScore[v];
+			vertexScore[v] = score;
+			for (GLuint i = 0; i < remaining[v]; i++) {
+				GLuint t = adjacency[offsets[v] + i];
+				triangleScore[t] += change;
+			}
+		}
+		for (GLuint v : nextCache) {
+			if (cachePosition[v] < 0) {
+				continue;
+			}
+			for (GLuint i = 0; i < remaining[v]; i++) {
+				GLuint t = adjacency[offsets[v] + i];
+				if (triangleScore[t] > bestScore) {
+					bestScore = triangleScore[t];
+					best = t;
+					haveBest = true;
+				}
+			}
+		}
+
+		if (nextCache.size() > ScoringCacheSize) {
+			nextCache.resize(ScoringCacheSize);
+		}
+		cache.swap(nextCache);
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+/***********************************************************************
+ * OptimizeOverdraw: Orders clusters of triangles front to back.
+ * Author: [Smirti Parajuli]
+ * Description: The cache ordered triangles are split wherever the
+ *              simulated cache misses all three vertices, so moving
+ *              the clusters around costs almost nothing in cache hits.
+ *              The clusters facing furthest out from the mesh centre are
+ *              drawn first, those are the ones most likely in front from
+ *              any view, so later clusters fail the depth test sooner.
+ *
+ * Parameters:
+ *   - vertices: floatsPerVertex floats for every vertex, position first.
+ *   - floatsPerVertex: Size of one vertex.
+ *   - vertexCount: Number of vertices.
+ *   - indices: Cache ordered triangle list, rewritten in the new order.
+ *   - indexCount: Number of indices.
+ *
+ * Return: None
+ ***********************************************************************/
+void MeshOptimizer::OptimizeOverdraw(const GLfloat* vertices, GLuint floatsPerVertex, GLuint vertexCount, GLuint* indices, GLuint indexCount)
+{
+	GLuint triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// Cluster starts, from the same FIFO simulation as AnalyzeVertexCache
+	std::vector<GLuint> clusterStarts;
+	std::vector<GLuint> stamp(vertexCount, 0);
+	GLuint time = SimulatedCacheSize + 1;
+	for (GLuint t = 0; t < triangleCount; t++) {
+		int misses = 0;
+		for (int corner = 0; corner < 3; corner++) {
+			GLuint v = indices[t * 3 + corner];
+			if (time - stamp[v] > SimulatedCacheSize) {
+				stamp[v] = time++;
+				misses++;
+			}
+		}
+		if (t == 0 || misses == 3) {
+			clusterStarts.push_back(t);
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+	GLuint clusterCount = static_cast<GLuint>(clusterStarts.size() - 1);
+	if (clusterCount < 2) {
+		return;
+	}
+
+	// Area weighted centre and normal of every cluster and of the whole mesh
+	std::vector<glm::vec3> clusterCentre(clusterCount, glm::vec3(0.0f));
+	std::vector<glm::vec3> clusterNormal(clusterCount, glm::vec3(0.0f));
+	std::vector<float> clusterArea(clusterCount, 0.0f);
+	glm::vec3 meshCentre(0.0f);
+	float meshArea = 0.0f;
+	for (GLuint c = 0; c < clusterCount; c++) {
+		for (GLuint t = clusterStarts[c]; t < clusterStarts[c + 1]; t++) {
+			const GLfloat* a = vertices + indices[t * 3 + 0] * floatsPerVertex;
+			const GLfloat* b = vertices + indices[t * 3 + 1] * floatsPerVertex;
+			const GLfloat* d = vertices + indices[t * 3 + 2] * floatsPerVertex;
+			glm::vec3 p0(a[0], a[1], a[2]);
+			glm::vec3 p1(b[0], b[1], b[2]);
+			glm::vec3 p2(d[0], d[1], d[2]);
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);// Length is twice the area
+			float area = glm::length(normal);
+			clusterCentre[c] += (p0 + p1 + p2) * (area / 3.0f);
+			clusterNormal[c] += normal;
+			clusterArea[c] += area;
+		}
+		meshCentre += clusterCentre[c];
+		meshArea += clusterArea[c];
+	}
+	if (meshArea <= 0.0f) {
+		return;
+	}
+	meshCentre /= meshArea;
+
+	std::vector<float> sortKey(clusterCount, 0.0f);
+	for (GLuint c = 0; c < clusterCount; c++) {
+		float normalLength = glm::length(clusterNormal[c]);
+		if (clusterArea[c] > 0.0f && normalLength > 0.0f) {
+			glm::vec3 centre = clusterCentre[c] / clusterArea[c];
+			sortKey[c] = glm::dot(centre - meshCentre, clusterNormal[c] / normalLength);
+		}
+	}
+
+	std::vector<GLuint> order(clusterCount);
+	for (GLuint c = 0; c < clusterCount; c++) {
+		order[c] = c;
+	}
+	std::stable_sort(order.begin(), order.end(), [&sortKey](GLuint a, GLuint b) { return sortKey[a] > sortKey[b]; });
+
+	std::vector<GLuint> output;
+	output.reserve(triangleCount * 3);
+	for (GLuint c : order) {
+		output.insert(output.end(), indices + clusterStarts[c] * 3, indices + clusterStarts[c + 1] * 3);
+	}
+	std::copy(output.begin(), output.end(), indices);
+}
+
+/***********************************************************************
+ * OptimizeVertexFetch: Reorders the vertices by first use.
+ * Author: [Smirti Parajuli]
+ * Description: Vertices are renumbered in the order the triangles first
+ *              reference them, so pulling them walks the vertex buffer
+ *              mostly forwards. Unused vertices are moved to the end.
+ *
+ * Parameters:
+ *   - vertices: floatsPerVertex floats for every vertex, rewritten.
+ *   - floatsPerVertex: Size of one vertex.
+ *   - vertexCount: Number of vertices.
+ *   - indices: Triangle list indices, renumbered.
+ *   - indexCount: Number of indices.
+ *
+ * Return: None
+ ***********************************************************************/
+void MeshOptimizer::OptimizeVertexFetch(GLfloat* vertices, GLuint floatsPerVertex, GLuint vertexCount, GLuint* indices, GLuint indexCount)
+{
+	const GLuint unassigned = 0xFFFFFFFFu;
+	std::vector<GLuint> remap(vertexCount, unassigned);
+	GLuint next = 0;
+	for (GLuint i = 0; i < indexCount; i++) {
+		if (remap[indices[i]] == unassigned) {
+			remap[indices[i]] = next++;
+		}
+		indices[i] = remap[indices[i]];
+	}
+	for (GLuint v = 0; v < vertexCount; v++) {
+		if (remap[v] == unassigned) {
+			remap[v] = next++;
+		}
+	}
+
+	std::vector<GLfloat> original(vertices, vertices + vertexCount * floatsPerVertex);
+	for (GLuint v = 0; v < vertexCount; v++) {
+		std::copy(original.begin() + v * floatsPerVertex, original.begin() + (v + 1) * floatsPerVertex, vertices + remap[v] * floatsPerVertex);
+	}
+}
+
+/***********************************************************************
+ * AnalyzeVertexCache: Simulates a FIFO post-transform vertex cache.
+ * Author: [Smirti Parajuli]
+ * Description: Each vertex remembers when it entered the cache, it is
+ *              still there while fewer than cacheSize vertices entered
+ *              after it.
+ *
+ * Parameters:
+ *   - indices: Triangle list indices.
+ *   - indexCount: Number of indices.
+ *   - vertexCount: Number of vertices.
+ *   - cacheSize: Entries in the simulated cache.
+ *
+ * Return: The ACMR and ATVR of the index order.
+ ***********************************************************************/
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const GLuint* indices, GLuint indexCount, GLuint vertexCount, GLuint cacheSize)
+{
+	VertexCacheStats stats;
+	std::vector<GLuint> stamp(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	GLuint time = cacheSize + 1;
+	GLuint misses = 0;
+	GLuint usedCount = 0;
+	for (GLuint i = 0; i < indexCount; i++) {
+		GLuint v = indices[i];
+		if (time - stamp[v] > cacheSize) {
+			stamp[v] = time++;
+			misses++;
+		}
+		if (!used[v]) {
+			used[v] = true;
+			usedCount++;
+		}
+	}
+
+	if (indexCount >= 3) {
+		stats.acmr = static_cast<float>(misses) / (indexCount / 3);
+	}
+	if (usedCount > 0) {
+		stats.atvr = static_cast<float>(misses) / usedCount;
+	}
+	return stats;
+}
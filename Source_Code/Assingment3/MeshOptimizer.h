@@ -0,0 +1,52 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :MeshOptimizer.h
+Description :  The MeshOptimizer reorders the triangles and vertices of a
+               mesh before it is copied into the geometry pool:
+               - triangles for the post-transform vertex cache (Forsyth)
+               - clusters of those triangles front to back, less overdraw
+               - vertices in the order the triangles first use them
+               The result is measured with a simulated FIFO vertex cache.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <glew.h>
+#include <vector>
+
+// Results of the vertex cache simulation
+struct VertexCacheStats
+{
+	float acmr = 0.0f;// Average cache miss ratio, transformed vertices per triangle (0.5 to 3)
+	float atvr = 0.0f;// Average transformed vertex ratio, transformed per used vertex (1 is ideal)
+};
+
+class MeshOptimizer
+{
+public:
+	static const GLuint SimulatedCacheSize = 16;// FIFO entries, a typical post-transform cache
+	static const GLuint ScoringCacheSize = 32;// LRU entries the Forsyth scores assume
+
+	// Runs every stage in place and prints the cache statistics before and after
+	static void Optimize(GLfloat* vertices, GLuint floatsPerVertex, GLuint vertexCount, GLuint* indices, GLuint indexCount);
+
+	static void OptimizeVertexCache(GLuint* indices, GLuint indexCount, GLuint vertexCount);
+	static void OptimizeOverdraw(const GLfloat* vertices, GLuint floatsPerVertex, GLuint vertexCount, GLuint* indices, GLuint indexCount);
+	static void OptimizeVertexFetch(GLfloat* vertices, GLuint floatsPerVertex, GLuint vertexCount, GLuint* indices, GLuint indexCount);
+
+	static VertexCacheStats AnalyzeVertexCache(const GLuint* indices, GLuint indexCount, GLuint vertexCount, GLuint cacheSize = SimulatedCacheSize);
+
+private:
+	MeshOptimizer();
+
+	static float ScoreVertex(int cachePosition, GLuint remainingTriangles);
+};
+#endif // MESHOPTIMIZER_H
@@ -0,0 +1,263 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :MeshletBuilder.cpp
+Description :  Implementation of the meshlet split and bounds.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "MeshletBuilder.h"
+#include <algorithm>
+#include <cmath>
+
+/***********************************************************************
+ * Build: Splits a mesh into meshlets.
+ * Author: [Smirti Parajuli]
+ * Description: Each meshlet starts from the first triangle not yet
+ *              taken and grows through triangles sharing its vertices,
+ *              taking the one that adds the fewest new vertices and,
+ *              among those, the one closest to the meshlet and facing
+ *              most like it. Compact patches with similar normals give
+ *              tight spheres and narrow cones, so more of them can be
+ *              culled. The triangles are rewritten in meshlet order,
+ *              keeping their earlier order inside each meshlet, so every
+ *              meshlet is a run of consecutive indices.
+ *
+ * Parameters:
+ *   - vertices: floatsPerVertex floats for every vertex: position,
+ *               texture coordinates, normal.
+ *   - floatsPerVertex: Size of one vertex.
+ *   - vertexCount: Number of vertices.
+ *   - indices: Triangle list indices, rewritten in meshlet order.
+ *   - indexCount: Number of indices.
+ *   - out: Receives one entry per meshlet.
+ *   - maxVertices: Unique vertices per meshlet, at least 3.
+ *
+ * Return: None
+ ***********************************************************************/
+void MeshletBuilder::Build(const GLfloat* vertices, GLuint floatsPerVertex, GLuint vertexCount, GLuint* indices, GLuint indexCount, std::vector<MeshletBounds>& out, GLuint maxVertices)
+{
+	out.clear();
+	GLuint triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+	maxVertices = std::max(maxVertices, 3u);
+	size_t maxTriangles = 2 * maxVertices - 4;
+
+	// Triangles using each vertex
+	std::vector<GLuint> offsets(vertexCount + 1, 0);
+	for (GLuint i = 0; i < triangleCount * 3; i++) {
+		offsets[indices[i] + 1]++;
+	}
+	for (GLuint v = 0; v < vertexCount; v++) {
+		offsets[v + 1] += offsets[v];
+	}
+	std::vector<GLuint> adjacency(triangleCount * 3);
+	std::vector<GLuint> cursor(offsets.begin(), offsets.end() - 1);
+	for (GLuint i = 0; i < triangleCount * 3; i++) {
+		adjacency[cursor[indices[i]]++] = i / 3;
+	}
+
+	// Centre and unit normal of every triangle
+	std::vector<glm::vec3> centres(triangleCount);
+	std::vector<glm::vec3> normals(triangleCount);
+	for (GLuint t = 0; t < triangleCount; t++) {
+		const GLfloat* a = vertices + indices[t * 3] * floatsPerVertex;
+		const GLfloat* b = vertices + indices[t * 3 + 1] * floatsPerVertex;
+		const GLfloat* c = vertices + indices[t * 3 + 2] * floatsPerVertex;
+		glm::vec3 p0(a[0], a[1], a[2]);
+		glm::vec3 p1(b[0], b[1], b[2]);
+		glm::vec3 p2(c[0], c[1], c[2]);
+		centres[t] = (p0 + p1 + p2) / 3.0f;
+		normals[t] = FaceNormal(a, b, c);
+	}
+
+	std::vector<bool> taken(triangleCount, false);
+	std::vector<GLuint> owner(vertexCount, 0);// Meshlet number plus one of the latest meshlet using each vertex
+	std::vector<GLuint> meshletTriangles;
+	std::vector<GLuint> meshletVertices;
+	std::vector<GLuint> output;
+	output.reserve(triangleCount * 3);
+	GLuint firstFree = 0;
+	GLuint meshletNumber = 0;
+
+	while (firstFree < triangleCount) {
+		meshletNumber++;
+		meshletTriangles.clear();
+		meshletVertices.clear();
+		glm::vec3 centreSum(0.0f);
+		glm::vec3 normalSum(0.0f);
+		GLuint next = firstFree;
+
+		while (true) {
+			// Take the chosen triangle
+			taken[next] = true;
+			meshletTriangles.push_back(next);
+			for (int corner = 0; corner < 3; corner++) {
+				GLuint v = indices[next * 3 + corner];
+				if (owner[v] != meshletNumber) {
+					owner[v] = meshletNumber;
+					meshletVertices.push_back(v);
+				}
+			}
+			centreSum += centres[next];
+			normalSum += normals[next];
+			if (meshletTriangles.size() == maxTriangles) {
+				break;
+			}
+
+			// Best neighbour that still fits
+			glm::vec3 centre = centreSum / static_cast<float>(meshletTriangles.size());
+			float normalLength = glm::length(normalSum);
+			glm::vec3 axis = (normalLength > 0.0f) ? normalSum / normalLength : glm::vec3(0.0f);
+			bool found = false;
+			GLuint bestNew = 4;
+			float bestScore = 0.0f;
+			for (GLuint v : meshletVertices) {
+				for (GLuint i = offsets[v]; i < offsets[v + 1]; i++) {
+					GLuint t = adjacency[i];
+					if (taken[t]) {
+						continue;
+					}
+					GLuint newVertices = 0;
+					for (int corner = 0; corner < 3; corner++) {
+						GLuint cornerVertex = indices[t * 3 + corner];
+						bool repeated = (corner > 0 && cornerVertex == indices[t * 3]) || (corner > 1 && cornerVertex == indices[t * 3 + 1]);
+						if (owner[cornerVertex] != meshletNumber && !repeated) {
+							newVertices++;
+						}
+					}
+					if (meshletVertices.size() + newVertices > maxVertices) {
+						continue;
+					}
+					float score = glm::length(centres[t] - centre) * (2.0f - glm::dot(normals[t], axis));
+					if (!found || newVertices < bestNew || (newVertices == bestNew && score < bestScore)) {
+						found = true;
+						bestNew = newVertices;
+						bestScore = score;
+						next = t;
+					}
+				}
+			}
+			if (!found) {
+				break;
+			}
+		}
+
+		// Earlier order inside the meshlet, it was already arranged for the vertex cache
+		std::sort(meshletTriangles.begin(), meshletTriangles.end());
+		GLuint firstIndex = static_cast<GLuint>(output.size());
+		for (GLuint t : meshletTriangles) {
+			output.insert(output.end(), indices + t * 3, indices + t * 3 + 3);
+		}
+		out.push_back(ComputeBounds(vertices, floatsPerVertex, output.data(), firstIndex, static_cast<GLuint>(meshletTriangles.size() * 3)));
+
+		while (firstFree < triangleCount && taken[firstFree]) {
+			firstFree++;
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+/***********************************************************************
+ * FaceNormal: Unit normal of one triangle.
+ * Author: [Smirti Parajuli]
+ * Description: The vertex normals decide which side is the front,
+ *              whatever the winding of the triangle.
+ *
+ * Parameters:
+ *   - a, b, c: The three vertices: position, texture coordinates, normal.
+ *
+ * Return: The normal, zero for a triangle without an area.
+ ***********************************************************************/
+glm::vec3 MeshletBuilder::FaceNormal(const GLfloat* a, const GLfloat* b, const GLfloat* c)
+{
+	glm::vec3 p0(a[0], a[1], a[2]);
+	glm::vec3 normal = glm::cross(glm::vec3(b[0], b[1], b[2]) - p0, glm::vec3(c[0], c[1], c[2]) - p0);
+	glm::vec3 shading(a[5] + b[5] + c[5], a[6] + b[6] + c[6], a[7] + b[7] + c[7]);
+	if (glm::dot(normal, shading) < 0.0f) {
+		normal = -normal;
+	}
+	float length = glm::length(normal);
+	return (length > 1e-12f) ? normal / length : glm::vec3(0.0f);
+}
+
+/***********************************************************************
+ * ComputeBounds: Bounding sphere and normal cone of one meshlet.
+ * Author: [Smirti Parajuli]
+ * Description: The sphere is centred on the bounding box. The cone axis
+ *              is the average triangle normal, and the cutoff is the sine
+ *              of the widest angle between a normal and the axis: looking
+ *              down the axis within that many degrees of it sees every
+ *              triangle from behind. Cones wider than about 84 degrees are
+ *              never culled.
+ *
+ * Parameters:
+ *   - vertices: floatsPerVertex floats for every vertex: position,
+ *               texture coordinates, normal.
+ *   - floatsPerVertex: Size of one vertex.
+ *   - indices: Triangle list indices of the whole mesh.
+ *   - firstIndex: First index of the meshlet.
+ *   - indexCount: Number of indices in the meshlet.
+ *
+ * Return: The meshlet bounds and index range.
+ ***********************************************************************/
+MeshletBounds MeshletBuilder::ComputeBounds(const GLfloat* vertices, GLuint floatsPerVertex, const GLuint* indices, GLuint firstIndex, GLuint indexCount)
+{
+	const GLuint* meshletIndices = indices + firstIndex;
+	glm::vec3 low(vertices[meshletIndices[0] * floatsPerVertex], vertices[meshletIndices[0] * floatsPerVertex + 1], vertices[meshletIndices[0] * floatsPerVertex + 2]);
+	glm::vec3 high = low;
+	for (GLuint i = 1; i < indexCount; i++) {
+		const GLfloat* position = vertices + meshletIndices[i] * floatsPerVertex;
+		for (int axis = 0; axis < 3; axis++) {
+			low[axis] = std::min(low[axis], position[axis]);
+			high[axis] = std::max(high[axis], position[axis]);
+		}
+	}
+	glm::vec3 centre = (low + high) * 0.5f;
+	float radius = 0.0f;
+	for (GLuint i = 0; i < indexCount; i++) {
+		const GLfloat* position = vertices + meshletIndices[i] * floatsPerVertex;
+		radius = std::max(radius, glm::length(glm::vec3(position[0], position[1], position[2]) - centre));
+	}
+
+	// Unit normals of the triangles with an area, degenerate ones face nowhere
+	std::vector<glm::vec3> normals;
+	normals.reserve(indexCount / 3);
+	glm::vec3 axis(0.0f);
+	for (GLuint i = 0; i + 2 < indexCount; i += 3) {
+		glm::vec3 normal = FaceNormal(vertices + meshletIndices[i] * floatsPerVertex, vertices + meshletIndices[i + 1] * floatsPerVertex, vertices + meshletIndices[i + 2] * floatsPerVertex);
+		if (normal != glm::vec3(0.0f)) {
+			normals.push_back(normal);
+			axis += normal;
+		}
+	}
+
+	float cutoff = 2.0f;
+	float axisLength = glm::length(axis);
+	if (axisLength > 0.0f) {
+		axis /= axisLength;
+		float minimumDot = 1.0f;
+		for (const glm::vec3& normal : normals) {
+			minimumDot = std::min(minimumDot, glm::dot(normal, axis));
+		}
+		if (minimumDot > 0.1f) {
+			cutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+		}
+	}
+	else {
+		axis = glm::vec3(0.0f, 0.0f, 1.0f);
+	}
+
+	MeshletBounds bounds;
+	bounds.sphere = glm::vec4(centre, radius);
+	bounds.cone = glm::vec4(axis, cutoff);
+	bounds.range = glm::uvec4(firstIndex, indexCount, 0u, 0u);
+	return bounds;
+}
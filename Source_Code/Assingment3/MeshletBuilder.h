@@ -0,0 +1,40 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :MeshletBuilder.h
+Description :  The MeshletBuilder splits the triangles of a mesh into small
+               clusters (meshlets) with a bounding sphere and a cone around
+               their triangle normals, so whole clusters that are off screen
+               or facing away from the camera can be skipped before any of
+               their vertices are shaded.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef MESHLETBUILDER_H
+#define MESHLETBUILDER_H
+
+#include <glew.h>
+#include <vector>
+#include "ShaderBindings.h"
+
+class MeshletBuilder
+{
+public:
+	static const GLuint DefaultVertices = 64;// Unique vertices per meshlet, 124 triangles
+
+	// Groups the triangles into meshlets and reorders them so each meshlet is a run of consecutive indices
+	// A grid patch of n vertices has about 2n - 4 triangles, which limits the triangles per meshlet
+	static void Build(const GLfloat* vertices, GLuint floatsPerVertex, GLuint vertexCount, GLuint* indices, GLuint indexCount, std::vector<MeshletBounds>& out, GLuint maxVertices = DefaultVertices);
+
+private:
+	MeshletBuilder();
+
+	static glm::vec3 FaceNormal(const GLfloat* a, const GLfloat* b, const GLfloat* c);
+	static MeshletBounds ComputeBounds(const GLfloat* vertices, GLuint floatsPerVertex, const GLuint* indices, GLuint firstIndex, GLuint indexCount);
+};
+#endif // MESHLETBUILDER_H
@@ -0,0 +1,178 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :MeshletCuller.cpp
+Description :  Implementation of the GPU meshlet culling pass.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "MeshletCuller.h"
+#include "ShaderLoader.h"
+#include "GLState.h"
+#include "GeometryPool.h"
+#include "Frustum.h"
+
+/***********************************************************************
+ * MeshletCuller: Constructor for the MeshletCuller class.
+ * Author: [Smirti Parajuli]
+ * Description: Nothing is created until Create is given a mesh.
+ *
+ * Parameters: None
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+MeshletCuller::MeshletCuller()
+{
+}
+
+/***********************************************************************
+ * ~MeshletCuller: Destructor for the MeshletCuller class.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None (destructor)
+ ***********************************************************************/
+MeshletCuller::~MeshletCuller()
+{
+	glDeleteBuffers(1, &meshletBuffer);
+	glDeleteBuffers(1, &drawBuffer);
+	glDeleteBuffers(1, &visibleBuffer);
+	glDeleteProgram(program);
+}
+
+/***********************************************************************
+ * Create: Builds the buffers for one mesh.
+ * Author: [Smirti Parajuli]
+ * Description: The meshlet bounds never change, so they are uploaded
+ *              once. The mesh must outlive the culler.
+ *
+ * Parameters:
+ *   - mesh: A mesh built with meshlets.
+ *   - maxInstances: The most instances a single Cull may test.
+ *
+ * Return: None
+ ***********************************************************************/
+void MeshletCuller::Create(const Mesh& mesh, GLuint maxInstances)
+{
+	program = ShaderLoader::CreateComputeProgram("Resources/Shaders/MeshletCull.comp");
+	planesLocation = glGetUniformLocation(program, "frustumPlanes");
+	instanceCountLocation = glGetUniformLocation(program, "instanceCount");
+	meshletCountLocation = glGetUniformLocation(program, "meshletCount");
+	instanceStrideLocation = glGetUniformLocation(program, "instanceStride");
+	animatedLocation = glGetUniformLocation(program, "animated");
+
+	this->mesh = &mesh;
+	meshletCount = static_cast<GLuint>(mesh.meshlets.size());
+	this->maxInstances = (maxInstances > 0) ? maxInstances : 1;
+	if (meshletCount == 0) {
+		return;
+	}
+	UpdateDraws();
+
+	glGenBuffers(1, &meshletBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, meshletBuffer);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(MeshletBounds) * meshletCount, mesh.meshlets.data(), 0);
+	glGenBuffers(1, &drawBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, drawBuffer);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(DrawElementsCommand) * meshletCount, emptyDraws.data(), GL_DYNAMIC_STORAGE_BIT);
+	glGenBuffers(1, &visibleBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, visibleBuffer);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * meshletCount * this->maxInstances, nullptr, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MeshletDataBinding, meshletBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MeshletDrawBinding, drawBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MeshletVisibleBinding, visibleBuffer);
+
+	glProgramUniform1ui(program, meshletCountLocation, meshletCount);
+	glProgramUniform1ui(program, instanceStrideLocation, this->maxInstances);
+}
+
+/***********************************************************************
+ * Cull: Runs the culling pass.
+ * Author: [Smirti Parajuli]
+ * Description: The instance counts are reset, then one invocation per
+ *              instance and meshlet appends the instance to the meshlet's
+ *              list if it survives. The barrier makes the counts visible
+ *              to the indirect draws queued after this.
+ *
+ * Parameters:
+ *   - viewProjection: projection * view of the camera.
+ *   - instanceCount: Instances to test, at most the Create limit.
+ *   - animated: Read the instance animation instead of the transforms.
+ *
+ * Return: None
+ ***********************************************************************/
+void MeshletCuller::Cull(const glm::mat4& viewProjection, GLuint instanceCount, bool animated)
+{
+	if (!IsReady()) {
+		return;
+	}
+	if (instanceCount > maxInstances) {
+		instanceCount = maxInstances;
+	}
+
+	if (poolGeneration != GeometryPool::Get().GetGeneration()) {
+		UpdateDraws();
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, drawBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, 0, sizeof(DrawElementsCommand) * meshletCount, emptyDraws.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	Frustum frustum(viewProjection);
+	glProgramUniform4fv(program, planesLocation, 6, &frustum.planes[0].x);
+	glProgramUniform1ui(program, instanceCountLocation, instanceCount);
+	glProgramUniform1i(program, animatedLocation, animated ? 1 : 0);
+
+	GLState::Get().UseProgram(program);
+	glDispatchCompute((instanceCount * meshletCount + GroupSize - 1) / GroupSize, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+/***********************************************************************
+ * UpdateDraws: Builds the empty indirect draws.
+ * Author: [Smirti Parajuli]
+ * Description: Each draw covers one meshlet's indices and carries the
+ *              mesh handle as its base instance, like every other draw
+ *              from the geometry pool. Redone whenever the pool has
+ *              moved its meshes.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void MeshletCuller::UpdateDraws()
+{
+	MeshRange range = mesh->GetRange();
+	indexType = range.indexType;
+	GLuint indexSize = (indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+	emptyDraws.resize(meshletCount);
+	for (GLuint i = 0; i < meshletCount; i++) {
+		emptyDraws[i].count = mesh->meshlets[i].range.y;
+		emptyDraws[i].instanceCount = 0;
+		emptyDraws[i].firstIndex = range.indexOffset / indexSize + mesh->meshlets[i].range.x;
+		emptyDraws[i].baseVertex = 0;
+		emptyDraws[i].baseInstance = range.mesh;
+	}
+	poolGeneration = GeometryPool::Get().GetGeneration();
+}
+
+/***********************************************************************
+ * SetGeometry: Points a draw packet at the culled meshlets.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - packet: The packet to fill in.
+ *
+ * Return: None
+ ***********************************************************************/
+void MeshletCuller::SetGeometry(DrawPacket& packet) const
+{
+	packet.vertexArray = GeometryPool::Get().GetVAO();
+	packet.indexType = indexType;
+	packet.indirectBuffer = drawBuffer;
+	packet.drawCount = static_cast<GLsizei>(meshletCount);
+}
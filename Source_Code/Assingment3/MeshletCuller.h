@@ -0,0 +1,76 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :MeshletCuller.h
+Description :  The MeshletCuller draws the instances of one mesh meshlet by
+               meshlet. A compute pass tests every meshlet of every instance
+               against the view frustum and its normal cone, and writes one
+               indirect draw per meshlet with the instances that kept it.
+               Meshlets that are off screen or facing away from the camera
+               never reach the vertex shader.
+               Its buffers stay bound to the meshlet binding points, so there
+               is one culler for the application.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef MESHLETCULLER_H
+#define MESHLETCULLER_H
+
+#include <glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "Mesh.h"
+#include "RenderQueue.h"
+#include "ShaderBindings.h"
+
+class MeshletCuller
+{
+public:
+	MeshletCuller();
+	~MeshletCuller();
+
+	// Uploads the meshlets of mesh, maxInstances is the most instances one Cull may test
+	void Create(const Mesh& mesh, GLuint maxInstances);
+
+	// Culls the instances bound at InstanceDataBinding, or InstanceAnimationBinding when animated
+	// The FrameData block must already be bound, it gives the camera and the animation time
+	void Cull(const glm::mat4& viewProjection, GLuint instanceCount, bool animated);
+
+	// Points a draw packet at the indirect draws of the latest Cull
+	void SetGeometry(DrawPacket& packet) const;
+
+	GLuint GetInstanceStride() const { return maxInstances; }// Room for instances in each visible list
+	bool IsReady() const { return program != 0 && meshletCount > 0; }
+
+	// Copying and assignment not allowed for this class
+	MeshletCuller(const MeshletCuller&) = delete;
+	MeshletCuller& operator=(const MeshletCuller&) = delete;
+
+private:
+	static const GLuint GroupSize = 64;// local_size_x of MeshletCull.comp
+
+	GLuint program = 0;
+	GLint planesLocation = -1;
+	GLint instanceCountLocation = -1;
+	GLint meshletCountLocation = -1;
+	GLint instanceStrideLocation = -1;
+	GLint animatedLocation = -1;
+
+	GLuint meshletBuffer = 0;// MeshletBounds, bound at MeshletDataBinding
+	GLuint drawBuffer = 0;// DrawElementsCommand, bound at MeshletDrawBinding and as the indirect buffer
+	GLuint visibleBuffer = 0;// maxInstances entries per meshlet, bound at MeshletVisibleBinding
+	std::vector<DrawElementsCommand> emptyDraws;// Every draw with no instances, copied in before each pass
+	const Mesh* mesh = nullptr;
+	unsigned int poolGeneration = 0;// Pool generation the first indices of emptyDraws were taken from
+
+	void UpdateDraws();// Points emptyDraws at the current range of the mesh
+	GLuint meshletCount = 0;
+	GLuint maxInstances = 0;
+	GLenum indexType = GL_UNSIGNED_INT;
+};
+#endif // MESHLETCULLER_H
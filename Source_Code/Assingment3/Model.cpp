@@ -0,0 +1,302 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :Model.cpp
+Description :  Implementation of the Model class.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "Model.h"
+#include "MeshImporter.h"
+#include "AssetPack.h"
+#include "ShaderBindings.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <iostream>
+
+/***********************************************************************
+ * Model: Constructor for the Model class.
+ * Author: [Smirti Parajuli]
+ * Description: Queues the load as a job and returns straight away. The
+ *              texture is decoded as a job of its own, the files do not
+ *              carry materials that are read.
+ * Parameters:
+ *   - path: The .obj, .gltf or .glb file, empty for no model.
+ *   - texturePath: The image drawn on the model.
+ *   - jobs: The job system the load runs on.
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+Model::Model(const std::string& path, const std::string& texturePath, JobSystem& jobs)
+	: path(path), jobs(path.empty() ? nullptr : &jobs)
+{
+	if (!path.empty()) {
+		texture = new Texture(texturePath, jobs);
+		jobs.Run(loadCounter, [this] { Load(); });
+	}
+}
+
+/***********************************************************************
+ * ~Model: Destructor for the Model class.
+ * Author: [Smirti Parajuli]
+ * Description: A load still running is waited for, it writes into this
+ *              object.
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+Model::~Model()
+{
+	if (jobs != nullptr) {
+		jobs->Wait(loadCounter);
+	}
+	delete mesh;
+	delete texture;
+}
+
+/***********************************************************************
+ * Load: Maps the cooked mesh, cooking it first when needed.
+ * Author: [Smirti Parajuli]
+ * Description: A cooked mesh in the asset pack or a cooked file, matching
+ *              the size and time of the source if it exists, is used as
+ *              it is. Otherwise the source is imported and cooked
+ *              and the result written next to it, then mapped like a warm
+ *              start would. If it cannot be written the cooked mesh in
+ *              memory is used instead.
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void Model::Load()
+{
+	auto start = std::chrono::steady_clock::now();
+	FileStamp source = MappedFile::GetStamp(path);
+	std::string cookedPath = MeshCache::GetCookedPath(path);
+
+	// The asset pack lives as long as the application, so its mesh is used in place
+	const unsigned char* packed = nullptr;
+	size_t packedSize = 0;
+	if (AssetPack::Get().Find(path, AssetType::Mesh, packed, packedSize) && MeshCache::Read(packed, packedSize, source, view)) {
+		viewReady = true;
+		fromCache = true;
+	}
+	else if (source.size != 0 && cookedFile.Open(cookedPath) && MeshCache::Read(cookedFile, source, view)) {
+		viewReady = true;
+		fromCache = true;
+	}
+	else {
+		cookedFile.Close();
+		ImportedMesh imported;
+		if (MeshImporter::Import(path, imported)) {
+			MeshImporter::Cook(imported, cooked);
+			if (MeshCache::Write(cookedPath, cooked, source) && cookedFile.Open(cookedPath) && MeshCache::Read(cookedFile, source, view)) {
+				cooked = CookedMesh();
+			}
+			else {
+				cookedFile.Close();
+				view = MeshCache::View(cooked);
+			}
+			viewReady = true;
+		}
+	}
+	loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/***********************************************************************
+ * FinishLoad: Completes the load started by the constructor.
+ * Author: [Smirti Parajuli]
+ * Description: Waits for the load job, running other jobs meanwhile, and
+ *              copies the mesh from the mapping into the geometry pool.
+ *              The mapping is released afterwards. The model is scaled to
+ *              DisplayRadius around the origin.
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void Model::FinishLoad()
+{
+	if (jobs == nullptr) {
+		return;
+	}
+	texture->FinishLoad();
+	jobs->Wait(loadCounter);
+	jobs = nullptr;
+	if (!viewReady) {
+		std::cout << "Model not loaded: " << path << std::endl;
+		return;
+	}
+
+	mesh = new Mesh(view);
+	if (mesh->handle == GeometryPool::InvalidMesh) {
+		delete mesh;
+		mesh = nullptr;
+	}
+	else {
+		std::cout << "Model " << path << (fromCache ? " mapped from cache" : " imported and cooked") << " in "
+			<< loadMilliseconds << " ms: " << view.data.vertexCount << " vertices, " << view.lodCount << " levels of detail" << std::endl;
+		scale = (view.bounds.w > 0.0f) ? DisplayRadius / view.bounds.w : 1.0f;
+		model = glm::scale(glm::mat4(1.0f), glm::vec3(scale)) * glm::translate(glm::mat4(1.0f), -glm::vec3(view.bounds));
+		normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(model))));
+		centre = glm::vec3(model * glm::vec4(glm::vec3(view.bounds), 1.0f));
+	}
+	view = CookedMeshView();
+	cookedFile.Close();
+	cooked = CookedMesh();
+}
+
+/***********************************************************************
+ * SelectLod: Picks the level of detail for this frame.
+ * Author: [Smirti Parajuli]
+ * Description: The error of each level is projected at the distance of
+ *              the model and the coarsest one under LodScreenError wins.
+ * Parameters:
+ *   - frame: The snapshot built by the simulation thread.
+ *
+ * Return: unsigned int - The level, 0 is the full mesh.
+ ***********************************************************************/
+unsigned int Model::SelectLod(const FrameSnapshot& frame) const
+{
+	if (mesh == nullptr || mesh->lods.empty()) {
+		return 0;
+	}
+	float distance = glm::length(centre - frame.cameraPosition) - DisplayRadius;
+	if (distance <= 0.0f) {
+		return 0;
+	}
+	// projection[1][1] turns a view space height into a share of the half screen
+	float toScreen = scale * frame.projection[1][1] * 0.5f / distance;
+	unsigned int lod = 0;
+	for (unsigned int i = 1; i < mesh->lods.size(); ++i) {
+		if (mesh->lods[i].error * toScreen <= LodScreenError) {
+			lod = i;
+		}
+	}
+	return lod;
+}
+
+/***********************************************************************
+ * Submit: Queues the model.
+ * Author: [Smirti Parajuli]
+ * Description: Writes its one instance transform into the stream buffer
+ *              and queues the chosen level of detail with the instanced
+ *              lighting program.
+ * Parameters:
+ *   - queue: The render queue for this frame.
+ *   - frame: The snapshot built by the simulation thread.
+ *   - program: A program reading InstanceData, like the Blinn-Phong one.
+ *   - depthProgram: program's vertex shader with DepthOnly.fs.
+ *   - gbufferProgram: program's vertex shader with GBuffer.fs.
+ *   - stream: The stream buffer for this frame.
+ *
+ * Return: None
+ ***********************************************************************/
+void Model::Submit(RenderQueue& queue, const FrameSnapshot& frame, GLuint program, GLuint depthProgram, GLuint gbufferProgram, StreamBuffer& stream) const
+{
+	if (mesh == nullptr) {
+		return;
+	}
+	GLintptr offset = 0;
+	InstanceTransform* instance = stream.Allocate<InstanceTransform>(offset);
+	if (!instance) {
+		return;
+	}
+	instance->model = model;
+	instance->normalMatrix = normalMatrix;
+	instance->pvm = frame.projection * frame.view * model;
+
+	DrawPacket packet;
+	packet.program = program;
+	packet.depthProgram = depthProgram;
+	packet.gbufferProgram = gbufferProgram;
+	mesh->SetGeometry(packet, SelectLod(frame));
+	packet.texture = texture->GetID();
+	packet.rangeTarget = GL_SHADER_STORAGE_BUFFER;
+	packet.rangeIndex = InstanceDataBinding;
+	packet.rangeBuffer = stream.GetID();
+	packet.rangeOffset = offset;
+	packet.rangeSize = sizeof(InstanceTransform);
+
+	float distance = glm::max(glm::length(centre - frame.cameraPosition) - DisplayRadius, 0.0f);
+	packet.key = RenderQueue::MakeKey(RenderPass::Opaque, packet.program, packet.texture, packet.vertexArray, distance / frame.farPlane);
+	queue.Submit(packet);
+}
+
+/***********************************************************************
+ * SubmitShadowCaster: Queues the model as a shadow caster.
+ * Author: [Smirti Parajuli]
+ * Description: The model never moves, so it is a static caster and is
+ *              only queued on the frames a static tile is drawn. Its
+ *              matrix never changes either, so the static keys can leave
+ *              it out. The full detail level is drawn into every view.
+ * Parameters:
+ *   - atlas: The shadow atlas, after its BeginFrame.
+ *   - stream: The stream buffer for this frame.
+ *
+ * Return: None
+ ***********************************************************************/
+void Model::SubmitShadowCaster(ShadowAtlas& atlas, StreamBuffer& stream) const
+{
+	if (mesh == nullptr || !atlas.NeedsStaticCasters()) {
+		return;
+	}
+	GLintptr offset = 0;
+	glm::mat4* caster = stream.Allocate<glm::mat4>(offset);
+	if (!caster) {
+		return;
+	}
+	*caster = model;
+
+	DrawPacket packet;
+	packet.program = atlas.GetCasterProgram();
+	packet.depthProgram = packet.program;
+	mesh->SetGeometry(packet);
+	packet.rangeTarget = GL_SHADER_STORAGE_BUFFER;
+	packet.rangeIndex = InstanceDataBinding;
+	packet.rangeBuffer = stream.GetID();
+	packet.rangeOffset = offset;
+	packet.rangeSize = sizeof(glm::mat4);
+	packet.key = RenderQueue::MakeKey(RenderPass::Opaque, packet.program, 0, packet.vertexArray, 0.0f);
+	atlas.GetStaticCasters().Submit(packet);
+}
+
+/***********************************************************************
+ * SubmitToProbes: Queues the model for the reflection probe faces.
+ * Author: [Smirti Parajuli]
+ * Description: The model never moves, so the face keys leave it out,
+ *              like the static shadow keys do. It is drawn at full
+ *              detail with its texture, lit like the spheres.
+ * Parameters:
+ *   - probes: The reflection probes, after their BeginFrame.
+ *   - stream: The stream buffer for this frame.
+ *
+ * Return: None
+ ***********************************************************************/
+void Model::SubmitToProbes(ReflectionProbes& probes, StreamBuffer& stream) const
+{
+	if (mesh == nullptr || !probes.NeedsScene()) {
+		return;
+	}
+	GLintptr offset = 0;
+	glm::mat4* instance = stream.Allocate<glm::mat4>(offset);
+	if (!instance) {
+		return;
+	}
+	*instance = model;
+
+	DrawPacket packet;
+	packet.program = probes.GetSceneProgram();
+	packet.depthProgram = packet.program;
+	mesh->SetGeometry(packet);
+	packet.texture = texture->GetID();
+	packet.rangeTarget = GL_SHADER_STORAGE_BUFFER;
+	packet.rangeIndex = InstanceDataBinding;
+	packet.rangeBuffer = stream.GetID();
+	packet.rangeOffset = offset;
+	packet.rangeSize = sizeof(glm::mat4);
+	packet.key = RenderQueue::MakeKey(RenderPass::Opaque, packet.program, packet.texture, packet.vertexArray, 0.0f);
+	probes.GetScene().Submit(packet);
+}
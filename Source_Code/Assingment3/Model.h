@@ -0,0 +1,79 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :Model.h
+Description :  A Model is a mesh loaded from an OBJ or glTF file. Loading
+               runs as a job: a current cooked file is only mapped, anything
+               else is imported, cooked and written back for the next run.
+               FinishLoad then hands the mapped data to the geometry pool
+               on the GL thread. Each frame the coarsest level of detail
+               whose error stays under LodScreenError is drawn.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef MODEL_H
+#define MODEL_H
+
+#include <glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "Mesh.h"
+#include "Texture.h"
+#include "FrameSnapshot.h"
+#include "RenderQueue.h"
+#include "StreamBuffer.h"
+#include "ShadowAtlas.h"
+#include "ReflectionProbes.h"
+
+class Model
+{
+public:
+	static constexpr float LodScreenError = 0.002f;// Share of the screen height a vertex of the drawn level may be off by
+	static constexpr float DisplayRadius = 2.0f;// Models are scaled to this radius around the origin
+
+	// Starts loading as a job, an empty path loads nothing
+	Model(const std::string& path, const std::string& texturePath, JobSystem& jobs);
+	~Model();
+
+	void FinishLoad();// Waits for the load job and uploads the mesh, GL thread only
+	bool IsLoaded() const { return mesh != nullptr; }
+	unsigned int SelectLod(const FrameSnapshot& frame) const;
+	void Submit(RenderQueue& queue, const FrameSnapshot& frame, GLuint program, GLuint depthProgram, GLuint gbufferProgram, StreamBuffer& stream) const;
+	void SubmitShadowCaster(ShadowAtlas& atlas, StreamBuffer& stream) const;// Queued with the static casters when the atlas redraws them
+	void SubmitToProbes(ReflectionProbes& probes, StreamBuffer& stream) const;// Queued with the probe scene when a face is drawn
+
+	// Copying and assignment not allowed for this class
+	Model(const Model&) = delete;
+	Model& operator=(const Model&) = delete;
+
+private:
+	void Load();// Maps or cooks the mesh, safe to run on any thread
+
+	std::string path;
+	JobSystem* jobs;// Set while the load job may still be running
+	JobCounter loadCounter;
+	Texture* texture = nullptr;// Only created along with a model
+
+	// Written by the load job, read by FinishLoad
+	MappedFile cookedFile;
+	CookedMesh cooked;// Used when the cooked file could not be written
+	CookedMeshView view;
+	bool viewReady = false;
+	bool fromCache = false;
+	double loadMilliseconds = 0.0;
+
+	Mesh* mesh = nullptr;
+	glm::mat4 model = glm::mat4(1.0f);
+	glm::mat4 normalMatrix = glm::mat4(1.0f);
+	glm::vec3 centre = glm::vec3(0.0f);// World space centre of the bounding sphere
+	float scale = 1.0f;
+};
+#endif // MODEL_H
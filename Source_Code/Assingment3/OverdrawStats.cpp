@@ -0,0 +1,154 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :OverdrawStats.cpp
+Description :  Implementation of the fragment and GPU time statistics of
+               the opaque passes.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "OverdrawStats.h"
+
+/***********************************************************************
+ * OverdrawStats: Constructor for the OverdrawStats class.
+ * Author: [Smirti Parajuli]
+ * Description: Creates a fragment and a time query per pass for every
+ *              frame that may be in flight.
+ * Parameters: None
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+OverdrawStats::OverdrawStats()
+{
+	for (int i = 0; i < FrameCount; i++) {
+		for (int pass = 0; pass < PassCount; pass++) {
+			glGenQueries(1, &queries[i][pass].fragments);
+			glGenQueries(1, &queries[i][pass].time);
+		}
+	}
+}
+
+/***********************************************************************
+ * ~OverdrawStats: Destructor for the OverdrawStats class.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None (destructor)
+ ***********************************************************************/
+OverdrawStats::~OverdrawStats()
+{
+	for (int i = 0; i < FrameCount; i++) {
+		for (int pass = 0; pass < PassCount; pass++) {
+			glDeleteQueries(1, &queries[i][pass].fragments);
+			glDeleteQueries(1, &queries[i][pass].time);
+		}
+	}
+}
+
+/***********************************************************************
+ * BeginFrame: Moves to the queries of the next frame.
+ * Author: [Smirti Parajuli]
+ * Description: Those queries were last used FrameCount frames ago. Their
+ *              results are added to the totals when the GPU has them,
+ *              otherwise that frame is left out rather than waited for.
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void OverdrawStats::BeginFrame()
+{
+	frame = (frame + 1) % FrameCount;
+	for (int pass = 0; pass < PassCount; pass++) {
+		Queries& query = queries[frame][pass];
+		if (!query.pending) {
+			continue;
+		}
+		query.pending = false;
+
+		GLuint fragmentsReady = GL_FALSE;
+		GLuint timeReady = GL_FALSE;
+		glGetQueryObjectuiv(query.fragments, GL_QUERY_RESULT_AVAILABLE, &fragmentsReady);
+		glGetQueryObjectuiv(query.time, GL_QUERY_RESULT_AVAILABLE, &timeReady);
+		if (!fragmentsReady || !timeReady) {
+			continue;
+		}
+		GLuint64 fragments = 0;
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(query.fragments, GL_QUERY_RESULT, &fragments);
+		glGetQueryObjectui64v(query.time, GL_QUERY_RESULT, &nanoseconds);
+		fragmentTotals[pass] += static_cast<double>(fragments);
+		millisecondTotals[pass] += static_cast<double>(nanoseconds) * 1e-6;
+		frameTotals[pass]++;
+	}
+}
+
+/***********************************************************************
+ * Begin: Starts measuring a pass.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - pass: The pass about to be drawn, once per frame.
+ *
+ * Return: None
+ ***********************************************************************/
+void OverdrawStats::Begin(StatsPass pass)
+{
+	Queries& query = queries[frame][static_cast<int>(pass)];
+	glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS, query.fragments);
+	glBeginQuery(GL_TIME_ELAPSED, query.time);
+}
+
+/***********************************************************************
+ * End: Stops measuring a pass.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - pass: The pass given to Begin.
+ *
+ * Return: None
+ ***********************************************************************/
+void OverdrawStats::End(StatsPass pass)
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS);
+	queries[frame][static_cast<int>(pass)].pending = true;
+}
+
+/***********************************************************************
+ * GetAverage: Gets the per frame cost of a pass.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - pass: The pass to report.
+ *
+ * Return: PassStats - Averages over the frames read since ResetStats,
+ *         all zero when none measured the pass.
+ ***********************************************************************/
+PassStats OverdrawStats::GetAverage(StatsPass pass) const
+{
+	int index = static_cast<int>(pass);
+	PassStats stats;
+	stats.frames = frameTotals[index];
+	if (stats.frames > 0) {
+		stats.fragments = fragmentTotals[index] / stats.frames;
+		stats.gpuMilliseconds = millisecondTotals[index] / stats.frames;
+	}
+	return stats;
+}
+
+/***********************************************************************
+ * ResetStats: Starts a new reporting window.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void OverdrawStats::ResetStats()
+{
+	for (int pass = 0; pass < PassCount; pass++) {
+		fragmentTotals[pass] = 0.0;
+		millisecondTotals[pass] = 0.0;
+		frameTotals[pass] = 0;
+	}
+}
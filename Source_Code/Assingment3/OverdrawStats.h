@@ -0,0 +1,78 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :OverdrawStats.h
+Description :  OverdrawStats measures what the opaque geometry costs on the
+               GPU. Every measured pass counts its fragment shader
+               invocations and its GPU time with queries. Fragments per
+               pixel of the opaque pass is the overdraw: 1 means every
+               covered pixel was shaded once, more means fragments were
+               shaded and then drawn over. Comparing it and the times with
+               the depth pre-pass on and off shows whether the pre-pass
+               pays for itself. The deferred path measures its G-buffer and
+               lighting passes the same way. The queries are read a few
+               frames later, so the CPU never waits on them.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef OVERDRAWSTATS_H
+#define OVERDRAWSTATS_H
+
+#include <glew.h>
+
+// Passes measured by OverdrawStats
+enum class StatsPass : int
+{
+	DepthPrepass = 0,
+	Opaque = 1,// Shading of the opaque geometry, or filling the G-buffer when deferred
+	Lighting = 2// Deferred lighting of the G-buffer
+};
+
+// Per frame averages of a pass
+struct PassStats
+{
+	double fragments = 0.0;// Fragment shader invocations
+	double gpuMilliseconds = 0.0;
+	int frames = 0;// Frames that measured the pass
+};
+
+class OverdrawStats
+{
+public:
+	OverdrawStats();
+	~OverdrawStats();
+
+	void BeginFrame();// Collects the results of the oldest frame and reuses its queries
+	void Begin(StatsPass pass);
+	void End(StatsPass pass);
+
+	PassStats GetAverage(StatsPass pass) const;// Since the last ResetStats
+	void ResetStats();
+
+	// Copying and assignment not allowed for this class
+	OverdrawStats(const OverdrawStats&) = delete;
+	OverdrawStats& operator=(const OverdrawStats&) = delete;
+
+private:
+	static const int FrameCount = 4;// Frames a result may take before it is read
+	static const int PassCount = 3;
+
+	struct Queries
+	{
+		GLuint fragments = 0;
+		GLuint time = 0;
+		bool pending = false;// Begun and ended, not read yet
+	};
+
+	Queries queries[FrameCount][PassCount];
+	int frame = 0;
+	double fragmentTotals[PassCount] = {};
+	double millisecondTotals[PassCount] = {};
+	int frameTotals[PassCount] = {};
+};
+#endif // OVERDRAWSTATS_H
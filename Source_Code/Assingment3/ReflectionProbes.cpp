@@ -0,0 +1,284 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :ReflectionProbes.cpp
+Description :  Implementation of the budgeted reflection probes.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "ReflectionProbes.h"
+#include "GLState.h"
+#include "ShaderLoader.h"
+#include "ShaderBindings.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+/***********************************************************************
+ * GetFaceView: Gets the view matrix of one cube map face.
+ * Author: [Smirti Parajuli]
+ * Description: The directions and up vectors follow the cube map face
+ *              layout, so a face drawn with this view lines up with the
+ *              direction it is sampled from.
+ * Parameters:
+ *   - position: Centre of the probe.
+ *   - face: 0 to 5, +X, -X, +Y, -Y, +Z, -Z.
+ *
+ * Return: glm::mat4 - The view matrix.
+ ***********************************************************************/
+glm::mat4 ReflectionProbes::GetFaceView(const glm::vec3& position, int face)
+{
+	static const glm::vec3 Directions[FaceCount] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+	};
+	static const glm::vec3 Ups[FaceCount] = {
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+	};
+	return glm::lookAt(position, position + Directions[face], Ups[face]);
+}
+
+/***********************************************************************
+ * GetProjection: Gets the projection shared by every face.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - nearPlane: Distance from the probe centre where a face starts.
+ *
+ * Return: glm::mat4 - A 90 degree square perspective projection.
+ ***********************************************************************/
+glm::mat4 ReflectionProbes::GetProjection(float nearPlane)
+{
+	return glm::perspective(glm::radians(90.0f), 1.0f, nearPlane, FarPlane);
+}
+
+/***********************************************************************
+ * ReflectionProbes: Constructor for the ReflectionProbes class.
+ * Author: [Smirti Parajuli]
+ * Description: Creates the face framebuffer and its depth buffer and
+ *              loads the scene program. The cube maps are created when
+ *              their probe is first drawn.
+ * Parameters: None
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+ReflectionProbes::ReflectionProbes()
+{
+	Program_Scene = ShaderLoader::CreateProgram("Resources/Shaders/ProbeScene.vs", "Resources/Shaders/Blinn_PhongLight.fs");
+
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, FaceSize, FaceSize);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************************
+ * ~ReflectionProbes: Destructor for the ReflectionProbes class.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None (destructor)
+ ***********************************************************************/
+ReflectionProbes::~ReflectionProbes()
+{
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	for (Probe& probe : probes) {
+		if (probe.texture != 0) {
+			GLState::Get().ForgetTexture(probe.texture);
+			glDeleteTextures(1, &probe.texture);
+		}
+	}
+}
+
+/***********************************************************************
+ * CreateTexture: Creates the cube map of a probe.
+ * Author: [Smirti Parajuli]
+ * Description: One level, the reflections are sharp mirrors.
+ * Parameters:
+ *   - probe: The probe without a texture yet.
+ *
+ * Return: None
+ ***********************************************************************/
+void ReflectionProbes::CreateTexture(Probe& probe)
+{
+	glGenTextures(1, &probe.texture);
+	GLState::Get().BindTexture(GL_TEXTURE_CUBE_MAP, probe.texture, 0);
+	glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_RGBA16F, FaceSize, FaceSize);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+}
+
+/***********************************************************************
+ * GetLightingKey: Packs the light settings the faces are shaded with.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - frame: The snapshot holding the light toggles.
+ *
+ * Return: std::uint64_t - Changes whenever one of the settings changes.
+ ***********************************************************************/
+std::uint64_t ReflectionProbes::GetLightingKey(const FrameSnapshot& frame) const
+{
+	std::uint64_t key = static_cast<std::uint64_t>(frame.pointLightCount);
+	key = (key << 1) | (frame.pointLightsEnabled ? 1u : 0u);
+	key = (key << 1) | (frame.directionalLightEnabled ? 1u : 0u);
+	key = (key << 1) | (frame.spotLightsEnabled ? 1u : 0u);
+	key = (key << 1) | (frame.shadowsEnabled ? 1u : 0u);
+	return key;
+}
+
+/***********************************************************************
+ * BeginFrame: Decides which faces are drawn this frame.
+ * Author: [Smirti Parajuli]
+ * Description: A face is out of date when its key changed, when the
+ *              light settings changed, or every frame while the spheres
+ *              are animated on the GPU, where no key can follow them. The
+ *              search starts after the face drawn last, so out of date
+ *              faces take turns and none waits more than a few frames.
+ *              The scene queue is emptied for the Submit calls that
+ *              follow.
+ * Parameters:
+ *   - frame: The snapshot holding the probes and their face keys.
+ *
+ * Return: None
+ ***********************************************************************/
+void ReflectionProbes::BeginFrame(const FrameSnapshot& frame)
+{
+	scene.Clear();
+	pickedCount = 0;
+	dirtyCount = 0;
+	if (!frame.reflectionProbesEnabled) {
+		return;
+	}
+
+	std::uint64_t key = GetLightingKey(frame);
+	if (key != lightingKey) {
+		lightingKey = key;
+		for (Probe& probe : probes) {
+			for (bool& valid : probe.faceValid) {
+				valid = false;
+			}
+		}
+	}
+
+	int probeCount = static_cast<int>(frame.reflectionProbes.size() < MaxProbes ? frame.reflectionProbes.size() : MaxProbes);
+	int total = probeCount * FaceCount;
+	if (total == 0) {
+		return;
+	}
+	for (int step = 0; step < total; step++) {
+		int index = (cursor + step) % total;
+		int face = index % FaceCount;
+		const Probe& probe = probes[index / FaceCount];
+		bool dirty = frame.sphereAnimationOnGpu || !probe.faceValid[face] || probe.faceKeys[face] != frame.reflectionProbes[index / FaceCount].faceKeys[face];
+		if (!dirty) {
+			continue;
+		}
+		dirtyCount++;
+		if (pickedCount < FacesPerFrame) {
+			picked[pickedCount++] = index;
+		}
+	}
+	if (pickedCount > 0) {
+		cursor = (picked[pickedCount - 1] + 1) % total;
+	}
+}
+
+/***********************************************************************
+ * Render: Brings the picked faces up to date.
+ * Author: [Smirti Parajuli]
+ * Description: Each face is cleared to transparent and the queued scene
+ *              is drawn into it with the face's view as FrameData, lit by
+ *              the lights uploaded for this frame. Afterwards the sky is
+ *              bound for the reflective shaders, which show it where a
+ *              face stayed transparent. The caller rebinds the camera
+ *              FrameData afterwards.
+ * Parameters:
+ *   - frame: The snapshot holding the probes.
+ *   - stream: The per-frame stream buffer for the face FrameData.
+ *   - skyTexture: The prefiltered sky of EnvironmentLighting.
+ *
+ * Return: None
+ ***********************************************************************/
+void ReflectionProbes::Render(const FrameSnapshot& frame, StreamBuffer& stream, GLuint skyTexture)
+{
+	GLState& state = GLState::Get();
+	if (pickedCount > 0) {
+		GLint viewport[4] = {};
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		GLint polygonMode[2] = { GL_FILL, GL_FILL };
+		glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+		GLfloat clearColor[4] = {};
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glViewport(0, 0, FaceSize, FaceSize);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		scene.Sort();
+
+		for (int i = 0; i < pickedCount; i++) {
+			int face = picked[i] % FaceCount;
+			const ReflectionProbeView& view = frame.reflectionProbes[picked[i] / FaceCount];
+			Probe& probe = probes[picked[i] / FaceCount];
+			GLintptr offset = 0;
+			FrameUniforms* uniforms = stream.Allocate<FrameUniforms>(offset);
+			if (!uniforms) {
+				break;// Out of stream space, the face keeps its turn
+			}
+			uniforms->view = GetFaceView(view.position, face);
+			uniforms->projection = GetProjection(view.nearPlane);
+			uniforms->cameraPosition = glm::vec4(view.position, 1.0f);
+			uniforms->time = frame.animationTime;
+			stream.BindRange(GL_UNIFORM_BUFFER, FrameDataBinding, offset, sizeof(FrameUniforms));
+
+			if (probe.texture == 0) {
+				CreateTexture(probe);
+			}
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, probe.texture, 0);
+			state.DepthMask(GL_TRUE);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			scene.Execute(stream);
+
+			probe.faceKeys[face] = view.faceKeys[face];
+			probe.faceValid[face] = true;
+			probe.drawnFaces |= 1u << face;
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+		glPolygonMode(GL_FRONT_AND_BACK, static_cast<GLenum>(polygonMode[0]));
+	}
+	state.BindTexture(GL_TEXTURE_CUBE_MAP, skyTexture, SkyUnit);
+}
+
+/***********************************************************************
+ * GetTexture: Gets the cube map a reflective sphere samples.
+ * Author: [Smirti Parajuli]
+ * Description: A probe is only handed out once all six faces hold the
+ *              scene, before that the sphere keeps reflecting the sky.
+ * Parameters:
+ *   - probe: Index into the probes of the snapshot.
+ *
+ * Return: GLuint - The cube map, or 0 when the probe is not ready.
+ ***********************************************************************/
+GLuint ReflectionProbes::GetTexture(int probe) const
+{
+	if (probe < 0 || probe >= MaxProbes || probes[probe].drawnFaces != (1u << FaceCount) - 1) {
+		return 0;
+	}
+	return probes[probe].texture;
+}
@@ -0,0 +1,91 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :ReflectionProbes.h
+Description :  ReflectionProbes keeps a small cube map of the scene around
+               every reflective sphere, so the spheres reflect the spheres
+               and the model around them and not just the skybox. Faces
+               are cleared to transparent and the reflective shaders show
+               the prefiltered sky wherever nothing was drawn, so the sky
+               keeps its own filtering. The simulation thread gives every face a
+               key that changes when a sphere inside it moves. A face is
+               drawn again only when its key changed, and at most
+               FacesPerFrame faces are drawn per frame, taking turns in
+               round robin order. However many probes there are, a frame
+               costs at most that many small scene passes, and a still
+               frame costs none.
+               All access must happen on the thread that owns the GL context.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef REFLECTIONPROBES_H
+#define REFLECTIONPROBES_H
+
+#include <glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include "FrameSnapshot.h"
+#include "RenderQueue.h"
+#include "StreamBuffer.h"
+
+class ReflectionProbes
+{
+public:
+	static const int MaxProbes = 8;
+	static const int FaceCount = 6;
+	static const int FaceSize = 128;
+	static const int FacesPerFrame = 2;// Budget of faces drawn per frame
+	static const GLuint SkyUnit = 5;// layout(binding = 5) of SkySpecular in EnvironmentLighting.glsl
+	static constexpr float FarPlane = 30.0f;
+
+	static glm::mat4 GetFaceView(const glm::vec3& position, int face);// Looks down face GL_TEXTURE_CUBE_MAP_POSITIVE_X + face
+	static glm::mat4 GetProjection(float nearPlane);// 90 degrees, square
+
+	ReflectionProbes();
+	~ReflectionProbes();
+
+	void BeginFrame(const FrameSnapshot& frame);// Picks the faces to draw and empties the scene queue
+	bool NeedsScene() const { return pickedCount > 0; }
+	RenderQueue& GetScene() { return scene; }
+	GLuint GetSceneProgram() const { return Program_Scene; }// Model matrices in InstanceData, Blinn-Phong lit
+	// Draws the picked faces and binds the sky for the reflective shaders
+	void Render(const FrameSnapshot& frame, StreamBuffer& stream, GLuint skyTexture);
+	GLuint GetTexture(int probe) const;// 0 until every face of the probe was drawn once
+
+	int GetFacesDrawn() const { return pickedCount; }// This frame
+	int GetDirtyFaces() const { return dirtyCount; }// Faces waiting for their turn, including the drawn ones
+
+	// Copying and assignment not allowed for this class
+	ReflectionProbes(const ReflectionProbes&) = delete;
+	ReflectionProbes& operator=(const ReflectionProbes&) = delete;
+
+private:
+	struct Probe
+	{
+		GLuint texture = 0;// RGBA16F cube map, alpha 0 where the sky shows through
+		std::uint64_t faceKeys[FaceCount] = {};// Keys each face was last drawn with
+		bool faceValid[FaceCount] = {};
+		unsigned int drawnFaces = 0;// Bit per face drawn at least once, the probe is used once all are
+	};
+
+	void CreateTexture(Probe& probe);
+	std::uint64_t GetLightingKey(const FrameSnapshot& frame) const;// Light settings the faces are shaded with
+
+	Probe probes[MaxProbes];
+	GLuint framebuffer = 0;
+	GLuint depthBuffer = 0;// Renderbuffer shared by every face
+	int cursor = 0;// Face where the next round robin search starts
+	int picked[FacesPerFrame] = {};// probe * FaceCount + face
+	int pickedCount = 0;
+	int dirtyCount = 0;
+	std::uint64_t lightingKey = 0;
+
+	RenderQueue scene;
+	GLuint Program_Scene;
+};
+#endif // REFLECTIONPROBES_H
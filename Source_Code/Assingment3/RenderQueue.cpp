@@ -0,0 +1,453 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :RenderQueue.cpp
+Description :  Implementation of the sorted render queue.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "RenderQueue.h"
+#include "GLState.h"
+#include "ShaderBindings.h"
+#include "FrameArena.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <cstring>
+
+// Key layout for opaque and sky packets, from the most significant bit:
+//   [63:62] pass  [61:52] program  [51:40] texture  [39:28] vertex array  [27:4] depth
+// Transparent packets move the inverted depth right below the pass so they
+// sort back to front first and by state second:
+//   [63:62] pass  [61:38] inverted depth  [37:28] program  [27:16] texture  [15:4] vertex array
+// GL object names are small integers handed out in order, so the masked ids
+// only alias once there are thousands of objects, and aliasing only costs batching.
+namespace
+{
+	const int PassShift = 62;
+	const std::uint64_t ProgramMask = 0x3FF;
+	const std::uint64_t TextureMask = 0xFFF;
+	const std::uint64_t VertexArrayMask = 0xFFF;
+	const std::uint64_t DepthMask = 0xFFFFFF;
+	const int RadixBits = 8;
+	const int RadixBuckets = 1 << RadixBits;
+}
+
+/***********************************************************************
+ * RenderQueue: Constructor for the RenderQueue class.
+ * Author: [Smirti Parajuli]
+ * Description: Reserves room for a typical frame so the queue does not
+ *              allocate while rendering.
+ *
+ * Parameters: None
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+RenderQueue::RenderQueue()
+{
+	packets.reserve(256);
+	entries.reserve(256);
+}
+
+/***********************************************************************
+ * MakeKey: Builds the 64-bit sort key of a packet.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - pass: The pass the packet belongs to.
+ *   - program: Shader program of the draw.
+ *   - texture: Texture bound for the draw, zero for none.
+ *   - vertexArray: Vertex array of the draw.
+ *   - depth: View distance divided by the far plane.
+ *
+ * Return: The packed key, lower keys are drawn first.
+ ***********************************************************************/
+std::uint64_t RenderQueue::MakeKey(RenderPass pass, GLuint program, GLuint texture, GLuint vertexArray, float depth)
+{
+	depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+	std::uint64_t quantized = static_cast<std::uint64_t>(depth * static_cast<float>(DepthMask));
+
+	std::uint64_t key = static_cast<std::uint64_t>(pass) << PassShift;
+	if (pass == RenderPass::Transparent) {
+		key |= (DepthMask - quantized) << 38;
+		key |= (program & ProgramMask) << 28;
+		key |= (texture & TextureMask) << 16;
+		key |= (vertexArray & VertexArrayMask) << 4;
+	}
+	else {
+		key |= (program & ProgramMask) << 52;
+		key |= (texture & TextureMask) << 40;
+		key |= (vertexArray & VertexArrayMask) << 28;
+		key |= quantized << 4;
+	}
+	return key;
+}
+
+/***********************************************************************
+ * Submit: Adds a packet to this frame's queue.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - packet: The draw, with its key already filled in.
+ *
+ * Return: None
+ ***********************************************************************/
+void RenderQueue::Submit(const DrawPacket& packet)
+{
+	entries.push_back({ packet.key, static_cast<std::uint32_t>(packets.size()) });
+	packets.push_back(packet);
+}
+
+/***********************************************************************
+ * Sort: Orders the packets by key.
+ * Author: [Smirti Parajuli]
+ * Description: LSD radix sort over 8-bit digits. Only the small key/index
+ *              pairs move, and a digit every key shares is skipped, so a
+ *              typical frame runs a handful of passes. The sort is stable,
+ *              so equal keys keep their submission order. The ping-pong
+ *              buffer is scratch memory of the calling thread.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void RenderQueue::Sort()
+{
+	size_t count = entries.size();
+	if (count < 2) {
+		return;
+	}
+	ScratchScope scratch;
+
+	SortEntry* source = entries.data();
+	SortEntry* destination = scratch.Allocate<SortEntry>(count);
+	for (int shift = 0; shift < 64; shift += RadixBits) {
+		size_t histogram[RadixBuckets] = {};
+		for (size_t i = 0; i < count; i++) {
+			histogram[(source[i].key >> shift) & (RadixBuckets - 1)]++;
+		}
+		// Every key has the same digit here, nothing would move
+		if (histogram[(source[0].key >> shift) & (RadixBuckets - 1)] == count) {
+			continue;
+		}
+
+		size_t offset = 0;
+		for (int bucket = 0; bucket < RadixBuckets; bucket++) {
+			size_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+		for (size_t i = 0; i < count; i++) {
+			destination[histogram[(source[i].key >> shift) & (RadixBuckets - 1)]++] = source[i];
+		}
+		SortEntry* swap = source;
+		source = destination;
+		destination = swap;
+	}
+
+	// An odd number of passes leaves the result in the scratch buffer
+	if (source != entries.data()) {
+		std::memcpy(entries.data(), source, sizeof(SortEntry) * count);
+	}
+}
+
+/***********************************************************************
+ * CanMerge: Tells whether two packets can share one multi-draw.
+ * Author: [Smirti Parajuli]
+ * Description: Only plain pool draws merge, they may differ in the mesh,
+ *              index range and instance count but not in any state.
+ *
+ * Parameters:
+ *   - first: The packet that starts the run.
+ *   - next: The packet that follows it in sorted order.
+ *
+ * Return: bool - True when next can be drawn with the same call as first.
+ ***********************************************************************/
+bool RenderQueue::CanMerge(const DrawPacket& first, const DrawPacket& next)
+{
+	bool plain = next.rangeSize == 0 && next.modelLocation < 0 && next.colorLocation < 0 && next.indirectBuffer == 0 && next.vertexCount == 0;
+	return plain && next.program == first.program && next.depthProgram == first.depthProgram && next.gbufferProgram == first.gbufferProgram
+		&& next.vertexArray == first.vertexArray && next.texture == first.texture && next.textureTarget == first.textureTarget
+		&& next.depthFunc == first.depthFunc && next.indexType == first.indexType;
+}
+
+/***********************************************************************
+ * FindOpaqueEnd: Finds where the opaque packets end in sorted order.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: size_t - One past the last sorted opaque entry.
+ ***********************************************************************/
+size_t RenderQueue::FindOpaqueEnd() const
+{
+	size_t opaqueEnd = 0;
+	while (opaqueEnd < entries.size() && (entries[opaqueEnd].key >> PassShift) == static_cast<std::uint64_t>(RenderPass::Opaque)) {
+		opaqueEnd++;
+	}
+	return opaqueEnd;
+}
+
+/***********************************************************************
+ * Skips: Tells whether a pass leaves a packet out.
+ * Author: [Smirti Parajuli]
+ * Description: The depth and G-buffer passes only draw packets that have
+ *              a program for them. With deferred shading on, the shaded
+ *              pass leaves out the packets already in the G-buffer.
+ *
+ * Parameters:
+ *   - packet: The packet about to be drawn.
+ *   - mode: The pass being drawn.
+ *
+ * Return: bool - True when the packet is not drawn in this pass.
+ ***********************************************************************/
+bool RenderQueue::Skips(const DrawPacket& packet, DrawMode mode) const
+{
+	switch (mode) {
+	case DrawMode::DepthOnly: return packet.depthProgram == 0;
+	case DrawMode::GBuffer: return packet.gbufferProgram == 0;
+	default: return deferred && packet.gbufferProgram != 0;
+	}
+}
+
+/***********************************************************************
+ * ApplyState: Binds what a packet needs before its draw.
+ * Author: [Smirti Parajuli]
+ * Description: The depth pass only needs the depth program and geometry.
+ *              A packet that went through the pre-pass is shaded with
+ *              GL_EQUAL and without depth writes, its depth is in place.
+ *              The G-buffer pass writes depth like a forward draw.
+ *
+ * Parameters:
+ *   - packet: The packet about to be drawn.
+ *   - mode: The pass being drawn.
+ *
+ * Return: None
+ ***********************************************************************/
+void RenderQueue::ApplyState(const DrawPacket& packet, DrawMode mode) const
+{
+	GLState& state = GLState::Get();
+	if (mode == DrawMode::DepthOnly) {
+		state.UseProgram(packet.depthProgram);
+		state.DepthFunc(packet.depthFunc);
+	}
+	else {
+		bool prepassed = mode == DrawMode::Shaded && depthPrepass && !deferred && packet.depthProgram != 0;
+		state.UseProgram(mode == DrawMode::GBuffer ? packet.gbufferProgram : packet.program);
+		state.DepthFunc(prepassed ? GL_EQUAL : packet.depthFunc);
+		state.DepthMask(prepassed ? GL_FALSE : GL_TRUE);
+		if (packet.texture != 0) {
+			state.BindTexture(packet.textureTarget, packet.texture, 0);
+		}
+	}
+	state.BindVertexArray(packet.vertexArray);
+}
+
+/***********************************************************************
+ * ExecuteMerged: Draws a run of mergeable packets with one call.
+ * Author: [Smirti Parajuli]
+ * Description: Writes one indirect command per packet into the stream
+ *              buffer and issues them with glMultiDrawElementsIndirect,
+ *              which, unlike glMultiDrawElementsBaseVertex, carries the
+ *              base instance each pool draw needs for its mesh number.
+ *
+ * Parameters:
+ *   - first: Index into the sorted entries where the run starts.
+ *   - end: One past the last entry the run may take.
+ *   - stream: The stream buffer the commands are written to.
+ *   - mode: The pass being drawn.
+ *
+ * Return: size_t - Number of packets drawn, zero if nothing was merged.
+ ***********************************************************************/
+size_t RenderQueue::ExecuteMerged(size_t first, size_t end, StreamBuffer& stream, DrawMode mode)
+{
+	const DrawPacket& head = packets[entries[first].index];
+	if (head.rangeSize > 0 || head.modelLocation >= 0 || head.colorLocation >= 0 || head.indirectBuffer != 0 || head.vertexCount > 0) {
+		return 0;
+	}
+	size_t count = 1;
+	while (first + count < end && CanMerge(head, packets[entries[first + count].index])) {
+		count++;
+	}
+	if (count < 2) {
+		return 0;
+	}
+
+	GLintptr offset = 0;
+	DrawElementsCommand* commands = stream.Allocate<DrawElementsCommand>(offset, static_cast<GLsizeiptr>(count));
+	if (commands == nullptr) {
+		return 0;
+	}
+	GLuint indexSize = (head.indexType == GL_UNSIGNED_SHORT) ? 2u : 4u;
+	for (size_t i = 0; i < count; ++i) {
+		const DrawPacket& packet = packets[entries[first + i].index];
+		commands[i] = { static_cast<GLuint>(packet.indexCount), static_cast<GLuint>(packet.instanceCount),
+			packet.indexOffset / indexSize, 0, packet.baseInstance };
+	}
+
+	ApplyState(head, mode);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, stream.GetID());
+	glMultiDrawElementsIndirect(GL_TRIANGLES, head.indexType, reinterpret_cast<const void*>(offset), static_cast<GLsizei>(count), 0);
+	drawCalls++;
+	return count;
+}
+
+/***********************************************************************
+ * ExecuteRange: Issues a run of sorted packets.
+ * Author: [Smirti Parajuli]
+ * Description: All bindings go through the GL state cache, so packets that
+ *              share a program, texture or vertex array with the previous
+ *              one cost only their draw call. Runs of plain pool draws
+ *              are merged into a single multi-draw.
+ *
+ * Parameters:
+ *   - begin: First sorted entry to draw.
+ *   - end: One past the last sorted entry to draw.
+ *   - stream: The stream buffer for the merged draw commands.
+ *   - mode: The pass being drawn, see Skips for the packets it takes.
+ *
+ * Return: None
+ ***********************************************************************/
+void RenderQueue::ExecuteRange(size_t begin, size_t end, StreamBuffer& stream, DrawMode mode)
+{
+	for (size_t i = begin; i < end; ++i) {
+		const DrawPacket& packet = packets[entries[i].index];
+		if (Skips(packet, mode)) {
+			continue;
+		}
+		size_t merged = ExecuteMerged(i, end, stream, mode);
+		if (merged > 0) {
+			i += merged - 1;
+			continue;
+		}
+		drawCalls++;
+
+		ApplyState(packet, mode);
+		if (packet.rangeSize > 0) {
+			glBindBufferRange(packet.rangeTarget, packet.rangeIndex, packet.rangeBuffer, packet.rangeOffset, packet.rangeSize);
+		}
+		if (mode == DrawMode::Shaded && packet.modelLocation >= 0) {
+			glUniformMatrix4fv(packet.modelLocation, 1, GL_FALSE, glm::value_ptr(packet.model));
+		}
+		if (mode == DrawMode::Shaded && packet.colorLocation >= 0) {
+			glUniform3fv(packet.colorLocation, 1, glm::value_ptr(packet.color));
+		}
+
+		if (packet.indirectBuffer != 0) {
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, packet.indirectBuffer);
+			glMultiDrawElementsIndirect(GL_TRIANGLES, packet.indexType, nullptr, packet.drawCount, 0);
+			continue;
+		}
+		if (packet.vertexCount > 0) {
+			glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, packet.vertexCount, packet.instanceCount, packet.baseInstance);
+			continue;
+		}
+		const void* indexOffset = reinterpret_cast<const void*>(static_cast<std::uintptr_t>(packet.indexOffset));
+		glDrawElementsInstancedBaseInstance(GL_TRIANGLES, packet.indexCount, packet.indexType, indexOffset, packet.instanceCount, packet.baseInstance);
+	}
+}
+
+/***********************************************************************
+ * Execute: Issues the sorted packets.
+ * Author: [Smirti Parajuli]
+ * Description: Opaque packets sort first. With the depth pre-pass on they
+ *              are drawn depth only before they are shaded. The opaque
+ *              passes are measured when stats is given. When deferred,
+ *              there is no pre-pass and the packets lit from the G-buffer
+ *              are left out.
+ *
+ * Parameters:
+ *   - stream: The stream buffer for the merged draw commands.
+ *   - stats: Receives the fragments and GPU time of the opaque passes, or nullptr.
+ *
+ * Return: None
+ ***********************************************************************/
+void RenderQueue::Execute(StreamBuffer& stream, OverdrawStats* stats)
+{
+	GLState& state = GLState::Get();
+	size_t opaqueEnd = FindOpaqueEnd();
+
+	if (depthPrepass && !deferred) {
+		if (stats) {
+			stats->Begin(StatsPass::DepthPrepass);
+		}
+		state.ColorMask(GL_FALSE);
+		state.DepthMask(GL_TRUE);
+		ExecuteRange(0, opaqueEnd, stream, DrawMode::DepthOnly);
+		state.ColorMask(GL_TRUE);
+		if (stats) {
+			stats->End(StatsPass::DepthPrepass);
+		}
+	}
+
+	if (stats) {
+		stats->Begin(StatsPass::Opaque);
+	}
+	ExecuteRange(0, opaqueEnd, stream, DrawMode::Shaded);
+	if (stats) {
+		stats->End(StatsPass::Opaque);
+	}
+	ExecuteRange(opaqueEnd, entries.size(), stream, DrawMode::Shaded);
+
+	// glClear only clears depth while depth writes are on
+	state.DepthMask(GL_TRUE);
+}
+
+/***********************************************************************
+ * ExecuteGBuffer: Issues the opaque packets the deferred path lights.
+ * Author: [Smirti Parajuli]
+ * Description: Draws every sorted opaque packet that has a G-buffer
+ *              program with it, front to back as in Execute. The pass is
+ *              measured as the opaque pass when stats is given.
+ *
+ * Parameters:
+ *   - stream: The stream buffer for the merged draw commands.
+ *   - stats: Receives the fragments and GPU time of the pass, or nullptr.
+ *
+ * Return: None
+ ***********************************************************************/
+void RenderQueue::ExecuteGBuffer(StreamBuffer& stream, OverdrawStats* stats)
+{
+	if (stats) {
+		stats->Begin(StatsPass::Opaque);
+	}
+	ExecuteRange(0, FindOpaqueEnd(), stream, DrawMode::GBuffer);
+	if (stats) {
+		stats->End(StatsPass::Opaque);
+	}
+	GLState::Get().DepthMask(GL_TRUE);
+}
+
+/***********************************************************************
+ * ExecuteDepth: Issues the opaque packets depth only.
+ * Author: [Smirti Parajuli]
+ * Description: Draws every sorted opaque packet that has a depth program
+ *              with it and colour writes off, as the depth pre-pass does.
+ *              Used for the casters of the shadow maps.
+ *
+ * Parameters:
+ *   - stream: The stream buffer for the merged draw commands.
+ *
+ * Return: None
+ ***********************************************************************/
+void RenderQueue::ExecuteDepth(StreamBuffer& stream)
+{
+	GLState& state = GLState::Get();
+	state.ColorMask(GL_FALSE);
+	state.DepthMask(GL_TRUE);
+	ExecuteRange(0, FindOpaqueEnd(), stream, DrawMode::DepthOnly);
+	state.ColorMask(GL_TRUE);
+}
+
+/***********************************************************************
+ * Clear: Empties the queue.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void RenderQueue::Clear()
+{
+	packets.clear();
+	entries.clear();
+	drawCalls = 0;
+}
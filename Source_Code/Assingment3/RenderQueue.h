@@ -0,0 +1,135 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :RenderQueue.h
+Description :  The RenderQueue collects draw packets from every renderable
+               object, radix sorts them by a packed 64-bit key and submits
+               them in that order. Opaque packets are grouped by program,
+               texture and vertex array and drawn front to back, the sky is
+               drawn after all opaque geometry and transparent packets last,
+               back to front. Neighbouring packets that only differ in the
+               geometry pool mesh they draw are merged into one multi-draw.
+               With the depth pre-pass on, opaque packets that have a depth
+               program are drawn twice: first depth only, then shaded with
+               GL_EQUAL, so each pixel runs the expensive fragment shader
+               once however many surfaces cover it. With deferred shading
+               on, opaque packets that have a G-buffer program are drawn
+               into the G-buffer by ExecuteGBuffer and skipped by Execute,
+               which then only draws what the lighting pass cannot light.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "StreamBuffer.h"
+#include "OverdrawStats.h"
+
+// Passes in submission order, stored in the top bits of the sort key
+enum class RenderPass : unsigned int
+{
+	Opaque = 0,
+	Sky = 1,
+	Transparent = 2
+};
+
+// Everything needed to issue one draw call
+struct DrawPacket
+{
+	std::uint64_t key = 0;
+	GLuint program = 0;
+	GLuint vertexArray = 0;
+	GLenum textureTarget = GL_TEXTURE_2D;
+	GLuint texture = 0;// Bound to unit 0, skipped when zero
+	GLenum depthFunc = GL_LESS;
+	GLuint depthProgram = 0;// The vertex shader of program with DepthOnly.fs, joins the depth pre-pass when set
+	GLuint gbufferProgram = 0;// The vertex shader of program with GBuffer.fs, lit by the deferred path when set
+	GLsizei indexCount = 0;
+	GLsizei vertexCount = 0;// Drawn with glDrawArrays from vertex 0 instead of the indices when set
+	GLsizei instanceCount = 1;
+	GLenum indexType = GL_UNSIGNED_INT;// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	GLuint indexOffset = 0;// Offset into the element buffer, in bytes
+	GLuint baseInstance = 0;// Mesh number in the geometry pool, gl_InstanceID does not include it
+
+	// Optional multi-draw indirect commands replacing the counts above, used when the buffer is set
+	GLuint indirectBuffer = 0;
+	GLsizei drawCount = 0;
+
+	// Optional buffer range for this draw (instance data, skybox matrix), skipped when size is zero
+	GLenum rangeTarget = GL_UNIFORM_BUFFER;
+	GLuint rangeIndex = 0;
+	GLuint rangeBuffer = 0;
+	GLintptr rangeOffset = 0;
+	GLsizeiptr rangeSize = 0;
+
+	// Optional uniforms of program, skipped when the location is -1 and by the depth and G-buffer passes
+	GLint modelLocation = -1;
+	glm::mat4 model = glm::mat4(1.0f);
+	GLint colorLocation = -1;
+	glm::vec3 color = glm::vec3(1.0f);
+};
+
+class RenderQueue
+{
+public:
+	RenderQueue();
+
+	// Packs the sort key. depth is the view distance scaled to 0..1 by the far plane.
+	static std::uint64_t MakeKey(RenderPass pass, GLuint program, GLuint texture, GLuint vertexArray, float depth);
+
+	void Submit(const DrawPacket& packet);
+	void Sort();// Radix sorts the submitted packets by key
+	// Issues every packet in sorted order, stream holds the merged draw commands, stats is optional
+	void Execute(StreamBuffer& stream, OverdrawStats* stats = nullptr);
+	// Draws the opaque packets that have a G-buffer program into the bound G-buffer
+	void ExecuteGBuffer(StreamBuffer& stream, OverdrawStats* stats = nullptr);
+	void ExecuteDepth(StreamBuffer& stream);// Draws the opaque packets that have a depth program, for shadow maps
+	void Clear();// Empties the queue, keeps the capacity for the next frame
+	void SetDepthPrepass(bool enabled) { depthPrepass = enabled; }
+	void SetDeferred(bool enabled) { deferred = enabled; }// Execute leaves out what ExecuteGBuffer drew
+
+	int GetPacketCount() const { return static_cast<int>(packets.size()); }
+	int GetDrawCallCount() const { return drawCalls; }// Draw calls since the latest Clear
+
+	// Copying and assignment not allowed for this class
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+
+private:
+	// The program each packet is drawn with
+	enum class DrawMode
+	{
+		Shaded,// program
+		DepthOnly,// depthProgram
+		GBuffer// gbufferProgram
+	};
+
+	struct SortEntry
+	{
+		std::uint64_t key;
+		std::uint32_t index;// Position of the packet in the submission list
+	};
+
+	std::vector<DrawPacket> packets;
+	std::vector<SortEntry> entries;
+	int drawCalls = 0;
+	bool depthPrepass = false;
+	bool deferred = false;
+
+	static bool CanMerge(const DrawPacket& first, const DrawPacket& next);
+	size_t FindOpaqueEnd() const;// Opaque packets sort first, this is one past the last
+	bool Skips(const DrawPacket& packet, DrawMode mode) const;
+	void ApplyState(const DrawPacket& packet, DrawMode mode) const;
+	void ExecuteRange(size_t begin, size_t end, StreamBuffer& stream, DrawMode mode);
+	size_t ExecuteMerged(size_t first, size_t end, StreamBuffer& stream, DrawMode mode);
+};
+#endif // RENDERQUEUE_H
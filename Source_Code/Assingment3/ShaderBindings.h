@@ -0,0 +1,110 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :ShaderBindings.h
+Description :  Binding points and std140/std430 layouts of the buffer blocks
+               shared between the C++ code and the GLSL shaders. Any change
+               here must be mirrored in the matching block in the shaders.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef SHADERBINDINGS_H
+#define SHADERBINDINGS_H
+
+#include <glew.h>
+#include <glm/glm.hpp>
+
+// Uniform block binding points
+const GLuint FrameDataBinding = 0;// FrameData: camera matrices and position
+const GLuint LightDataBinding = 1;// LightData: every light in the scene
+const GLuint SkyBoxDataBinding = 3;// SkyBoxData: skybox matrix
+const GLuint EnvironmentDataBinding = 11;// EnvironmentData: image-based lighting of the sky, written once
+
+// Shader storage block binding points
+const GLuint InstanceDataBinding = 2;// InstanceData: per-instance transforms
+const GLuint InstanceAnimationBinding = 4;// InstanceAnimationData: per-instance animation, never rewritten
+const GLuint VertexDataBinding = 5;// VertexData: the vertices of every mesh, pulled by gl_VertexID
+const GLuint MeshFormatBinding = 6;// MeshFormatData: how the vertices of each mesh are stored
+const GLuint MeshletDataBinding = 7;// MeshletData: bounds and index range of every meshlet of the culled mesh
+const GLuint MeshletDrawBinding = 8;// MeshletDraws: one indirect draw per meshlet, written by the culling pass
+const GLuint MeshletVisibleBinding = 9;// MeshletVisibleData: instances that kept each meshlet
+const GLuint PointLightDataBinding = 10;// PointLightData: every point light, written once
+
+// Shadow maps, array sizes of the LightData block. Atlas tile i holds shadow view i:
+// the directional cascades first, then one view per spotlight
+const int ShadowCascadeCount = 3;
+const int MaxSpotShadows = 10;// Matches Light::MaxSpotLights
+const int MaxShadowViews = ShadowCascadeCount + MaxSpotShadows;
+
+// layout(std140, binding = 0) uniform FrameData
+struct FrameUniforms
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 cameraPosition;// xyz used, w padding
+	float time;// Animation time in seconds
+	float padding[3];
+};
+
+// layout(std140, binding = 11) uniform EnvironmentData
+struct EnvironmentUniforms
+{
+	glm::vec4 irradiance[9];// Spherical harmonic coefficients of the sky irradiance over pi, rgb used
+	glm::vec4 specularLevels;// x the roughest level of the specular cube map, yzw padding
+};
+
+// layout(std430, binding = 2) buffer InstanceData, one entry per instance
+struct InstanceTransform
+{
+	glm::mat4 model;
+	glm::mat4 normalMatrix;// Inverse transpose of the model rotation and scale
+	glm::mat4 pvm;// projection * view * model
+};
+
+// layout(std430, binding = 4) buffer InstanceAnimationData, one entry per instance
+// Angles are in radians and speeds in radians per second
+struct InstanceAnimation
+{
+	glm::vec4 basePosition;// xyz position, w uniform scale
+	glm::vec4 baseRotation;// Quaternion (x, y, z, w)
+	glm::vec4 spin;// xyz unit axis, w speed
+	glm::vec4 bob;// x height, y speed, z phase, w padding
+	glm::vec4 orbit;// x radius, y speed, z phase, w padding
+	glm::vec4 pulse;// rgb tint at the peak of the pulse, w speed
+};
+
+// layout(std430, binding = 6) buffer MeshFormatData, one entry per mesh in the geometry pool
+// Draws pass the mesh number as their base instance so the shader can find it
+struct MeshFormat
+{
+	glm::uvec4 layout;// x VertexFormat, y first word in VertexData, z words per vertex, w padding
+	glm::vec4 positionScale;// Decoded position = stored * scale + offset, w padding
+	glm::vec4 positionOffset;
+};
+
+// layout(std430, binding = 7) buffer MeshletData, one entry per meshlet, in object space
+// The meshlet faces away from every camera position where
+// dot(centre - camera, axis) >= cutoff * length(centre - camera) + radius
+struct MeshletBounds
+{
+	glm::vec4 sphere;// xyz centre, w radius
+	glm::vec4 cone;// xyz unit axis of the triangle normals, w cutoff, above 1 when it never faces away
+	glm::uvec4 range;// x first index within the mesh, y index count, zw padding
+};
+
+// layout(std430, binding = 8) buffer MeshletDraws, read by glMultiDrawElementsIndirect
+struct DrawElementsCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+#endif // SHADERBINDINGS_H
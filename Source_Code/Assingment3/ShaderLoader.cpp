@@ -14,8 +14,10 @@ Mail : [smirti.parajuli]@mds.ac.nz
 **************************************************************************/
 
 #include "ShaderLoader.h" 
+#include "AssetPack.h"
 #include<iostream>
 #include<fstream>
+#include<sstream>
 #include<vector>
 
 ShaderLoader::ShaderLoader(void) {}// Default constructor.
@@ -57,6 +59,33 @@ GLuint ShaderLoader::CreateProgram(const char* vertexShaderFilename, const char*
 	}
 
 
+	return program;
+}
+/***********************************************************************
+ * Function: CreateComputeProgram
+ * Author: [Smirti Parajuli]
+ * Description: Creates a shader program from a single compute shader.
+ * Parameters:
+ *   - computeShaderFilename: Path to the compute shader file.
+ * Return: GLuint - The shader program ID, zero if it failed to link.
+ ***********************************************************************/
+GLuint ShaderLoader::CreateComputeProgram(const char* computeShaderFilename)
+{
+	GLuint computeShaderID = CreateShader(GL_COMPUTE_SHADER, computeShaderFilename);
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, computeShaderID);
+	glLinkProgram(program);
+
+	// Check for link errors
+	int link_result = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &link_result);
+	if (link_result == GL_FALSE)
+	{
+		PrintErrorDetails(false, program, computeShaderFilename);
+		return 0;
+	}
+
 	return program;
 }
 /***********************************************************************
@@ -73,7 +102,7 @@ GLuint ShaderLoader::CreateProgram(const char* vertexShaderFilename, const char*
 GLuint ShaderLoader::CreateShader(GLenum shaderType, const char* shaderName)
 {
 	// Read the shader files and save the source code as strings
-	std::string shaderSourceCode = ReadShaderFile(shaderName);
+	std::string shaderSourceCode = ExpandIncludes(ReadShaderFile(shaderName), shaderName, 0);
 
 	// Create the shader ID and create pointers for source code string and length
 	GLuint shaderID = glCreateShader(shaderType);
@@ -99,7 +128,8 @@ GLuint ShaderLoader::CreateShader(GLenum shaderType, const char* shaderName)
 /***********************************************************************
  * Function: ReadShaderFile
  * Author:  [Smirti Parajuli]
- * Description: Reads the shader source code from a file.
+ * Description: Reads the shader source code from the asset pack, or from
+ *              the loose file when the pack does not hold it.
  * 
  * Parameters:
  *   - filename: Path to the shader file.
@@ -108,26 +138,55 @@ GLuint ShaderLoader::CreateShader(GLenum shaderType, const char* shaderName)
  ***********************************************************************/
 std::string ShaderLoader::ReadShaderFile(const char* filename)
 {
-	// Open the file for reading
-	std::ifstream file(filename, std::ios::in);
-	std::string shaderCode;
+	AssetData source;
 
-	// Ensure the file is open and readable
-	if (!file.good()) {
+	// Ensure the file is there and readable
+	if (!AssetPack::Load(filename, source)) {
 		std::cout << "Cannot read file:  " << filename << std::endl;
 		return "";
 	}
-
-	// Determine the size of of the file in characters and resize the string variable to accomodate
-	file.seekg(0, std::ios::end);
-	shaderCode.resize((unsigned int)file.tellg());
-
-	// Set the position of the next character to be read back to the beginning
-	file.seekg(0, std::ios::beg);
-	// Extract the contents of the file and store in the string variable
-	file.read(&shaderCode[0], shaderCode.size());
-	file.close();
-	return shaderCode;
+	return std::string(reinterpret_cast<const char*>(source.GetData()), source.GetSize());
+}
+/***********************************************************************
+ * Function: ExpandIncludes
+ * Author:  [Smirti Parajuli]
+ * Description: Replaces every line of the form #include "file" with the
+ *              contents of that file, looked up next to the including
+ *              file. Included files may include others, up to
+ *              MaxIncludeDepth levels.
+ * 
+ * Parameters:
+ *   - source: The shader source code.
+ *   - filename: Path of the file the source was read from.
+ *   - depth: How many includes deep the source is.
+ * 
+ * Return: std::string - The source code with the includes expanded.
+ ***********************************************************************/
+std::string ShaderLoader::ExpandIncludes(const std::string& source, const char* filename, int depth)
+{
+	std::string path(filename);
+	size_t slash = path.find_last_of("/\\");
+	std::string directory = (slash == std::string::npos) ? "" : path.substr(0, slash + 1);
+
+	std::istringstream lines(source);
+	std::string expanded;
+	std::string line;
+	while (std::getline(lines, line)) {
+		size_t directive = line.find_first_not_of(" \t");
+		size_t open = line.find('"');
+		size_t close = (open == std::string::npos) ? open : line.find('"', open + 1);
+		if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0 || close == std::string::npos) {
+			expanded += line + "\n";
+			continue;
+		}
+		if (depth >= MaxIncludeDepth) {
+			std::cout << "Too many nested includes in: " << filename << std::endl;
+			return expanded;
+		}
+		std::string included = directory + line.substr(open + 1, close - open - 1);
+		expanded += ExpandIncludes(ReadShaderFile(included.c_str()), included.c_str(), depth + 1) + "\n";
+	}
+	return expanded;
 }
 /***********************************************************************
  * Function: PrintErrorDetails
@@ -23,11 +23,14 @@ class ShaderLoader
 
 public:
 	static GLuint CreateProgram(const char* VertexShaderFilename, const char* FragmentShaderFilename);
+	static GLuint CreateComputeProgram(const char* ComputeShaderFilename);
 	static GLuint ID;
 private:
 	ShaderLoader(void);
 	~ShaderLoader(void);
 	static GLuint CreateShader(GLenum shaderType, const char* shaderName);
 	static std::string ReadShaderFile(const char* filename);
+	static std::string ExpandIncludes(const std::string& source, const char* filename, int depth);
+	static const int MaxIncludeDepth = 8;// Stops include cycles
 	static void PrintErrorDetails(bool isShader, GLuint id, const char* name);
 };
\ No newline at end of file
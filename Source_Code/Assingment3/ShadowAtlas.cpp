@@ -0,0 +1,294 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :ShadowAtlas.cpp
+Description :  Implementation of the cached shadow map atlas.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "ShadowAtlas.h"
+#include "GLState.h"
+#include "ShaderLoader.h"
+#include "ShaderBindings.h"
+#include <iostream>
+
+/***********************************************************************
+ * GetTileMatrix: Gets the matrix from a view to its tile.
+ * Author: [Smirti Parajuli]
+ * Description: Maps clip space x and y from -1..1 onto the tile and z onto
+ *              0..1, the range the depth comparison uses.
+ * Parameters:
+ *   - tile: The tile, the same number as the shadow view.
+ *
+ * Return: glm::mat4 - Applied after the projection of the view.
+ ***********************************************************************/
+glm::mat4 ShadowAtlas::GetTileMatrix(int tile)
+{
+	float scale = static_cast<float>(TileSize) / AtlasSize;
+	glm::vec2 corner(static_cast<float>(tile % TilesPerRow) * scale, static_cast<float>(tile / TilesPerRow) * scale);
+	glm::mat4 matrix(1.0f);
+	matrix[0][0] = 0.5f * scale;
+	matrix[1][1] = 0.5f * scale;
+	matrix[2][2] = 0.5f;
+	matrix[3] = glm::vec4(corner + glm::vec2(0.5f * scale), 0.5f, 1.0f);
+	return matrix;
+}
+
+/***********************************************************************
+ * ShadowAtlas: Constructor for the ShadowAtlas class.
+ * Author: [Smirti Parajuli]
+ * Description: Creates both atlases and loads the caster program. Every
+ *              tile starts invalid, so the first frame draws them all.
+ * Parameters: None
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+ShadowAtlas::ShadowAtlas()
+{
+	staticTexture = CreateTexture(false);
+	atlasTexture = CreateTexture(true);
+	staticFramebuffer = CreateFramebuffer(staticTexture);
+	atlasFramebuffer = CreateFramebuffer(atlasTexture);
+	Program_Caster = ShaderLoader::CreateProgram("Resources/Shaders/ShadowCaster.vs", "Resources/Shaders/DepthOnly.fs");
+}
+
+/***********************************************************************
+ * ~ShadowAtlas: Destructor for the ShadowAtlas class.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None (destructor)
+ ***********************************************************************/
+ShadowAtlas::~ShadowAtlas()
+{
+	glDeleteFramebuffers(1, &staticFramebuffer);
+	glDeleteFramebuffers(1, &atlasFramebuffer);
+	for (GLuint* texture : { &staticTexture, &atlasTexture }) {
+		GLState::Get().ForgetTexture(*texture);
+		glDeleteTextures(1, texture);
+	}
+}
+
+/***********************************************************************
+ * CreateTexture: Creates one atlas texture.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - compare: True for the atlas the lighting samples. Its lookups
+ *              compare against the depth and filter the results, so
+ *              every sample is already a 2x2 percentage closer filter.
+ *
+ * Return: GLuint - The texture.
+ ***********************************************************************/
+GLuint ShadowAtlas::CreateTexture(bool compare)
+{
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	GLState::Get().BindTexture(GL_TEXTURE_2D, texture, 0);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, AtlasSize, AtlasSize);
+	GLint filter = compare ? GL_LINEAR : GL_NEAREST;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	if (compare) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	}
+	return texture;
+}
+
+/***********************************************************************
+ * CreateFramebuffer: Creates a framebuffer that only writes depth.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - texture: The atlas texture to draw into.
+ *
+ * Return: GLuint - The framebuffer.
+ ***********************************************************************/
+GLuint ShadowAtlas::CreateFramebuffer(GLuint texture)
+{
+	GLuint framebuffer = 0;
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "Shadows: the atlas framebuffer is incomplete" << std::endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return framebuffer;
+}
+
+/***********************************************************************
+ * BeginFrame: Decides which tiles are drawn this frame.
+ * Author: [Smirti Parajuli]
+ * Description: A tile whose static key changed draws everything again.
+ *              A tile whose dynamic key changed, or whose moving casters
+ *              are animated on the GPU where no key can follow them, only
+ *              draws the moving casters over its cached static tile. With
+ *              caching off every tile is drawn from scratch. The caster
+ *              queues are emptied for the Submit calls that follow.
+ * Parameters:
+ *   - frame: The snapshot holding the shadow views and their keys.
+ *
+ * Return: None
+ ***********************************************************************/
+void ShadowAtlas::BeginFrame(const FrameSnapshot& frame)
+{
+	staticCasters.Clear();
+	dynamicCasters.Clear();
+	staticTiles = 0;
+	dynamicTiles = 0;
+	staticTilesDrawn = 0;
+	dynamicTilesDrawn = 0;
+	if (!frame.shadowsEnabled) {
+		return;
+	}
+
+	for (int i = 0; i < MaxShadowViews; i++) {
+		bool used = (i < ShadowCascadeCount) ? (i < frame.shadowCascadeCount) : (i - ShadowCascadeCount < frame.spotShadowCount);
+		if (!used) {
+			continue;
+		}
+		const ShadowView& view = frame.shadowViews[i];
+		Tile& tile = tiles[i];
+		bool drawStatic = !frame.shadowCaching || !tile.valid || tile.staticKey != view.staticKey;
+		bool drawDynamic = drawStatic || frame.sphereAnimationOnGpu || tile.dynamicKey != view.dynamicKey;
+		if (drawStatic) {
+			staticTiles |= 1u << i;
+			staticTilesDrawn++;
+		}
+		if (drawDynamic) {
+			dynamicTiles |= 1u << i;
+			dynamicTilesDrawn++;
+		}
+		tile.staticKey = view.staticKey;
+		tile.dynamicKey = view.dynamicKey;
+		tile.valid = true;
+	}
+}
+
+/***********************************************************************
+ * SetTile: Limits drawing to one tile.
+ * Author: [Smirti Parajuli]
+ * Description: The scissor keeps the depth clear inside the tile.
+ * Parameters:
+ *   - tile: The tile to draw into.
+ *
+ * Return: None
+ ***********************************************************************/
+void ShadowAtlas::SetTile(int tile) const
+{
+	GLint x = (tile % TilesPerRow) * TileSize;
+	GLint y = (tile / TilesPerRow) * TileSize;
+	glViewport(x, y, TileSize, TileSize);
+	glScissor(x, y, TileSize, TileSize);
+}
+
+/***********************************************************************
+ * Render: Brings the atlas up to date for this frame.
+ * Author: [Smirti Parajuli]
+ * Description: Draws the tiles picked by BeginFrame, if any, then binds
+ *              the atlas to its texture unit for the lighting.
+ * Parameters:
+ *   - frame: The snapshot holding the shadow views.
+ *   - stream: The per-frame stream buffer for the light FrameData.
+ *
+ * Return: None
+ ***********************************************************************/
+void ShadowAtlas::Render(const FrameSnapshot& frame, StreamBuffer& stream)
+{
+	// Every static tile also draws its moving casters
+	if (dynamicTiles != 0) {
+		DrawTiles(frame, stream);
+	}
+	GLState::Get().BindTexture(GL_TEXTURE_2D, atlasTexture, TextureUnit);
+}
+
+/***********************************************************************
+ * DrawTiles: Draws the casters into the picked tiles.
+ * Author: [Smirti Parajuli]
+ * Description: Each tile gets the view and projection of its light as
+ *              FrameData, so the animated sphere shaders place their
+ *              spheres as they do for the camera. The static casters go
+ *              into the static atlas first. Each tile with moving casters
+ *              then starts from a copy of its static tile. The casters are
+ *              drawn filled even in wireframe mode, with a slope scaled
+ *              depth offset against shadow acne. The caller rebinds the
+ *              camera FrameData afterwards.
+ * Parameters:
+ *   - frame: The snapshot holding the shadow views.
+ *   - stream: The per-frame stream buffer for the light FrameData.
+ *
+ * Return: None
+ ***********************************************************************/
+void ShadowAtlas::DrawTiles(const FrameSnapshot& frame, StreamBuffer& stream)
+{
+	GLState& state = GLState::Get();
+	GLintptr offsets[MaxShadowViews] = {};
+	for (int i = 0; i < MaxShadowViews; i++) {
+		if (!(dynamicTiles & (1u << i))) {
+			continue;
+		}
+		const ShadowView& view = frame.shadowViews[i];
+		FrameUniforms* uniforms = stream.Allocate<FrameUniforms>(offsets[i]);
+		if (!uniforms) {
+			// Out of stream space, the tile is drawn next frame
+			staticTiles &= ~(1u << i);
+			dynamicTiles &= ~(1u << i);
+			tiles[i].valid = false;
+			continue;
+		}
+		uniforms->view = view.view;
+		uniforms->projection = view.projection;
+		uniforms->cameraPosition = glm::inverse(view.view)[3];
+		uniforms->time = frame.animationTime;
+	}
+
+	GLint viewport[4] = {};
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	GLint polygonMode[2] = { GL_FILL, GL_FILL };
+	glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	state.SetEnabled(GL_SCISSOR_TEST, true);
+	state.SetEnabled(GL_POLYGON_OFFSET_FILL, true);
+	glPolygonOffset(SlopeBias, ConstantBias);
+	staticCasters.Sort();
+	dynamicCasters.Sort();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, staticFramebuffer);
+	for (int i = 0; i < MaxShadowViews; i++) {
+		if (!(staticTiles & (1u << i))) {
+			continue;
+		}
+		SetTile(i);
+		state.DepthMask(GL_TRUE);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		stream.BindRange(GL_UNIFORM_BUFFER, FrameDataBinding, offsets[i], sizeof(FrameUniforms));
+		staticCasters.ExecuteDepth(stream);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, atlasFramebuffer);
+	for (int i = 0; i < MaxShadowViews; i++) {
+		if (!(dynamicTiles & (1u << i))) {
+			continue;
+		}
+		GLint x = (i % TilesPerRow) * TileSize;
+		GLint y = (i / TilesPerRow) * TileSize;
+		glCopyImageSubData(staticTexture, GL_TEXTURE_2D, 0, x, y, 0, atlasTexture, GL_TEXTURE_2D, 0, x, y, 0, TileSize, TileSize, 1);
+		SetTile(i);
+		stream.BindRange(GL_UNIFORM_BUFFER, FrameDataBinding, offsets[i], sizeof(FrameUniforms));
+		dynamicCasters.ExecuteDepth(stream);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	state.SetEnabled(GL_SCISSOR_TEST, false);
+	state.SetEnabled(GL_POLYGON_OFFSET_FILL, false);
+	glPolygonMode(GL_FRONT_AND_BACK, static_cast<GLenum>(polygonMode[0]));
+}
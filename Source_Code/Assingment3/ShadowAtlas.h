@@ -0,0 +1,96 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :ShadowAtlas.h
+Description :  The ShadowAtlas holds the shadow maps of the directional
+               cascades and the spotlights as tiles of one depth texture,
+               so the lighting samples them all through one sampler. A
+               tile is only drawn again when something in it changed. The
+               simulation thread gives every view two keys: the static key
+               covers the view itself and the casters that never move, the
+               dynamic key the casters that do. The static casters are
+               kept in a second atlas of their own. When only the dynamic
+               key changed, the static tile is copied over the shadow tile
+               and only the moving casters are drawn on top. When nothing
+               changed, the tile is left as it is, so a still frame costs
+               no shadow drawing at all.
+               All access must happen on the thread that owns the GL context.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef SHADOWATLAS_H
+#define SHADOWATLAS_H
+
+#include <glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include "FrameSnapshot.h"
+#include "RenderQueue.h"
+#include "StreamBuffer.h"
+
+class ShadowAtlas
+{
+public:
+	static const int AtlasSize = 4096;
+	static const int TileSize = 1024;
+	static const int TilesPerRow = AtlasSize / TileSize;// SHADOW_TILES_PER_ROW in BlinnPhongLighting.glsl
+	static const GLuint TextureUnit = 4;// layout(binding = 4) of ShadowAtlas in BlinnPhongLighting.glsl
+	static_assert(TilesPerRow * TilesPerRow >= MaxShadowViews, "Every shadow view needs a tile");
+
+	static glm::mat4 GetTileMatrix(int tile);// Clip space of a shadow view to texture space of its tile
+
+	ShadowAtlas();
+	~ShadowAtlas();
+
+	void BeginFrame(const FrameSnapshot& frame);// Picks the tiles to draw and empties the caster queues
+	bool NeedsStaticCasters() const { return staticTiles != 0; }
+	bool NeedsDynamicCasters() const { return dynamicTiles != 0; }
+	RenderQueue& GetStaticCasters() { return staticCasters; }
+	RenderQueue& GetDynamicCasters() { return dynamicCasters; }
+	GLuint GetCasterProgram() const { return Program_Caster; }// Model matrices in InstanceData, depth only
+	void Render(const FrameSnapshot& frame, StreamBuffer& stream);// Draws the picked tiles and binds the atlas for the lighting
+
+	int GetStaticTilesDrawn() const { return staticTilesDrawn; }// Tiles whose static casters were drawn this frame
+	int GetDynamicTilesDrawn() const { return dynamicTilesDrawn; }// Tiles whose moving casters were drawn this frame
+
+	// Copying and assignment not allowed for this class
+	ShadowAtlas(const ShadowAtlas&) = delete;
+	ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+private:
+	static constexpr float SlopeBias = 2.0f;// glPolygonOffset while casters are drawn
+	static constexpr float ConstantBias = 4.0f;
+
+	// Keys the tile was last drawn with
+	struct Tile
+	{
+		std::uint64_t staticKey = 0;
+		std::uint64_t dynamicKey = 0;
+		bool valid = false;// Drawn at least once with these keys
+	};
+
+	GLuint CreateTexture(bool compare);// One level of 32-bit float depth, the size of the atlas
+	GLuint CreateFramebuffer(GLuint texture);// Depth only
+	void SetTile(int tile) const;// Viewport and scissor
+	void DrawTiles(const FrameSnapshot& frame, StreamBuffer& stream);
+
+	GLuint staticTexture = 0;// Static casters only
+	GLuint atlasTexture = 0;// Everything, sampled with depth comparison
+	GLuint staticFramebuffer = 0;
+	GLuint atlasFramebuffer = 0;
+	Tile tiles[MaxShadowViews];
+	std::uint32_t staticTiles = 0;// Bit i set when tile i draws its static casters this frame
+	std::uint32_t dynamicTiles = 0;// Bit i set when tile i draws its moving casters this frame
+	int staticTilesDrawn = 0;
+	int dynamicTilesDrawn = 0;
+
+	RenderQueue staticCasters;
+	RenderQueue dynamicCasters;
+	GLuint Program_Caster;
+};
+#endif // SHADOWATLAS_H
@@ -0,0 +1,235 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :Simulation.cpp
+Description :  Implementation of the simulation thread that produces frame
+               snapshots for the render thread.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "Simulation.h"
+#include "FrameArena.h"
+#include "HeapCounter.h"
+
+/***********************************************************************
+ * Simulation: Constructor for the Simulation class.
+ * Author: [Smirti Parajuli]
+ * Description: Stores the scene objects the simulation updates and the
+ *              buffers used to talk to the main thread.
+ *
+ * Parameters:
+ *   - camera: The camera moved by the user input.
+ *   - sphere: The sphere field animated and culled every frame.
+ *   - light: The lights toggled by the number keys.
+ *   - inputs: Input states published by the main thread.
+ *   - snapshots: Frame snapshots consumed by the render thread.
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+Simulation::Simulation(Camera& camera, Sphere& sphere, Light& light,
+	TripleBuffer<InputState>& inputs, TripleBuffer<FrameSnapshot>& snapshots)
+	: camera(camera), sphere(sphere), light(light), inputs(inputs), snapshots(snapshots),
+	frameClock(1.0f / 60.0f, 5), running(false), framesConsumed(0)
+{
+}
+
+/***********************************************************************
+ * ~Simulation: Destructor for the Simulation class.
+ * Author: [Smirti Parajuli]
+ * Description: Makes sure the thread is joined before the scene objects
+ *              it references are destroyed.
+ *
+ * Parameters: None
+ *
+ * Return: None (destructor)
+ ***********************************************************************/
+Simulation::~Simulation()
+{
+	Stop();
+}
+
+/***********************************************************************
+ * Start: Launches the simulation thread.
+ * Author: [Smirti Parajuli]
+ * Description: Resets the frame clock so loading time is not simulated,
+ *              then starts the loop on a new thread.
+ *
+ * Parameters:
+ *   - now: Current time in seconds.
+ *
+ * Return: None
+ ***********************************************************************/
+void Simulation::Start(double now)
+{
+	frameClock.Reset(now);
+	running = true;
+	thread = std::thread(&Simulation::Run, this);
+}
+
+/***********************************************************************
+ * Stop: Stops the simulation thread.
+ * Author: [Smirti Parajuli]
+ * Description: Signals the loop to exit and waits for the thread.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void Simulation::Stop()
+{
+	running = false;
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+/***********************************************************************
+ * NotifyFrameConsumed: Lets the simulation run one frame further ahead.
+ * Author: [Smirti Parajuli]
+ * Description: Called by the render thread each time it takes a new
+ *              snapshot. The simulation stays at most one frame ahead so
+ *              it overlaps GPU submission without wasting CPU time.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void Simulation::NotifyFrameConsumed()
+{
+	framesConsumed.fetch_add(1, std::memory_order_release);
+}
+
+/***********************************************************************
+ * Run: The simulation thread loop.
+ * Author: [Smirti Parajuli]
+ * Description: Steps the simulation at the fixed rate, interpolates the
+ *              result and publishes a snapshot for the render thread.
+ *              The frame arena of this thread is reset for every snapshot
+ *              and the heap allocations made meanwhile are recorded in it.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void Simulation::Run()
+{
+	while (running)
+	{
+		// Wait while the render thread has not picked up the previous snapshot yet
+		while (running && framesProduced > framesConsumed.load(std::memory_order_acquire) + 1) {
+			std::this_thread::yield();
+		}
+
+		FrameArena::ForThread().Reset();
+		std::uint64_t allocationsBefore = HeapCounter::GetThreadAllocations();
+
+		inputs.Consume();
+		const InputState& input = inputs.Read();
+
+		double now = glfwGetTime();
+		frameClock.BeginFrame(now);
+		while (frameClock.StepSimulation())
+		{
+			camera.Inputs(input, frameClock.GetFixedDelta());
+			light.HandleKeyPress(input);
+			HandleKeyPress(input);
+			sphere.HandleKeyPress(input);
+			sphere.Update(frameClock.GetFixedDelta());
+		}
+
+		// Blend the last two simulation states for rendering
+		float alpha = frameClock.GetAlpha();
+		camera.Interpolate(alpha);
+		sphere.Interpolate(alpha);
+
+		FrameSnapshot& frame = snapshots.BeginWrite();
+		BuildSnapshot(frame, input);
+		frame.simHeapAllocations = HeapCounter::GetThreadAllocations() - allocationsBefore;
+		snapshots.Publish();
+		framesProduced++;
+		frameClock.EndFrame(glfwGetTime());
+	}
+}
+
+/***********************************************************************
+ * BuildSnapshot: Fills a snapshot with the state for one frame.
+ * Author: [Smirti Parajuli]
+ * Description: Copies the camera matrices, culls the sphere field,
+ *              places the shadow maps and records the light toggles and
+ *              timing information.
+ *
+ * Parameters:
+ *   - frame: The snapshot slot to fill.
+ *   - input: The input state used for this frame.
+ *
+ * Return: None
+ ***********************************************************************/
+void Simulation::BuildSnapshot(FrameSnapshot& frame, const InputState& input)
+{
+	frame.aspect = static_cast<float>(camera.windowWidth) / static_cast<float>(camera.windowHeight);
+	frame.fov = camera.fov;
+	frame.view = camera.GetViewMatrix();
+	frame.projection = camera.GetProjectionMatrix(frame.fov, frame.aspect, frame.nearPlane, frame.farPlane);
+	frame.cameraPosition = camera.renderPosition;
+
+	// Cull and sort on this thread so the render thread only sees visible spheres, nearest first
+	Frustum frustum(frame.projection * frame.view);
+	sphere.BuildInstances(frustum, frame.cameraPosition, frame);
+	frame.totalSpheres = sphere.GetSphereCount();
+	frame.sphereAnimationOnGpu = sphere.IsGpuAnimationActive();
+	frame.animationTime = sphere.GetAnimationTime();
+	frame.sphereImpostors = sphere.IsImpostorsEnabled();
+	frame.sphereMeshletCulling = sphere.IsMeshletCullingEnabled();
+	frame.physicsEnabled = sphere.IsPhysicsEnabled();
+	frame.physicsContacts = sphere.GetContactCount();
+	frame.physicsStepMs = sphere.GetPhysicsStepMs();
+
+	frame.depthPrepass = depthPrepassEnabled;
+	frame.deferredShading = deferredShadingEnabled;
+
+	frame.pointLightsEnabled = light.IsPointLightsEnabled();
+	frame.pointLightCount = light.GetPointLightCount();
+	light.BuildMarkers(frustum, frame);
+	frame.directionalLightEnabled = light.IsDirectionalLightEnabled();
+	frame.spotLightsEnabled = light.IsSpotlightsEnabled();
+
+	// Shadow views and the keys that decide which of their tiles the render thread draws again
+	light.BuildShadowViews(frame);
+	sphere.BuildShadowCasters(frame);
+	// Probes sit at the reflective spheres placed by BuildInstances
+	sphere.BuildReflectionProbes(frame);
+
+	frame.frameIndex = framesProduced;
+	frame.inputSampleTime = input.sampleTime;
+	frame.simStepsPerSecond = frameClock.GetStepsPerSecond();
+	frame.droppedSteps = frameClock.GetDroppedSteps();
+}
+
+/***********************************************************************
+ * HandleKeyPress: Toggles the render settings.
+ * Author: [Smirti Parajuli]
+ * Description: 'Z' turns the depth pre-pass of the opaque geometry on
+ *              and off, 'F' switches between forward and deferred
+ *              shading.
+ *
+ * Parameters:
+ *   - input: The keyboard state sampled for this step.
+ *
+ * Return: None
+ ***********************************************************************/
+void Simulation::HandleKeyPress(const InputState& input)
+{
+	if (input.IsKeyDown(GLFW_KEY_Z) && !isPrepassKeyPressed) {
+		depthPrepassEnabled = !depthPrepassEnabled;
+	}
+	isPrepassKeyPressed = input.IsKeyDown(GLFW_KEY_Z);
+
+	if (input.IsKeyDown(GLFW_KEY_F) && !isDeferredKeyPressed) {
+		deferredShadingEnabled = !deferredShadingEnabled;
+	}
+	isDeferredKeyPressed = input.IsKeyDown(GLFW_KEY_F);
+}
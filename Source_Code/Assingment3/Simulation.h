@@ -0,0 +1,63 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :Simulation.h
+Description :  The Simulation class runs camera movement, sphere animation,
+               culling and light toggles on their own thread and publishes
+               one FrameSnapshot per frame for the render thread to draw.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <atomic>
+#include <thread>
+#include "Camera.h"
+#include "Sphere.h"
+#include "Light.h"
+#include "FrameClock.h"
+#include "FrameSnapshot.h"
+#include "InputState.h"
+#include "TripleBuffer.h"
+
+class Simulation
+{
+public:
+	Simulation(Camera& camera, Sphere& sphere, Light& light,
+		TripleBuffer<InputState>& inputs, TripleBuffer<FrameSnapshot>& snapshots);
+	~Simulation();
+
+	void Start(double now);// Launches the simulation thread
+	void Stop();// Signals the thread to finish and joins it
+	void NotifyFrameConsumed();// Called by the render thread after it picks up a new snapshot
+
+private:
+	void Run();
+	void BuildSnapshot(FrameSnapshot& frame, const InputState& input);
+	void HandleKeyPress(const InputState& input);// Toggles the depth pre-pass with 'Z' and deferred shading with 'F'
+
+	Camera& camera;
+	Sphere& sphere;
+	Light& light;
+	TripleBuffer<InputState>& inputs;// Written by the main thread, read here
+	TripleBuffer<FrameSnapshot>& snapshots;// Written here, read by the render thread
+
+	FrameClock frameClock;
+	std::thread thread;
+	std::atomic<bool> running;
+	std::atomic<unsigned long long> framesConsumed;
+	unsigned long long framesProduced = 0;
+
+	// Render settings, handed to the render thread through the snapshot
+	bool depthPrepassEnabled = false;
+	bool isPrepassKeyPressed = false;// Key 'Z' held during the previous step
+	bool deferredShadingEnabled = false;
+	bool isDeferredKeyPressed = false;// Key 'F' held during the previous step
+};
+#endif // SIMULATION_H
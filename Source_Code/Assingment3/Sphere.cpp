@@ -13,9 +13,28 @@
  ***********************************************************************/
 
 #include "Sphere.h"
+#include "ShaderBindings.h"
+#include "FrameArena.h"
 #include <cmath>
 #include <cstdlib> // Include necessary header for rand() and srand()
 #include <ctime>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+
+namespace {
+    const std::uint64_t HashSeed = 14695981039346656037ull;// FNV-1a offset basis
+
+    // FNV-1a, enough to tell whether anything in a shadow view changed
+    std::uint64_t HashBytes(std::uint64_t hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+}
 
 
 
@@ -31,19 +50,50 @@
   * Return: None (constructor)
   ***********************************************************************/
 
-Sphere::Sphere()
-    : position(0.0f), rotation(0.0f), texture("Resources/Textures/Rayman.jpg") {
+Sphere::Sphere(EntityStore& entities, JobSystem& jobs)
+    : entities(entities), jobs(jobs), texture("Resources/Textures/Rayman.jpg", jobs),
+    physics(entities, jobs, sphereRadius, -10.0f, 10.0f) {
+    // The texture decodes on a worker while the shader, mesh and placement are done here
     Program_Reflection = ShaderLoader::CreateProgram("Resources/Shaders/reflective.vs", "Resources/Shaders/reflective.fs");
+    reflectionModelLocation = glGetUniformLocation(Program_Reflection, "model");
+    Program_Animated = ShaderLoader::CreateProgram("Resources/Shaders/AnimatedInstances.vs", "Resources/Shaders/Blinn_PhongLight.fs");
+    Program_Impostor = ShaderLoader::CreateProgram("Resources/Shaders/SphereImpostor.vs", "Resources/Shaders/SphereImpostor.fs");
+    Program_AnimatedImpostor = ShaderLoader::CreateProgram("Resources/Shaders/AnimatedImpostor.vs", "Resources/Shaders/SphereImpostor.fs");
+    Program_ReflectiveImpostor = ShaderLoader::CreateProgram("Resources/Shaders/SphereImpostor.vs", "Resources/Shaders/ReflectiveImpostor.fs");
+    Program_Culled = ShaderLoader::CreateProgram("Resources/Shaders/CulledInstances.vs", "Resources/Shaders/Blinn_PhongLight.fs");
+    Program_CulledAnimated = ShaderLoader::CreateProgram("Resources/Shaders/CulledAnimatedInstances.vs", "Resources/Shaders/Blinn_PhongLight.fs");
+    // The depth pre-pass draws the same vertices without shading, the impostors write their depth while shading
+    Program_AnimatedDepth = ShaderLoader::CreateProgram("Resources/Shaders/AnimatedInstances.vs", "Resources/Shaders/DepthOnly.fs");
+    Program_CulledDepth = ShaderLoader::CreateProgram("Resources/Shaders/CulledInstances.vs", "Resources/Shaders/DepthOnly.fs");
+    Program_CulledAnimatedDepth = ShaderLoader::CreateProgram("Resources/Shaders/CulledAnimatedInstances.vs", "Resources/Shaders/DepthOnly.fs");
+    // The deferred path stores the same surfaces in the G-buffer, the impostors stay forward shaded
+    Program_AnimatedGBuffer = ShaderLoader::CreateProgram("Resources/Shaders/AnimatedInstances.vs", "Resources/Shaders/GBuffer.fs");
+    Program_CulledGBuffer = ShaderLoader::CreateProgram("Resources/Shaders/CulledInstances.vs", "Resources/Shaders/GBuffer.fs");
+    Program_CulledAnimatedGBuffer = ShaderLoader::CreateProgram("Resources/Shaders/CulledAnimatedInstances.vs", "Resources/Shaders/GBuffer.fs");
+    // The impostors trace a sphere of the mesh radius, which never changes
+    for (GLuint program : { Program_Impostor, Program_AnimatedImpostor, Program_ReflectiveImpostor }) {
+        glProgramUniform1f(program, glGetUniformLocation(program, "sphereRadius"), sphereRadius);
+    }
     // Clean up the used memory
 
     CreateSphere();
+    CreateImpostorQuad();
     SetPosition(sphereRadius); // Calling the setPosition() method to initialize the mesh and set Positions for spheres
+    CreateAnimations();
+    // Every sphere may be tested in one pass, so each meshlet has room for all of them
+    meshletCuller.Create(*sphereMesh, static_cast<GLuint>(sphereCount));
+    for (GLuint program : { Program_Culled, Program_CulledAnimated, Program_CulledDepth, Program_CulledAnimatedDepth,
+        Program_CulledGBuffer, Program_CulledAnimatedGBuffer }) {
+        glProgramUniform1ui(program, glGetUniformLocation(program, "meshletInstanceStride"), meshletCuller.GetInstanceStride());
+    }
+    reflectiveEntity = entities.Create(glm::vec3(0.0f), 1.0f, MaterialReflective, EntityVisible | EntityCullable);
+    texture.FinishLoad();
 }
 /***********************************************************************
   * SkyBox:  Destructor for the Sphere class.
   * Author: [Smirti Parajuli]
-  * Description: Destructor for the Sphere class that deallocates memory
- *              used by the vertex and index arrays.
+  * Description: Destructor for the Sphere class that deletes the
+ *              animation buffer, the meshes free themselves.
   *
   * Parameters:None
   *
@@ -51,9 +101,7 @@ Sphere::Sphere()
   * Return: None (constructor)
   ***********************************************************************/
 Sphere::~Sphere() {
-    delete[] vertices;
-    delete[] indices;
-    // Free the memory allocated for the mesh object
+    glDeleteBuffers(1, &animationBuffer);
 }
 /***********************************************************************
  * Function: CreateSphere
@@ -65,16 +113,18 @@ Sphere::~Sphere() {
  * Return:    None (constructor)
  ***********************************************************************/
 void Sphere::CreateSphere() {
-    float radius = 0.4f;
+    float radius = sphereRadius;
     int quality = 20;		// Relates to how many rings/facets for the sphere
     int vertexAttrib = 8;	// Float components are needed for each vertex point
     int indexPerQuad = 6;	// Indices needed to create a quad
     // Angles to keep track of the sphere points 
     float Phi = 0.0f;
     float Theta = 0.0f;
+    // The arrays are only staging for the mesh, so they come from the scratch arena and go with the scope
+    ScratchScope scratch;
     // Create the vertex array to hold the correct number of elements based on the fidelity of the sphere
     int vertexCount = quality * quality * vertexAttrib;
-    GLfloat* vertices = new GLfloat[vertexCount];
+    GLfloat* vertices = scratch.Allocate<GLfloat>(vertexCount);
     int element = 0;
 
     // Each cycle moves down on the vertical (Y axis) to start the next ring
@@ -117,7 +167,7 @@ void Sphere::CreateSphere() {
 
     // Create the index array to hold the correct number of elements based on the fidelity of the sphere
     indexCount = quality * quality * indexPerQuad;
-    GLuint* indices = new GLuint[indexCount];
+    GLuint* indices = scratch.Allocate<GLuint>(indexCount);
 
 
     element = 0;	// Reset the element offset for the new array
@@ -138,10 +188,28 @@ void Sphere::CreateSphere() {
     }
     // Convert the std::vector to raw arrays
     // Create the Vertex Array and associated buffers
-    sphereMesh = std::make_unique<Mesh>(vertices, indices, vertexCount, indexCount);
+    // Split into meshlets so the halves facing away from the camera can be skipped
+    // The sphere only has quality * quality vertices, 32 per meshlet keeps each one's normal cone narrow
+    sphereMesh = std::make_unique<Mesh>(vertices, indices, vertexCount, indexCount, VertexFormat::HalfOctahedral, true, 32);
 
     DrawType = GL_TRIANGLES;
 }
+/***********************************************************************
+ * Function: CreateImpostorQuad
+ * Author: [Smirti Parajuli]
+ * Description: Creates the mesh drawn for every sphere impostor. Only
+ *              its two triangles matter, the impostor vertex shader
+ *              places the four corners itself, so the vertices are empty.
+ * Parameters: None
+ * Return : None
+ ***********************************************************************/
+void Sphere::CreateImpostorQuad() {
+    GLfloat quadVertices[4 * 8] = {};
+    GLuint quadIndices[6] = { 0, 1, 2, 2, 1, 3 };
+    // Kept unoptimized, the impostor shader finds each corner from its vertex number
+    impostorQuad = std::make_unique<Mesh>(quadVertices, quadIndices, 4 * 8, 6, VertexFormat::HalfOctahedral, false);
+}
+
 /***********************************************************************
  * Function: isOverlapping
  * Author: [Smirti Parajuli]
@@ -154,7 +222,11 @@ void Sphere::CreateSphere() {
  ***********************************************************************/
 // Function to check if the new sphere overlaps with existing spheres
 bool Sphere:: isOverlapping(const glm::vec3& newPos, float sphereRadius) {
-    for (const auto& pos : positions) {
+    for (size_t i = 0; i < entities.Size(); ++i) {
+        if (entities.material[i] != MaterialSphere) {
+            continue;
+        }
+        glm::vec3 pos(entities.positionX[i], entities.positionY[i], entities.positionZ[i]);
         if (glm::distance(newPos, pos) < 2 * sphereRadius) {
             // The new Position is too close to an existing sphere, so they would overlap
             return true;
@@ -166,7 +238,9 @@ bool Sphere:: isOverlapping(const glm::vec3& newPos, float sphereRadius) {
  * Function: SetPosition
  *  Author: [Smirti Parajuli]
  * Description: Randomly places spheres within a defined volume and ensures
- *              they do not overlap.
+ *              they do not overlap. All the candidate positions of a sphere
+ *              are tested at once as jobs and the first free one is kept,
+ *              the same pick as trying them one after another.
  * Parameters:
  *   - sphereRadius: The radius of the spheres to set the position for.
  * Return : None
@@ -186,30 +260,40 @@ void Sphere :: SetPosition(float sphereRadius) {
     float zMin = -10.0f;
     float zMax = 10.0f;
 
-    positions.reserve(numSpheres);  // Reserve space for all spheres to prevent reallocations
+    entities.Reserve(entities.Size() + numSpheres + 1);  // Reserve space for all spheres to prevent reallocations
+
+    // Attempt to place a sphere up to a certain number of tries
+    const int maxTries = 100;
+    std::vector<glm::vec3> candidates(maxTries);
+    std::vector<char> candidateOverlaps(maxTries);
 
     for (int i = 0; i < numSpheres; ++i) {
-        bool overlapping;
-        glm::vec3 newPos{};
+        // Generate random Positions within the defined bounds
+        for (glm::vec3& candidate : candidates) {
+            candidate.x = xMin + static_cast<float>(std::rand()) / (static_cast<float>(RAND_MAX / (xMax - xMin)));
+            candidate.y = yMin + static_cast<float>(std::rand()) / (static_cast<float>(RAND_MAX / (yMax - yMin)));
+            candidate.z = zMin + static_cast<float>(std::rand()) / (static_cast<float>(RAND_MAX / (zMax - zMin)));
+        }
 
-        // Attempt to place a sphere up to a certain number of tries
-        const int maxTries = 100;
-        for (int tries = 0; tries < maxTries; ++tries) {
-            // Generate random Positions within the defined bounds
-            newPos.x = xMin + static_cast<float>(std::rand()) / (static_cast<float>(RAND_MAX / (xMax - xMin)));
-            newPos.y = yMin + static_cast<float>(std::rand()) / (static_cast<float>(RAND_MAX / (yMax - yMin)));
-            newPos.z = zMin + static_cast<float>(std::rand()) / (static_cast<float>(RAND_MAX / (zMax - zMin)));
-
-            overlapping = isOverlapping(newPos, sphereRadius);
-            if (!overlapping) {
-                // If it's not overlapping, break out of the loop and add the new Position
-                break;
+        // Only reads the store, so the candidates can be checked side by side
+        jobs.ParallelFor(candidates.size(), CandidateGrain, [&](size_t begin, size_t end) {
+            for (size_t tries = begin; tries < end; ++tries) {
+                candidateOverlaps[tries] = isOverlapping(candidates[tries], sphereRadius);
             }
-            // If we've reached maxTries and still overlap, we may need to reconsider the number of spheres or the size of the window
+        });
+
+        // Keep the first candidate that does not overlap
+        bool overlapping = true;
+        glm::vec3 newPos{};
+        for (int tries = 0; tries < maxTries && overlapping; ++tries) {
+            overlapping = candidateOverlaps[tries] != 0;
+            newPos = candidates[tries];
         }
+        // If every try overlaps, we may need to reconsider the number of spheres or the size of the window
 
         if (!overlapping) {
-            positions.push_back(newPos);
+            entities.Create(newPos, 1.0f, MaterialSphere, EntityVisible | EntitySpinning | EntityCullable | EntityDynamic);
+            sphereCount++;
         }
         else {
             // Handle the situation where a Position couldn't be found
@@ -219,110 +303,702 @@ void Sphere :: SetPosition(float sphereRadius) {
 }
 
 /***********************************************************************
- * Function: Render
+ * Function: CreateAnimations
  * Author: [Smirti Parajuli]
- * Description: Renders all the spheres using the provided shader program
- *              and the camera for view/projection matrices.
+ * Description: Gives every sphere its own spin, bob, orbit and colour
+ *              pulse and uploads them once to an immutable storage buffer.
+ *              The vertex shader evaluates them from the frame time, so
+ *              animating the spheres costs no CPU time and no uploads.
+ *              Entry i belongs to the i-th sphere in the entity store.
+ * Parameters: None
+ * Return : None
+ ***********************************************************************/
+void Sphere::CreateAnimations() {
+    auto random = [](float low, float high) {
+        return low + (high - low) * (static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX));
+    };
+    const float twoPi = 2.0f * static_cast<float>(M_PI);
+
+    // Staging for the upload only
+    ScratchScope scratch;
+    InstanceAnimation* animations = scratch.Allocate<InstanceAnimation>(sphereCount);
+    size_t animationCount = 0;
+    for (size_t i = 0; i < entities.Size(); ++i) {
+        if (entities.material[i] != MaterialSphere) {
+            continue;
+        }
+        InstanceAnimation animation;
+        animation.basePosition = glm::vec4(entities.positionX[i], entities.positionY[i], entities.positionZ[i], entities.scale[i]);
+        animation.baseRotation = glm::vec4(entities.rotationX[i], entities.rotationY[i], entities.rotationZ[i], entities.rotationW[i]);
+
+        // Around 80 degrees a second about an axis close to Y, like the CPU spin
+        glm::vec3 axis = glm::normalize(glm::vec3(random(-0.3f, 0.3f), 1.0f, random(-0.3f, 0.3f)));
+        animation.spin = glm::vec4(axis, glm::radians(random(60.0f, 100.0f)));
+        animation.bob = glm::vec4(random(0.05f, 0.2f), random(1.0f, 3.0f), random(0.0f, twoPi), 0.0f);
+        // Orbits stay inside the gap SetPosition leaves between spheres
+        float orbitSpeed = random(0.3f, 1.0f) * ((std::rand() % 2) ? 1.0f : -1.0f);
+        animation.orbit = glm::vec4(random(0.0f, 0.3f), orbitSpeed, random(0.0f, twoPi), 0.0f);
+        animation.pulse = glm::vec4(random(0.5f, 1.0f), random(0.5f, 1.0f), random(0.5f, 1.0f), random(0.5f, 2.0f));
+        animations[animationCount++] = animation;
+    }
+
+    // Never written again, so the storage does not need any access flags
+    glGenBuffers(1, &animationBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, animationBuffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(InstanceAnimation) * animationCount, animations, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+/***********************************************************************
+ * Function: BuildInstances
+ * Author: [Smirti Parajuli]
+ * Description: Builds the model matrix of every sphere that is inside the
+ *              view frustum, nearest to the camera first so the instanced
+ *              draw fills the depth buffer front to back. Culling walks the
+ *              entity store arrays linearly. Runs on the simulation thread
+ *              and writes into the frame snapshot, so the render thread
+ *              only uploads them. The work is a small task graph: sphere
+ *              culling, split into jobs, feeds the transform kernel jobs
+ *              while the reflective spheres are handled beside them.
+ *              While the spheres are animated on the GPU only the
+ *              reflective spheres are handled here. The culling lists
+ *              come from the frame arena of the simulation thread, taken
+ *              before any job starts since the arena is not shared.
+ * Parameters:
+ *   - frustum: The camera frustum for this frame.
+ *   - cameraPosition: The camera position used for the sort.
+ *   - frame: Snapshot whose sphere transforms and reflective models are refilled.
+ * Return : None
+ ***********************************************************************/
+void Sphere::BuildInstances(const Frustum& frustum, const glm::vec3& cameraPosition, FrameSnapshot& frame) const {
+    instanceGraph.Clear();
+    FrameArena& arena = FrameArena::ForThread();
+    size_t entityCount = entities.Size();
+
+    std::uint32_t* reflectiveIndices = arena.Allocate<std::uint32_t>(entityCount);
+    instanceGraph.Add([&] {
+        size_t reflectiveCount = entities.Cull(frustum, MaterialReflective, sphereRadius, reflectiveIndices);
+        frame.reflectiveModels.clear();
+        for (size_t i = 0; i < reflectiveCount; ++i) {
+            frame.reflectiveModels.push_back(entities.BuildModel(reflectiveIndices[i], glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+        }
+    });
+
+    // Animated on the GPU, the vertex shader places every sphere itself
+    if (IsGpuAnimationActive()) {
+        frame.sphereInstances.clear();
+        instanceGraph.Run(jobs);
+        return;
+    }
+
+    // The culling job of range [begin, end) writes its spheres from culled + begin
+    size_t chunkCount = (entityCount + CullGrain - 1) / CullGrain;
+    std::uint32_t* culled = arena.Allocate<std::uint32_t>(entityCount);
+    size_t* culledCounts = arena.Allocate<size_t>(chunkCount);
+    VisibleSphere* visibleSpheres = arena.Allocate<VisibleSphere>(entityCount);
+    std::uint32_t* instanceIndices = arena.Allocate<std::uint32_t>(entityCount);// Entity index of every visible sphere, nearest first
+    size_t instanceCount = 0;
+
+    size_t cullSpheres = instanceGraph.Add([&] {
+        // Every job culls its own range, joining them in order matches a single pass
+        jobs.ParallelFor(entityCount, CullGrain, [&](size_t begin, size_t end) {
+            culledCounts[begin / CullGrain] = entities.Cull(frustum, MaterialSphere, sphereRadius, begin, end, culled + begin);
+        });
+
+        size_t visibleCount = 0;
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            const std::uint32_t* indices = culled + chunk * CullGrain;
+            for (size_t i = 0; i < culledCounts[chunk]; ++i) {
+                std::uint32_t index = indices[i];
+                float dx = entities.positionX[index] - cameraPosition.x;
+                float dy = entities.positionY[index] - cameraPosition.y;
+                float dz = entities.positionZ[index] - cameraPosition.z;
+                visibleSpheres[visibleCount++] = { dx * dx + dy * dy + dz * dz, index };
+            }
+        }
+        std::sort(visibleSpheres, visibleSpheres + visibleCount,
+            [](const VisibleSphere& a, const VisibleSphere& b) { return a.distanceSquared < b.distanceSquared; });
+        for (size_t i = 0; i < visibleCount; ++i) {
+            instanceIndices[i] = visibleSpheres[i].index;
+        }
+        instanceCount = visibleCount;
+    });
+
+    size_t buildSpheres = instanceGraph.Add([&] {
+        TransformSource source;
+        source.positionX = entities.positionX.data();
+        source.positionY = entities.positionY.data();
+        source.positionZ = entities.positionZ.data();
+        source.rotationX = entities.rotationX.data();
+        source.rotationY = entities.rotationY.data();
+        source.rotationZ = entities.rotationZ.data();
+        source.rotationW = entities.rotationW.data();
+        source.scale = entities.scale.data();
+
+        // Spinning spheres are turned back to where they are between fixed steps
+        // Moving spheres are also moved back along their velocity
+        TransformParams params;
+        params.extraRotation = renderCorrection;
+        if (physicsEnabled) {
+            source.velocityX = entities.velocityX.data();
+            source.velocityY = entities.velocityY.data();
+            source.velocityZ = entities.velocityZ.data();
+            params.timeOffset = renderTimeOffset;
+        }
+        params.writePVM = true;
+        params.viewProjection = frame.projection * frame.view;
+
+        // The kernel builds the model, normal and PVM matrices of whole batches at once
+        frame.sphereInstances.resize(instanceCount);
+        jobs.ParallelFor(instanceCount, InstanceGrain, [&](size_t begin, size_t end) {
+            TransformKernel::Build(source, instanceIndices + begin, end - begin, params, frame.sphereInstances.data() + begin);
+        });
+    });
+    instanceGraph.Precede(cullSpheres, buildSpheres);
+
+    instanceGraph.Run(jobs);
+}
+
+/***********************************************************************
+ * Function: Submit
+ * Author: [Smirti Parajuli]
+ * Description: Queues all the visible spheres as one instanced draw.
+ *              The instance transforms from the frame snapshot are copied
+ *              straight into the mapped stream buffer and read by the
+ *              vertex shader through the InstanceData storage block.
+ *              The packet is keyed by the nearest sphere. While the
+ *              spheres are animated on the GPU nothing is copied. With
+ *              impostors on, each sphere is a quad instead of the mesh.
+ *              Impostors write their depth while shading, so they stay
+ *              out of the depth pre-pass and the G-buffer.
  * Parameters:
- *   - camera: The camera from which the scene is viewed.
+ *   - queue: The render queue for this frame.
+ *   - frame: The snapshot built by the simulation thread.
  *   - shaderProgram: The shader program used for rendering.
+ *   - depthProgram: shaderProgram's vertex shader with DepthOnly.fs.
+ *   - gbufferProgram: shaderProgram's vertex shader with GBuffer.fs.
+ *   - stream: The per-frame stream buffer for the instance data.
+ * Return : None
+ ***********************************************************************/
+
+void Sphere::Submit(RenderQueue& queue, const FrameSnapshot& frame, GLuint shaderProgram, GLuint depthProgram, GLuint gbufferProgram, StreamBuffer& stream) {
+    if (frame.sphereAnimationOnGpu) {
+        SubmitAnimated(queue, frame);
+        return;
+    }
+
+    GLsizei instanceCount = static_cast<GLsizei>(frame.sphereInstances.size());
+    if (instanceCount == 0) {
+        return;
+    }
+
+    // Write the instance transforms directly into GPU visible memory
+    GLintptr offset = 0;
+    GLsizeiptr size = sizeof(InstanceTransform) * instanceCount;
+    InstanceTransform* instances = stream.Allocate<InstanceTransform>(offset, instanceCount);
+    if (!instances) {
+        return;
+    }
+    std::memcpy(instances, frame.sphereInstances.data(), size);
+
+    // Every sphere shares the same mesh, so they are drawn in one call
+    DrawPacket packet;
+    packet.program = frame.sphereImpostors ? Program_Impostor : shaderProgram;
+    packet.depthProgram = frame.sphereImpostors ? 0 : depthProgram;
+    packet.gbufferProgram = frame.sphereImpostors ? 0 : gbufferProgram;
+    (frame.sphereImpostors ? impostorQuad : sphereMesh)->SetGeometry(packet);
+    if (frame.sphereMeshletCulling && !frame.sphereImpostors && meshletCuller.IsReady()) {
+        // One indirect draw per meshlet, holding only the spheres that kept it
+        stream.BindRange(GL_SHADER_STORAGE_BUFFER, InstanceDataBinding, offset, size);
+        meshletCuller.Cull(frame.projection * frame.view, static_cast<GLuint>(instanceCount), false);
+        packet.program = Program_Culled;
+        packet.depthProgram = Program_CulledDepth;
+        packet.gbufferProgram = Program_CulledGBuffer;
+        meshletCuller.SetGeometry(packet);
+    }
+    packet.texture = texture.GetID();
+    packet.instanceCount = instanceCount;
+    packet.rangeTarget = GL_SHADER_STORAGE_BUFFER;
+    packet.rangeIndex = InstanceDataBinding;
+    packet.rangeBuffer = stream.GetID();
+    packet.rangeOffset = offset;
+    packet.rangeSize = size;
+
+    float nearest = glm::length(glm::vec3(frame.sphereInstances[0].model[3]) - frame.cameraPosition);
+    packet.key = RenderQueue::MakeKey(RenderPass::Opaque, packet.program, packet.texture, packet.vertexArray, nearest / frame.farPlane);
+    queue.Submit(packet);
+}
+
+/***********************************************************************
+ * Function: BuildShadowCasters
+ * Author: [Smirti Parajuli]
+ * Description: Tests every sphere against the shadow views placed by
+ *              Light::BuildShadowViews. A view's static key hashes its
+ *              matrices and the spheres that never move inside it, its
+ *              dynamic key the moving spheres inside it. A sphere casts
+ *              the same shadow however it is spun, so only its position
+ *              and scale are hashed and the spin is left out of its model
+ *              matrix, a spinning sphere that stays in place keeps its
+ *              tiles cached. Spheres animated on the GPU are left out, the
+ *              atlas draws them every frame. Runs on the simulation thread.
+ * Parameters:
+ *   - frame: The snapshot holding the shadow views, whose keys and caster
+ *            lists are filled in.
  * Return : None
  ***********************************************************************/
+void Sphere::BuildShadowCasters(FrameSnapshot& frame) const {
+    frame.staticShadowCasters.clear();
+    frame.dynamicShadowCasters.clear();
+    if (!frame.shadowsEnabled) {
+        return;
+    }
 
-void Sphere::Render(const Camera& camera, GLuint shaderProgram) {
-    // Set up view and projection matrices based on the camera
-    glm::mat4 view = camera.GetViewMatrix();
-    glm::mat4 projection = camera.GetProjectionMatrix(static_cast<float>(camera.fov),
-        static_cast<float>(camera.windowWidth) / static_cast<float>(camera.windowHeight),
-        0.1f, 1000.0f);
-
-    // Use the shader program
-    glUseProgram(shaderProgram);
-
-    // Bind the VAO (assumes you've created and populated this with your sphere data)
-   
-
-    // Loop through each Position to draw the spheres
-    for (const auto& pos : positions) {
-        glBindVertexArray(sphereMesh->GetVAO());
-        // Create model matrix for the current sphere
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), pos);
-        model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-
-        // Compute the PVM matrix
-        glm::mat4 PVM = projection * view * model;
-
-        // Set the uniforms for model and PVM matrices in the shader
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "PVM"), 1, GL_FALSE, glm::value_ptr(PVM));
-        
-        // Draw the sphere using your chosen method (glDrawArrays, glDrawElements, etc.)
-        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
-    }
-    sphereMesh->Draw();
-    // Unbind the VAO
- 
-    // Unuse the shader program
-    glUseProgram(0);
+    int viewCount = ShadowCascadeCount + frame.spotShadowCount;
+    Frustum frusta[MaxShadowViews];
+    for (int v = 0; v < viewCount; ++v) {
+        ShadowView& view = frame.shadowViews[v];
+        frusta[v] = Frustum(view.projection * view.view);
+        view.staticKey = HashBytes(HashSeed, &view.view, sizeof(glm::mat4));
+        view.staticKey = HashBytes(view.staticKey, &view.projection, sizeof(glm::mat4));
+        view.dynamicKey = HashSeed;
+    }
+
+    bool gpuAnimated = IsGpuAnimationActive();
+    for (size_t i = 0; i < entities.Size(); ++i) {
+        std::uint16_t material = entities.material[i];
+        if ((material != MaterialSphere && material != MaterialReflective) || !(entities.flags[i] & EntityVisible)) {
+            continue;
+        }
+        if (gpuAnimated && material == MaterialSphere) {
+            continue;
+        }
+
+        // Position and scale, moved back to the interpolated moment like the drawn spheres
+        bool dynamic = (entities.flags[i] & EntityDynamic) != 0;
+        glm::vec4 caster(entities.positionX[i], entities.positionY[i], entities.positionZ[i], entities.scale[i]);
+        if (dynamic && physicsEnabled) {
+            caster += glm::vec4(entities.velocityX[i], entities.velocityY[i], entities.velocityZ[i], 0.0f) * renderTimeOffset;
+        }
+
+        bool inside = false;
+        for (int v = 0; v < viewCount; ++v) {
+            if (!frusta[v].IsSphereVisible(glm::vec3(caster), sphereRadius * caster.w)) {
+                continue;
+            }
+            std::uint64_t& key = dynamic ? frame.shadowViews[v].dynamicKey : frame.shadowViews[v].staticKey;
+            key = HashBytes(key, &caster, sizeof(caster));
+            inside = true;
+        }
+        if (inside) {
+            glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(caster)), glm::vec3(caster.w));
+            (dynamic ? frame.dynamicShadowCasters : frame.staticShadowCasters).push_back(model);
+        }
+    }
+}
+
+/***********************************************************************
+ * Function: SubmitShadowCasters
+ * Author: [Smirti Parajuli]
+ * Description: Queues the static casters when a tile redraws them and
+ *              the moving casters when a tile redraws those. Spheres
+ *              animated on the GPU are drawn by the animated depth
+ *              program, which reads the light matrices and the time from
+ *              the FrameData block the atlas binds per tile.
+ * Parameters:
+ *   - atlas: The shadow atlas, after its BeginFrame.
+ *   - frame: The snapshot built by the simulation thread.
+ *   - stream: The per-frame stream buffer for the model matrices.
+ * Return : None
+ ***********************************************************************/
+void Sphere::SubmitShadowCasters(ShadowAtlas& atlas, const FrameSnapshot& frame, StreamBuffer& stream) const {
+    if (atlas.NeedsStaticCasters()) {
+        SubmitModels(atlas.GetStaticCasters(), frame.staticShadowCasters, atlas.GetCasterProgram(), 0, stream);
+    }
+    if (!atlas.NeedsDynamicCasters()) {
+        return;
+    }
+    if (!frame.sphereAnimationOnGpu) {
+        SubmitModels(atlas.GetDynamicCasters(), frame.dynamicShadowCasters, atlas.GetCasterProgram(), 0, stream);
+        return;
+    }
+    SubmitAnimatedMesh(atlas.GetDynamicCasters(), Program_AnimatedDepth, Program_AnimatedDepth, 0);
+}
+
+/***********************************************************************
+ * Function: BuildReflectionProbes
+ * Author: [Smirti Parajuli]
+ * Description: Places a probe at the centre of every reflective sphere,
+ *              up to ReflectionProbes::MaxProbes, and tests the spheres
+ *              against the six faces of each. A face key hashes the probe
+ *              position and the position and scale of every sphere inside
+ *              the face, so it only changes when the face would look
+ *              different. The spin is left out, as for the shadow
+ *              casters. Spheres animated on the GPU are left out, the
+ *              probes treat every face as changed then. Runs on the
+ *              simulation thread after BuildInstances.
+ * Parameters:
+ *   - frame: The snapshot holding the reflective models, whose probe
+ *            lists are refilled.
+ * Return : None
+ ***********************************************************************/
+void Sphere::BuildReflectionProbes(FrameSnapshot& frame) const {
+    frame.reflectionProbesEnabled = reflectionProbesEnabled;
+    frame.reflectionProbes.clear();
+    frame.probeSphereModels.clear();
+    frame.reflectiveProbeIndices.assign(frame.reflectiveModels.size(), -1);
+    if (!reflectionProbesEnabled) {
+        return;
+    }
+
+    for (size_t i = 0; i < entities.Size() && frame.reflectionProbes.size() < ReflectionProbes::MaxProbes; ++i) {
+        if (entities.material[i] != MaterialReflective || !(entities.flags[i] & EntityVisible)) {
+            continue;
+        }
+        ReflectionProbeView probe;
+        probe.position = glm::vec3(entities.positionX[i], entities.positionY[i], entities.positionZ[i]);
+        probe.nearPlane = sphereRadius * entities.scale[i] * ProbeNearScale;
+        frame.reflectionProbes.push_back(probe);
+    }
+
+    size_t probeCount = frame.reflectionProbes.size();
+    Frustum frusta[ReflectionProbes::MaxProbes][ReflectionProbes::FaceCount];
+    for (size_t p = 0; p < probeCount; ++p) {
+        ReflectionProbeView& probe = frame.reflectionProbes[p];
+        glm::mat4 projection = ReflectionProbes::GetProjection(probe.nearPlane);
+        std::uint64_t probeKey = HashBytes(HashSeed, &probe, sizeof(glm::vec3) + sizeof(float));
+        for (int face = 0; face < ReflectionProbes::FaceCount; ++face) {
+            frusta[p][face] = Frustum(projection * ReflectionProbes::GetFaceView(probe.position, face));
+            probe.faceKeys[face] = probeKey;
+        }
+    }
+
+    // Each reflective sphere reflects the probe at its own centre
+    for (size_t m = 0; m < frame.reflectiveModels.size(); ++m) {
+        glm::vec3 centre(frame.reflectiveModels[m][3]);
+        for (size_t p = 0; p < probeCount; ++p) {
+            if (frame.reflectionProbes[p].position == centre) {
+                frame.reflectiveProbeIndices[m] = static_cast<int>(p);
+                break;
+            }
+        }
+    }
+
+    if (probeCount == 0 || IsGpuAnimationActive()) {
+        return;
+    }
+    for (size_t i = 0; i < entities.Size(); ++i) {
+        if (entities.material[i] != MaterialSphere || !(entities.flags[i] & EntityVisible)) {
+            continue;
+        }
+        glm::vec4 sphere(entities.positionX[i], entities.positionY[i], entities.positionZ[i], entities.scale[i]);
+        if ((entities.flags[i] & EntityDynamic) && physicsEnabled) {
+            sphere += glm::vec4(entities.velocityX[i], entities.velocityY[i], entities.velocityZ[i], 0.0f) * renderTimeOffset;
+        }
+
+        bool inside = false;
+        for (size_t p = 0; p < probeCount; ++p) {
+            for (int face = 0; face < ReflectionProbes::FaceCount; ++face) {
+                if (!frusta[p][face].IsSphereVisible(glm::vec3(sphere), sphereRadius * sphere.w)) {
+                    continue;
+                }
+                std::uint64_t& key = frame.reflectionProbes[p].faceKeys[face];
+                key = HashBytes(key, &sphere, sizeof(sphere));
+                inside = true;
+            }
+        }
+        if (inside) {
+            frame.probeSphereModels.push_back(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(sphere)), glm::vec3(sphere.w)));
+        }
+    }
+}
+
+/***********************************************************************
+ * Function: SubmitProbeScene
+ * Author: [Smirti Parajuli]
+ * Description: Queues the spheres for the probe faces drawn this frame,
+ *              lit with the same Blinn-Phong shading as on screen.
+ * Parameters:
+ *   - probes: The reflection probes, after their BeginFrame.
+ *   - frame: The snapshot built by the simulation thread.
+ *   - stream: The per-frame stream buffer for the model matrices.
+ * Return : None
+ ***********************************************************************/
+void Sphere::SubmitProbeScene(ReflectionProbes& probes, const FrameSnapshot& frame, StreamBuffer& stream) const {
+    if (!probes.NeedsScene()) {
+        return;
+    }
+    if (frame.sphereAnimationOnGpu) {
+        SubmitAnimatedMesh(probes.GetScene(), Program_Animated, Program_AnimatedDepth, texture.GetID());
+    }
+    else {
+        SubmitModels(probes.GetScene(), frame.probeSphereModels, probes.GetSceneProgram(), texture.GetID(), stream);
+    }
+}
+
+/***********************************************************************
+ * Function: SubmitAnimatedMesh
+ * Author: [Smirti Parajuli]
+ * Description: Queues every sphere as one instanced draw of the sphere
+ *              mesh with an animated program, which reads the view and
+ *              the time from whatever FrameData block is bound when the
+ *              queue is executed.
+ * Parameters:
+ *   - queue: The queue of the shadow atlas or the reflection probes.
+ *   - program: A program with the animated vertex shader.
+ *   - depthProgram: The same vertex shader with DepthOnly.fs.
+ *   - texture: The sphere texture, 0 for shadow casters.
+ * Return : None
+ ***********************************************************************/
+void Sphere::SubmitAnimatedMesh(RenderQueue& queue, GLuint program, GLuint depthProgram, GLuint texture) const {
+    if (sphereCount == 0) {
+        return;
+    }
+
+    DrawPacket packet;
+    packet.program = program;
+    packet.depthProgram = depthProgram;
+    sphereMesh->SetGeometry(packet);
+    packet.texture = texture;
+    packet.instanceCount = sphereCount;
+    packet.rangeTarget = GL_SHADER_STORAGE_BUFFER;
+    packet.rangeIndex = InstanceAnimationBinding;
+    packet.rangeBuffer = animationBuffer;
+    packet.rangeOffset = 0;
+    packet.rangeSize = sizeof(InstanceAnimation) * sphereCount;
+    packet.key = RenderQueue::MakeKey(RenderPass::Opaque, packet.program, packet.texture, packet.vertexArray, 0.0f);
+    queue.Submit(packet);
+}
+
+/***********************************************************************
+ * Function: SubmitModels
+ * Author: [Smirti Parajuli]
+ * Description: Copies the model matrices into the stream buffer and
+ *              queues one instanced draw of the sphere mesh for them.
+ * Parameters:
+ *   - queue: The queue of the shadow atlas or the reflection probes.
+ *   - models: One model matrix per sphere.
+ *   - program: A program reading a mat4 per instance from InstanceData,
+ *              also used as its depth program.
+ *   - texture: The sphere texture, 0 for shadow casters.
+ *   - stream: The per-frame stream buffer to write into.
+ * Return : None
+ ***********************************************************************/
+void Sphere::SubmitModels(RenderQueue& queue, const std::vector<glm::mat4>& models, GLuint program, GLuint texture, StreamBuffer& stream) const {
+    if (models.empty()) {
+        return;
+    }
+    GLintptr offset = 0;
+    glm::mat4* casters = stream.Allocate<glm::mat4>(offset, static_cast<GLsizeiptr>(models.size()));
+    if (!casters) {
+        return;
+    }
+    std::memcpy(casters, models.data(), sizeof(glm::mat4) * models.size());
+
+    DrawPacket packet;
+    packet.program = program;
+    packet.depthProgram = program;
+    sphereMesh->SetGeometry(packet);
+    packet.texture = texture;
+    packet.instanceCount = static_cast<GLsizei>(models.size());
+    packet.rangeTarget = GL_SHADER_STORAGE_BUFFER;
+    packet.rangeIndex = InstanceDataBinding;
+    packet.rangeBuffer = stream.GetID();
+    packet.rangeOffset = offset;
+    packet.rangeSize = static_cast<GLsizeiptr>(sizeof(glm::mat4) * models.size());
+    packet.key = RenderQueue::MakeKey(RenderPass::Opaque, packet.program, packet.texture, packet.vertexArray, 0.0f);
+    queue.Submit(packet);
+}
+
+/***********************************************************************
+ * Function: SubmitAnimated
+ * Author: [Smirti Parajuli]
+ * Description: Queues every sphere as one instanced draw of the animated
+ *              program. It reads the animation buffer written at start up
+ *              and the time from the FrameData block, so nothing is
+ *              uploaded. Without culling there is no nearest sphere, so the
+ *              packet takes the front of the depth range.
+ * Parameters:
+ *   - queue: The render queue for this frame.
+ *   - frame: The snapshot built by the simulation thread.
+ * Return : None
+ ***********************************************************************/
+void Sphere::SubmitAnimated(RenderQueue& queue, const FrameSnapshot& frame) {
+    if (sphereCount == 0) {
+        return;
+    }
+
+    DrawPacket packet;
+    packet.program = frame.sphereImpostors ? Program_AnimatedImpostor : Program_Animated;
+    packet.depthProgram = frame.sphereImpostors ? 0 : Program_AnimatedDepth;
+    packet.gbufferProgram = frame.sphereImpostors ? 0 : Program_AnimatedGBuffer;
+    (frame.sphereImpostors ? impostorQuad : sphereMesh)->SetGeometry(packet);
+    if (frame.sphereMeshletCulling && !frame.sphereImpostors && meshletCuller.IsReady()) {
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, InstanceAnimationBinding, animationBuffer, 0, sizeof(InstanceAnimation) * sphereCount);
+        meshletCuller.Cull(frame.projection * frame.view, static_cast<GLuint>(sphereCount), true);
+        packet.program = Program_CulledAnimated;
+        packet.depthProgram = Program_CulledAnimatedDepth;
+        packet.gbufferProgram = Program_CulledAnimatedGBuffer;
+        meshletCuller.SetGeometry(packet);
+    }
+    packet.texture = texture.GetID();
+    packet.instanceCount = sphereCount;
+    packet.rangeTarget = GL_SHADER_STORAGE_BUFFER;
+    packet.rangeIndex = InstanceAnimationBinding;
+    packet.rangeBuffer = animationBuffer;
+    packet.rangeOffset = 0;
+    packet.rangeSize = sizeof(InstanceAnimation) * sphereCount;
+    packet.key = RenderQueue::MakeKey(RenderPass::Opaque, packet.program, packet.texture, packet.vertexArray, 0.0f);
+    queue.Submit(packet);
 }
 
 /***********************************************************************
  * Function: Update
  * Author: [Smirti Parajuli]
- * Description: Updates the sphere's properties, such as rotation, based on
- *              elapsed time.
+ * Description: Spins every spinning sphere in the entity store by one
+ *              fixed step and, in physics mode, moves and collides them.
+ *              While the vertex shader animates the spheres only the
+ *              animation time moves on. Called once per fixed simulation
+ *              step.
  * Parameters:
- *   - deltaTime: The time elapsed since the last frame.
+ *   - deltaTime: The length of the fixed simulation step.
  * Return : Void
  ***********************************************************************/
 
 void Sphere::Update(float deltaTime) {
-    rotation.y += 80.f * deltaTime;
+    stepDelta = deltaTime;
+    animationTime += deltaTime;
+    stepAngle = 0.0f;
+    if (!IsGpuAnimationActive()) {
+        stepAngle = glm::radians(80.f * deltaTime);
+        entities.Rotate(EntitySpinning, glm::vec4(0.0f, std::sin(stepAngle * 0.5f), 0.0f, std::cos(stepAngle * 0.5f)));
+    }
+
+    if (physicsEnabled) {
+        auto start = std::chrono::steady_clock::now();
+        physics.Step(deltaTime);
+        physicsStepMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+/***********************************************************************
+ * Function: HandleKeyPress
+ * Author: [Smirti Parajuli]
+ * Description: Toggles the physics mode when 'P' is pressed. The first
+ *              time it is turned on every sphere is given a velocity;
+ *              turning it off freezes the spheres where they are. 'G'
+ *              switches between the GPU animation and the CPU spin, 'I'
+ *              between the sphere mesh and ray traced impostors, 'M'
+ *              turns meshlet culling of the sphere mesh on and off and
+ *              'R' the reflection probes.
+ * Parameters:
+ *   - input: The keyboard state sampled for this step.
+ * Return : Void
+ ***********************************************************************/
+void Sphere::HandleKeyPress(const InputState& input) {
+    if (input.IsKeyDown(GLFW_KEY_P) && !isPhysicsKeyPressed) {
+        physicsEnabled = !physicsEnabled;
+        if (physicsEnabled && !physicsSeeded) {
+            physics.SeedVelocities(3.0f);
+            physicsSeeded = true;
+        }
+    }
+    isPhysicsKeyPressed = input.IsKeyDown(GLFW_KEY_P);
+
+    if (input.IsKeyDown(GLFW_KEY_G) && !isAnimationKeyPressed) {
+        gpuAnimationEnabled = !gpuAnimationEnabled;
+    }
+    isAnimationKeyPressed = input.IsKeyDown(GLFW_KEY_G);
+
+    if (input.IsKeyDown(GLFW_KEY_I) && !isImpostorKeyPressed) {
+        impostorsEnabled = !impostorsEnabled;
+    }
+    isImpostorKeyPressed = input.IsKeyDown(GLFW_KEY_I);
+
+    if (input.IsKeyDown(GLFW_KEY_M) && !isMeshletKeyPressed) {
+        meshletCullingEnabled = !meshletCullingEnabled;
+    }
+    isMeshletKeyPressed = input.IsKeyDown(GLFW_KEY_M);
+
+    if (input.IsKeyDown(GLFW_KEY_R) && !isProbeKeyPressed) {
+        reflectionProbesEnabled = !reflectionProbesEnabled;
+    }
+    isProbeKeyPressed = input.IsKeyDown(GLFW_KEY_R);
+}
+
+/***********************************************************************
+ * Function: Interpolate
+ * Author: [Smirti Parajuli]
+ * Description: Blends the previous and current rotation, position and
+ *              animation time so the spheres move smoothly regardless of
+ *              the rendering frame rate.
+ * Parameters:
+ *   - alpha: Interpolation factor from the frame clock, in the range [0, 1].
+ * Return : Void
+ ***********************************************************************/
+void Sphere::Interpolate(float alpha) {
+    // Every spinning sphere turns by the same step, so one correction serves them all
+    float angle = (alpha - 1.0f) * stepAngle;
+    renderCorrection = glm::vec4(0.0f, std::sin(angle * 0.5f), 0.0f, std::cos(angle * 0.5f));
+    renderTimeOffset = (alpha - 1.0f) * stepDelta;
+    renderAnimationTime = static_cast<float>(animationTime + renderTimeOffset);
 }
 
 /***********************************************************************
- * Function: RenderReflectiveSphere
+ * Function: SubmitReflectiveSphere
  *  Author: [Smirti Parajuli]
- * Description: Renders a reflective sphere using the provided camera and
- *              the skybox for reflections.
+ * Description: Queues the reflective spheres. Each sphere samples the
+ *              cube map of its reflection probe once every face of it was
+ *              drawn. Until then it binds the prefiltered sky, whose
+ *              alpha of 0 makes the shaders show the sky bound at
+ *              ReflectionProbes::SkyUnit, as wherever a probe saw
+ *              nothing. With impostors on, each
+ *              sphere is one impostor quad whose model goes into the
+ *              stream buffer.
  * Parameters:
- *   - camera: The camera from which the scene is viewed.
- *   - skyBox: The skybox used to provide the reflection texture.
+ *   - queue: The render queue for this frame.
+ *   - frame: The snapshot built by the simulation thread.
+ *   - skyBox: The skybox whose environment lighting stands in for a missing probe.
+ *   - probes: The reflection probes, after their Render.
+ *   - stream: The per-frame stream buffer for the impostor instances.
  * Return : Void 
  ***********************************************************************/
-void Sphere::RenderReflectiveSphere(const Camera& camera, SkyBox& skyBox) {
-    // glm::vec3 scale = glm::vec3(1.0f); // Adjust scale as needed
-    glm::mat4 model = glm::translate(glm::mat4(4.0f),position);
-    // model = glm::scale(model, scale);
-
-    glm::mat4 view = camera.GetViewMatrix();
-    glm::mat4 projection = camera.GetProjectionMatrix(static_cast<float>(camera.fov),
-        static_cast<float>(camera.windowWidth) / static_cast<float>(camera.windowHeight),
-        0.1f, 100.0f);
-    // Use the reflective shader program
-    glUseProgram(Program_Reflection);
-    glDepthFunc(GL_LEQUAL); // Change depth function so depth test passes when values are equal to depth buffer's content
-    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS); // Helps with cube map seams
-   
-    // Set matrices
-    glUniformMatrix4fv(glGetUniformLocation(Program_Reflection, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glm::mat4 PVM = projection * view * model;
-    glUniformMatrix4fv(glGetUniformLocation(Program_Reflection, "PVM"), 1, GL_FALSE, glm::value_ptr(PVM));
-    // Bind the cube map texture
-    glActiveTexture(GL_TEXTURE0);
-    GLuint skyboxTextureID = skyBox.getTextureID(); // Assuming 'skyBox' is an instance of 'SkyBox'
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTextureID);
-    glUniform1i(glGetUniformLocation(Program_Reflection, "skyBox"), 0);
-    // Bind VAO of the sphere mesh
-    sphereMesh->Draw(); // Make sure 'sphereMesh' is a pointer to a Mesh class instance with sphere geometry
-    // Render the sphere mesh
-    glDrawElements(DrawType, indexCount, GL_UNSIGNED_INT, nullptr);
-    // Unbind VAO
-    glBindVertexArray(0);
-    // Unbind the cube map texture
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-    // Reset to default depth function
-    glDepthFunc(GL_LESS);
-    // Unuse the shader program
-    glUseProgram(0);
+void Sphere::SubmitReflectiveSphere(RenderQueue& queue, const FrameSnapshot& frame, const SkyBox& skyBox, const ReflectionProbes& probes, StreamBuffer& stream) {
+    for (size_t i = 0; i < frame.reflectiveModels.size(); ++i) {
+        const glm::mat4& model = frame.reflectiveModels[i];
+        GLuint reflection = 0;
+        if (i < frame.reflectiveProbeIndices.size() && frame.reflectiveProbeIndices[i] >= 0) {
+            reflection = probes.GetTexture(frame.reflectiveProbeIndices[i]);
+        }
+
+        DrawPacket packet;
+        packet.textureTarget = GL_TEXTURE_CUBE_MAP;
+        packet.texture = reflection != 0 ? reflection : skyBox.getEnvironment().GetSpecularTexture();
+        if (frame.sphereImpostors) {
+            GLintptr offset = 0;
+            InstanceTransform* instance = stream.Allocate<InstanceTransform>(offset);
+            if (!instance) {
+                return;
+            }
+            // The impostor shader only reads the model matrix
+            *instance = { model, glm::mat4(1.0f), glm::mat4(1.0f) };
+
+            packet.program = Program_ReflectiveImpostor;
+            impostorQuad->SetGeometry(packet);
+            packet.rangeTarget = GL_SHADER_STORAGE_BUFFER;
+            packet.rangeIndex = InstanceDataBinding;
+            packet.rangeBuffer = stream.GetID();
+            packet.rangeOffset = offset;
+            packet.rangeSize = sizeof(InstanceTransform);
+        }
+        else {
+            packet.program = Program_Reflection;
+            sphereMesh->SetGeometry(packet);
+            packet.modelLocation = reflectionModelLocation;
+            packet.model = model;
+        }
+
+        float distance = glm::length(glm::vec3(model[3]) - frame.cameraPosition);
+        packet.key = RenderQueue::MakeKey(RenderPass::Opaque, packet.program, packet.texture, packet.vertexArray, distance / frame.farPlane);
+        queue.Submit(packet);
+    }
 }
@@ -26,6 +26,20 @@ Mail : smirti.parajuli@mds.ac.nz
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include "SkyBox.h"
+#include "FrameSnapshot.h"
+#include "Frustum.h"
+#include "StreamBuffer.h"
+#include "RenderQueue.h"
+#include "EntityStore.h"
+#include "SpherePhysics.h"
+#include "JobSystem.h"
+#include "TaskGraph.h"
+#include "TransformKernel.h"
+#include "InputState.h"
+#include "MeshletCuller.h"
+#include "ShadowAtlas.h"
+#include "ReflectionProbes.h"
+#include <memory>
 // Constants for PI values
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -37,39 +51,113 @@ Mail : smirti.parajuli@mds.ac.nz
 
 class Sphere {
 public:
-    Sphere();
+    Sphere(EntityStore& entities, JobSystem& jobs);
 
         // Default constructor body (if needed)
     
     ~Sphere();
     std::unique_ptr<Mesh> sphereMesh;
-    void Render(const Camera& camera, GLuint shaderProgram);
+    void Submit(RenderQueue& queue, const FrameSnapshot& frame, GLuint shaderProgram, GLuint depthProgram, GLuint gbufferProgram, StreamBuffer& stream);
+    void BuildInstances(const Frustum& frustum, const glm::vec3& cameraPosition, FrameSnapshot& frame) const;// Culls, sorts and builds model matrices (simulation thread)
+    void BuildShadowCasters(FrameSnapshot& frame) const;// Lists the casters of the shadow views and fills in their keys (simulation thread)
+    void SubmitShadowCasters(ShadowAtlas& atlas, const FrameSnapshot& frame, StreamBuffer& stream) const;// Queues the casters the atlas needs this frame
+    void BuildReflectionProbes(FrameSnapshot& frame) const;// Places a probe in every reflective sphere and fills in the face keys (simulation thread)
+    void SubmitProbeScene(ReflectionProbes& probes, const FrameSnapshot& frame, StreamBuffer& stream) const;// Queues the spheres the probe faces show
+    int GetSphereCount() const { return sphereCount; }
     void Update(float deltaTime);
+    void HandleKeyPress(const InputState& input);// Toggles physics with 'P', GPU animation with 'G', impostors with 'I', meshlet culling with 'M' and reflection probes with 'R'
+    bool IsPhysicsEnabled() const { return physicsEnabled; }
+    bool IsGpuAnimationActive() const { return gpuAnimationEnabled && !physicsEnabled; }// Physics moves the spheres, so it needs the CPU path
+    float GetAnimationTime() const { return renderAnimationTime; }
+    bool IsImpostorsEnabled() const { return impostorsEnabled; }
+    bool IsMeshletCullingEnabled() const { return meshletCullingEnabled; }
+    int GetContactCount() const { return physics.GetContactCount(); }
+    float GetPhysicsStepMs() const { return physicsStepMs; }
+    void Interpolate(float alpha);// Blends the rotation between fixed steps for rendering
     bool isOverlapping(const glm::vec3& newPos, float sphereRadius);  // Utility function to check overlap
     GLuint getTextureID() const { return textureID; }
     GLuint textureID;  // Store the texture ID here
     GLuint baseTextureID;
     GLuint reflectionMaskID;
-    void RenderReflectiveSphere(const Camera& camera, SkyBox& skyBox);
+    void SubmitReflectiveSphere(RenderQueue& queue, const FrameSnapshot& frame, const SkyBox& skyBox, const ReflectionProbes& probes, StreamBuffer& stream);
    // void LightSphereRender(const glm::vec3& lightColor, const Camera& camera);
     void CreateSphere();
     void SetPosition(float sphereRadius);
+    void CreateAnimations();
+    void CreateImpostorQuad();
     glm::vec3 newPos;
 private:
     
   
-    std::vector<glm::vec3> positions;
-    Mesh* mesh;
+    EntityStore& entities;// Positions and rotations of every sphere live here
+    JobSystem& jobs;// Runs texture decoding, placement, culling and the instance matrices
+    EntityHandle reflectiveEntity;// The sphere reflecting the skybox
+    int sphereCount = 0;
     GLuint VBO, EBO, VAO;
     glm::mat4 PVM;
-    glm::vec3 position = glm::vec3(0.0f);
-    glm::vec3 rotation = glm::vec3(0.0f);
+    float stepAngle = 0.0f;// Spin applied by the latest fixed step, in radians
+    glm::vec4 renderCorrection = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);// Quaternion taking the latest step back to the interpolated spin
     Texture texture;
-     GLfloat* vertices;
-        GLuint* indices;
     int indexCount = 0;
     GLenum DrawType = GL_TRIANGLES;
-    float sphereRadius;
+    float sphereRadius = 0.4f;// Radius of the generated mesh, also used for placement and culling
     GLuint Program_Reflection;
+    GLint reflectionModelLocation = -1;// "model" uniform of the reflective program
+
+    // Visible spheres with their distance to the camera, BuildInstances keeps them in the frame arena
+    struct VisibleSphere {
+        float distanceSquared;
+        std::uint32_t index;// Dense index in the entity store
+    };
+    mutable TaskGraph instanceGraph;// Sphere culling then matrices, beside the reflective spheres
+    static const size_t CullGrain = 1024;// Entities per culling job
+    static const size_t InstanceGrain = 256;// Matrices per job
+    static const size_t CandidateGrain = 25;// Placement candidates tested per job
     GLuint Program_Object;
+    void SubmitModels(RenderQueue& queue, const std::vector<glm::mat4>& models, GLuint program, GLuint texture, StreamBuffer& stream) const;// One instanced draw of the mesh
+    void SubmitAnimatedMesh(RenderQueue& queue, GLuint program, GLuint depthProgram, GLuint texture) const;// Every sphere, placed by the animated vertex shader
+
+    // Animation evaluated in the vertex shader from the frame time
+    void SubmitAnimated(RenderQueue& queue, const FrameSnapshot& frame);
+    GLuint Program_Animated;
+    GLuint Program_AnimatedDepth;// Depth pre-pass with the animated vertex shader
+    GLuint Program_AnimatedGBuffer;// Deferred G-buffer pass with the animated vertex shader
+    GLuint animationBuffer = 0;// One InstanceAnimation per sphere, written once
+    bool gpuAnimationEnabled = true;
+    bool isAnimationKeyPressed = false;// Key 'G' held during the previous step
+    double animationTime = 0.0;// Time of the latest fixed step
+    float renderAnimationTime = 0.0f;// Animation time interpolated for rendering
+
+    // Spheres drawn as camera facing quads, ray traced in the fragment shader
+    GLuint Program_Impostor;// Instance transforms from the stream buffer
+    GLuint Program_AnimatedImpostor;// Instance animation buffer
+    GLuint Program_ReflectiveImpostor;
+    std::unique_ptr<Mesh> impostorQuad;// The vertex shader builds the quad from gl_VertexID
+    bool impostorsEnabled = false;
+    bool isImpostorKeyPressed = false;// Key 'I' held during the previous step
+
+    // Sphere meshes drawn meshlet by meshlet, skipping those off screen or facing away
+    MeshletCuller meshletCuller;
+    GLuint Program_Culled;// Instance transforms, instance from the culling pass
+    GLuint Program_CulledAnimated;// Instance animation, instance from the culling pass
+    GLuint Program_CulledDepth;// Depth pre-pass versions of the two above
+    GLuint Program_CulledAnimatedDepth;
+    GLuint Program_CulledGBuffer;// G-buffer versions of the two above
+    GLuint Program_CulledAnimatedGBuffer;
+    bool meshletCullingEnabled = true;
+    bool isMeshletKeyPressed = false;// Key 'M' held during the previous step
+
+    // The reflective spheres reflect cube maps of the scene around them instead of the skybox alone
+    static constexpr float ProbeNearScale = 1.05f;// Probe faces start just outside the reflective sphere
+    bool reflectionProbesEnabled = true;
+    bool isProbeKeyPressed = false;// Key 'R' held during the previous step
+
+    // Optional rigid body motion of the sphere field
+    SpherePhysics physics;
+    bool physicsEnabled = false;
+    bool physicsSeeded = false;// Velocities are given out the first time physics is turned on
+    bool isPhysicsKeyPressed = false;// Key 'P' held during the previous step
+    float physicsStepMs = 0.0f;
+    float stepDelta = 0.0f;// Length of the latest fixed step
+    float renderTimeOffset = 0.0f;// Time from the latest step back to the interpolated moment, zero or negative
 };
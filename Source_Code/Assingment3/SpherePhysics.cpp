@@ -0,0 +1,303 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :SpherePhysics.cpp
+Description :  Implementation of the grid based sphere physics.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "SpherePhysics.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+/***********************************************************************
+ * SpherePhysics: Constructor for the SpherePhysics class.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - entities: The store holding the bodies.
+ *   - jobs: Job system the integration and narrowphase run on.
+ *   - radius: Radius of every sphere.
+ *   - boundsMin: Lower corner of the cube the spheres stay in, on all axes.
+ *   - boundsMax: Upper corner of the cube, on all axes.
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+SpherePhysics::SpherePhysics(EntityStore& entities, JobSystem& jobs, float radius, float boundsMin, float boundsMax)
+	: entities(entities), jobs(jobs), radius(radius), boundsMin(boundsMin), boundsMax(boundsMax), contacts(0)
+{
+	ConfigureGrid();
+}
+
+/***********************************************************************
+ * ConfigureGrid: Sizes the broadphase grid.
+ * Author: [Smirti Parajuli]
+ * Description: A cell must be at least one diameter wide so a sphere only
+ *              touches spheres in its own and the 26 neighbouring cells.
+ *              The cell count per axis is capped to keep the grid small
+ *              when the spheres are tiny.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void SpherePhysics::ConfigureGrid()
+{
+	float extent = boundsMax - boundsMin;
+	cellSize = 2.0f * radius;
+	if (extent / cellSize > MaxCellsPerAxis) {
+		cellSize = extent / MaxCellsPerAxis;
+	}
+	cellsPerAxis = static_cast<int>(std::ceil(extent / cellSize));
+	if (cellsPerAxis < 1) {
+		cellsPerAxis = 1;
+	}
+	inverseCellSize = 1.0f / cellSize;
+	cellStart.assign(static_cast<size_t>(cellsPerAxis) * cellsPerAxis * cellsPerAxis + 1, 0);
+}
+
+/***********************************************************************
+ * CellOf: Grid cell containing a point.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - x, y, z: World position.
+ *
+ * Return: Linear cell index.
+ ***********************************************************************/
+std::uint32_t SpherePhysics::CellOf(float x, float y, float z) const
+{
+	int cx = static_cast<int>((x - boundsMin) * inverseCellSize);
+	int cy = static_cast<int>((y - boundsMin) * inverseCellSize);
+	int cz = static_cast<int>((z - boundsMin) * inverseCellSize);
+	cx = cx < 0 ? 0 : (cx >= cellsPerAxis ? cellsPerAxis - 1 : cx);
+	cy = cy < 0 ? 0 : (cy >= cellsPerAxis ? cellsPerAxis - 1 : cy);
+	cz = cz < 0 ? 0 : (cz >= cellsPerAxis ? cellsPerAxis - 1 : cz);
+	return static_cast<std::uint32_t>((cz * cellsPerAxis + cy) * cellsPerAxis + cx);
+}
+
+/***********************************************************************
+ * GatherBodies: Lists the dynamic entities.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void SpherePhysics::GatherBodies()
+{
+	bodies.clear();
+	for (size_t i = 0; i < entities.Size(); i++) {
+		if (entities.flags[i] & EntityDynamic) {
+			bodies.push_back(static_cast<std::uint32_t>(i));
+		}
+	}
+	size_t count = bodies.size();
+	positionX.resize(count);
+	positionY.resize(count);
+	positionZ.resize(count);
+	velocityX.resize(count);
+	velocityY.resize(count);
+	velocityZ.resize(count);
+	bodyCell.resize(count);
+	cellBodies.resize(count);
+	sortedX.resize(count);
+	sortedY.resize(count);
+	sortedZ.resize(count);
+	sortedVX.resize(count);
+	sortedVY.resize(count);
+	sortedVZ.resize(count);
+}
+
+/***********************************************************************
+ * SortByCell: Broadphase, buckets the bodies by grid cell.
+ * Author: [Smirti Parajuli]
+ * Description: Counting sort on the cell index. It is stable, so the
+ *              order inside a cell is always body order. The state is then
+ *              gathered in cell order so the narrowphase reads each
+ *              neighbouring cell as one contiguous run.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void SpherePhysics::SortByCell()
+{
+	size_t count = bodies.size();
+	std::fill(cellStart.begin(), cellStart.end(), 0);
+	for (size_t k = 0; k < count; k++) {
+		cellStart[bodyCell[k] + 1]++;
+	}
+	for (size_t c = 1; c < cellStart.size(); c++) {
+		cellStart[c] += cellStart[c - 1];
+	}
+	cellCursor.assign(cellStart.begin(), cellStart.end() - 1);
+	for (size_t k = 0; k < count; k++) {
+		cellBodies[cellCursor[bodyCell[k]]++] = static_cast<std::uint32_t>(k);
+	}
+
+	jobs.ParallelFor(count, Grain, [&](size_t begin, size_t end) {
+		for (size_t e = begin; e < end; e++) {
+			std::uint32_t k = cellBodies[e];
+			sortedX[e] = positionX[k];
+			sortedY[e] = positionY[k];
+			sortedZ[e] = positionZ[k];
+			sortedVX[e] = velocityX[k];
+			sortedVY[e] = velocityY[k];
+			sortedVZ[e] = velocityZ[k];
+		}
+	});
+}
+
+/***********************************************************************
+ * SeedVelocities: Starts every dynamic body moving.
+ * Author: [Smirti Parajuli]
+ * Description: Uses a fixed seed so a run is reproducible.
+ *
+ * Parameters:
+ *   - maxSpeed: Largest speed along each axis.
+ *
+ * Return: None
+ ***********************************************************************/
+void SpherePhysics::SeedVelocities(float maxSpeed)
+{
+	std::mt19937 random(20231);
+	std::uniform_real_distribution<float> speed(-maxSpeed, maxSpeed);
+	for (size_t i = 0; i < entities.Size(); i++) {
+		if (entities.flags[i] & EntityDynamic) {
+			entities.velocityX[i] = speed(random);
+			entities.velocityY[i] = speed(random);
+			entities.velocityZ[i] = speed(random);
+		}
+	}
+}
+
+/***********************************************************************
+ * Step: Advances the physics by one fixed step.
+ * Author: [Smirti Parajuli]
+ * Description:
+ *   1. Integrate and bounce off the bounds, in parallel, into packed arrays.
+ *   2. Counting sort the bodies into grid cells.
+ *   3. Narrowphase in parallel over the cell-sorted bodies: each body
+ *      pushes itself out of every overlapping neighbour by half the overlap
+ *      and exchanges the normal velocity with it, reading only the sorted
+ *      state from step 2, and writes the result back to the entity store.
+ *
+ * Parameters:
+ *   - deltaTime: The fixed step length.
+ *
+ * Return: None
+ ***********************************************************************/
+void SpherePhysics::Step(float deltaTime)
+{
+	GatherBodies();
+	size_t count = bodies.size();
+	if (count == 0) {
+		contactCount = 0;
+		return;
+	}
+
+	const float low = boundsMin + radius;
+	const float high = boundsMax - radius;
+
+	// 1. Integrate
+	jobs.ParallelFor(count, Grain, [&](size_t begin, size_t end) {
+		for (size_t k = begin; k < end; k++) {
+			std::uint32_t i = bodies[k];
+			float p[3] = { entities.positionX[i], entities.positionY[i], entities.positionZ[i] };
+			float v[3] = { entities.velocityX[i], entities.velocityY[i], entities.velocityZ[i] };
+			for (int axis = 0; axis < 3; axis++) {
+				p[axis] += v[axis] * deltaTime;
+				if (p[axis] < low) {
+					p[axis] = low;
+					v[axis] = std::fabs(v[axis]);
+				}
+				else if (p[axis] > high) {
+					p[axis] = high;
+					v[axis] = -std::fabs(v[axis]);
+				}
+			}
+			positionX[k] = p[0];
+			positionY[k] = p[1];
+			positionZ[k] = p[2];
+			velocityX[k] = v[0];
+			velocityY[k] = v[1];
+			velocityZ[k] = v[2];
+			bodyCell[k] = CellOf(p[0], p[1], p[2]);
+		}
+	});
+
+	// 2. Broadphase
+	SortByCell();
+
+	// 3. Narrowphase
+	contacts.store(0);
+	const float diameter = 2.0f * radius;
+	const float diameterSquared = diameter * diameter;
+	jobs.ParallelFor(count, Grain, [&](size_t begin, size_t end) {
+		int localContacts = 0;
+		for (size_t e = begin; e < end; e++) {
+			std::uint32_t k = cellBodies[e];
+			float px = sortedX[e], py = sortedY[e], pz = sortedZ[e];
+			float vx = sortedVX[e], vy = sortedVY[e], vz = sortedVZ[e];
+			float moveX = 0.0f, moveY = 0.0f, moveZ = 0.0f;
+			float deltaVX = 0.0f, deltaVY = 0.0f, deltaVZ = 0.0f;
+
+			int cell = static_cast<int>(bodyCell[k]);
+			int cx = cell % cellsPerAxis;
+			int cy = (cell / cellsPerAxis) % cellsPerAxis;
+			int cz = cell / (cellsPerAxis * cellsPerAxis);
+			// The three cells of a neighbouring row are adjacent in the sorted
+			// arrays, so each row is scanned as one contiguous run
+			int xFirst = cx > 0 ? cx - 1 : 0;
+			int xLast = cx < cellsPerAxis - 1 ? cx + 1 : cellsPerAxis - 1;
+			for (int z = cz - 1; z <= cz + 1; z++) {
+				if (z < 0 || z >= cellsPerAxis) continue;
+				for (int y = cy - 1; y <= cy + 1; y++) {
+					if (y < 0 || y >= cellsPerAxis) continue;
+					int row = (z * cellsPerAxis + y) * cellsPerAxis;
+					for (std::uint32_t m = cellStart[row + xFirst]; m < cellStart[row + xLast + 1]; m++) {
+						if (m == e) continue;
+						float dx = px - sortedX[m];
+						float dy = py - sortedY[m];
+						float dz = pz - sortedZ[m];
+						float distanceSquared = dx * dx + dy * dy + dz * dz;
+						if (distanceSquared >= diameterSquared || distanceSquared <= 0.0f) continue;
+
+						float distance = std::sqrt(distanceSquared);
+						float nx = dx / distance, ny = dy / distance, nz = dz / distance;
+
+						// Each body of the pair moves half the overlap
+						float push = 0.5f * (diameter - distance);
+						moveX += nx * push;
+						moveY += ny * push;
+						moveZ += nz * push;
+
+						// Equal masses, elastic: swap the normal velocity when approaching
+						float approach = (vx - sortedVX[m]) * nx + (vy - sortedVY[m]) * ny + (vz - sortedVZ[m]) * nz;
+						if (approach < 0.0f) {
+							deltaVX -= nx * approach;
+							deltaVY -= ny * approach;
+							deltaVZ -= nz * approach;
+						}
+						localContacts++;
+					}
+				}
+			}
+
+			std::uint32_t i = bodies[k];
+			entities.positionX[i] = std::fmin(std::fmax(px + moveX, low), high);
+			entities.positionY[i] = std::fmin(std::fmax(py + moveY, low), high);
+			entities.positionZ[i] = std::fmin(std::fmax(pz + moveZ, low), high);
+			entities.velocityX[i] = vx + deltaVX;
+			entities.velocityY[i] = vy + deltaVY;
+			entities.velocityZ[i] = vz + deltaVZ;
+		}
+		contacts.fetch_add(localContacts);
+	});
+
+	// Every touching pair was seen from both sides
+	contactCount = contacts.load() / 2;
+}
@@ -0,0 +1,76 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :SpherePhysics.h
+Description :  The SpherePhysics class moves every dynamic sphere in the
+               entity store and resolves sphere/sphere and sphere/bounds
+               collisions. A uniform grid built with a counting sort is the
+               broadphase; the narrowphase resolves every body against its
+               neighbours from the previous state only, so bodies are
+               independent, run as jobs and give the same result
+               for any thread count.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef SPHEREPHYSICS_H
+#define SPHEREPHYSICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "EntityStore.h"
+#include "JobSystem.h"
+
+class SpherePhysics
+{
+public:
+	SpherePhysics(EntityStore& entities, JobSystem& jobs, float radius, float boundsMin, float boundsMax);
+
+	void SeedVelocities(float maxSpeed);// Gives every dynamic body a random velocity, same sequence every run
+	void Step(float deltaTime);
+
+	int GetContactCount() const { return contactCount; }// Touching pairs in the last step
+	int GetBodyCount() const { return static_cast<int>(bodies.size()); }
+
+	// Copying and assignment not allowed for this class
+	SpherePhysics(const SpherePhysics&) = delete;
+	SpherePhysics& operator=(const SpherePhysics&) = delete;
+
+private:
+	void GatherBodies();
+	void SortByCell();
+	void ConfigureGrid();
+	std::uint32_t CellOf(float x, float y, float z) const;
+
+	static const size_t Grain = 4096;// Bodies per job
+	static const int MaxCellsPerAxis = 128;
+
+	EntityStore& entities;
+	JobSystem& jobs;
+	float radius;
+	float boundsMin;
+	float boundsMax;
+
+	// Uniform grid over the bounds, cells are at least one diameter wide
+	int cellsPerAxis = 1;
+	float cellSize = 1.0f;
+	float inverseCellSize = 1.0f;
+
+	std::vector<std::uint32_t> bodies;// Dense store index of every dynamic body
+	std::vector<float> positionX, positionY, positionZ;// Packed copies, indexed like bodies
+	std::vector<float> velocityX, velocityY, velocityZ;
+	std::vector<std::uint32_t> bodyCell;
+	std::vector<std::uint32_t> cellStart;// First entry of each cell in cellBodies, plus one end entry
+	std::vector<std::uint32_t> cellCursor;
+	std::vector<std::uint32_t> cellBodies;// Bodies sorted by cell, in body order within a cell
+	std::vector<float> sortedX, sortedY, sortedZ;// Packed state in cell order, so neighbours are adjacent in memory
+	std::vector<float> sortedVX, sortedVY, sortedVZ;
+	std::atomic<int> contacts;
+	int contactCount = 0;
+};
+#endif // SPHEREPHYSICS_H
@@ -0,0 +1,164 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :StreamBuffer.cpp
+Description :  Implementation of the persistently mapped per-frame ring buffer.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "StreamBuffer.h"
+#include <iostream>
+
+/***********************************************************************
+ * StreamBuffer: Constructor for the StreamBuffer class.
+ * Author: [Smirti Parajuli]
+ * Description: Creates immutable storage for all regions and maps it once
+ *              for the lifetime of the buffer.
+ *
+ * Parameters:
+ *   - regionSize: Bytes available to a single frame.
+ *   - regionCount: Number of frames that may be in flight at once.
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+StreamBuffer::StreamBuffer(GLsizeiptr regionSize, int regionCount)
+	: regionSize(regionSize), regionCount(regionCount > MaxRegions ? MaxRegions : regionCount)
+{
+	// Every suballocation must satisfy the stricter of the uniform and storage offset alignments
+	GLint uniformAlignment = 256;
+	GLint storageAlignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+	alignment = (uniformAlignment > storageAlignment) ? uniformAlignment : storageAlignment;
+	this->regionSize = (regionSize + alignment - 1) / alignment * alignment;
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	GLsizeiptr totalSize = this->regionSize * this->regionCount;
+
+	glGenBuffers(1, &bufferID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, totalSize, nullptr, flags);
+	mapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags));
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	if (!mapped) {
+		std::cout << "Failed to map the stream buffer" << std::endl;
+	}
+}
+
+/***********************************************************************
+ * ~StreamBuffer: Destructor for the StreamBuffer class.
+ * Author: [Smirti Parajuli]
+ * Description: Releases the fences, the mapping and the buffer.
+ *
+ * Parameters: None
+ *
+ * Return: None (destructor)
+ ***********************************************************************/
+StreamBuffer::~StreamBuffer()
+{
+	for (int i = 0; i < regionCount; i++) {
+		if (fences[i]) {
+			glDeleteSync(fences[i]);
+		}
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+	glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glDeleteBuffers(1, &bufferID);
+}
+
+/***********************************************************************
+ * BeginFrame: Starts writing a new frame.
+ * Author: [Smirti Parajuli]
+ * Description: Advances to the next region. If the GPU has not finished
+ *              the frame that last used it, waits on that frame's fence.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void StreamBuffer::BeginFrame()
+{
+	region = (region + 1) % regionCount;
+	head = 0;
+
+	GLsync fence = fences[region];
+	if (!fence) {
+		return;
+	}
+
+	// Poll first so the common case costs nothing, then block with a flush if needed
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		stallCount++;
+		do {
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);// 1 ms
+		} while (result == GL_TIMEOUT_EXPIRED);
+	}
+	glDeleteSync(fence);
+	fences[region] = nullptr;
+}
+
+/***********************************************************************
+ * EndFrame: Finishes writing the current frame.
+ * Author: [Smirti Parajuli]
+ * Description: Inserts a fence after the commands that read this region.
+ *
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void StreamBuffer::EndFrame()
+{
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/***********************************************************************
+ * Allocate: Reserves space in the current region.
+ * Author: [Smirti Parajuli]
+ * Description: Bumps the region head by the aligned size. The returned
+ *              pointer is write-only mapped memory valid until EndFrame.
+ *
+ * Parameters:
+ *   - size: Number of bytes required.
+ *   - offset: Receives the byte offset in the buffer for binding.
+ *
+ * Return: Pointer to the mapped memory, or nullptr if the region is full.
+ ***********************************************************************/
+void* StreamBuffer::Allocate(GLsizeiptr size, GLintptr& offset)
+{
+	GLsizeiptr alignedHead = (head + alignment - 1) / alignment * alignment;
+	if (!mapped || alignedHead + size > regionSize) {
+		if (!reportedOverflow) {
+			std::cout << "Stream buffer region is full, increase the region size" << std::endl;
+			reportedOverflow = true;
+		}
+		return nullptr;
+	}
+	head = alignedHead + size;
+	offset = regionSize * region + alignedHead;
+	return mapped + offset;
+}
+
+/***********************************************************************
+ * BindRange: Binds a suballocation to an indexed binding point.
+ * Author: [Smirti Parajuli]
+ * Description: Thin wrapper over glBindBufferRange for this buffer.
+ *
+ * Parameters:
+ *   - target: GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER.
+ *   - index: Binding point declared in the shader.
+ *   - offset: Offset returned by Allocate.
+ *   - size: Size passed to Allocate.
+ *
+ * Return: None
+ ***********************************************************************/
+void StreamBuffer::BindRange(GLenum target, GLuint index, GLintptr offset, GLsizeiptr size) const
+{
+	glBindBufferRange(target, index, bufferID, offset, size);
+}
@@ -0,0 +1,63 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :StreamBuffer.h
+Description :  The StreamBuffer class is a persistently mapped ring buffer for
+               per-frame data. It is split into one region per frame in
+               flight, each guarded by a fence, so the CPU writes uniforms
+               and instance data straight into GPU visible memory without
+               driver copies or implicit synchronisation.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <glew.h>
+
+class StreamBuffer
+{
+public:
+	StreamBuffer(GLsizeiptr regionSize, int regionCount = 3);
+	~StreamBuffer();
+
+	void BeginFrame();// Moves to the next region, waiting only if the GPU still reads it
+	void EndFrame();// Fences the commands that read the current region
+
+	// Reserves aligned space in the current region, returns nullptr when the region is full
+	void* Allocate(GLsizeiptr size, GLintptr& offset);
+	template <typename T>
+	T* Allocate(GLintptr& offset, GLsizeiptr count = 1) {
+		return static_cast<T*>(Allocate(static_cast<GLsizeiptr>(sizeof(T)) * count, offset));
+	}
+
+	// Binds part of the buffer to an indexed uniform or shader storage binding point
+	void BindRange(GLenum target, GLuint index, GLintptr offset, GLsizeiptr size) const;
+
+	GLuint GetID() const { return bufferID; }
+	int GetStallCount() const { return stallCount; }// Frames that had to wait on a fence
+
+	// Copying and assignment not allowed for this class
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+private:
+	static const int MaxRegions = 4;
+
+	GLuint bufferID = 0;
+	unsigned char* mapped = nullptr;// Persistent mapping of the whole buffer
+	GLsizeiptr regionSize;
+	int regionCount;
+	int region = 0;// Region written this frame
+	GLsizeiptr head = 0;// Next free byte inside the current region
+	GLsizeiptr alignment = 256;// Largest offset alignment required by the bind targets
+	GLsync fences[MaxRegions] = {};
+	int stallCount = 0;
+	bool reportedOverflow = false;
+};
+#endif // STREAMBUFFER_H
@@ -0,0 +1,118 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :TaskGraph.cpp
+Description :  Implementation of the dependency graph run on the job system.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "TaskGraph.h"
+
+/***********************************************************************
+ * TaskGraph: Constructor for the TaskGraph class.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+TaskGraph::TaskGraph()
+{
+}
+
+/***********************************************************************
+ * Add: Adds a task with no dependencies yet.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - task: The work to run.
+ *
+ * Return: Id of the task.
+ ***********************************************************************/
+size_t TaskGraph::Add(std::function<void()> task)
+{
+	tasks.emplace_back();
+	tasks.back().work = std::move(task);
+	return tasks.size() - 1;
+}
+
+/***********************************************************************
+ * Precede: Orders two tasks.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - before: Task that must finish first.
+ *   - after: Task that waits for it.
+ *
+ * Return: None
+ ***********************************************************************/
+void TaskGraph::Precede(size_t before, size_t after)
+{
+	tasks[before].successors.push_back(after);
+	tasks[after].dependencyCount++;
+}
+
+/***********************************************************************
+ * Run: Runs every task once, respecting the order.
+ * Author: [Smirti Parajuli]
+ * Description: Tasks without dependencies are queued straight away, the
+ *              rest are queued by the last task they wait for. The calling
+ *              thread helps until the counter shows everything has run.
+ *
+ * Parameters:
+ *   - jobs: The job system to run on.
+ *
+ * Return: None
+ ***********************************************************************/
+void TaskGraph::Run(JobSystem& jobs)
+{
+	for (Task& task : tasks) {
+		task.remaining.store(task.dependencyCount, std::memory_order_relaxed);
+	}
+	JobCounter counter;
+	for (size_t id = 0; id < tasks.size(); id++) {
+		if (tasks[id].dependencyCount == 0) {
+			Launch(jobs, counter, id);
+		}
+	}
+	jobs.Wait(counter);
+}
+
+/***********************************************************************
+ * Clear: Removes every task.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void TaskGraph::Clear()
+{
+	tasks.clear();
+}
+
+/***********************************************************************
+ * Launch: Queues one task.
+ * Author: [Smirti Parajuli]
+ * Description: Successors are queued from inside the job before it ends,
+ *              so the counter cannot reach zero while work is left.
+ *
+ * Parameters:
+ *   - jobs: The job system to run on.
+ *   - counter: Counter of the current Run.
+ *   - id: The task to queue.
+ *
+ * Return: None
+ ***********************************************************************/
+void TaskGraph::Launch(JobSystem& jobs, JobCounter& counter, size_t id)
+{
+	jobs.Run(counter, [this, &jobs, &counter, id] {
+		Task& task = tasks[id];
+		task.work();
+		for (size_t successor : task.successors) {
+			if (tasks[successor].remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				Launch(jobs, counter, successor);
+			}
+		}
+	});
+}
@@ -0,0 +1,54 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :TaskGraph.h
+Description :  The TaskGraph holds tasks and the order some of them must
+               run in. Run hands every task to the job system as soon as
+               the tasks before it have finished, so independent branches
+               run side by side, and returns when the whole graph is done.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <vector>
+#include "JobSystem.h"
+
+class TaskGraph
+{
+public:
+	TaskGraph();
+
+	size_t Add(std::function<void()> task);// Returns the id used by Precede
+	void Precede(size_t before, size_t after);// after starts only once before has finished
+	void Run(JobSystem& jobs);// Blocks, helping with the jobs, until every task has run
+	void Clear();
+
+	size_t GetTaskCount() const { return tasks.size(); }
+
+	// Copying and assignment not allowed for this class
+	TaskGraph(const TaskGraph&) = delete;
+	TaskGraph& operator=(const TaskGraph&) = delete;
+
+private:
+	struct Task {
+		std::function<void()> work;
+		std::vector<size_t> successors;
+		int dependencyCount = 0;
+		std::atomic<int> remaining{ 0 };// Unfinished dependencies during Run
+	};
+
+	void Launch(JobSystem& jobs, JobCounter& counter, size_t id);
+
+	std::deque<Task> tasks;// A deque so adding never moves a task
+};
+#endif // TASKGRAPH_H
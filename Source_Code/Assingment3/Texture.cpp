@@ -16,6 +16,9 @@
 // Including necessary header files
 #include "stb_image.h"
 #include "Texture.h"
+#include "GLState.h"
+#include <cstring>
+#include <vector>
 
 /***********************************************************************
  * Texture: Constructor for the Texture class.
@@ -29,11 +32,29 @@
  ***********************************************************************/
 
 Texture::Texture(const std::string& path)
-    : data(nullptr), height(0), nrChannels(0) // Initializing data to null and height to 0
+    : textureID(0), width(0), height(0), nrChannels(0), jobs(nullptr) // Initializing the sizes to 0
 {
     TextureLoad(path);// Load the texture from the specified path
 }
 
+/***********************************************************************
+ * Texture: Constructor for the Texture class that loads in the background.
+ * Author: [Smirti Parajuli]
+ * Description: Queues the file read and decode as a job and returns
+ *              straight away. The texture has no ID until FinishLoad is
+ *              called on the GL thread.
+ * Parameters:
+ *   - path: The file path to the texture image.
+ *   - jobs: The job system the decode runs on.
+ *
+ * Return: None (constructor)
+ ***********************************************************************/
+Texture::Texture(const std::string& path, JobSystem& jobs)
+    : textureID(0), width(0), height(0), nrChannels(0), path(path), jobs(&jobs)
+{
+    jobs.Run(decodeCounter, [this] { Decode(); });
+}
+
 /***********************************************************************
  * TextureLoad: Loads a texture from the specified file path.
  * Author: [Smirti Parajuli]
@@ -45,12 +66,60 @@ Texture::Texture(const std::string& path)
  * Return: None
  ***********************************************************************/
 void Texture::TextureLoad(const std::string& path) {
-    // This line flips the loaded image's origin to the lower left, matching OpenGL's image coordinate system.
-    stbi_set_flip_vertically_on_load(true);
+    this->path = path;
+    Decode();
+    Upload();
+}
 
-    int width, height, nrChannels;// Variables to store image's dimensions and number of color channels
-    // Load the image from the provided path, also fetch its dimensions and number of color channels
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
+/***********************************************************************
+ * FinishLoad: Completes a texture started with the job constructor.
+ * Author: [Smirti Parajuli]
+ * Description: Waits for the decode job, running other jobs meanwhile,
+ *              then uploads the image. Does nothing when already loaded.
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void Texture::FinishLoad() {
+    if (jobs == nullptr) {
+        return;
+    }
+    jobs->Wait(decodeCounter);
+    jobs = nullptr;
+    Upload();
+}
+
+/***********************************************************************
+ * Decode: Reads and decodes the image file.
+ * Author: [Smirti Parajuli]
+ * Description: Asks for the bottom row first so the image origin is the
+ *              lower left, matching OpenGL's image coordinate system. A
+ *              packed image is already stored that way and used in place.
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void Texture::Decode() {
+    // Load the image from the asset pack or the file, bottom row first, also fetch its dimensions and number of color channels
+    if (!image.Load(path, true)) {
+        return;
+    }
+    width = image.GetWidth();
+    height = image.GetHeight();
+    nrChannels = image.GetChannels();
+}
+
+/***********************************************************************
+ * Upload: Creates the OpenGL texture from the decoded image.
+ * Author: [Smirti Parajuli]
+ * Description: Must run on the GL thread. The pixels are released once
+ *              they are on the GPU.
+ * Parameters: None
+ *
+ * Return: None
+ ***********************************************************************/
+void Texture::Upload() {
+    const unsigned char* data = image.GetPixels();
     if (!data) { // Check if the data was loaded successfully
         std::cout << "Failed to load texture from " << path << std::endl;
         return;
@@ -58,7 +127,7 @@ void Texture::TextureLoad(const std::string& path) {
     // Generate a new OpenGL texture ID
     glGenTextures(1, &textureID);
     // Bind this texture to the current OpenGL context for 2D texturing
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLState::Get().BindTexture(GL_TEXTURE_2D, textureID, GLState::Get().GetActiveTextureUnit());
     GLenum format = (nrChannels == 3) ? GL_RGB : GL_RGBA;
     // Check the number of color channels and define the texture format accordingly
     if (nrChannels == 3) {
@@ -73,7 +142,7 @@ void Texture::TextureLoad(const std::string& path) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     // Release the loaded image data as it's no longer needed
-    stbi_image_free(data);
+    image.Release();
 }
 /***********************************************************************
  * ~Texture: Destructor for the Texture class.
@@ -86,7 +155,14 @@ void Texture::TextureLoad(const std::string& path) {
  * Return: None (destructor)
  ***********************************************************************/
 Texture::~Texture() {
-    glDeleteTextures(1, &textureID);
+    // A decode job may still be writing into this object
+    if (jobs != nullptr) {
+        jobs->Wait(decodeCounter);
+    }
+    if (textureID != 0) {
+        GLState::Get().ForgetTexture(textureID);
+        glDeleteTextures(1, &textureID);
+    }
 }
 /***********************************************************************
  * Bind: Binds the texture to a specific texture slot in OpenGL.
@@ -99,10 +175,8 @@ Texture::~Texture() {
  * Return: None
  ***********************************************************************/
 void Texture::Bind(int slot) const {
-    // Set the active texture slot
-    glActiveTexture(GL_TEXTURE0 + slot);
-    // Bind this texture to the active slot
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    // Bind this texture to the slot, switching the active slot only if needed
+    GLState::Get().BindTexture(GL_TEXTURE_2D, textureID, slot);
 }
 /***********************************************************************
  * Unbind: Unbinds any textures from the currently active texture slot.
@@ -115,5 +189,5 @@ void Texture::Bind(int slot) const {
  * Return: None
  ***********************************************************************/
 void Texture::Unbind() const {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::Get().BindTexture(GL_TEXTURE_2D, 0, GLState::Get().GetActiveTextureUnit());
 }
@@ -7,6 +7,7 @@ New Zealand
 File Name :Texture.h
 Description : The Texture class encapsulates the functionalities required for handling textures in an OpenGL context. 
               It provides a convenient interface to load, bind, unbind, and retrieve the ID of a texture. 
+              The image can be decoded as a job while the owner carries on, and is uploaded by FinishLoad.
 Author : [Smirti Parajuli]
 Mail : smirti.parajuli@mds.ac.nz
 **************************************************************************/
@@ -16,18 +17,29 @@ Mail : smirti.parajuli@mds.ac.nz
 
 #include <iostream>
 #include <string>
+#include "JobSystem.h"
+#include "AssetPack.h"
 class Texture {
 private:
     GLuint textureID;// OpenGL ID for // Dimensions of the texture and the number of color channels the texture
     int width, height, nrChannels;
-    unsigned char* data;// Pointer to the raw pixel data of the texture
+    ImageAsset image;// Pixels of the texture, in the asset pack or decoded, held between decoding and uploading
+    std::string path;
+    JobSystem* jobs;// Set while a decode job may still be running
+    JobCounter decodeCounter;
+
+    void Decode();// Finds or decodes the image, safe to run on any thread
+    void Upload();// Creates the OpenGL texture from the image, GL thread only
 
 public:
     Texture(const std::string& path); // Constructor that takes a file path to load the texture
+    Texture(const std::string& path, JobSystem& jobs); // Starts decoding as a job, FinishLoad completes it
     ~Texture();// Destructor to clean up resources
 
     // Function to load a texture from a file path
     void TextureLoad(const std::string& path);
+    // Waits for the decode job, helping with other jobs meanwhile, and uploads the image
+    void FinishLoad();
     // Binds the texture to a given texture slot (default is 0)
     void Bind(int slot = 0) const;
     // Unbinds the texture from the current slot
@@ -35,5 +47,9 @@ public:
 
     // Getter function to retrieve the OpenGL ID of the texture
     GLuint GetID() const { return textureID; }
+
+    // Copying and assignment not allowed for this class
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
 };
 #endif // TEXTURE_H
\ No newline at end of file
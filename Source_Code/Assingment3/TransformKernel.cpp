@@ -0,0 +1,461 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :TransformKernel.cpp
+Description :  Implementation of the batched transform kernel: CPU feature
+               detection, the scalar and SSE paths and the benchmark.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "TransformKernel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TRANSFORM_KERNEL_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define TRANSFORM_KERNEL_SSE 1
+#include <emmintrin.h>
+#endif
+
+#if defined(TRANSFORM_KERNEL_SSE)
+namespace
+{
+	// Four instances per register
+	struct Sse4 {
+		static const size_t Width = 4;
+		__m128 v;
+
+		static Sse4 Set1(float value) { return { _mm_set1_ps(value) }; }
+		static Sse4 Gather(const float* base, const std::uint32_t* index) {
+			return { _mm_set_ps(base[index[3]], base[index[2]], base[index[1]], base[index[0]]) };
+		}
+		// a, b, c, d hold one matrix column element each, written as the column of four instances
+		static void StoreColumns(InstanceTransform* out, size_t offset, Sse4 a, Sse4 b, Sse4 c, Sse4 d) {
+			__m128 row0 = a.v, row1 = b.v, row2 = c.v, row3 = d.v;
+			_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+			_mm_storeu_ps(reinterpret_cast<float*>(out + 0) + offset, row0);
+			_mm_storeu_ps(reinterpret_cast<float*>(out + 1) + offset, row1);
+			_mm_storeu_ps(reinterpret_cast<float*>(out + 2) + offset, row2);
+			_mm_storeu_ps(reinterpret_cast<float*>(out + 3) + offset, row3);
+		}
+	};
+	inline Sse4 operator+(Sse4 a, Sse4 b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline Sse4 operator-(Sse4 a, Sse4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+	inline Sse4 operator*(Sse4 a, Sse4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+	inline Sse4 operator/(Sse4 a, Sse4 b) { return { _mm_div_ps(a.v, b.v) }; }
+}
+#include "TransformKernelSimd.h"
+#endif
+
+namespace
+{
+	/***********************************************************************
+	 * CpuSupports: Checks the CPU and operating system for a path.
+	 * Author: [Smirti Parajuli]
+	 * Description: AVX2 needs the CPU flag and the operating system saving
+	 *              the upper halves of the AVX registers.
+	 *
+	 * Parameters:
+	 *   - path: The path to check.
+	 *
+	 * Return: True if the path can run here.
+	 ***********************************************************************/
+	bool CpuSupports(TransformPath path)
+	{
+		if (path == TransformPath::Scalar) {
+			return true;
+		}
+#if defined(TRANSFORM_KERNEL_X86)
+		unsigned int leaf1[4] = { 0, 0, 0, 0 };
+		unsigned int leaf7[4] = { 0, 0, 0, 0 };
+		unsigned long long enabledState = 0;
+#if defined(_MSC_VER)
+		int registers[4];
+		__cpuid(registers, 0);
+		int highestLeaf = registers[0];
+		__cpuid(registers, 1);
+		for (int i = 0; i < 4; i++) leaf1[i] = static_cast<unsigned int>(registers[i]);
+		if (highestLeaf >= 7) {
+			__cpuidex(registers, 7, 0);
+			for (int i = 0; i < 4; i++) leaf7[i] = static_cast<unsigned int>(registers[i]);
+		}
+		if (leaf1[2] & (1u << 27)) {
+			enabledState = _xgetbv(0);
+		}
+#else
+		unsigned int highestLeaf = __get_cpuid_max(0, nullptr);
+		__get_cpuid(1, &leaf1[0], &leaf1[1], &leaf1[2], &leaf1[3]);
+		if (highestLeaf >= 7) {
+			__cpuid_count(7, 0, leaf7[0], leaf7[1], leaf7[2], leaf7[3]);
+		}
+		if (leaf1[2] & (1u << 27)) {
+			unsigned int low = 0, high = 0;
+			__asm__ volatile ("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+			enabledState = (static_cast<unsigned long long>(high) << 32) | low;
+		}
+#endif
+		bool sse2 = (leaf1[3] & (1u << 26)) != 0;
+		bool avx = (leaf1[2] & (1u << 28)) != 0 && (enabledState & 0x6) == 0x6;
+		bool avx2 = avx && (leaf7[1] & (1u << 5)) != 0;
+#if !defined(_M_X64) && !defined(__x86_64__)
+		avx2 = false;// TransformKernelAVX2.cpp is only built for 64-bit
+#endif
+		if (path == TransformPath::SSE) {
+#if defined(TRANSFORM_KERNEL_SSE)
+			return sse2;
+#else
+			return false;
+#endif
+		}
+		return avx2;
+#else
+		return false;
+#endif
+	}
+
+	/***********************************************************************
+	 * BuildOne: Builds the transform of one instance.
+	 * Author: [Smirti Parajuli]
+	 * Parameters:
+	 *   - source: The entity arrays.
+	 *   - index: Dense entity index.
+	 *   - params: Values shared by the batch.
+	 *   - out: Receives the transform.
+	 *
+	 * Return: None
+	 ***********************************************************************/
+	void BuildOne(const TransformSource& source, std::uint32_t index, const TransformParams& params, InstanceTransform& out)
+	{
+		const float rx = params.extraRotation.x, ry = params.extraRotation.y, rz = params.extraRotation.z, rw = params.extraRotation.w;
+		const float ex = source.rotationX[index], ey = source.rotationY[index], ez = source.rotationZ[index], ew = source.rotationW[index];
+		float x = rw * ex + rx * ew + ry * ez - rz * ey;
+		float y = rw * ey - rx * ez + ry * ew + rz * ex;
+		float z = rw * ez + rx * ey - ry * ex + rz * ew;
+		float w = rw * ew - rx * ex - ry * ey - rz * ez;
+
+		float xx = x * x, yy = y * y, zz = z * z;
+		float xy = x * y, xz = x * z, yz = y * z;
+		float wx = w * x, wy = w * y, wz = w * z;
+		glm::vec4 rotation[3] = {
+			glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f),
+			glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f),
+			glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f)
+		};
+
+		float scale = source.scale[index];
+		float inverseScale = 1.0f / scale;
+		glm::vec4 translation(source.positionX[index], source.positionY[index], source.positionZ[index], 1.0f);
+		if (source.velocityX != nullptr) {
+			translation.x += source.velocityX[index] * params.timeOffset;
+			translation.y += source.velocityY[index] * params.timeOffset;
+			translation.z += source.velocityZ[index] * params.timeOffset;
+		}
+
+		for (int column = 0; column < 3; column++) {
+			out.model[column] = rotation[column] * scale;
+			out.normalMatrix[column] = rotation[column] * inverseScale;
+		}
+		out.model[3] = translation;
+		out.normalMatrix[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		if (params.writePVM) {
+			out.pvm = params.viewProjection * out.model;
+		}
+	}
+}
+
+/***********************************************************************
+ * Build: Builds the transforms of a batch of instances.
+ * Author: [Smirti Parajuli]
+ * Description: Runs on the calling thread only, callers split big batches
+ *              with JobSystem::ParallelFor.
+ *
+ * Parameters:
+ *   - source: The entity arrays.
+ *   - indices: Entity index of every output instance.
+ *   - count: Number of instances.
+ *   - params: Values shared by the batch.
+ *   - out: Receives count transforms.
+ *
+ * Return: None
+ ***********************************************************************/
+void TransformKernel::Build(const TransformSource& source, const std::uint32_t* indices, size_t count, const TransformParams& params, InstanceTransform* out)
+{
+	switch (CurrentPath())
+	{
+	case TransformPath::AVX2:
+		BuildAVX2(source, indices, count, params, out);
+		break;
+	case TransformPath::SSE:
+		BuildSSE(source, indices, count, params, out);
+		break;
+	default:
+		BuildScalar(source, indices, count, params, out);
+		break;
+	}
+}
+
+/***********************************************************************
+ * GetPath: The path Build currently uses.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: The selected path.
+ ***********************************************************************/
+TransformPath TransformKernel::GetPath()
+{
+	return CurrentPath();
+}
+
+/***********************************************************************
+ * GetBestPath: The fastest path the CPU can run.
+ * Author: [Smirti Parajuli]
+ * Parameters: None
+ *
+ * Return: AVX2, SSE or Scalar.
+ ***********************************************************************/
+TransformPath TransformKernel::GetBestPath()
+{
+	if (CpuSupports(TransformPath::AVX2)) {
+		return TransformPath::AVX2;
+	}
+	if (CpuSupports(TransformPath::SSE)) {
+		return TransformPath::SSE;
+	}
+	return TransformPath::Scalar;
+}
+
+/***********************************************************************
+ * SetPath: Forces a path, for comparisons.
+ * Author: [Smirti Parajuli]
+ * Description: A path the CPU cannot run is ignored.
+ *
+ * Parameters:
+ *   - path: The path Build should use.
+ *
+ * Return: None
+ ***********************************************************************/
+void TransformKernel::SetPath(TransformPath path)
+{
+	if (CpuSupports(path)) {
+		CurrentPath() = path;
+	}
+}
+
+/***********************************************************************
+ * GetPathName: Readable name of a path.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - path: The path.
+ *
+ * Return: The name.
+ ***********************************************************************/
+const char* TransformKernel::GetPathName(TransformPath path)
+{
+	switch (path)
+	{
+	case TransformPath::AVX2:
+		return "AVX2";
+	case TransformPath::SSE:
+		return "SSE";
+	default:
+		return "Scalar";
+	}
+}
+
+/***********************************************************************
+ * CurrentPath: Storage of the selected path.
+ * Author: [Smirti Parajuli]
+ * Description: Detected from the CPU on first use.
+ *
+ * Parameters: None
+ *
+ * Return: Reference to the selected path.
+ ***********************************************************************/
+TransformPath& TransformKernel::CurrentPath()
+{
+	static TransformPath path = GetBestPath();
+	return path;
+}
+
+/***********************************************************************
+ * BuildScalar: One instance at a time, runs everywhere.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - source: The entity arrays.
+ *   - indices: Entity index of every output instance.
+ *   - count: Number of instances.
+ *   - params: Values shared by the batch.
+ *   - out: Receives count transforms.
+ *
+ * Return: None
+ ***********************************************************************/
+void TransformKernel::BuildScalar(const TransformSource& source, const std::uint32_t* indices, size_t count, const TransformParams& params, InstanceTransform* out)
+{
+	for (size_t k = 0; k < count; k++) {
+		BuildOne(source, indices[k], params, out[k]);
+	}
+}
+
+/***********************************************************************
+ * BuildSSE: Four instances at a time.
+ * Author: [Smirti Parajuli]
+ * Description: The last count % 4 instances use the scalar path.
+ *
+ * Parameters:
+ *   - source: The entity arrays.
+ *   - indices: Entity index of every output instance.
+ *   - count: Number of instances.
+ *   - params: Values shared by the batch.
+ *   - out: Receives count transforms.
+ *
+ * Return: None
+ ***********************************************************************/
+void TransformKernel::BuildSSE(const TransformSource& source, const std::uint32_t* indices, size_t count, const TransformParams& params, InstanceTransform* out)
+{
+	size_t done = 0;
+#if defined(TRANSFORM_KERNEL_SSE)
+	done = BuildBatches<Sse4>(source, indices, count, params, out);
+#endif
+	BuildScalar(source, indices + done, count - done, params, out + done);
+}
+
+/***********************************************************************
+ * Benchmark: Compares the per-object path with the kernel paths.
+ * Author: [Smirti Parajuli]
+ * Description: Builds every matrix of instanceCount random instances the
+ *              way the spheres used to, glm::translate, rotate and scale
+ *              then projection * view * model one object at a time, and
+ *              then with every kernel path the CPU supports, on one thread
+ *              and across the job system. Prints the best of a few runs.
+ *
+ * Parameters:
+ *   - jobs: The job system for the multithreaded runs.
+ *   - instanceCount: Number of instances per run.
+ *
+ * Return: None
+ ***********************************************************************/
+void TransformKernel::Benchmark(JobSystem& jobs, size_t instanceCount)
+{
+	const int runs = 10;
+	const size_t grain = 1024;
+
+	// Random scene in structure of arrays form
+	std::mt19937 random(20231);
+	std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::vector<float> positionX(instanceCount), positionY(instanceCount), positionZ(instanceCount);
+	std::vector<float> rotationX(instanceCount), rotationY(instanceCount), rotationZ(instanceCount), rotationW(instanceCount);
+	std::vector<float> scale(instanceCount);
+	std::vector<std::uint32_t> indices(instanceCount);
+	for (size_t i = 0; i < instanceCount; i++) {
+		positionX[i] = position(random);
+		positionY[i] = position(random);
+		positionZ[i] = position(random);
+		glm::vec4 q(unit(random), unit(random), unit(random), unit(random));
+		q = glm::normalize(q);
+		rotationX[i] = q.x;
+		rotationY[i] = q.y;
+		rotationZ[i] = q.z;
+		rotationW[i] = q.w;
+		scale[i] = 0.5f + 0.5f * std::fabs(unit(random));
+		indices[i] = static_cast<std::uint32_t>(i);
+	}
+	// Visit the instances out of order, as sorted visible lists do
+	std::shuffle(indices.begin(), indices.end(), random);
+
+	TransformSource source;
+	source.positionX = positionX.data();
+	source.positionY = positionY.data();
+	source.positionZ = positionZ.data();
+	source.rotationX = rotationX.data();
+	source.rotationY = rotationY.data();
+	source.rotationZ = rotationZ.data();
+	source.rotationW = rotationW.data();
+	source.scale = scale.data();
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 30.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	TransformParams params;
+	params.writePVM = true;
+	params.viewProjection = projection * view;
+
+	std::vector<InstanceTransform> out(instanceCount);
+	auto timeBest = [&](const std::function<void()>& work) {
+		double best = 1e30;
+		for (int run = 0; run < runs; run++) {
+			auto start = std::chrono::steady_clock::now();
+			work();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	};
+	// One result line, padded in its own stream so std::cout keeps its settings
+	auto report = [](const std::string& name, double milliseconds, double speedup) {
+		std::ostringstream line;
+		line << "  " << std::left << std::setw(20) << name << milliseconds << " ms";
+		if (speedup > 0.0) {
+			line << " (" << speedup << "x)";
+		}
+		std::cout << line.str() << std::endl;
+	};
+
+	std::cout << "Transform benchmark, " << instanceCount << " instances, best of " << runs << " runs" << std::endl;
+
+	double perObject = timeBest([&] {
+		for (size_t k = 0; k < instanceCount; k++) {
+			std::uint32_t i = indices[k];
+			glm::quat rotation(rotationW[i], rotationX[i], rotationY[i], rotationZ[i]);
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(positionX[i], positionY[i], positionZ[i]));
+			model = model * glm::mat4_cast(rotation);
+			model = glm::scale(model, glm::vec3(scale[i]));
+			out[k].model = model;
+			out[k].normalMatrix = glm::transpose(glm::inverse(model));
+			out[k].pvm = projection * view * model;
+		}
+	});
+	report("per-object glm", perObject, 0.0);
+
+	TransformPath selected = GetPath();
+	const TransformPath paths[3] = { TransformPath::Scalar, TransformPath::SSE, TransformPath::AVX2 };
+	for (TransformPath path : paths) {
+		if (!CpuSupports(path)) {
+			std::cout << "  " << GetPathName(path) << " not supported by this CPU" << std::endl;
+			continue;
+		}
+		SetPath(path);
+		double single = timeBest([&] {
+			Build(source, indices.data(), instanceCount, params, out.data());
+		});
+		double threaded = timeBest([&] {
+			jobs.ParallelFor(instanceCount, grain, [&](size_t begin, size_t end) {
+				Build(source, indices.data() + begin, end - begin, params, out.data() + begin);
+			});
+		});
+		std::string name = GetPathName(path);
+		report(name + ", 1 thread", single, perObject / single);
+		report(name + ", " + std::to_string(jobs.GetThreadCount() + 1) + " threads", threaded, perObject / threaded);
+	}
+	CurrentPath() = selected;
+}
@@ -0,0 +1,78 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :TransformKernel.h
+Description :  The TransformKernel turns the position, rotation and scale
+               arrays of the entity store into the model, normal and
+               projection-view-model matrices of a batch of instances.
+               It works on 8 instances at a time with AVX2, 4 with SSE or
+               one with plain C++, picked once from what the CPU supports.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef TRANSFORMKERNEL_H
+#define TRANSFORMKERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "ShaderBindings.h"
+#include "JobSystem.h"
+
+// Structure of arrays input, indexed by the dense entity index
+struct TransformSource {
+	const float* positionX = nullptr;
+	const float* positionY = nullptr;
+	const float* positionZ = nullptr;
+	const float* rotationX = nullptr;// Unit quaternion (x, y, z, w)
+	const float* rotationY = nullptr;
+	const float* rotationZ = nullptr;
+	const float* rotationW = nullptr;
+	const float* scale = nullptr;// Uniform scale
+	const float* velocityX = nullptr;// Optional, moves the position by velocity * timeOffset
+	const float* velocityY = nullptr;
+	const float* velocityZ = nullptr;
+};
+
+// Values shared by every instance of a batch
+struct TransformParams {
+	glm::vec4 extraRotation = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);// Applied on top of every rotation
+	float timeOffset = 0.0f;
+	bool writePVM = false;
+	glm::mat4 viewProjection = glm::mat4(1.0f);// Used when writePVM is set
+};
+
+enum class TransformPath {
+	Scalar,
+	SSE,
+	AVX2
+};
+
+class TransformKernel
+{
+public:
+	// Fills out[k] for the entity indices[k], k in [0, count)
+	static void Build(const TransformSource& source, const std::uint32_t* indices, size_t count, const TransformParams& params, InstanceTransform* out);
+
+	static TransformPath GetPath();// The path Build uses
+	static TransformPath GetBestPath();// The fastest path this CPU can run
+	static void SetPath(TransformPath path);// Forces a path, limited to what the CPU can run
+	static const char* GetPathName(TransformPath path);
+
+	// Times the old per-object glm path against every kernel path and prints the results
+	static void Benchmark(JobSystem& jobs, size_t instanceCount);
+
+private:
+	TransformKernel();
+
+	static void BuildScalar(const TransformSource& source, const std::uint32_t* indices, size_t count, const TransformParams& params, InstanceTransform* out);
+	static void BuildSSE(const TransformSource& source, const std::uint32_t* indices, size_t count, const TransformParams& params, InstanceTransform* out);
+	static void BuildAVX2(const TransformSource& source, const std::uint32_t* indices, size_t count, const TransformParams& params, InstanceTransform* out);// TransformKernelAVX2.cpp
+	static TransformPath& CurrentPath();
+};
+#endif // TRANSFORMKERNEL_H
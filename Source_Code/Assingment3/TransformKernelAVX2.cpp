@@ -0,0 +1,87 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :TransformKernelAVX2.cpp
+Description :  The AVX2 path of the transform kernel. This is the only file
+               built with AVX2 enabled (see its settings in the project), so
+               nothing here runs unless the CPU check picked this path.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "TransformKernel.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define TRANSFORM_KERNEL_AVX2 1
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__AVX2__)
+#pragma GCC target("avx2")
+#endif
+
+namespace
+{
+	// Eight instances per register
+	struct Avx8 {
+		static const size_t Width = 8;
+		__m256 v;
+
+		static Avx8 Set1(float value) { return { _mm256_set1_ps(value) }; }
+		static Avx8 Gather(const float* base, const std::uint32_t* index) {
+			__m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index));
+			return { _mm256_i32gather_ps(base, offsets, 4) };
+		}
+		// a, b, c, d hold one matrix column element each, written as the column of eight instances
+		static void StoreColumns(InstanceTransform* out, size_t offset, Avx8 a, Avx8 b, Avx8 c, Avx8 d) {
+			// Interleave within each 128-bit half, then each half is four finished columns
+			__m256 ab0 = _mm256_unpacklo_ps(a.v, b.v);
+			__m256 ab1 = _mm256_unpackhi_ps(a.v, b.v);
+			__m256 cd0 = _mm256_unpacklo_ps(c.v, d.v);
+			__m256 cd1 = _mm256_unpackhi_ps(c.v, d.v);
+			__m256 column0 = _mm256_shuffle_ps(ab0, cd0, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 column1 = _mm256_shuffle_ps(ab0, cd0, _MM_SHUFFLE(3, 2, 3, 2));
+			__m256 column2 = _mm256_shuffle_ps(ab1, cd1, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 column3 = _mm256_shuffle_ps(ab1, cd1, _MM_SHUFFLE(3, 2, 3, 2));
+			_mm_storeu_ps(reinterpret_cast<float*>(out + 0) + offset, _mm256_castps256_ps128(column0));
+			_mm_storeu_ps(reinterpret_cast<float*>(out + 1) + offset, _mm256_castps256_ps128(column1));
+			_mm_storeu_ps(reinterpret_cast<float*>(out + 2) + offset, _mm256_castps256_ps128(column2));
+			_mm_storeu_ps(reinterpret_cast<float*>(out + 3) + offset, _mm256_castps256_ps128(column3));
+			_mm_storeu_ps(reinterpret_cast<float*>(out + 4) + offset, _mm256_extractf128_ps(column0, 1));
+			_mm_storeu_ps(reinterpret_cast<float*>(out + 5) + offset, _mm256_extractf128_ps(column1, 1));
+			_mm_storeu_ps(reinterpret_cast<float*>(out + 6) + offset, _mm256_extractf128_ps(column2, 1));
+			_mm_storeu_ps(reinterpret_cast<float*>(out + 7) + offset, _mm256_extractf128_ps(column3, 1));
+		}
+	};
+	inline Avx8 operator+(Avx8 a, Avx8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+	inline Avx8 operator-(Avx8 a, Avx8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+	inline Avx8 operator*(Avx8 a, Avx8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+	inline Avx8 operator/(Avx8 a, Avx8 b) { return { _mm256_div_ps(a.v, b.v) }; }
+}
+#include "TransformKernelSimd.h"
+#endif
+
+/***********************************************************************
+ * BuildAVX2: Eight instances at a time.
+ * Author: [Smirti Parajuli]
+ * Description: The last count % 8 instances use the scalar path. Only
+ *              64-bit builds have this path, elsewhere it is all scalar.
+ *
+ * Parameters:
+ *   - source: The entity arrays.
+ *   - indices: Entity index of every output instance.
+ *   - count: Number of instances.
+ *   - params: Values shared by the batch.
+ *   - out: Receives count transforms.
+ *
+ * Return: None
+ ***********************************************************************/
+void TransformKernel::BuildAVX2(const TransformSource& source, const std::uint32_t* indices, size_t count, const TransformParams& params, InstanceTransform* out)
+{
+	size_t done = 0;
+#if defined(TRANSFORM_KERNEL_AVX2)
+	done = BuildBatches<Avx8>(source, indices, count, params, out);
+#endif
+	BuildScalar(source, indices + done, count - done, params, out + done);
+}
@@ -0,0 +1,138 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :TransformKernelSimd.h
+Description :  The batched transform loop shared by the SSE and AVX2 paths,
+               written once against a small vector wrapper. Only included
+               by TransformKernel.cpp and TransformKernelAVX2.cpp, which are
+               compiled for different instruction sets. Everything here is
+               in an unnamed namespace so neither file can end up calling
+               the other's copy.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef TRANSFORMKERNELSIMD_H
+#define TRANSFORMKERNELSIMD_H
+
+#include <cstddef>
+#include <cstdint>
+#include "TransformKernel.h"
+
+namespace
+{
+	// Float offsets of the matrices inside one InstanceTransform
+	const size_t ModelOffset = 0;
+	const size_t NormalOffset = 16;
+	const size_t PVMOffset = 32;
+
+	/***********************************************************************
+	 * BuildBatches: Builds the transforms of whole batches of instances.
+	 * Author: [Smirti Parajuli]
+	 * Description: V holds V::Width lanes, one instance per lane. The
+	 *              quaternion product, the rotation matrix, the model,
+	 *              normal and PVM matrices are all computed lane-wise and
+	 *              transposed into the output only at the end.
+	 *              The rotation of a unit quaternion scaled by s has the
+	 *              rotation divided by s as its inverse transpose.
+	 *
+	 * Parameters:
+	 *   - source: The entity arrays.
+	 *   - indices: Entity index of every output instance.
+	 *   - count: Number of instances.
+	 *   - params: Values shared by the batch.
+	 *   - out: Receives one transform per instance.
+	 *
+	 * Return: Number of instances written, a multiple of V::Width.
+	 ***********************************************************************/
+	template <class V>
+	size_t BuildBatches(const TransformSource& source, const std::uint32_t* indices, size_t count, const TransformParams& params, InstanceTransform* out)
+	{
+		const V rx = V::Set1(params.extraRotation.x);
+		const V ry = V::Set1(params.extraRotation.y);
+		const V rz = V::Set1(params.extraRotation.z);
+		const V rw = V::Set1(params.extraRotation.w);
+		const V time = V::Set1(params.timeOffset);
+		const V zero = V::Set1(0.0f);
+		const V one = V::Set1(1.0f);
+		const V two = V::Set1(2.0f);
+		const bool moving = (source.velocityX != nullptr);
+
+		// viewProjection[column][row], broadcast once
+		const float* viewProjection = reinterpret_cast<const float*>(&params.viewProjection);
+		V vp[16];
+		for (int element = 0; element < 16; element++) {
+			vp[element] = V::Set1(viewProjection[element]);
+		}
+
+		size_t i = 0;
+		for (; i + V::Width <= count; i += V::Width) {
+			const std::uint32_t* batch = indices + i;
+			V ex = V::Gather(source.rotationX, batch);
+			V ey = V::Gather(source.rotationY, batch);
+			V ez = V::Gather(source.rotationZ, batch);
+			V ew = V::Gather(source.rotationW, batch);
+
+			// Extra rotation applied after the entity rotation
+			V x = rw * ex + rx * ew + ry * ez - rz * ey;
+			V y = rw * ey - rx * ez + ry * ew + rz * ex;
+			V z = rw * ez + rx * ey - ry * ex + rz * ew;
+			V w = rw * ew - rx * ex - ry * ey - rz * ez;
+
+			V xx = x * x, yy = y * y, zz = z * z;
+			V xy = x * y, xz = x * z, yz = y * z;
+			V wx = w * x, wy = w * y, wz = w * z;
+
+			// Rotation matrix, r[column][row]
+			V r[3][3];
+			r[0][0] = one - two * (yy + zz); r[0][1] = two * (xy + wz); r[0][2] = two * (xz - wy);
+			r[1][0] = two * (xy - wz); r[1][1] = one - two * (xx + zz); r[1][2] = two * (yz + wx);
+			r[2][0] = two * (xz + wy); r[2][1] = two * (yz - wx); r[2][2] = one - two * (xx + yy);
+
+			V scale = V::Gather(source.scale, batch);
+			V inverseScale = one / scale;
+			V translation[3] = {
+				V::Gather(source.positionX, batch),
+				V::Gather(source.positionY, batch),
+				V::Gather(source.positionZ, batch)
+			};
+			if (moving) {
+				translation[0] = translation[0] + V::Gather(source.velocityX, batch) * time;
+				translation[1] = translation[1] + V::Gather(source.velocityY, batch) * time;
+				translation[2] = translation[2] + V::Gather(source.velocityZ, batch) * time;
+			}
+
+			InstanceTransform* target = out + i;
+			V model[3][3];
+			for (int column = 0; column < 3; column++) {
+				model[column][0] = r[column][0] * scale;
+				model[column][1] = r[column][1] * scale;
+				model[column][2] = r[column][2] * scale;
+				V::StoreColumns(target, ModelOffset + column * 4, model[column][0], model[column][1], model[column][2], zero);
+				V::StoreColumns(target, NormalOffset + column * 4, r[column][0] * inverseScale, r[column][1] * inverseScale, r[column][2] * inverseScale, zero);
+			}
+			V::StoreColumns(target, ModelOffset + 12, translation[0], translation[1], translation[2], one);
+			V::StoreColumns(target, NormalOffset + 12, zero, zero, zero, one);
+
+			if (params.writePVM) {
+				for (int column = 0; column < 4; column++) {
+					const V* m = (column < 3) ? model[column] : translation;
+					V row[4];
+					for (int element = 0; element < 4; element++) {
+						row[element] = vp[element] * m[0] + vp[4 + element] * m[1] + vp[8 + element] * m[2];
+						if (column == 3) {
+							row[element] = row[element] + vp[12 + element];
+						}
+					}
+					V::StoreColumns(target, PVMOffset + column * 4, row[0], row[1], row[2], row[3]);
+				}
+			}
+		}
+		return i;
+	}
+}
+#endif // TRANSFORMKERNELSIMD_H
@@ -0,0 +1,62 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :TripleBuffer.h
+Description :  Lock-free single producer / single consumer triple buffer.
+               The producer always has a slot to write into and the consumer
+               always reads the most recently published complete value,
+               without either side ever waiting on the other.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() : middle(1), back(2), front(0) {}
+
+	// Producer: slot to fill for the next publish. Contents are whatever was
+	// written there two publishes ago, so containers keep their capacity.
+	T& BeginWrite() { return slots[back]; }
+
+	// Producer: makes the back slot visible to the consumer and takes the old middle slot
+	void Publish()
+	{
+		unsigned int previous = middle.exchange(back | DirtyBit, std::memory_order_acq_rel);
+		back = previous & IndexMask;
+	}
+
+	// Consumer: swaps in the newest published slot, returns false if nothing new was published
+	bool Consume()
+	{
+		if ((middle.load(std::memory_order_relaxed) & DirtyBit) == 0) {
+			return false;
+		}
+		unsigned int previous = middle.exchange(front, std::memory_order_acq_rel);
+		front = previous & IndexMask;
+		return true;
+	}
+
+	// Consumer: the slot returned by the latest successful Consume()
+	const T& Read() const { return slots[front]; }
+
+private:
+	static const unsigned int DirtyBit = 4;
+	static const unsigned int IndexMask = 3;
+
+	T slots[3];
+	std::atomic<unsigned int> middle;// Index of the shared slot, plus DirtyBit when it holds unread data
+	unsigned int back;// Owned by the producer
+	unsigned int front;// Owned by the consumer
+};
+#endif // TRIPLEBUFFER_H
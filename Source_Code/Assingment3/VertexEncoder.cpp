@@ -0,0 +1,138 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :VertexEncoder.cpp
+Description :  Implementation of the vertex format conversion.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#include "VertexEncoder.h"
+#include <glm/packing.hpp>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+/***********************************************************************
+ * GetStride: Size of one vertex.
+ * Author: [Smirti Parajuli]
+ * Parameters:
+ *   - format: The vertex format.
+ *
+ * Return: Number of 32-bit words per vertex.
+ ***********************************************************************/
+GLuint VertexEncoder::GetStride(VertexFormat format)
+{
+	return (format == VertexFormat::Float32) ? FloatsPerVertex : 3;
+}
+
+/***********************************************************************
+ * Encode: Converts float vertices to a stored format.
+ * Author: [Smirti Parajuli]
+ * Description: The compact formats use three words per vertex:
+ *              - position x and y
+ *              - position z in the low half, the octahedral normal as two
+ *                snorm8 values in the high half
+ *              - texture coordinates as two unorm16 values
+ *              Snorm positions are stored relative to the mesh bounds, so
+ *              they keep 16 bits of precision whatever the mesh size.
+ *
+ * Parameters:
+ *   - vertices: FloatsPerVertex floats for every vertex.
+ *   - vertexCount: Number of vertices.
+ *   - format: The format to store.
+ *   - out: Receives the words and the position decode values.
+ *
+ * Return: None
+ ***********************************************************************/
+void VertexEncoder::Encode(const GLfloat* vertices, GLuint vertexCount, VertexFormat format, EncodedVertices& out)
+{
+	out.stride = GetStride(format);
+	out.words.resize(static_cast<size_t>(vertexCount) * out.stride);
+	out.positionScale = glm::vec3(1.0f);
+	out.positionOffset = glm::vec3(0.0f);
+
+	if (format == VertexFormat::Float32) {
+		if (vertexCount > 0) {
+			std::memcpy(out.words.data(), vertices, sizeof(GLfloat) * FloatsPerVertex * vertexCount);
+		}
+		return;
+	}
+
+	if (format == VertexFormat::SnormOctahedral && vertexCount > 0) {
+		glm::vec3 low(vertices[0], vertices[1], vertices[2]);
+		glm::vec3 high = low;
+		for (GLuint i = 1; i < vertexCount; i++) {
+			const GLfloat* vertex = vertices + i * FloatsPerVertex;
+			for (int axis = 0; axis < 3; axis++) {
+				low[axis] = std::min(low[axis], vertex[axis]);
+				high[axis] = std::max(high[axis], vertex[axis]);
+			}
+		}
+		for (int axis = 0; axis < 3; axis++) {
+			out.positionOffset[axis] = (low[axis] + high[axis]) * 0.5f;
+			float extent = (high[axis] - low[axis]) * 0.5f;
+			out.positionScale[axis] = (extent > 0.0f) ? extent : 1.0f;
+		}
+	}
+
+	for (GLuint i = 0; i < vertexCount; i++) {
+		const GLfloat* vertex = vertices + i * FloatsPerVertex;
+		glm::vec3 position(vertex[0], vertex[1], vertex[2]);
+		glm::vec2 texCoord(vertex[3], vertex[4]);
+		glm::vec3 normal(vertex[5], vertex[6], vertex[7]);
+
+		GLuint xy = 0;
+		GLuint z = 0;
+		if (format == VertexFormat::HalfOctahedral) {
+			xy = glm::packHalf2x16(glm::vec2(position.x, position.y));
+			z = glm::packHalf2x16(glm::vec2(position.z, 0.0f)) & 0xFFFFu;
+		}
+		else {
+			glm::vec3 local((position.x - out.positionOffset.x) / out.positionScale.x,
+				(position.y - out.positionOffset.y) / out.positionScale.y,
+				(position.z - out.positionOffset.z) / out.positionScale.z);
+			xy = glm::packSnorm2x16(glm::vec2(local.x, local.y));
+			z = glm::packSnorm2x16(glm::vec2(local.z, 0.0f)) & 0xFFFFu;
+		}
+
+		// Meshes without normals (the skybox) store the zero square point, which decodes to +Z
+		glm::vec2 octahedral = EncodeOctahedral(normal);
+		GLuint packedNormal = glm::packSnorm4x8(glm::vec4(octahedral.x, octahedral.y, 0.0f, 0.0f)) & 0xFFFFu;
+
+		GLuint* word = out.words.data() + static_cast<size_t>(i) * out.stride;
+		word[0] = xy;
+		word[1] = z | (packedNormal << 16);
+		word[2] = glm::packUnorm2x16(texCoord);
+	}
+}
+
+/***********************************************************************
+ * EncodeOctahedral: Maps a unit vector onto the octahedral square.
+ * Author: [Smirti Parajuli]
+ * Description: The vector is projected onto the octahedron |x|+|y|+|z|=1
+ *              and the lower half is folded over the diagonals, so every
+ *              direction gets a point of the [-1, 1] square.
+ *
+ * Parameters:
+ *   - normal: The unit vector, a zero vector encodes as the centre.
+ *
+ * Return: The point on the square.
+ ***********************************************************************/
+glm::vec2 VertexEncoder::EncodeOctahedral(const glm::vec3& normal)
+{
+	float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	if (length <= 0.0f) {
+		return glm::vec2(0.0f, 0.0f);
+	}
+	glm::vec2 point(normal.x / length, normal.y / length);
+	if (normal.z < 0.0f) {
+		glm::vec2 folded((1.0f - std::fabs(point.y)) * (point.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - std::fabs(point.x)) * (point.y >= 0.0f ? 1.0f : -1.0f));
+		point = folded;
+	}
+	return point;
+}
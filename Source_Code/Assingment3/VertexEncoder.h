@@ -0,0 +1,53 @@
+/***********************************************************************
+Bachelor of Software Engineering (AI)
+Media Design School
+Auckland
+New Zealand
+(c) [2023] Media Design School
+File Name :VertexEncoder.h
+Description :  The VertexEncoder converts the interleaved float vertices the
+               meshes are built with (position, texture coordinates, normal)
+               into the compact formats stored in the geometry pool. The
+               vertex shaders decode them again in VertexPulling.glsl.
+Author : [Smirti Parajuli]
+Mail : smirti.parajuli@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+#ifndef VERTEXENCODER_H
+#define VERTEXENCODER_H
+
+#include <glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// How the vertices of one mesh are stored, the values match VertexPulling.glsl
+enum class VertexFormat : GLuint
+{
+	Float32 = 0,// 32 bytes: 8 floats
+	HalfOctahedral = 1,// 12 bytes: half float position, 8-bit octahedral normal, unorm16 texture coordinates
+	SnormOctahedral = 2// 12 bytes: as above with snorm16 positions inside the mesh bounds
+};
+
+// Vertices ready for the geometry pool
+struct EncodedVertices
+{
+	std::vector<GLuint> words;
+	GLuint stride = 0;// Words per vertex
+	glm::vec3 positionScale = glm::vec3(1.0f);// Decoded position = stored * scale + offset
+	glm::vec3 positionOffset = glm::vec3(0.0f);
+};
+
+class VertexEncoder
+{
+public:
+	static const GLuint FloatsPerVertex = 8;// Position, texture coordinates, normal
+
+	static GLuint GetStride(VertexFormat format);// Words per vertex
+	static void Encode(const GLfloat* vertices, GLuint vertexCount, VertexFormat format, EncodedVertices& out);
+	static glm::vec2 EncodeOctahedral(const glm::vec3& normal);// Unit normal to a point of the [-1, 1] square
+
+private:
+	VertexEncoder();
+};
+#endif // VERTEXENCODER_H
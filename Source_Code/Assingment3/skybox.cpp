@@ -13,27 +13,32 @@ Mail : smirti.parajuli@mds.ac.nz
 
 
 #include "SkyBox.h"
+#include "ShaderBindings.h"
+#include "GLState.h"
 #include <glew.h>
 #include <glm/gtc/type_ptr.hpp>
 #include "Camera.h"
-#include <stb_image.h>
+#include "AssetPack.h"
 #include "ShaderLoader.h"
 
 /***********************************************************************
  * SkyBox: Constructor for the SkyBox class.
  * Author: [Smirti Parajuli]
- * Initializes a SkyBox object with a camera reference and sets up textures and buffers.
+ * Initializes a SkyBox object with a camera reference and sets up the texture.
+ * The six faces are decoded as jobs while the shader and buffers are built
+ * on this thread, which then helps with any decoding still left. The
+ * environment lighting is made from the faces before they are released.
  *
  * Parameters:
  *   - camera: Pointer to the Camera object to be used with the SkyBox.
+ *   - jobs: The job system the faces are decoded on.
  *
  * Return: None (constructor)
  ***********************************************************************/
-SkyBox::SkyBox(Camera* camera)
+SkyBox::SkyBox(Camera* camera, JobSystem& jobs)
     : camera(camera),
-    TextureID(0), PVM(),
-    VAO(0), VBO(0), EBO(0),
-    Program_SkyBox(ShaderLoader::CreateProgram("Resources/Shaders/SkyBox.vs", "Resources/Shaders/SkyBox.fs")),
+    TextureID(0), InverseViewProjection(1.0f),
+    Program_SkyBox(0),
     TextureFilePaths({
         "Resources/Textures/CubeMaps/Right.jpg",
         "Resources/Textures/CubeMaps/Left.jpg",
@@ -44,43 +49,44 @@ SkyBox::SkyBox(Camera* camera)
         })
 
 {
+    // Faces found in the asset pack or decoded by the jobs, read here once they are done
+    // Cube map faces keep the top row first, stb_image's default
+    // Each face is hashed by its job too, the hashes key the environment lighting cache
+    ImageAsset faces[6];
+    std::uint64_t faceHashes[6] = {};
+    JobCounter decodeCounter;
+    for (int i = 0; i < 6; i++)
+    {
+        jobs.Run(decodeCounter, [this, &faces, &faceHashes, i] {
+            if (faces[i].Load(TextureFilePaths[i], false)) {
+                size_t size = static_cast<size_t>(faces[i].GetWidth()) * faces[i].GetHeight() * faces[i].GetChannels();
+                faceHashes[i] = AssetPack::Hash(faces[i].GetPixels(), size);
+            }
+        });
+    }
+
+    Program_SkyBox = ShaderLoader::CreateProgram("Resources/Shaders/SkyBox.vs", "Resources/Shaders/SkyBox.fs");
+
+    // The fullscreen triangle is made from gl_VertexID alone
+    glGenVertexArrays(1, &emptyVertexArray);
 
-    // VAO, VBO, and EBO setup (shiftted from the bottom)
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, 72 * sizeof(GLfloat), &vertices_SkyBox[0], GL_STATIC_DRAW);
-    glGenBuffers(1, &EBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 36 * sizeof(GLuint), &indices_SkyBox[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
-    glEnableVertexAttribArray(0);
     //generate and bind the image texture ID
     glGenTextures(1, &TextureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, TextureID);
-
-    stbi_set_flip_vertically_on_load(false);
-    // Load the image Data
-    int ImageWidth;
-    int ImageHeight;
-    int ImageComponents;
+    GLState::Get().BindTexture(GL_TEXTURE_CUBE_MAP, TextureID, 0);
 
+    // Help with the decoding until every face is ready
+    jobs.Wait(decodeCounter);
 
     for (int i = 0; i < 6; i++)
     {
-
-        unsigned char* ImageData = stbi_load(TextureFilePaths[i].c_str(), &ImageWidth, &ImageHeight, &ImageComponents, 0);
+        const unsigned char* ImageData = faces[i].GetPixels();
         if (ImageData)
         {
             //Check RGB or RGBA
-            GLint LoadedComponents = (ImageComponents == 4) ? GL_RGBA : GL_RGB;
+            GLint LoadedComponents = (faces[i].GetChannels() == 4) ? GL_RGBA : GL_RGB;
 
             //Populate Texture with image data
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, LoadedComponents, ImageWidth, ImageHeight, 0, LoadedComponents, GL_UNSIGNED_BYTE, ImageData);
-
-            stbi_image_free(ImageData);
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, LoadedComponents, faces[i].GetWidth(), faces[i].GetHeight(), 0, LoadedComponents, GL_UNSIGNED_BYTE, ImageData);
         }
         else {
             std::cout << "Failed To load the Image" << i << std::endl;
@@ -97,7 +103,13 @@ SkyBox::SkyBox(Camera* camera)
 
     // Generate the mipmaps, free the memory and unbind the texture
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    // Image-based lighting from the same faces, read from the cache while they stay the same
+    environment.Create(faces, faceHashes, "Resources/Textures/CubeMaps/Environment.ibl", jobs);
+    for (int i = 0; i < 6; i++)
+    {
+        faces[i].Release();
+    }
 }
 /***********************************************************************
  * ~SkyBox: Destructor for the SkyBox class.
@@ -109,65 +121,71 @@ SkyBox::SkyBox(Camera* camera)
  * Return: None (destructor)
  ***********************************************************************/
 SkyBox::~SkyBox() {
+    GLState::Get().ForgetTexture(TextureID);
     glDeleteTextures(1, &TextureID);
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    GLState::Get().ForgetVertexArray(emptyVertexArray);
+    glDeleteVertexArrays(1, &emptyVertexArray);
 }
 /***********************************************************************
- * Update: Updates the SkyBox's transformation based on the camera's position.
+ * Update: Writes the skybox matrix for this frame.
  * Author: [Smirti Parajuli]
- * Updates the model matrix for the skybox and recalculates the PVM matrix.
+ * The sky only depends on which way the camera looks, so the inverse of
+ * the projection and the camera rotation is only rebuilt when one of them
+ * changed. Moving the camera or holding it still costs one copy into the
+ * stream buffer for the SkyBoxData block. The projection is the scene's
+ * own, so the sky follows the camera's field of view.
  *
  * Parameters:
- *   - camera: Pointer to the Camera object for view matrix calculation.
- *   - deltaTime: The time elapsed since the last frame.
+ *   - frame: The snapshot holding the camera view for this frame.
+ *   - stream: The per-frame stream buffer.
  *
  * Return: None
  ***********************************************************************/
-void SkyBox::Update(Camera* camera, float deltaTime) {
-    glm::mat4 ModelMat = glm::scale(glm::mat4(1.0f), glm::vec3(2000.0f)); // Model matrix for the skybox
-
-    // Use the method of the camera object and pass in the values explicitly
-    glm::mat4 projection = camera->GetProjectionMatrix(45.0f, static_cast<float>(camera->windowWidth) / camera->windowHeight, 0.1f, 4000.0f);
-
-    // Calculate the combined projection and view matrix
-    glm::mat4 viewMatrix = glm::mat4(glm::mat3(camera->GetViewMatrix())); // Remove translation for skybox effect
-    glm::mat4 projectionViewMatrix = projection * viewMatrix;
+void SkyBox::Update(const FrameSnapshot& frame, StreamBuffer& stream) {
+    glm::mat4 rotation = glm::mat4(glm::mat3(frame.view)); // Remove translation for skybox effect
+    if (!hasInverse || rotation != viewRotation || frame.projection != projection) {
+        viewRotation = rotation;
+        projection = frame.projection;
+        InverseViewProjection = glm::inverse(projection * viewRotation);
+        hasInverse = true;
+    }
 
-    // Combine with the model matrix to get the final projection-view-model matrix
-    PVM = projectionViewMatrix * ModelMat;
+    glm::mat4* block = stream.Allocate<glm::mat4>(matrixOffset);
+    hasMatrix = (block != nullptr);
+    if (hasMatrix) {
+        *block = InverseViewProjection;
+    }
 }
 
 /***********************************************************************
- * Render: Renders the SkyBox with the current texture and transformations.
+ * Submit: Queues the SkyBox with the current texture and transformations.
  * Author:[ Smirti Parajuli]
- * Binds the cube map texture and draws the skybox using the current PVM matrix.
+ * Queues the fullscreen triangle in the sky pass, after all opaque
+ * geometry. It lies on the far plane and is drawn with GL_LEQUAL, so the
+ * early depth test rejects every pixel the geometry already covers and
+ * only the visible sky is shaded.
  *
- * Parameters: None
+ * Parameters:
+ *   - queue: The render queue for this frame.
+ *   - stream: The stream buffer written by Update this frame.
  *
  * Return: None
  ***********************************************************************/
-void SkyBox::Render() {
-    glUseProgram(Program_SkyBox);
-    glDepthFunc(GL_LEQUAL);  // Change depth function so depth test passes when values are equal to depth buffer's content
-
-    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS); //added this from lecture code
-
-    glActiveTexture(GL_TEXTURE0); // activate the texture
-    glBindTexture(GL_TEXTURE_CUBE_MAP, TextureID); // bind the texture
-    glUniform1i(glGetUniformLocation(Program_SkyBox, "skyBox"), 0);
-
-   
-    // pass in the PVM matrix as calculated in update
-    glUniformMatrix4fv(glGetUniformLocation(Program_SkyBox, "PVM"), 1, GL_FALSE, glm::value_ptr(PVM));
- 
-   
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0); //unbind the texture
-    glUseProgram(0);
-    glDepthFunc(GL_LESS); // Set depth function back to default
+void SkyBox::Submit(RenderQueue& queue, const StreamBuffer& stream) const {
+    if (!hasMatrix) {
+        return;
+    }
+    DrawPacket packet;
+    packet.program = Program_SkyBox;
+    packet.vertexArray = emptyVertexArray;
+    packet.vertexCount = 3;
+    packet.textureTarget = GL_TEXTURE_CUBE_MAP;
+    packet.texture = TextureID;
+    packet.depthFunc = GL_LEQUAL;  // Depth test passes when values are equal to depth buffer's content
+    packet.rangeIndex = SkyBoxDataBinding;
+    packet.rangeBuffer = stream.GetID();
+    packet.rangeOffset = matrixOffset;
+    packet.rangeSize = sizeof(glm::mat4);
+    packet.key = RenderQueue::MakeKey(RenderPass::Sky, packet.program, packet.texture, packet.vertexArray, 1.0f);
+    queue.Submit(packet);
 }
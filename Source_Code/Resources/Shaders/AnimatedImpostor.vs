@@ -0,0 +1,22 @@
+#version 460 core
+// No vertex data, gl_VertexID picks the corner of the quad
+
+// Per-frame camera data, written once per frame into the stream buffer
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
+#include "InstanceAnimation.glsl"
+#include "ImpostorVertex.glsl"
+
+void main() {
+    vec3 center;
+    mat3 rotation;
+    float scale;
+    vec3 tint;
+    EvaluateAnimation(gl_InstanceID, center, rotation, scale, tint);
+    EmitImpostor(center, sphereRadius * scale, rotation, tint);
+}
@@ -0,0 +1,41 @@
+#version 460 core
+// The vertex attributes are pulled from the geometry pool
+#include "VertexPulling.glsl"
+// The depth pre-pass runs this shader too, GL_EQUAL needs the very same depths
+invariant gl_Position;
+// The instances come from the meshlet culling pass
+#include "MeshletInstance.glsl"
+
+// Per-frame camera data, written once per frame into the stream buffer
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
+// Transforms of every instance, built on the CPU in batches
+struct InstanceTransform {
+    mat4 model;
+    mat4 normalMatrix;// Inverse transpose of the model matrix
+    mat4 pvm;// projection * view * model
+};
+layout (std430, binding = 2) readonly buffer InstanceData {
+    InstanceTransform instances[];
+};
+
+out vec2 FragTexCoords;// Pass through for texture coordinates
+out vec3 FragPos; // Pass through for fragment position
+out vec3 FragNormal; // Pass through for normal vector
+out vec3 FragTint; // Colour multiplier, white for these instances
+
+void main() {
+    Vertex vertex = PullVertex();
+    InstanceTransform instance = instances[CulledInstance()];
+
+    gl_Position = instance.pvm * vec4(vertex.position, 1.0);
+    FragTexCoords = vertex.texCoord;
+    FragTint = vec3(1.0f);
+    FragNormal = mat3(instance.normalMatrix) * vertex.normal;
+    FragPos = vec3(instance.model * vec4(vertex.position, 1.0f));
+}
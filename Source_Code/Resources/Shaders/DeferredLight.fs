@@ -0,0 +1,27 @@
+#version 460 core
+
+// Lighting pass of the deferred path for the lights that reach every pixel:
+// ambient, directional, spot and rim light. The point lights are added on
+// top by their light volumes in DeferredPointLight.fs.
+
+out vec4 FinalColor; // The output color of the pixel
+
+// Per-frame camera data
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
+#include "BlinnPhongLighting.glsl"
+#include "GBuffer.glsl"
+
+void main() {
+    Surface surface = ReadSurface(ivec2(gl_FragCoord.xy));
+    if (!surface.covered) {
+        discard;
+    }
+    vec3 viewDir = normalize(cameraPosition.xyz - surface.position);
+    FinalColor = vec4(CalculateSceneLights(surface.position, surface.normal, viewDir, surface.shininess) * surface.albedo, 1.0f);
+}
@@ -0,0 +1,9 @@
+#version 460 core
+
+// One triangle covering the screen, built from gl_VertexID with no vertex data
+
+void main()
+{
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(corner * 2.0f - 1.0f, 0.0f, 1.0f);
+}
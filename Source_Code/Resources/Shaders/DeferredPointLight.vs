@@ -0,0 +1,27 @@
+#version 460 core
+
+// Light volume of one point light per instance: the pool cube scaled to
+// enclose the sphere the light reaches
+
+// The cube position is pulled from the geometry pool
+#include "VertexPulling.glsl"
+
+// Per-frame camera data
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
+#include "BlinnPhongLighting.glsl"
+
+flat out int LightIndex;// Into pointLights, gl_InstanceID does not include the base instance
+
+void main()
+{
+    PointLight light = pointLights[gl_InstanceID];
+    vec3 position = light.position.xyz + PullVertex().position * (2.0f * light.attenuation.w);
+    gl_Position = projection * view * vec4(position, 1.0f);
+    LightIndex = gl_InstanceID;
+}
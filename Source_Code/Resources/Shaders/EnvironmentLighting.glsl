@@ -0,0 +1,26 @@
+// Image-based lighting of the sky shared through #include, made by EnvironmentLighting
+
+// Matches EnvironmentUniforms in ShaderBindings.h
+layout (std140, binding = 11) uniform EnvironmentData {
+    vec4 irradiance[9];// Spherical harmonic coefficients of the sky irradiance over pi, rgb used
+    vec4 specularLevels;// x the roughest level of SkySpecular
+};
+
+// The sky blurred by a GGX lobe, roughness rises by one step per level, alpha is 0
+layout (binding = 5) uniform samplerCube SkySpecular;
+
+// Light arriving from the whole sky around a unit normal, divided by pi like a diffuse surface does
+vec3 SkyIrradiance(vec3 n) {
+    vec3 result = irradiance[0].rgb
+        + irradiance[1].rgb * n.y + irradiance[2].rgb * n.z + irradiance[3].rgb * n.x
+        + irradiance[4].rgb * (n.x * n.y) + irradiance[5].rgb * (n.y * n.z)
+        + irradiance[6].rgb * (3.0f * n.z * n.z - 1.0f)
+        + irradiance[7].rgb * (n.x * n.z) + irradiance[8].rgb * (n.x * n.x - n.y * n.y);
+    return max(result, vec3(0.0f));
+}
+
+// The sky reflected in a direction by a surface of the given roughness, never sharper than the screen footprint allows
+vec3 SkySpecularLight(vec3 direction, float roughness) {
+    float level = max(roughness * specularLevels.x, textureQueryLod(SkySpecular, direction).x);
+    return textureLod(SkySpecular, direction, level).rgb;
+}
@@ -0,0 +1,47 @@
+// Fragment half of the ray traced sphere impostors, shared through #include
+// The including shader declares the FrameData block first
+
+in vec3 FragPos;// Point on the quad, the camera ray passes through it
+flat in vec4 ImpostorSphere;// xyz centre, w radius
+flat in mat3 ImpostorRotation;// Object to world rotation
+flat in vec3 FragTint;// Colour multiplier
+
+// The surface is always behind the quad, which keeps early depth testing
+layout (depth_greater) out float gl_FragDepth;
+
+// Intersects the camera ray through this fragment with the sphere and writes
+// the depth of the hit. Returns false when the ray misses; the caller
+// discards only after sampling its textures, so the derivatives stay defined.
+bool TraceImpostor(out vec3 position, out vec3 normal) {
+    vec3 rayDir = normalize(FragPos - cameraPosition.xyz);
+    vec3 offset = cameraPosition.xyz - ImpostorSphere.xyz;
+    float b = dot(offset, rayDir);
+    float c = dot(offset, offset) - ImpostorSphere.w * ImpostorSphere.w;
+    float h = b * b - c;
+    float t = -b - sqrt(max(h, 0.0f));
+
+    position = cameraPosition.xyz + rayDir * t;
+    normal = normalize(position - ImpostorSphere.xyz);
+    vec4 clip = projection * view * vec4(position, 1.0f);
+    gl_FragDepth = (clip.z / clip.w) * 0.5f + 0.5f;
+    return h >= 0.0f;
+}
+
+// Samples a texture with the same mapping as the sphere mesh
+vec4 SampleImpostorTexture(sampler2D image, vec3 normal) {
+    vec3 local = transpose(ImpostorRotation) * normal;
+    float u = atan(local.z, local.x) / 6.28318530718f;
+    float v = 1.0f - acos(clamp(local.y, -1.0f, 1.0f)) / 3.14159265359f;
+
+    // u jumps back at one seam or the other, use the derivatives of the range that is smooth here
+    vec2 texCoords = vec2(fract(u), v);
+    vec2 dx = dFdx(texCoords);
+    vec2 dy = dFdy(texCoords);
+    vec2 dxCentered = dFdx(vec2(u, v));
+    vec2 dyCentered = dFdy(vec2(u, v));
+    if (dot(dxCentered, dxCentered) + dot(dyCentered, dyCentered) < dot(dx, dx) + dot(dy, dy)) {
+        dx = dxCentered;
+        dy = dyCentered;
+    }
+    return textureGrad(image, texCoords, dx, dy);
+}
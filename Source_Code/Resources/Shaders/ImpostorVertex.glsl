@@ -0,0 +1,36 @@
+// Vertex half of the ray traced sphere impostors, shared through #include
+// The including shader declares the FrameData block first
+// Each sphere is one quad of four vertices, the fragment shader finds the exact surface
+
+uniform float sphereRadius;// Radius of the sphere mesh, the impostor matches it
+
+out vec3 FragPos;// Point on the quad, the camera ray passes through it
+flat out vec4 ImpostorSphere;// xyz centre, w radius
+flat out mat3 ImpostorRotation;// Object to world rotation, gives the texture coordinates
+flat out vec3 FragTint;// Colour multiplier
+
+// Places this vertex at its corner of the quad covering the sphere
+void EmitImpostor(vec3 center, float radius, mat3 rotation, vec3 tint) {
+    // The quad faces the camera on the plane touching the front of the sphere,
+    // so every surface point lies behind it and the depth only ever grows
+    vec3 toCenter = center - cameraPosition.xyz;
+    float distance = length(toCenter);
+    vec3 forward = toCenter / distance;
+    vec3 up = (abs(forward.y) < 0.99f) ? vec3(0.0f, 1.0f, 0.0f) : vec3(1.0f, 0.0f, 0.0f);
+    vec3 right = normalize(cross(forward, up));
+    up = cross(right, forward);
+
+    // Half the width of the silhouette cone where it crosses that plane
+    float planeDistance = distance - radius;
+    float halfSize = planeDistance * radius / sqrt(max(distance * distance - radius * radius, 1e-6f));
+
+    // The quad is a mesh in the geometry pool, only its vertex number within the mesh is used
+    int quadVertex = gl_VertexID - gl_BaseVertex;
+    vec2 corner = vec2(float(quadVertex & 1), float(quadVertex >> 1)) * 2.0f - 1.0f;
+    FragPos = cameraPosition.xyz + forward * planeDistance + (right * corner.x + up * corner.y) * halfSize;
+    gl_Position = projection * view * vec4(FragPos, 1.0f);
+
+    ImpostorSphere = vec4(center, radius);
+    ImpostorRotation = rotation;
+    FragTint = tint;
+}
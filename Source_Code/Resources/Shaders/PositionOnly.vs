@@ -1,7 +1,7 @@
 #version 460 core
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec2 inTexCoord;
+// The vertex attributes are pulled from the geometry pool
+#include "VertexPulling.glsl"
 
 uniform mat4 PVM;
 
@@ -9,6 +9,7 @@ out vec2 TexCoord;
 
 void main()
 {
-    TexCoord = inTexCoord;
-    gl_Position =PVM * vec4(inPosition, 1.0);
+    Vertex vertex = PullVertex();
+    TexCoord = vertex.texCoord;
+    gl_Position =PVM * vec4(vertex.position, 1.0);
 }
@@ -0,0 +1,33 @@
+#version 460 core
+// Scene of a reflection probe face, linked with Blinn_PhongLight.fs
+// The vertex attributes are pulled from the geometry pool
+#include "VertexPulling.glsl"
+
+// The view and projection of the face being drawn, cameraPosition is the probe centre
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
+// One model matrix per instance, uniformly scaled, written into the stream buffer by the submitting object
+layout (std430, binding = 2) readonly buffer ProbeInstanceData {
+    mat4 probeModels[];
+};
+
+out vec2 FragTexCoords;// Pass through for texture coordinates
+out vec3 FragPos; // Pass through for fragment position
+out vec3 FragNormal; // Pass through for normal vector
+out vec3 FragTint; // Colour multiplier, white for these instances
+
+void main() {
+    Vertex vertex = PullVertex();
+    mat4 model = probeModels[gl_InstanceID];
+    FragPos = vec3(model * vec4(vertex.position, 1.0f));
+    gl_Position = projection * view * vec4(FragPos, 1.0f);
+    // The scale is uniform, so the model rotation also turns the normal
+    FragNormal = mat3(model) * vertex.normal;
+    FragTexCoords = vertex.texCoord;
+    FragTint = vec3(1.0f);
+}
@@ -1,13 +1,18 @@
 #version 460 core
+// Fullscreen triangle at the far plane, no vertex data: gl_VertexID 0, 1 and 2
+// become (-1, -1), (3, -1) and (-1, 3), which cover the whole screen
 
-layout(location = 0) in vec3 inPosition;
-
-uniform mat4 PVM;
+// Inverse of the projection and the camera rotation, rebuilt only when either changes
+layout (std140, binding = 3) uniform SkyBoxData {
+    mat4 InverseViewProjection;
+};
 
 out vec3 TexCoords;
 void main()
 {
-   
-     gl_Position = PVM * vec4(inPosition, 1.0f);
-      TexCoords = inPosition; 
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0f - 1.0f;
+    // Depth 1, so only pixels nothing was drawn on pass the depth test
+    gl_Position = vec4(position, 1.0f, 1.0f);
+    // The far plane point behind the vertex, its xyz points along the view ray and interpolates linearly
+    TexCoords = (InverseViewProjection * vec4(position, 1.0f, 1.0f)).xyz;
 }
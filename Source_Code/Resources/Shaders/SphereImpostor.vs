@@ -0,0 +1,28 @@
+#version 460 core
+// No vertex data, gl_VertexID picks the corner of the quad
+
+// Per-frame camera data, written once per frame into the stream buffer
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+
+// Transforms of every instance in this draw, only the model matrix is read
+struct InstanceTransform {
+    mat4 model;
+    mat4 normalMatrix;
+    mat4 pvm;
+};
+layout (std430, binding = 2) readonly buffer InstanceData {
+    InstanceTransform instances[];
+};
+
+#include "ImpostorVertex.glsl"
+
+void main() {
+    mat4 model = instances[gl_InstanceID].model;
+    float scale = length(model[0].xyz);
+    EmitImpostor(model[3].xyz, sphereRadius * scale, mat3(model) / scale, vec3(1.0f));
+}
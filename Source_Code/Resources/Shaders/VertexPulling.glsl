@@ -0,0 +1,63 @@
+// Vertex pulling shared by the mesh vertex shaders through #include
+// Every mesh lives in the geometry pool in its own format, the draw passes
+// the mesh number as its base instance and gl_VertexID counts from the mesh start
+
+// The vertex words of every mesh
+layout (std430, binding = 5) readonly buffer VertexData {
+    uint vertexData[];
+};
+
+// How each mesh is stored, matches MeshFormat in ShaderBindings.h
+struct MeshFormat {
+    uvec4 layout;// x format, y first word, z words per vertex
+    vec4 positionScale;
+    vec4 positionOffset;
+};
+
+layout (std430, binding = 6) readonly buffer MeshFormatData {
+    MeshFormat meshFormats[];
+};
+
+struct Vertex {
+    vec3 position;
+    vec2 texCoord;
+    vec3 normal;
+};
+
+// Inverse of VertexEncoder::EncodeOctahedral
+vec3 DecodeOctahedral(vec2 point) {
+    vec3 normal = vec3(point, 1.0f - abs(point.x) - abs(point.y));
+    float fold = max(-normal.z, 0.0f);
+    normal.x += (normal.x >= 0.0f) ? -fold : fold;
+    normal.y += (normal.y >= 0.0f) ? -fold : fold;
+    return normalize(normal);
+}
+
+// Fetches the vertex this invocation is running for
+Vertex PullVertex() {
+    MeshFormat meshFormat = meshFormats[gl_BaseInstance];
+    uint base = meshFormat.layout.y + uint(gl_VertexID) * meshFormat.layout.z;
+    Vertex vertex;
+
+    // VertexFormat::Float32, 8 floats: position, texture coordinates, normal
+    if (meshFormat.layout.x == 0u) {
+        vertex.position = uintBitsToFloat(uvec3(vertexData[base], vertexData[base + 1u], vertexData[base + 2u]));
+        vertex.texCoord = uintBitsToFloat(uvec2(vertexData[base + 3u], vertexData[base + 4u]));
+        vertex.normal = uintBitsToFloat(uvec3(vertexData[base + 5u], vertexData[base + 6u], vertexData[base + 7u]));
+        return vertex;
+    }
+
+    // The compact formats, 3 words: position xy, position z and octahedral normal, texture coordinates
+    uint xy = vertexData[base];
+    uint zNormal = vertexData[base + 1u];
+    if (meshFormat.layout.x == 1u) {
+        vertex.position = vec3(unpackHalf2x16(xy), unpackHalf2x16(zNormal).x);
+    }
+    else {
+        vec3 stored = vec3(unpackSnorm2x16(xy), unpackSnorm2x16(zNormal).x);
+        vertex.position = stored * meshFormat.positionScale.xyz + meshFormat.positionOffset.xyz;
+    }
+    vertex.normal = DecodeOctahedral(unpackSnorm4x8(zNormal >> 16u).xy);
+    vertex.texCoord = unpackUnorm2x16(vertexData[base + 2u]);
+    return vertex;
+}
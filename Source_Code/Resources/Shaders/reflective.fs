@@ -5,13 +5,24 @@ out vec4 FragColor;
 in vec3 FragNormal;
 in vec3 FragPos;
 
-uniform vec3 cameraPos;
-uniform samplerCube skybox;
+// Per-frame camera data shared with every scene shader
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
+// Cube map of the reflection probe around this sphere, or SkySpecular until the probe is ready
+layout (binding = 0) uniform samplerCube ReflectionProbe;
+// The sky shows through wherever the probe saw nothing, alpha 0
+#include "EnvironmentLighting.glsl"
+uniform float Roughness = 0.1f;// Polished rather than a perfect mirror
 
 void main()
 {   
    vec3 normal = normalize(FragNormal);
-    vec3 viewDir = normalize(cameraPos - FragPos);
-    vec3 reflectDir = reflect(viewDir, normal);
-    FragColor = texture(skybox, reflectDir);
+    vec3 viewDir = normalize(cameraPosition.xyz - FragPos);
+    vec3 reflectDir = reflect(-viewDir, normal);
+    vec4 probe = texture(ReflectionProbe, reflectDir);
+    FragColor = vec4(mix(SkySpecularLight(reflectDir, Roughness), probe.rgb, probe.a), 1.0f);
 }
\ No newline at end of file
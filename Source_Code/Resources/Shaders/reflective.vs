@@ -1,11 +1,17 @@
 #version 460 core
 
-layout (location = 0) in vec3 Position;
-layout (location = 1) in vec2 TexCoord;
-layout (location = 2) in vec3 Normal;
+// The vertex attributes are pulled from the geometry pool
+#include "VertexPulling.glsl"
 
 uniform mat4 model;               // Model matrix
-uniform mat4  PVM;                // View matrix
+
+// Per-frame camera data shared with every scene shader
+layout (std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;// Animation time in seconds
+};
 
 
 out vec2 FragTexCoords;
@@ -13,8 +19,9 @@ out vec3 FragPos;
 out vec3 FragNormal;
 
 void main() {
-    gl_Position = PVM * vec4(Position, 1.0);
-    FragTexCoords = TexCoord;
-    FragNormal = mat3(transpose(inverse(model))) * Normal;
-    FragPos = vec3(model * vec4(Position, 1.0f));
+    Vertex vertex = PullVertex();
+    gl_Position = projection * view * model * vec4(vertex.position, 1.0);
+    FragTexCoords = vertex.texCoord;
+    FragNormal = mat3(transpose(inverse(model))) * vertex.normal;
+    FragPos = vec3(model * vec4(vertex.position, 1.0f));
 }